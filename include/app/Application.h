@@ -52,6 +52,7 @@ private:
   void handleConnecting();
   void handleRunning();
   void handleUpdating();
+  void handleDutyCycle();
   void handleFlashing();
   void beginArduinoOtaSession();
   void touchArduinoOtaProgress(size_t current, size_t total);
@@ -66,8 +67,10 @@ private:
   IntervalTimer m_healthCheckTimer{60000};  // Run health checks every 60 seconds.
   IntervalTimer m_otaTimer{100};            // Throttle ArduinoOTA.handle() to reduce CPU load.
   IntervalTimer m_heapSampleTimer{250};     // Sample heap watermarks for stress testing.
+  IntervalTimer m_dutyCycleTimer{500};      // Deep-sleep mode: how often the upload window is checked.
   Ticker m_arduinoOtaWatchdog;
   bool m_safeModeCleared = false;
+  bool m_uploadWindowOpen = false;
   unsigned long m_bootTime = 0;
   bool m_arduinoOtaActive = REDACTED
   unsigned long m_arduinoOtaStartedAt = REDACTED
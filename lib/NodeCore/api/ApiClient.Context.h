@@ -14,8 +14,46 @@ namespace ApiClientDetail {
 
 using PayloadBuffer = std::array<char, MAX_PAYLOAD_SIZE + 1>;
 
+// Batched backlog drain: values > 1 let one POST carry up to N stored records as a JSON array.
+// Keep at 1 unless the cloud API and gateway accept array bodies.
+#ifndef UPLOAD_BATCH_MAX_RECORDS
+#define UPLOAD_BATCH_MAX_RECORDS 1
+#endif
+static constexpr uint16_t kUploadBatchMaxRecords = UPLOAD_BATCH_MAX_RECORDS;
+static constexpr size_t kUploadBatchRecordSlot = MAX_PAYLOAD_SIZE + 1;  // record + ',' or ']'
+static_assert(kUploadBatchMaxRecords >= 1 && kUploadBatchMaxRecords <= 32, "UPLOAD_BATCH_MAX_RECORDS out of range");
+// Queued upload bodies, a lone record or a batch, to the cloud or a gateway, are rendered from
+// storage straight to the socket while the request is sent instead of being held in the payload
+// buffer (or a heap batch buffer) through the connect. Gateway bodies are encrypted as they go.
+#ifndef UPLOAD_STREAM_BATCH
+#define UPLOAD_STREAM_BATCH 1
+#endif
+
+// Alert bounds in tenths (degC, %RH). A sample outside them skips the RTC queue and goes to
+// the cache priority lane, which the upload cycle drains before any routine backlog.
+#ifndef ALERT_TEMP_MIN_C10
+#define ALERT_TEMP_MIN_C10 50
+#endif
+#ifndef ALERT_TEMP_MAX_C10
+#define ALERT_TEMP_MAX_C10 400
+#endif
+#ifndef ALERT_HUM_MIN10
+#define ALERT_HUM_MIN10 200
+#endif
+#ifndef ALERT_HUM_MAX10
+#define ALERT_HUM_MAX10 950
+#endif
+static constexpr int16_t kAlertTempMin10 = ALERT_TEMP_MIN_C10;
+static constexpr int16_t kAlertTempMax10 = ALERT_TEMP_MAX_C10;
+static constexpr int16_t kAlertHumMin10 = ALERT_HUM_MIN10;
+static constexpr int16_t kAlertHumMax10 = ALERT_HUM_MAX10;
+static_assert(kAlertTempMin10 < kAlertTempMax10 && kAlertHumMin10 < kAlertHumMax10, "Alert bounds are inverted");
+
 struct ResourceState {
   std::unique_ptr<PayloadBuffer> sharedBuffer;
+  std::unique_ptr<PayloadBuffer> readAheadBuffer;
+  std::unique_ptr<char[]> batchBuffer;
+  size_t batchBufferSize = 0;
   std::unique_ptr<BearSSL::X509List> localTrustAnchors;
   bool tlsActive = false;
   bool tlsInsecure = false;
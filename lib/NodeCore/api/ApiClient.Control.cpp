@@ -190,6 +190,7 @@ void ApiClientControlController::pause() {
       m_transport.activeClient->stop();
     }
     m_transport.httpClient.reset();
+    m_api.discardReadAheadRecord();
     m_api.releaseTlsResources();
   }
 }
@@ -54,7 +54,7 @@ inline ApiClientDetail::RuntimeHealth captureRuntimeHealth(const ApiClientDetail
   health.wifiConnected = REDACTED
   health.wifiScanBusy = REDACTED
   health.rtcHasCapacity = !RtcManager::isFull();
-  health.littleFsHasCapacity = (ctx.deps.cacheManager.get_size() < MAX_CACHE_DATA_SIZE);
+  health.littleFsHasCapacity = (ctx.deps.cacheManager.get_lane_size(CacheLane::ROUTINE) < MAX_CACHE_DATA_SIZE);
   health.storageBackpressure = ctx.runtime.queue.emergencyBackpressure;
   health.tlsHeapHealthy = captureTlsHeapBudget(ctx).healthy;
   health.lastRefreshMs = millis();
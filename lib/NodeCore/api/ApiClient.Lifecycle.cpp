@@ -14,8 +14,10 @@
 #include "system/ConfigManager.h"
 #include "system/Logger.h"
 #include "net/NtpClient.h"
+#include "net/UploadLatency.h"
 #include "storage/RtcManager.h"
 #include "sensor/SensorManager.h"  // Concrete type for CRTP
+#include "system/DutyCycle.h"
 #include "REDACTED"
 #include "config/constants.h"
 #include "support/Utils.h"
@@ -46,6 +48,8 @@ void ApiClientLifecycleController::applyConfig(const AppConfig& config) {
   }
 
   m_api.updateCloudTargetCache();
+  // A saved config may carry a new token; the next edge upload derives the signing key again.
+  HmacSigner::invalidate(m_transport.signingKey);
   m_runtime.route.cachedGatewayMode = -1;
   m_runtime.route.lastGatewayModeCheck = 0;
 }
@@ -85,6 +89,11 @@ void ApiClientLifecycleController::handleTimerTasks() {
 
   if (m_runtime.uploadState == ApiClient::UploadState::UPLOADING) {
     m_api.handleUploadCycle();
+  } else if (m_transport.httpState == ApiClient::HttpState::IDLE &&
+             m_runtime.route.loadedRecordSource == ApiClient::UploadRecordSource::NONE) {
+    // Never while a record is loaded: the pass pops from the same tail the upload will pop.
+    (void)m_deps.cacheManager.downsample_step();
+    m_api.probeDemotedGateway();
   }
 
   if (m_runtime.cacheFlushTimer.hasElapsed()) {
@@ -127,6 +136,11 @@ void ApiClientLifecycleController::handle() {
   if (m_api.m_transport.httpState != ApiClient::HttpState::IDLE) {
     m_api.handleUploadStateMachine();
 
+    if (m_api.m_transport.httpState == ApiClient::HttpState::WAITING_RESPONSE) {
+      // Reads and renders the next record while the server is still answering this one.
+      m_api.readAheadNextRecord();
+    }
+
     if (m_api.m_transport.httpState == ApiClient::HttpState::COMPLETE) {
       m_api.m_transport.lastResult.success = (m_api.m_transport.lastResult.httpCode >= 200 && m_api.m_transport.lastResult.httpCode < 300);
       m_api.buildErrorMessage(m_api.m_transport.lastResult);
@@ -138,6 +152,9 @@ void ApiClientLifecycleController::handle() {
       } else {
         m_api.handleFailedUpload(m_api.m_transport.lastResult, m_api.m_deps.configManager.getConfig());
       }
+      if (m_api.m_runtime.route.loadedRecordSource != ApiClient::UploadRecordSource::NONE) {
+        m_api.discardReadAheadRecord();
+      }
 
       m_api.transitionState(ApiClient::HttpState::IDLE);
       m_api.releaseSharedBuffer();
@@ -146,12 +163,16 @@ void ApiClientLifecycleController::handle() {
       if (m_api.m_transport.activeClient) {
         m_api.m_transport.activeClient->stop();
       }
+      UploadLatency::recordFailure(m_api.m_transport.latencyTarget);
 
       if (m_api.m_runtime.route.targetIsEdge) {
         m_api.processGatewayResult(m_api.m_transport.lastResult);
       } else {
         m_api.handleFailedUpload(m_api.m_transport.lastResult, m_api.m_deps.configManager.getConfig());
       }
+      if (m_api.m_runtime.route.loadedRecordSource != ApiClient::UploadRecordSource::NONE) {
+        m_api.discardReadAheadRecord();
+      }
 
       m_api.transitionState(ApiClient::HttpState::IDLE);
       m_api.releaseSharedBuffer();
@@ -304,6 +325,31 @@ void ApiClientLifecycleController::requestImmediateUpload(bool restoreWsAfterUpl
   }
 }
 
+void ApiClientLifecycleController::beginUploadWindow() {
+  if (m_transport.httpState != ApiClient::HttpState::IDLE || m_runtime.uploadState != ApiClient::UploadState::IDLE) {
+    return;
+  }
+  if (m_deps.cacheManager.get_size() > 0 || RtcManager::getCount() > 0) {
+    m_runtime.uploadState = ApiClient::UploadState::UPLOADING;
+  }
+}
+
+bool ApiClientLifecycleController::isBacklogDrained() const {
+  return m_transport.httpState == ApiClient::HttpState::IDLE &&
+         m_runtime.uploadState == ApiClient::UploadState::IDLE && !m_runtime.immediate.requested &&
+         RtcManager::getCount() == 0 && m_deps.cacheManager.get_size() == 0;
+}
+
+void ApiClientLifecycleController::prepareForSleep() {
+  // A window that could not drain would otherwise turn every following wake into an upload
+  // wake; moving the RTC backlog to LittleFS gives the next windows a full RTC's worth of room.
+  if (static_cast<uint32_t>(RtcManager::getCount()) * 100U >=
+      static_cast<uint32_t>(RTC_MAX_RECORDS) * DEEP_SLEEP_UPLOAD_FILL_PCT) {
+    m_api.flushRtcToLittleFs();
+  }
+  m_deps.cacheManager.flush();
+}
+
 ApiClient::ApiClient(AsyncWebSocket& ws,
                      NtpClient& ntpClient,
                      WifiManager& wifiManager,
@@ -352,3 +398,15 @@ void ApiClient::requestImmediateUpload() {
 unsigned long ApiClient::getLastSuccessMillis() const {
   return m_runtime.lastApiSuccessMillis;
 }
+
+void ApiClient::beginUploadWindow() {
+  ApiClientLifecycleController(*this).beginUploadWindow();
+}
+
+bool ApiClient::isBacklogDrained() const {
+  return ApiClientLifecycleController(const_cast<ApiClient&>(*this)).isBacklogDrained();
+}
+
+void ApiClient::prepareForSleep() {
+  ApiClientLifecycleController(*this).prepareForSleep();
+}
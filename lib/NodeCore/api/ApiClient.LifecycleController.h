@@ -23,6 +23,9 @@ public:
   void handle();
   void scheduleImmediateUpload();
   void requestImmediateUpload(bool restoreWsAfterUpload);
+  void beginUploadWindow();
+  bool isBacklogDrained() const;
+  void prepareForSleep();
 
 private:
   ApiClient& m_api;
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cstring>
 #include <new>
+#include <strings.h>
 
 #include "storage/CacheManager.h"  // Concrete type for CRTP
 #include "support/CompileTimeJSON.h"
@@ -23,6 +24,8 @@
 #include "sensor/SensorData.h"
 #include "support/Utils.h"
 #include "api/ApiClient.Health.h"
+#include "api/ApiClient.TransportShared.h"
+#include "api/ApiClient.UploadShared.h"
 
 // ApiClient.Qos.cpp - QoS testing
 
@@ -36,6 +39,17 @@ void ApiClientQosController::requestOta() {
 
 namespace {
   constexpr int kQosSamples = 5;
+  // Throughput probe bodies: the current batch by default, at most the largest batch a build
+  // may be configured for, so a site can be measured before UPLOAD_BATCH_MAX_RECORDS is raised.
+  constexpr size_t kQosDefaultBodyBytes =
+      ApiClientDetail::kUploadBatchMaxRecords * ApiClientDetail::kUploadBatchRecordSlot + 1;
+  constexpr size_t kQosMaxBodyBytes = 32 * ApiClientDetail::kUploadBatchRecordSlot + 1;
+  static_assert(kQosMaxBodyBytes <= 0xFFFF, "QoS body size must fit QosRuntime::bodyBytes");
+  // Sweep order: cloud direct, relay, then the edge gateway candidates.
+  constexpr uint8_t kQosTargetCloud = 0;
+  constexpr uint8_t kQosTargetRelay = 1;
+  constexpr uint8_t kQosTargetEdgeFirst = 2;
+  constexpr uint8_t kQosTargetEnd = kQosTargetEdgeFirst + 4;
 
   static void copy_trunc(char* dst, size_t dst_len, const char* src) {
     if (!dst || dst_len == 0) {
@@ -160,6 +174,9 @@ void ApiClientQosController::handlePendingTask() {
       }
       performTest("REDACTED", urlBuf, "REDACTED", "REDACTED");
       m_qos.pendingTask = QosTaskType::NONE;
+    } else if (m_qos.pendingTask == QosTaskType::THROUGHPUT) {
+      m_qos.pendingTask = QosTaskType::NONE;
+      startThroughput();
     } else {
       return;
     }
@@ -185,27 +202,44 @@ void ApiClientQosController::handlePendingTask() {
     return;
   }
   unsigned long duration = 0;
+  const size_t bodyLen = m_qos.throughput ? m_qos.bodyBytes : 0;
   if (m_api.executeQosSample(*m_transport.httpClient,
                              m_qos.buffers->url,
                              m_qos.buffers->method,
                              m_qos.buffers->payload,
+                             bodyLen,
                              m_qos.usesOtaToken,
                              cfg,
                              duration)) {
-    updateStats(duration, m_qos.successCount, m_qos.totalDuration, m_qos.minLat, m_qos.maxLat);
+    if (m_qos.throughput) {
+      m_qos.buffers->window.add(duration, bodyLen);
+    } else {
+      updateStats(duration, m_qos.successCount, m_qos.totalDuration, m_qos.minLat, m_qos.maxLat);
+    }
   } else {
     LOG_WARN("QoS", F("Req %d failed"), m_qos.sampleIdx + 1);
   }
 
   m_qos.sampleIdx++;
-  if (m_qos.sampleIdx >= kQosSamples) {
-    reportResults(m_qos.targetName,
-                  m_qos.successCount,
-                  kQosSamples,
-                  m_qos.minLat,
-                  m_qos.maxLat,
-                  m_qos.totalDuration);
+  if (m_qos.sampleIdx >= m_qos.sampleTotal) {
+    if (m_qos.throughput) {
+      reportThroughput();
+      m_qos.targetIdx++;
+      if (loadThroughputTarget()) {
+        m_qos.nextAt = millis() + 100;
+        return;
+      }
+      m_api.broadcastEncrypted(F("[QoS] Throughput sweep complete."));
+    } else {
+      reportResults(m_qos.targetName,
+                    m_qos.successCount,
+                    m_qos.sampleTotal,
+                    m_qos.minLat,
+                    m_qos.maxLat,
+                    m_qos.totalDuration);
+    }
     m_qos.active = false;
+    m_qos.throughput = false;
     m_qos.buffers.reset();
     m_transport.httpClient.reset();
   } else {
@@ -297,19 +331,43 @@ void ApiClientQosController::performTest(const char* targetName,
   }
   LOG_INFO("QoS", F("Testing %s (%s)"), targetName, url);
 
+  if (!acquireTestResources()) {
+    return;
+  }
+
+  copy_trunc(m_qos.buffers->url, sizeof(m_qos.buffers->url), url);
+  copy_trunc(m_qos.buffers->method, sizeof(m_qos.buffers->method), method);
+  copy_trunc(m_qos.buffers->payload, sizeof(m_qos.buffers->payload), payload);
+  m_qos.targetName = targetName;
+  m_qos.usesOtaToken = REDACTED
+  m_qos.throughput = false;
+  m_qos.sampleTotal = kQosSamples;
+  m_qos.sampleIdx = 0;
+  m_qos.successCount = 0;
+  m_qos.totalDuration = REDACTED
+  m_qos.minLat = 0xFFFFFFFFu;
+  m_qos.maxLat = 0;
+  m_qos.nextAt = millis();
+  m_qos.active = true;
+
+  m_transport.httpClient->setReuse(true);
+  m_transport.httpClient->setTimeout(m_policy.connectTimeoutMs);
+}
+
+bool ApiClientQosController::acquireTestResources() {
   // Verify sufficient heap availability.
   const ApiClientHealth::HeapBudget apiBudget = ApiClientHealth::captureApiHeapBudget(m_ctx);
   if (!apiBudget.healthy) {
     LOG_ERROR("MEM", F("QoS Cancelled: Fragmentation too high! (Block: %u)"), apiBudget.maxBlock);
     m_api.broadcastEncrypted(F("[SYSTEM] QoS Cancelled: Low contiguous RAM. Try rebooting."));
-    return;
+    return false;
   }
 
   m_qos.buffers.reset(new (std::nothrow) QosBuffers());
   if (!m_qos.buffers) {
     LOG_ERROR("QoS", F("Buffer alloc failed"));
     m_api.broadcastEncrypted(F("[SYSTEM] QoS Cancelled: Buffer alloc failed."));
-    return;
+    return false;
   }
 
   if (!m_transport.httpClient) {
@@ -318,25 +376,124 @@ void ApiClientQosController::performTest(const char* targetName,
       LOG_ERROR("QoS", F("HTTP alloc failed"));
       m_api.broadcastEncrypted(F("[SYSTEM] QoS Cancelled: HTTP alloc failed."));
       m_qos.buffers.reset();
-      return;
+      return false;
     }
   }
+  return true;
+}
 
-  copy_trunc(m_qos.buffers->url, sizeof(m_qos.buffers->url), url);
-  copy_trunc(m_qos.buffers->method, sizeof(m_qos.buffers->method), method);
-  copy_trunc(m_qos.buffers->payload, sizeof(m_qos.buffers->payload), payload);
-  m_qos.targetName = targetName;
-  m_qos.usesOtaToken = REDACTED
-  m_qos.sampleIdx = 0;
-  m_qos.successCount = 0;
-  m_qos.totalDuration = REDACTED
-  m_qos.minLat = 0xFFFFFFFFu;
-  m_qos.maxLat = 0;
+// =============================================================================
+// Throughput sweep
+// =============================================================================
+
+bool ApiClientQosController::requestThroughput(uint16_t bodyBytes, uint8_t samples) {
+  if (m_qos.active || m_qos.pendingTask != QosTaskType::NONE) {
+    return false;
+  }
+  const size_t body = (bodyBytes == 0) ? kQosDefaultBodyBytes : bodyBytes;
+  m_qos.bodyBytes = static_cast<uint16_t>(std::clamp(body, QosProbe::kMinBodyLen, kQosMaxBodyBytes));
+  m_qos.sampleTotal = (samples == 0) ? QosProbe::kDefaultSamples : std::min(samples, QosProbe::kMaxSamples);
+  m_qos.pendingTask = QosTaskType::THROUGHPUT;
+  return true;
+}
+
+void ApiClientQosController::startThroughput() {
+  if (m_qos.active || !acquireTestResources()) {
+    return;
+  }
+  copy_trunc(m_qos.buffers->method, sizeof(m_qos.buffers->method), "POST");
+  m_qos.targetName = m_qos.buffers->label;
+  m_qos.usesOtaToken = false;
+  m_qos.throughput = true;
+  m_qos.targetIdx = kQosTargetCloud;
+  m_transport.httpClient->setReuse(true);
+  if (!loadThroughputTarget()) {
+    m_qos.throughput = false;
+    m_qos.buffers.reset();
+    return;
+  }
+
+  char msgBuf[96];
+  snprintf_P(msgBuf,
+             sizeof(msgBuf),
+             PSTR("[QoS] Throughput sweep: %u B x %u requests per target..."),
+             static_cast<unsigned>(m_qos.bodyBytes),
+             static_cast<unsigned>(m_qos.sampleTotal));
+  m_api.broadcastEncrypted(msgBuf);
   m_qos.nextAt = millis();
   m_qos.active = true;
+}
 
-  m_transport.httpClient->setReuse(true);
-  m_transport.httpClient->setTimeout(m_policy.connectTimeoutMs);
+bool ApiClientQosController::loadThroughputTarget() {
+  QosBuffers& buf = *m_qos.buffers;
+  const ApiClientTransportShared::EdgeGatewayTargets edge =
+      ApiClientTransportShared::resolveEdgeGatewayTargets(m_deps.configManager);
+  const char* hosts[] = {edge.primaryMdns, edge.primaryIp, edge.secondaryMdns, edge.secondaryIp};
+
+  for (; m_qos.targetIdx < kQosTargetEnd; ++m_qos.targetIdx) {
+    buf.url[0] = '\0';
+    if (m_qos.targetIdx == kQosTargetCloud) {
+      copy_trunc(buf.url, sizeof(buf.url), m_deps.configManager.getDataUploadUrl());
+      m_deps.configManager.releaseStrings();
+      copy_trunc(buf.label, sizeof(buf.label), "cloud");
+    } else if (m_qos.targetIdx == kQosTargetRelay) {
+      copy_trunc(buf.url, sizeof(buf.url), DEFAULT_RELAY_DATA_URL);
+      copy_trunc(buf.label, sizeof(buf.label), "relay");
+    } else {
+      const size_t k = m_qos.targetIdx - kQosTargetEdgeFirst;
+      bool seen = false;
+      for (size_t j = 0; j < k; ++j) {
+        seen = seen || strcasecmp(hosts[j], hosts[k]) == 0;
+      }
+      if (seen || hosts[k][0] == '\0' ||
+          !ApiClientUploadShared::build_gateway_url_from_host_str(buf.url, sizeof(buf.url), hosts[k], "/api/data")) {
+        continue;
+      }
+      size_t pos = append_literal_P(buf.label, sizeof(buf.label), 0, PSTR("edge "));
+      append_cstr(buf.label, sizeof(buf.label), pos, hosts[k]);
+    }
+    if (buf.url[0] == '\0') {
+      continue;
+    }
+    const bool edgeTarget = m_qos.targetIdx >= kQosTargetEdgeFirst;
+    m_transport.httpClient->setTimeout(edgeTarget ? m_policy.edgeHttpTimeoutMs : m_policy.connectTimeoutMs);
+    buf.window.reset();
+    m_qos.sampleIdx = 0;
+    LOG_INFO("QoS", F("Throughput %s (%s)"), buf.label, buf.url);
+    return true;
+  }
+  return false;
+}
+
+void ApiClientQosController::reportThroughput() {
+  QosProbe::Window& window = m_qos.buffers->window;
+  window.finish();
+
+  char report[256];
+  const int len = snprintf_P(report,
+                             sizeof(report),
+                             PSTR("\n[REPORT] Throughput: %s (%u B)\n"
+                                  " Requests    : %u/%u success\n"
+                                  " Throughput  : %lu B/s\n"
+                                  " Latency (RT): p50: %lu ms | p90: %lu ms | p99: %lu ms\n"
+                                  "-----------------------------"),
+                             m_qos.buffers->label,
+                             static_cast<unsigned>(m_qos.bodyBytes),
+                             static_cast<unsigned>(window.count),
+                             static_cast<unsigned>(m_qos.sampleTotal),
+                             static_cast<unsigned long>(window.bytesPerSec()),
+                             static_cast<unsigned long>(window.percentile(50)),
+                             static_cast<unsigned long>(window.percentile(90)),
+                             static_cast<unsigned long>(window.percentile(99)));
+  if (len > 0) {
+    m_api.broadcastEncrypted(std::string_view(report, std::min<size_t>(static_cast<size_t>(len), sizeof(report) - 1)));
+  }
+  LOG_INFO("QoS",
+           F("Throughput %s: %u/%u ok, %lu B/s"),
+           m_qos.buffers->label,
+           static_cast<unsigned>(window.count),
+           static_cast<unsigned>(m_qos.sampleTotal),
+           static_cast<unsigned long>(window.bytesPerSec()));
 }
 
 void ApiClient::requestQosUpload() {
@@ -347,6 +504,10 @@ void ApiClient::requestQosOta() {
   ApiClientQosController(*this).requestOta();
 }
 
+bool ApiClient::requestQosThroughput(uint16_t bodyBytes, uint8_t samples) {
+  return ApiClientQosController(*this).requestThroughput(bodyBytes, samples);
+}
+
 void ApiClient::handlePendingQosTask() {
   ApiClientQosController(*this).handlePendingTask();
 }
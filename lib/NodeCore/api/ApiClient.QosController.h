@@ -30,6 +30,7 @@ public:
 
   void requestUpload();
   void requestOta();
+  bool requestThroughput(uint16_t bodyBytes, uint8_t samples);
   void handlePendingTask();
   void updateStats(unsigned long duration,
                    int& successCount,
@@ -45,6 +46,12 @@ public:
   void performTest(const char* targetName, const char* url, const char* method, const char* payload);
 
 private:
+  bool acquireTestResources();
+  void startThroughput();
+  // Points the buffers at the sweep target at m_qos.targetIdx or the next usable one.
+  bool loadThroughputTarget();
+  void reportThroughput();
+
   ApiClient& m_api;
   ControllerContext& m_ctx;
   DependencyRefs& m_deps;
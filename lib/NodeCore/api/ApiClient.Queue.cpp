@@ -14,6 +14,14 @@ ApiClient::UploadRecordLoad ApiClient::loadRecordForUpload(size_t& record_len) {
   return ApiClientQueueController(*this).loadRecordForUpload(record_len);
 }
 
+void ApiClient::readAheadNextRecord() {
+  ApiClientQueueController(*this).readAheadNextRecord();
+}
+
+void ApiClient::discardReadAheadRecord() {
+  ApiClientQueueController(*this).discardReadAheadRecord();
+}
+
 bool ApiClient::popLoadedRecord() {
   return ApiClientQueueController(*this).popLoadedRecord();
 }
@@ -2,6 +2,7 @@
 #define API_CLIENT_QUEUE_CONTROLLER_H
 
 #include "api/ApiClient.h"
+#include "interfaces/ICacheManager.h"
 
 class ApiClientQueueController {
 public:
@@ -17,8 +18,11 @@ public:
         m_health(m_ctx.health) {}
 
   ApiClient::UploadRecordLoad loadRecordFromRtc(size_t& record_len);
-  ApiClient::UploadRecordLoad loadRecordFromLittleFs(size_t& record_len);
+  ApiClient::UploadRecordLoad loadRecordFromLittleFs(size_t& record_len, CacheLane lane = CacheLane::ROUTINE);
   ApiClient::UploadRecordLoad loadRecordForUpload(size_t& record_len);
+  void readAheadNextRecord();
+  bool takeReadAheadRecord(size_t& record_len);
+  void discardReadAheadRecord();
   bool popLoadedRecord();
   void applyQueuePopFailureCooldown(const AppConfig& cfg, const char* sourceTag);
   void logEmergencyQueueState(ApiClient::EmergencyQueueReason reason);
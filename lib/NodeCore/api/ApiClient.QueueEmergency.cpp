@@ -28,6 +28,17 @@ using namespace ApiClientUploadShared;
 
 // ApiClient.QueueEmergency.cpp - emergency queue persistence and backpressure orchestration
 
+namespace {
+  // A reading outside the alert bounds. All-zero fields mean the sensors were not read.
+  bool is_alert_record(const ApiClient::EmergencyRecord& record) {
+    if (record.temp10 == 0 && record.hum10 == 0) {
+      return false;
+    }
+    return record.temp10 < ApiClientDetail::kAlertTempMin10 || record.temp10 > ApiClientDetail::kAlertTempMax10 ||
+           record.hum10 < ApiClientDetail::kAlertHumMin10 || record.hum10 > ApiClientDetail::kAlertHumMax10;
+  }
+}  // namespace
+
 void ApiClientQueueController::applyQueuePopFailureCooldown(const AppConfig& cfg, const char* sourceTag) {
   if (m_api.m_runtime.queue.popFailStreak < 8) {
     m_api.m_runtime.queue.popFailStreak++;
@@ -124,6 +135,24 @@ void ApiClientQueueController::logEmergencyQueueState(ApiClient::EmergencyQueueR
 bool ApiClientQueueController::persistEmergencyRecord(const ApiClient::EmergencyRecord& record, bool allowDirectSend) {
   const unsigned long nowMs = millis();
 
+  // Alerts skip RTC, whose contents reach LittleFS only as routine blocks behind the backlog.
+  if (is_alert_record(record)) {
+    RtcSensorRecord compact{};
+    compact.timestamp = record.timestamp;
+    compact.temp10 = record.temp10;
+    compact.hum10 = record.hum10;
+    compact.lux = record.lux;
+    compact.rssi = record.rssi;
+    if (m_api.m_deps.cacheManager.write_sensor_record(compact, CacheLane::PRIORITY)) {
+      LOG_WARN("API",
+               F("Alert sample (T=%d H=%d) queued in priority lane"),
+               static_cast<int>(record.temp10),
+               static_cast<int>(record.hum10));
+      return true;
+    }
+    LOG_WARN("API", F("Priority lane write failed, storing alert with routine samples"));
+  }
+
   const bool rtcHasCapacity = !RtcManager::isFull();
   if (rtcHasCapacity && m_api.appendEmergencyRecordToRtc(record, allowDirectSend)) {
     return true;
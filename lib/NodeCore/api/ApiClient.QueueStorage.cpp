@@ -7,13 +7,17 @@
 #include <user_interface.h>
 
 #include <algorithm>
+#include <memory>
+#include <new>
 
 #include "storage/CacheManager.h"
 #include "support/CompileTimeJSON.h"
 #include "system/ConfigManager.h"
 #include "support/CryptoUtils.h"
 #include "system/Logger.h"
+#include "net/EdgeWireCodec.h"
 #include "net/NtpClient.h"
+#include "storage/QueueReadAhead.h"
 #include "storage/RtcManager.h"
 #include "sensor/SensorManager.h"
 #include "REDACTED"
@@ -22,12 +26,29 @@
 #include "sensor/SensorData.h"
 #include "support/Utils.h"
 
+#include "api/ApiClient.Health.h"
 #include "api/ApiClient.UploadShared.h"
 
 using namespace ApiClientUploadShared;
 
 // ApiClient.QueueStorage.cpp - persisted record loading and RTC/LittleFS flushing
 
+// ApiClient's aliases are private; file-local helpers name the type in ApiClientDetail.
+namespace {
+  ApiClientDetail::UploadRecordSource uploadSourceFor(QueueReadAhead::Source source) {
+    switch (source) {
+      case QueueReadAhead::Source::PRIORITY:
+        return ApiClientDetail::UploadRecordSource::PRIORITY;
+      case QueueReadAhead::Source::RTC:
+        return ApiClientDetail::UploadRecordSource::RTC;
+      case QueueReadAhead::Source::ROUTINE:
+        return ApiClientDetail::UploadRecordSource::LITTLEFS;
+      default:
+        return ApiClientDetail::UploadRecordSource::NONE;
+    }
+  }
+}  // namespace
+
 ApiClient::UploadRecordLoad ApiClientQueueController::loadRecordFromRtc(size_t& record_len) {
   record_len = 0;
   char* buf = m_api.sharedBuffer();
@@ -58,10 +79,14 @@ ApiClient::UploadRecordLoad ApiClientQueueController::loadRecordFromRtc(size_t&
   if (!build_payload_from_rtc_record(buf, buf_len, rec, record_len)) {
     return ApiClient::UploadRecordLoad::FATAL;
   }
+  if (EDGE_WIRE_CBOR) {
+    m_api.m_runtime.route.edgeRecord = SensorAggregateCodec::from_sample(rec);
+    m_api.m_runtime.route.edgeRecordTyped = true;
+  }
   return ApiClient::UploadRecordLoad::READY;
 }
 
-ApiClient::UploadRecordLoad ApiClientQueueController::loadRecordFromLittleFs(size_t& record_len) {
+ApiClient::UploadRecordLoad ApiClientQueueController::loadRecordFromLittleFs(size_t& record_len, CacheLane lane) {
   record_len = 0;
   char* buf = m_api.sharedBuffer();
   const size_t buf_len = m_api.sharedBufferSize();
@@ -69,10 +94,18 @@ ApiClient::UploadRecordLoad ApiClientQueueController::loadRecordFromLittleFs(siz
     return ApiClient::UploadRecordLoad::FATAL;
   }
 
-  CacheReadError err = m_api.m_deps.cacheManager.read_one(buf, buf_len - 1, record_len);
+  const ApiClient::UploadRecordSource source =
+      (lane == CacheLane::PRIORITY) ? ApiClient::UploadRecordSource::PRIORITY : ApiClient::UploadRecordSource::LITTLEFS;
+  CacheReadError err = m_api.m_deps.cacheManager.read_one(buf, buf_len - 1, record_len, lane);
   if (err == CacheReadError::NONE && record_len > 0) {
-    buf[record_len] = '\0';
-    return ApiClient::UploadRecordLoad::READY;
+    if (EDGE_WIRE_CBOR) {
+      m_api.m_runtime.route.edgeRecordTyped = decode_cached_sample(buf, record_len, m_api.m_runtime.route.edgeRecord);
+    }
+    if (render_cached_record(buf, buf_len, record_len)) {
+      buf[record_len] = '\0';
+      return ApiClient::UploadRecordLoad::READY;
+    }
+    err = CacheReadError::CORRUPT_DATA;
   }
   if (err == CacheReadError::CACHE_EMPTY || (err == CacheReadError::NONE && record_len == 0)) {
     return ApiClient::UploadRecordLoad::EMPTY;
@@ -82,8 +115,8 @@ ApiClient::UploadRecordLoad ApiClientQueueController::loadRecordFromLittleFs(siz
   }
   if (err == CacheReadError::CORRUPT_DATA) {
     m_api.broadcastEncrypted(F("[SYSTEM] LittleFS record corrupt, dropped."));
-    (void)m_api.m_deps.cacheManager.pop_one();
-    if (m_api.m_runtime.route.loadedRecordSource == ApiClient::UploadRecordSource::LITTLEFS) {
+    (void)m_api.m_deps.cacheManager.pop_one(lane);
+    if (m_api.m_runtime.route.loadedRecordSource == source) {
       m_api.clearLoadedRecordContext();
     }
     return ApiClient::UploadRecordLoad::RETRY;
@@ -93,8 +126,27 @@ ApiClient::UploadRecordLoad ApiClientQueueController::loadRecordFromLittleFs(siz
 
 ApiClient::UploadRecordLoad ApiClientQueueController::loadRecordForUpload(size_t& record_len) {
   record_len = 0;
+  m_api.m_runtime.route.batchRtcRecords = 0;
+  m_api.m_runtime.route.batchLittleFsRecords = 0;
+  m_api.m_runtime.route.body = ApiClient::UploadBody();
+  m_api.m_runtime.route.edgeRecordTyped = false;
 
-  if (m_api.m_runtime.route.loadedRecordSource == ApiClient::UploadRecordSource::RTC) {
+  // A read-ahead only stands for the next record once the one it was read behind has been popped.
+  if (m_api.m_runtime.route.loadedRecordSource == ApiClient::UploadRecordSource::NONE) {
+    if (takeReadAheadRecord(record_len)) {
+      return ApiClient::UploadRecordLoad::READY;
+    }
+  } else {
+    discardReadAheadRecord();
+  }
+
+  if (m_api.m_runtime.route.loadedRecordSource == ApiClient::UploadRecordSource::PRIORITY) {
+    ApiClient::UploadRecordLoad locked = loadRecordFromLittleFs(record_len, CacheLane::PRIORITY);
+    if (locked == ApiClient::UploadRecordLoad::READY || locked == ApiClient::UploadRecordLoad::RETRY) {
+      return locked;
+    }
+    m_api.m_runtime.route.loadedRecordSource = ApiClient::UploadRecordSource::NONE;
+  } else if (m_api.m_runtime.route.loadedRecordSource == ApiClient::UploadRecordSource::RTC) {
     ApiClient::UploadRecordLoad locked = loadRecordFromRtc(record_len);
     if (locked == ApiClient::UploadRecordLoad::READY || locked == ApiClient::UploadRecordLoad::RETRY) {
       return locked;
@@ -108,6 +160,16 @@ ApiClient::UploadRecordLoad ApiClientQueueController::loadRecordForUpload(size_t
     m_api.m_runtime.route.loadedRecordSource = ApiClient::UploadRecordSource::NONE;
   }
 
+  // Alerts first, however much routine backlog is waiting behind them.
+  ApiClient::UploadRecordLoad alertLoad = ApiClient::UploadRecordLoad::EMPTY;
+  if (m_api.m_deps.cacheManager.get_lane_size(CacheLane::PRIORITY) > 0) {
+    alertLoad = loadRecordFromLittleFs(record_len, CacheLane::PRIORITY);
+    if (alertLoad == ApiClient::UploadRecordLoad::READY) {
+      m_api.m_runtime.route.loadedRecordSource = ApiClient::UploadRecordSource::PRIORITY;
+      return ApiClient::UploadRecordLoad::READY;
+    }
+  }
+
   ApiClient::UploadRecordLoad rtcLoad = loadRecordFromRtc(record_len);
   if (rtcLoad == ApiClient::UploadRecordLoad::READY) {
     m_api.m_runtime.route.loadedRecordSource = ApiClient::UploadRecordSource::RTC;
@@ -120,19 +182,144 @@ ApiClient::UploadRecordLoad ApiClientQueueController::loadRecordForUpload(size_t
     return ApiClient::UploadRecordLoad::READY;
   }
 
-  if (rtcLoad == ApiClient::UploadRecordLoad::FATAL || lfsLoad == ApiClient::UploadRecordLoad::FATAL) {
+  if (alertLoad == ApiClient::UploadRecordLoad::FATAL || rtcLoad == ApiClient::UploadRecordLoad::FATAL ||
+      lfsLoad == ApiClient::UploadRecordLoad::FATAL) {
     return ApiClient::UploadRecordLoad::FATAL;
   }
-  if (rtcLoad == ApiClient::UploadRecordLoad::RETRY || lfsLoad == ApiClient::UploadRecordLoad::RETRY) {
+  if (alertLoad == ApiClient::UploadRecordLoad::RETRY || rtcLoad == ApiClient::UploadRecordLoad::RETRY ||
+      lfsLoad == ApiClient::UploadRecordLoad::RETRY) {
     return ApiClient::UploadRecordLoad::RETRY;
   }
   return ApiClient::UploadRecordLoad::EMPTY;
 }
 
+void ApiClientQueueController::readAheadNextRecord() {
+  auto& queue = m_runtime.queue;
+  const auto& route = m_runtime.route;
+  if (queue.readAheadTried) {
+    return;
+  }
+  queue.readAheadTried = true;
+
+  // Only a cloud upload of a stored record pops it on success; a gateway send keeps it for the
+  // cloud, so the record behind it would not be next.
+  if (route.targetIsEdge || route.loadedRecordSource == ApiClient::UploadRecordSource::NONE ||
+      queue.liveSnapshotInFlight || m_resources.readAheadBuffer) {
+    return;
+  }
+  // The spare buffer is held next to the TLS session, so it must fit on top of the TLS guard.
+  const ApiClientHealth::HeapBudget budget = ApiClientHealth::captureTlsHeapBudget(m_ctx);
+  if (!budget.healthy || budget.maxBlock < budget.minBlock + sizeof(ApiClient::PayloadBuffer) ||
+      budget.freeHeap < budget.minTotal + sizeof(ApiClient::PayloadBuffer)) {
+    return;
+  }
+  std::unique_ptr<ApiClient::PayloadBuffer> buf(new (std::nothrow) ApiClient::PayloadBuffer());
+  if (!buf) {
+    return;
+  }
+
+  const bool batch = route.batchRtcRecords > 0 || route.batchLittleFsRecords > 0;
+  QueueReadAhead::InFlight inFlight;
+  switch (route.loadedRecordSource) {
+    case ApiClient::UploadRecordSource::PRIORITY:
+      inFlight.priority = batch ? route.batchLittleFsRecords : 1;
+      break;
+    case ApiClient::UploadRecordSource::RTC:
+      inFlight.rtc = batch ? route.batchRtcRecords : 1;
+      inFlight.routine = batch ? route.batchLittleFsRecords : 0;
+      break;
+    default:
+      inFlight.routine = batch ? route.batchLittleFsRecords : 1;
+      break;
+  }
+
+  const QueueReadAhead::Ticket ticket = QueueReadAhead::read(
+      m_deps.cacheManager,
+      inFlight,
+      buf->data(),
+      buf->size(),
+      [](char* out, size_t out_len, const RtcSensorRecord& record, size_t& len) {
+        return build_payload_from_rtc_record(out, out_len, record, len);
+      },
+      [](char* out, size_t out_len, size_t& len) {
+        if (!render_cached_record(out, out_len, len)) {
+          return false;
+        }
+        out[len] = '\0';
+        return true;
+      });
+  if (ticket.source == QueueReadAhead::Source::NONE) {
+    return;
+  }
+  queue.readAhead = ticket;
+  m_resources.readAheadBuffer.swap(buf);
+}
+
+bool ApiClientQueueController::takeReadAheadRecord(size_t& record_len) {
+  const QueueReadAhead::Ticket ticket = m_runtime.queue.readAhead;
+  std::unique_ptr<ApiClient::PayloadBuffer> buf;
+  buf.swap(m_resources.readAheadBuffer);
+  discardReadAheadRecord();
+  if (!buf || !m_resources.sharedBuffer || ticket.source == QueueReadAhead::Source::NONE) {
+    return false;
+  }
+  if (!QueueReadAhead::valid(m_deps.cacheManager, ticket)) {
+    LOG_DEBUG("API", F("Read-ahead record stale; loading from storage"));
+    return false;
+  }
+  // The previous shared buffer goes out with `buf`.
+  m_resources.sharedBuffer.swap(buf);
+  record_len = ticket.length;
+  (*m_resources.sharedBuffer)[record_len] = '\0';
+  m_runtime.route.loadedRecordSource = uploadSourceFor(ticket.source);
+  return true;
+}
+
+void ApiClientQueueController::discardReadAheadRecord() {
+  m_resources.readAheadBuffer.reset();
+  m_runtime.queue.readAhead = QueueReadAhead::Ticket();
+  m_runtime.queue.readAheadTried = false;
+}
+
 bool ApiClientQueueController::popLoadedRecord() {
-  if (m_api.m_runtime.route.loadedRecordSource == ApiClient::UploadRecordSource::LITTLEFS) {
+  auto& route = m_api.m_runtime.route;
+  const CacheLane lane =
+      (route.loadedRecordSource == ApiClient::UploadRecordSource::PRIORITY) ? CacheLane::PRIORITY : CacheLane::ROUTINE;
+  if (route.batchRtcRecords > 0 || route.batchLittleFsRecords > 0) {
+    // Batch counters are consumed as each part is popped so a failed pop resumes where it stopped.
+    if (route.batchRtcRecords > 0) {
+      uint16_t popped = 0;
+      const RtcReadStatus status = RtcManager::popThroughSeq(route.batchRtcLastSeq, route.batchRtcRecords, popped);
+      if (status == RtcReadStatus::FILE_READ_ERROR) {
+        return false;
+      }
+      route.batchRtcRecords = 0;
+    }
+    if (route.batchLittleFsRecords > 0) {
+      // Bulk pop moves the tail once; anything it could not consume falls through to pop_one().
+      const size_t bulk = m_api.m_deps.cacheManager.pop_many(route.batchLittleFsRecords, lane);
+      route.batchLittleFsRecords = static_cast<uint16_t>(route.batchLittleFsRecords - bulk);
+    }
+    while (route.batchLittleFsRecords > 0) {
+      bool popped = false;
+      for (uint8_t i = 0; i < 3 && !popped; ++i) {
+        popped = m_api.m_deps.cacheManager.pop_one(lane);
+        if (!popped) {
+          ESP.wdtFeed();
+          yield();
+        }
+      }
+      if (!popped) {
+        return false;
+      }
+      route.batchLittleFsRecords--;
+    }
+    return true;
+  }
+  if (route.loadedRecordSource == ApiClient::UploadRecordSource::LITTLEFS ||
+      route.loadedRecordSource == ApiClient::UploadRecordSource::PRIORITY) {
     for (uint8_t i = 0; i < 3; ++i) {
-      if (m_api.m_deps.cacheManager.pop_one()) {
+      if (m_api.m_deps.cacheManager.pop_one(lane)) {
         return true;
       }
       ESP.wdtFeed();
@@ -172,105 +359,72 @@ void ApiClientQueueController::flushRtcToLittleFs() {
       m_api.broadcastEncrypted(std::string_view(msg, len));
     }
   }
-  char* buf = m_api.sharedBuffer();
-  const size_t buf_len = m_api.sharedBufferSize();
-  if (!buf || buf_len == 0) {
-    return;
-  }
-
   const uint16_t maxAttempts = static_cast<uint16_t>(RTC_MAX_RECORDS * 4);
   uint16_t attempts = 0;
-  RtcSensorRecord lastBuildFailure{};
-  bool haveLastBuildFailure = false;
   while (attempts < maxAttempts) {
     attempts++;
 
-    RtcSensorRecord rec;
-    RtcReadStatus peekStatus = RtcManager::peekEx(rec);
-    if (peekStatus == RtcReadStatus::CACHE_EMPTY) {
-      LOG_INFO("RTC", F("[FLUSH]RTC empty, flush complete"));
-      m_api.broadcastEncrypted(F("[CACHE] RTC->LittleFS flush complete (RTC empty)."));
-      return;
-    }
-    if (peekStatus == RtcReadStatus::SCANNING) {
-      LOG_WARN("RTC", F("[FLUSH]RTC recovery scanning in progress, retrying"));
-      ESP.wdtFeed();
-      continue;
-    }
-    if (peekStatus == RtcReadStatus::CORRUPT_DATA) {
-      LOG_WARN("RTC", F("[FLUSH]RTC corrected corrupt front slot, retrying"));
-      ESP.wdtFeed();
-      continue;
-    }
-    if (peekStatus == RtcReadStatus::FILE_READ_ERROR) {
-      LOG_ERROR("RTC", F("[FLUSH]RTC read/write error while peeking"));
-      return;
-    }
+    // Every valid RTC record comes out of a single RTC read; corrupt slots in between are skipped.
+    RtcSensorRecord run[RTC_MAX_RECORDS];
+    uint16_t runSeq[RTC_MAX_RECORDS];
+    uint16_t runLen = 0;
+    const RtcReadStatus peekStatus = RtcManager::peekRun(run, runSeq, RTC_MAX_RECORDS, runLen);
 
-    size_t payloadLen = 0;
-    if (!build_payload_from_rtc_record(buf, buf_len, rec, payloadLen)) {
-      payloadLen = 0;
-    }
-    if (payloadLen == 0) {
-      if (!haveLastBuildFailure || memcmp(&lastBuildFailure, &rec, sizeof(rec)) != 0) {
-        lastBuildFailure = rec;
-        haveLastBuildFailure = true;
-        LOG_ERROR("API", F("[FLUSH]buildSensorPayload returned 0; retrying RTC front record once."));
-        ESP.wdtFeed();
-        continue;
+    if (runLen == 0) {
+      if (peekStatus == RtcReadStatus::CACHE_EMPTY) {
+        LOG_INFO("RTC", F("[FLUSH]RTC empty, flush complete"));
+        m_api.broadcastEncrypted(F("[CACHE] RTC->LittleFS flush complete (RTC empty)."));
+        return;
       }
-
-      LOG_ERROR("API", F("[FLUSH]Dropping RTC record that repeatedly fails payload serialization."));
-      RtcSensorRecord discardedOnBuildFail;
-      RtcReadStatus dropStatus = RtcManager::popEx(discardedOnBuildFail);
-      if (dropStatus == RtcReadStatus::NONE) {
-        haveLastBuildFailure = false;
+      if (peekStatus == RtcReadStatus::SCANNING) {
+        LOG_WARN("RTC", F("[FLUSH]RTC recovery scanning in progress, retrying"));
         ESP.wdtFeed();
         continue;
       }
-      if (dropStatus == RtcReadStatus::SCANNING || dropStatus == RtcReadStatus::CORRUPT_DATA) {
+      if (peekStatus == RtcReadStatus::CORRUPT_DATA) {
+        LOG_WARN("RTC", F("[FLUSH]RTC corrected corrupt front slot, retrying"));
         ESP.wdtFeed();
         continue;
       }
-      if (dropStatus == RtcReadStatus::CACHE_EMPTY) {
-        LOG_INFO("RTC", F("[FLUSH]RTC empty after dropping invalid front record"));
-        m_api.broadcastEncrypted(F("[CACHE] RTC->LittleFS flush complete (RTC empty)."));
-        return;
-      }
-      LOG_ERROR("RTC", F("[FLUSH]RTC read/write error while dropping invalid front record"));
+      LOG_ERROR("RTC", F("[FLUSH]RTC read/write error while peeking"));
       return;
     }
-    haveLastBuildFailure = false;
-    if (!m_api.m_deps.cacheManager.write(buf, payloadLen)) {
+
+    // Stored as deltas; JSON is rendered from the decoded fields only when a sample is uploaded.
+    // One block normally holds the whole run; unusually wide deltas spill into a second one.
+    size_t stored = 0;
+    while (stored < runLen) {
+      const size_t n = m_api.m_deps.cacheManager.write_sensor_block(run + stored, runLen - stored);
+      if (n == 0) {
+        break;
+      }
+      stored += n;
+    }
+    if (stored == 0) {
       LOG_ERROR("API", F("LittleFS write failed during bulk flush!"));
       return;
     }
 
-    RtcSensorRecord discarded;
-    RtcReadStatus popStatus = RtcManager::popEx(discarded);
-    if (popStatus == RtcReadStatus::NONE) {
-      ESP.wdtFeed();
-      continue;
-    }
-    if (popStatus == RtcReadStatus::SCANNING) {
-      LOG_WARN("RTC", F("[FLUSH]RTC pop deferred: recovery scanning"));
-      ESP.wdtFeed();
-      continue;
-    }
-    if (popStatus == RtcReadStatus::CORRUPT_DATA) {
-      LOG_WARN("RTC", F("[FLUSH]RTC pop hit corrupted data, retrying"));
-      ESP.wdtFeed();
-      continue;
-    }
-    if (popStatus == RtcReadStatus::CACHE_EMPTY) {
-      LOG_INFO("RTC", F("[FLUSH]RTC empty after write, flush complete"));
-      m_api.broadcastEncrypted(F("[CACHE] RTC->LittleFS flush complete (drained)."));
+    // Appends only mark the cache header dirty, and a whole run is one mutation, so the lazy
+    // header write would rarely come before RTC lets go of it. Commit it first: a reset in
+    // between then repeats the run instead of losing it from both stores. The sequence
+    // watermark keeps anything appended since intact.
+    m_api.m_deps.cacheManager.flush();
+    // Corrupt slots the run skipped go too, so the run length does not bound the pop.
+    uint16_t popped = 0;
+    if (RtcManager::popThroughSeq(runSeq[stored - 1], RTC_MAX_RECORDS, popped) == RtcReadStatus::FILE_READ_ERROR) {
+      LOG_ERROR("RTC", F("[FLUSH]RTC read/write error while popping"));
       return;
     }
-    if (popStatus == RtcReadStatus::FILE_READ_ERROR) {
-      LOG_ERROR("RTC", F("[FLUSH]RTC read/write error while popping"));
+    LOG_INFO("RTC",
+             F("[FLUSH]%u samples stored, %u RTC slots cleared"),
+             static_cast<unsigned>(stored),
+             static_cast<unsigned>(popped));
+    if (stored < runLen) {
+      LOG_ERROR("API", F("LittleFS write failed during bulk flush!"));
       return;
     }
+    ESP.wdtFeed();
   }
 
   LOG_ERROR("RTC", F("[FLUSH]Aborted by guard loop (attempts=%u)"), attempts);
@@ -9,6 +9,14 @@
 #include <ESP8266WiFi.h>
 #include <system/IntervalTimer.h>
 
+#include "net/GatewayScoreboard.h"
+#include "net/HttpKeepAlive.h"
+#include "net/QosProbe.h"
+#include "net/UploadLatency.h"
+#include "storage/QueueReadAhead.h"
+#include "storage/SensorAggregateCodec.h"
+#include "storage/UploadBatchStream.h"
+#include "support/HmacSigner.h"
 #include "system/ConfigManager.h"
 
 enum class UploadMode : uint8_t;
@@ -30,7 +38,8 @@ struct UploadResult {
 
 namespace ApiClientDetail {
 
-enum class UploadRecordSource : uint8_t { NONE, RTC, LITTLEFS };
+// PRIORITY is the LittleFS cache lane holding alert samples; it is drained before RTC and LITTLEFS.
+enum class UploadRecordSource : uint8_t { NONE, RTC, LITTLEFS, PRIORITY };
 enum class UploadRecordLoad : uint8_t { READY, EMPTY, RETRY, FATAL };
 
 struct EmergencyRecord {
@@ -52,6 +61,19 @@ enum class EmergencyQueueReason : uint8_t {
 
 static constexpr uint8_t kEmergencyQueueCapacity = 16;
 
+// What the transport renders the request body from while sending it. Only BUFFER keeps a payload
+// buffer through the connect (UPLOAD_STREAM_BATCH=0); the others are rendered again each time the
+// request is written, so the buffer is released when the upload is dispatched.
+enum class UploadBodySource : uint8_t { BUFFER, QUEUE, LIVE_SNAPSHOT, TYPED };
+
+struct UploadBody {
+  UploadBodySource source = UploadBodySource::BUFFER;
+  UploadBatchStream::Plan plan;  // QUEUE: the loaded record and any batched behind it
+  EmergencyRecord live{};        // LIVE_SNAPSHOT: a copy, since a newer snapshot may replace it meanwhile
+  int32_t nonActiveRssi = 0;     // gateway JSON and CBOR; fixed at dispatch so every rendering matches
+  uint32_t plainLen = 0;         // before gateway encryption
+};
+
 struct RoutingState {
   UploadMode uploadMode{};
   UplinkMode uplinkMode = UplinkMode::AUTO;
@@ -60,6 +82,13 @@ struct RoutingState {
   bool cloudTargetIsRelay = false;
   bool forceRelayNextCloudAttempt = false;
   UploadRecordSource loadedRecordSource = UploadRecordSource::NONE;
+  uint16_t batchRtcRecords = 0;
+  uint16_t batchRtcLastSeq = 0;
+  uint16_t batchLittleFsRecords = 0;
+  UploadBody body;
+  // Typed form of the loaded record, for a CBOR edge body (UploadBodySource::TYPED).
+  SensorAggregateCodec::SensorAggregate edgeRecord{};
+  bool edgeRecordTyped = false;
   unsigned long lastCloudRetryAttempt = 0;
   unsigned long relayPinnedUntil = 0;
   int8_t cachedGatewayMode = -1;
@@ -82,6 +111,9 @@ struct QueueState {
   bool liveSnapshotPending = false;
   bool liveSnapshotInFlight = false;
   unsigned long lastEmergencyLogMs = 0;
+  // Next record, rendered into ResourceState::readAheadBuffer while the current upload waits.
+  QueueReadAhead::Ticket readAhead{};
+  bool readAheadTried = false;
 };
 
 struct ImmediateUploadState {
@@ -97,12 +129,14 @@ struct ImmediateUploadState {
 enum class QueuedUploadTargetDecision : uint8_t { PROCEED, HOLD, WAIT };
 enum class UploadState { IDLE, UPLOADING, PAUSED };
 enum class HttpState { IDLE, CONNECTING, SENDING_REQUEST, WAITING_RESPONSE, READING_RESPONSE, COMPLETE, FAILED };
-enum class QosTaskType { NONE, UPLOAD, OTA };
+enum class QosTaskType { NONE, UPLOAD, OTA, THROUGHPUT };
 
 struct QosBuffers {
   char url[160] = {0};
   char method[8] = {0};
   char payload[64] = {0};
+  char label[24] = {0};     // target of a throughput sweep step
+  QosProbe::Window window;  // its round trips
 };
 
 struct DependencyRefs {
@@ -148,12 +182,21 @@ struct TransportRuntime {
   char lastResponseLocation[64] = {0};
   std::unique_ptr<HTTPClient> httpClient;
   WiFiClient plainClient;
+  HttpKeepAlive::Connection edgeConn;  // plainClient kept open to the edge gateway between uploads
+  GatewayScoreboard::Board edgeBoard;  // which edge gateway candidate to try first
+  UploadLatency::Target latencyTarget = UploadLatency::Target::CLOUD;  // where the request in flight goes
+  unsigned long requestStartMs = 0;
+  HmacSigner::Key signingKey;  // edge X-Signature key schedule, derived from the upload token once
 };
 
 struct QosRuntime {
   QosTaskType pendingTask = QosTaskType::NONE;
   bool active = false;
+  bool throughput = false;  // sweeping every upload target with bodyBytes-sized posts
   uint8_t sampleIdx = 0;
+  uint8_t sampleTotal = 0;
+  uint8_t targetIdx = 0;
+  uint16_t bodyBytes = 0;
   unsigned long nextAt = 0;
   int successCount = 0;
   unsigned long totalDuration = REDACTED
@@ -65,6 +65,8 @@ PGM_P ApiClient::uploadSourceLabelP(UploadRecordSource source) {
       return PSTR("RTC");
     case UploadRecordSource::LITTLEFS:
       return PSTR("LittleFS");
+    case UploadRecordSource::PRIORITY:
+      return PSTR("Priority");
     default:
       return PSTR("Unknown");
   }
@@ -115,11 +117,12 @@ bool ApiClient::executeQosSample(HTTPClient& http,
                                  const char* url,
                                  const char* method,
                                  const char* payload,
+                                 size_t bodyLen,
                                  bool useOtaToken,
                                  const AppConfig& cfg,
                                  unsigned long& duration) {
   return ApiClientTransportController(*this).executeQosSample(
-      http, url, method, payload, useOtaToken, cfg, duration);
+      http, url, method, payload, bodyLen, useOtaToken, cfg, duration);
 }
 
 void ApiClient::startUpload(const char* payload, size_t length, bool isEdgeTarget) {
@@ -18,6 +18,8 @@ public:
   using GuardPolicy = ApiClient::GuardPolicy;
   using RuntimeHealth = ApiClient::RuntimeHealth;
   using ControllerContext = ApiClient::ControllerContext;
+  using UploadBody = ApiClient::UploadBody;
+  using UploadBodySource = ApiClient::UploadBodySource;
 
   explicit ApiClientTransportController(ApiClient& api)
       : m_api(api),
@@ -42,6 +44,7 @@ public:
                         const char* url,
                         const char* method,
                         const char* payload,
+                        size_t bodyLen,
                         bool useOtaToken,
                         const AppConfig& cfg,
                         unsigned long& duration);
@@ -90,10 +93,17 @@ private:
     return m_api.sharedBuffer();
   }
 
+  char* outgoingPayload() {
+    return m_api.outgoingPayload();
+  }
+
   void releaseSharedBuffer() {
     m_api.releaseSharedBuffer();
   }
 
+  void signWithKey(const char* payload, size_t payload_len, char* signatureBuffer);
+  bool ensureSigningKey();
+
   ApiClient& m_api;
   ControllerContext& m_ctx;
   DependencyRefs& m_deps;
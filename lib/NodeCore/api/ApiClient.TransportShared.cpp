@@ -205,6 +205,14 @@ StreamWriteResult write_all(WiFiClient& client, const uint8_t* data, size_t len,
   return result;
 }
 
+size_t ClientSink::operator()(const uint8_t* data, size_t len) {
+  const StreamWriteResult r = write_all(client, data, len, timeoutMs);
+  result.written += r.written;
+  result.timedOut = result.timedOut || r.timedOut;
+  result.disconnected = result.disconnected || r.disconnected;
+  return r.written;
+}
+
 int parse_status_code(const char* line) {
   if (!line) {
     return -1;
@@ -293,8 +301,12 @@ bool copy_header_value_if_matches(const char* line, const char* name, char* out,
   return true;
 }
 
-void parse_response_headers(
-    WiFiClient& client, char* dateBuf, size_t dateBufLen, char* locationBuf, size_t locationBufLen) {
+void parse_response_headers(WiFiClient& client,
+                            char* dateBuf,
+                            size_t dateBufLen,
+                            char* locationBuf,
+                            size_t locationBufLen,
+                            HttpKeepAlive::Framing* framing) {
   char line[128];
   while (read_line(client, line, sizeof(line), 5000)) {
     if (line[0] == '\0') {
@@ -306,6 +318,9 @@ void parse_response_headers(
     if (locationBuf && locationBuf[0] == '\0') {
       (void)copy_header_value_if_matches(line, "Location", locationBuf, locationBufLen);
     }
+    if (framing) {
+      HttpKeepAlive::note_header(*framing, line);
+    }
   }
 }
 
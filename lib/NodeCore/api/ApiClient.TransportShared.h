@@ -6,6 +6,8 @@
 #include <cstddef>
 
 #include "api/ApiClient.State.h"
+#include "net/HttpKeepAlive.h"
+#include "net/HttpStreamWriter.h"
 #include "system/ConfigManager.h"
 #include "support/TextBufferUtils.h"
 
@@ -48,12 +50,27 @@ namespace ApiClientTransportShared {
   };
 
   StreamWriteResult write_all(WiFiClient& client, const uint8_t* data, size_t len, unsigned long timeoutMs);
+
+  // write_all() as an HttpStreamWriter sink; `result` keeps why a write came up short.
+  struct ClientSink {
+    WiFiClient& client;
+    unsigned long timeoutMs;
+    StreamWriteResult result{};
+
+    size_t operator()(const uint8_t* data, size_t len);
+  };
   int parse_status_code(const char* line);
   PGM_P lookup_http_reason_P(int code);
   void buildErrorMessageSimple(UploadResult& result);
   bool copy_header_value_if_matches(const char* line, const char* name, char* out, size_t out_len);
-  void parse_response_headers(
-      WiFiClient& client, char* dateBuf, size_t dateBufLen, char* locationBuf, size_t locationBufLen);
+  // Reads the header block, picking out Date and Location; `framing`, when given, also collects
+  // what keep-alive needs to know about the body and the socket.
+  void parse_response_headers(WiFiClient& client,
+                              char* dateBuf,
+                              size_t dateBufLen,
+                              char* locationBuf,
+                              size_t locationBufLen,
+                              HttpKeepAlive::Framing* framing = nullptr);
   void sync_time_from_http_date(NtpClient& ntpClient, const char* dateBuf);
   void copy_location_display(char* out, size_t out_len, const char* location);
   size_t read_body_preview(WiFiClient& client, char* out, size_t out_len, unsigned long timeoutMs);
@@ -17,6 +17,8 @@
 #include "support/CryptoUtils.h"
 #include "system/Logger.h"
 #include "net/NtpClient.h"
+#include "net/TlsSessionCache.h"
+#include "net/UploadLatency.h"
 #include "system/NodeIdentity.h"
 #include "storage/RtcManager.h"
 #include "sensor/SensorManager.h"
@@ -38,6 +40,9 @@ UploadResult ApiClientTransportController::performSingleUpload(const char* paylo
   UploadResult result = {HTTPC_ERROR_CONNECTION_FAILED, false, {0}};
   copy_trunc_P(result.message, sizeof(result.message), PSTR("Connection Failed"));
   const bool startedOnRelay = shouldUseRelayForCloudUpload();
+  const UploadLatency::Target latencyTarget =
+      startedOnRelay ? UploadLatency::Target::RELAY : UploadLatency::Target::CLOUD;
+  const unsigned long requestStart = millis();
 
   LOG_DEBUG("API", F("--- START UPLOAD ---"));
   LOG_DEBUG("API", F("Route: %s"), startedOnRelay ? "relay" : "direct");
@@ -80,7 +85,21 @@ UploadResult ApiClientTransportController::performSingleUpload(const char* paylo
 
   yield();
   LOG_INFO("API", F("TLS pre-connect heap: %u, blk: %u"), ESP.getFreeHeap(), ESP.getMaxFreeBlockSize());
-  if (!m_deps.secureClient.connect(host, 443)) {
+  const unsigned long lookupStart = millis();
+  IPAddress addr;
+  const bool resolved = WiFi.hostByName(host, addr, m_policy.connectTimeoutMs);
+  const unsigned long tlsStart = millis();
+  bool connected = false;
+  if (resolved) {
+    UploadLatency::record(latencyTarget, UploadLatency::Phase::DNS, tlsStart - lookupStart);
+    const TlsSessionCache::Ticket tlsTicket = TlsSessionCache::attach(m_deps.secureClient, host);
+    connected = m_deps.secureClient.connect(host, 443);
+    TlsSessionCache::finish(tlsTicket, connected);
+  }
+  if (connected) {
+    UploadLatency::record(latencyTarget, UploadLatency::Phase::TLS, millis() - tlsStart);
+  } else {
+    UploadLatency::recordFailure(latencyTarget);
     copy_trunc_P(result.message, sizeof(result.message), PSTR("TLS connect failed"));
     releaseTlsResources();
     m_deps.configManager.releaseStrings();
@@ -117,6 +136,7 @@ UploadResult ApiClientTransportController::performSingleUpload(const char* paylo
   m_deps.secureClient.print(F("Content-Length: "));
   m_deps.secureClient.print(length);
   m_deps.secureClient.print(F("\r\n\r\n"));
+  const unsigned long sendStart = millis();
   if (length > 0 && payload) {
     const StreamWriteResult writeResult =
         write_all(m_deps.secureClient, reinterpret_cast<const uint8_t*>(payload), length, m_policy.writeTimeoutMs);
@@ -127,6 +147,7 @@ UploadResult ApiClientTransportController::performSingleUpload(const char* paylo
                    writeResult.timedOut ? PSTR("Write timeout")
                                         : writeResult.disconnected ? PSTR("Connection Lost")
                                                                    : PSTR("Short write"));
+      UploadLatency::recordFailure(latencyTarget);
       m_deps.secureClient.stop();
       releaseTlsResources();
       m_deps.configManager.releaseStrings();
@@ -139,8 +160,11 @@ UploadResult ApiClientTransportController::performSingleUpload(const char* paylo
     }
   }
 
+  const unsigned long waitStart = millis();
+  UploadLatency::record(latencyTarget, UploadLatency::Phase::SEND, waitStart - sendStart);
   char line[128];
   if (!read_line(m_deps.secureClient, line, sizeof(line), m_policy.secureLineTimeoutMs)) {
+    UploadLatency::recordFailure(latencyTarget);
     result.httpCode = (!m_deps.secureClient.connected() && !m_deps.secureClient.available())
                           ? HTTPC_ERROR_CONNECTION_LOST
                           : HTTPC_ERROR_READ_TIMEOUT;
@@ -159,6 +183,8 @@ UploadResult ApiClientTransportController::performSingleUpload(const char* paylo
     return result;
   }
 
+  const unsigned long readStart = millis();
+  UploadLatency::record(latencyTarget, UploadLatency::Phase::FIRST_BYTE, readStart - waitStart);
   result.httpCode = parse_status_code(line);
   result.success = (result.httpCode >= 200 && result.httpCode < 300);
 
@@ -169,6 +195,9 @@ UploadResult ApiClientTransportController::performSingleUpload(const char* paylo
   char bodyPreview[192] = {0};
   const size_t bodyLen =
       read_body_preview(m_deps.secureClient, bodyPreview, sizeof(bodyPreview), m_policy.previewTimeoutMs);
+  const unsigned long readEnd = millis();
+  UploadLatency::record(latencyTarget, UploadLatency::Phase::BODY, readEnd - readStart);
+  UploadLatency::record(latencyTarget, UploadLatency::Phase::TOTAL, readEnd - requestStart);
   const bool wafBlocked = (bodyLen > 0 && response_body_indicates_waf_block(bodyPreview));
   if (wafBlocked) {
     result.success = false;
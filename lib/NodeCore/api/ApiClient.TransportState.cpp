@@ -8,6 +8,7 @@
 #include <user_interface.h>
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 #include <strings.h>
 
@@ -16,7 +17,12 @@
 #include "system/ConfigManager.h"
 #include "support/CryptoUtils.h"
 #include "system/Logger.h"
+#include "net/EdgeWireCodec.h"
+#include "net/EncryptedBody.h"
+#include "net/GatewayScoreboard.h"
 #include "net/NtpClient.h"
+#include "net/TlsSessionCache.h"
+#include "net/UploadLatency.h"
 #include "system/NodeIdentity.h"
 #include "storage/RtcManager.h"
 #include "sensor/SensorManager.h"
@@ -27,9 +33,161 @@
 
 #include "api/ApiClient.Health.h"
 #include "api/ApiClient.TransportShared.h"
+#include "api/ApiClient.UploadShared.h"
 
 using namespace ApiClientTransportShared;
 
+namespace {
+  constexpr uint16_t kEdgePort = 80;
+  // One body record as it is rendered for a streamed body, the separator ahead of it included.
+  constexpr size_t kBodySlotLen = ApiClientDetail::kUploadBatchRecordSlot + 1;
+  static_assert(!UPLOAD_STREAM_BATCH || kBodySlotLen + 1 <= HTTP_STREAM_CHUNK_BYTES,
+                "a streamed cloud body record must fit in one HTTP_STREAM_CHUNK_BYTES chunk");
+
+  using RequestWriter = HttpStreamWriter::Writer<ClientSink>;
+
+  bool keepEdgeAlive(bool isEdgeTarget) {
+    return EDGE_KEEPALIVE && isEdgeTarget;
+  }
+
+  // Cloud body: each record is rendered straight into the writer's chunk, one byte in so that the
+  // separator can go ahead of it.
+  class WriterBodyOut {
+  public:
+    explicit WriterBodyOut(RequestWriter& writer) : m_writer(writer) {}
+
+    char* slot(size_t& len) {
+      char* room = m_writer.reserve(kBodySlotLen + 1);
+      len = room ? kBodySlotLen : 0;
+      return room ? room + 1 : nullptr;
+    }
+
+    bool record(char* rec, size_t len, char sep) {
+      if (sep == '\0') {
+        memmove(rec - 1, rec, len);
+        return m_writer.commit(len);
+      }
+      rec[-1] = sep;
+      return m_writer.commit(len + 1);
+    }
+
+    bool put(const char* data, size_t len) {
+      return m_writer.put(data, len);
+    }
+
+  private:
+    RequestWriter& m_writer;
+  };
+
+  struct MainCipher {
+    bool operator()(uint8_t* iv, uint8_t* data, size_t len) const {
+      return CryptoUtils::cbc_encrypt_main(iv, data, len);
+    }
+  };
+
+  // Gateway body: the plaintext goes through the cipher and base64 on its way to `emit`, one
+  // record at a time.
+  template <typename Emit>
+  class EncryptingBodyOut {
+  public:
+    EncryptingBodyOut(Emit& emit, const uint8_t* iv, uint32_t timestamp, size_t plainLen)
+        : m_encoder(m_cipher, emit, iv, timestamp, plainLen) {}
+
+    bool begin() {
+      return m_encoder.begin();
+    }
+    bool finish() {
+      return m_encoder.finish();
+    }
+
+    char* slot(size_t& len) {
+      len = sizeof(m_slot);
+      return m_slot;
+    }
+
+    bool record(char* rec, size_t len, char sep) {
+      return (sep == '\0' || m_encoder.put(&sep, 1)) && m_encoder.put(rec, len);
+    }
+
+    bool put(const char* data, size_t len) {
+      return m_encoder.put(data, len);
+    }
+
+  private:
+    const MainCipher m_cipher{};
+    EncryptedBody::Encoder<const MainCipher, Emit> m_encoder;
+    char m_slot[kBodySlotLen];
+  };
+
+  // Renders the plaintext body into `out`, the same bytes every time it is called. Kept out of
+  // line: the RTC run it reads for a queued body must not share a frame with the request writer.
+  template <typename Out>
+  __attribute__((noinline)) bool render_plain_body(CacheManager& cache,
+                                                   const ApiClientDetail::UploadBody& body,
+                                                   const char* payload,
+                                                   const SensorAggregateCodec::SensorAggregate& typed,
+                                                   bool edge,
+                                                   Out& out) {
+    const ApiClientUploadShared::WireRecordRenderer render{edge, body.nonActiveRssi};
+    char* rec = nullptr;
+    size_t cap = 0;
+    size_t len = 0;
+    switch (body.source) {
+      case ApiClientDetail::UploadBodySource::QUEUE:
+        return UploadBatchStream::write(cache, body.plan, render, render, out);
+      case ApiClientDetail::UploadBodySource::LIVE_SNAPSHOT:
+        rec = out.slot(cap);
+        return rec && render(rec, cap, body.live, len) && len == body.plainLen && out.record(rec, len, '\0');
+      case ApiClientDetail::UploadBodySource::TYPED:
+        rec = out.slot(cap);
+        if (!rec) {
+          return false;
+        }
+        len = EdgeWireCodec::encode(reinterpret_cast<uint8_t*>(rec),
+                                    cap,
+                                    typed,
+                                    ApiClientUploadShared::edge_envelope(typed, body.nonActiveRssi));
+        return len == body.plainLen && out.record(rec, len, '\0');
+      default:
+        return payload && out.put(payload, body.plainLen);
+    }
+  }
+
+  // First pass over a gateway body, into the HMAC for X-Signature; the second goes to the socket.
+  __attribute__((noinline)) bool sign_edge_body(const HmacSigner::Key& key,
+                                                CacheManager& cache,
+                                                const ApiClientDetail::UploadBody& body,
+                                                const char* payload,
+                                                const SensorAggregateCodec::SensorAggregate& typed,
+                                                const uint8_t* iv,
+                                                uint32_t timestamp,
+                                                char* signature) {
+    HmacSigner::Incremental hmac(key);
+    auto emit = [&hmac](const char* data, size_t len) {
+      hmac.update(data, len);
+      return true;
+    };
+    EncryptingBodyOut<decltype(emit)> out(emit, iv, timestamp, body.plainLen);
+    if (!out.begin() || !render_plain_body(cache, body, payload, typed, true, out) || !out.finish()) {
+      return false;
+    }
+    hmac.finish_hex(signature);
+    return true;
+  }
+
+  __attribute__((noinline)) bool write_edge_body(RequestWriter& writer,
+                                                 CacheManager& cache,
+                                                 const ApiClientDetail::UploadBody& body,
+                                                 const char* payload,
+                                                 const SensorAggregateCodec::SensorAggregate& typed,
+                                                 const uint8_t* iv,
+                                                 uint32_t timestamp) {
+    auto emit = [&writer](const char* data, size_t len) { return writer.put(data, len); };
+    EncryptingBodyOut<decltype(emit)> out(emit, iv, timestamp, body.plainLen);
+    return out.begin() && render_plain_body(cache, body, payload, typed, true, out) && out.finish();
+  }
+}  // namespace
+
 void ApiClientTransportController::startUpload(const char* payload, size_t length, bool isEdgeTarget) {
   if (m_transport.httpState != HttpState::IDLE) {
     LOG_WARN("API", F("Upload request ignored - Busy"));
@@ -45,7 +203,12 @@ void ApiClientTransportController::startUpload(const char* payload, size_t lengt
       m_runtime.route.forceRelayNextCloudAttempt = false;
     }
   }
+  m_transport.latencyTarget = isEdgeTarget                          ? UploadLatency::Target::EDGE
+                              : m_runtime.route.cloudTargetIsRelay ? UploadLatency::Target::RELAY
+                                                                   : UploadLatency::Target::CLOUD;
+  m_transport.requestStartMs = millis();
   m_transport.lastResponseLocation[0] = '\0';
+  HttpKeepAlive::begin_request(m_transport.edgeConn);
   (void)payload;
 
   transitionState(HttpState::CONNECTING);
@@ -62,7 +225,7 @@ void ApiClientTransportController::handleStateConnecting(const AppConfig& cfg) {
   if (isEdge) {
     edgeTargets = resolveEdgeGatewayTargets(m_deps.configManager);
     host = edgeTargets.primaryMdns;
-    port = 80;
+    port = kEdgePort;
     m_transport.activeClient = &m_transport.plainClient;
   } else {
     updateCloudTargetCache();
@@ -98,32 +261,53 @@ void ApiClientTransportController::handleStateConnecting(const AppConfig& cfg) {
         edgeTargets.secondaryIp,
     };
 
-    for (size_t i = 0; i < (sizeof(candidates) / sizeof(candidates[0])) && !connected; ++i) {
-      const char* candidate = candidates[i];
-      if (!candidate || candidate[0] == '\0') {
-        continue;
-      }
-
-      bool duplicate = false;
-      for (size_t j = 0; j < i; ++j) {
-        const char* prev = candidates[j];
-        if (prev && strcmp(prev, candidate) == 0) {
-          duplicate = true;
-          break;
+    if (keepEdgeAlive(isEdge)) {
+      for (size_t i = 0; i < (sizeof(candidates) / sizeof(candidates[0])) && !connected; ++i) {
+        if (candidates[i][0] != '\0' &&
+            HttpKeepAlive::reuse(m_transport.edgeConn, m_transport.plainClient, candidates[i], port, millis())) {
+          connected = true;
+          host = candidates[i];
+          LOG_DEBUG("API", F("Edge keep-alive: reusing socket (%u requests)"), m_transport.edgeConn.requests);
         }
       }
-      if (duplicate) {
-        continue;
-      }
+    }
+    if (!connected) {
+      // Whatever is left open (another gateway, or an HTTPClient request) is not ours to reuse.
+      HttpKeepAlive::close(m_transport.edgeConn, m_transport.plainClient);
+    }
 
-      if (i > 0) {
+    // Best-scoring candidate first; empty and duplicate entries are left out.
+    uint8_t order[sizeof(candidates) / sizeof(candidates[0])];
+    const size_t orderCount = GatewayScoreboard::order(m_transport.edgeBoard,
+                                                       candidates,
+                                                       sizeof(candidates) / sizeof(candidates[0]),
+                                                       order,
+                                                       sizeof(order),
+                                                       m_policy.connectTimeoutMs);
+    for (size_t k = 0; k < orderCount && !connected; ++k) {
+      const size_t i = order[k];
+      const char* candidate = candidates[i];
+      if (k > 0) {
         char label[17];
         copy_trunc_P(label, sizeof(label), edge_target_label_P(i));
         LOG_WARN("API", F("Edge fallback -> %s"), label);
       }
-      connected = m_transport.activeClient->connect(candidate, port);
+      // The name is resolved here rather than inside connect() so the lookup is timed on its own.
+      const unsigned long lookupStart = millis();
+      IPAddress addr;
+      const bool resolved = WiFi.hostByName(candidate, addr, m_policy.connectTimeoutMs);
+      const unsigned long connectStart = millis();
+      connected = resolved && m_transport.activeClient->connect(addr, port);
+      const unsigned long connectEnd = millis();
+      const unsigned long attemptMs = std::max<unsigned long>(1, connectEnd - lookupStart);
+      GatewayScoreboard::record(m_transport.edgeBoard, candidate, connected, connected ? attemptMs : 0, connectEnd);
       if (connected) {
+        UploadLatency::record(m_transport.latencyTarget, UploadLatency::Phase::DNS, connectStart - lookupStart);
+        UploadLatency::record(m_transport.latencyTarget, UploadLatency::Phase::CONNECT, connectEnd - connectStart);
         host = candidate;
+        if (keepEdgeAlive(isEdge)) {
+          HttpKeepAlive::opened(m_transport.edgeConn, host, port, millis());
+        }
       }
     }
 
@@ -131,7 +315,21 @@ void ApiClientTransportController::handleStateConnecting(const AppConfig& cfg) {
       LOG_WARN("API", F("Edge gateways unreachable; trying cloud fallback"));
     }
   } else {
-    connected = m_transport.activeClient->connect(host, port);
+    // Resolved ahead so the lookup is timed apart from the handshakes; connect() then finds the
+    // address in lwIP's DNS cache. It still takes the name, for SNI and the certificate check.
+    const unsigned long lookupStart = millis();
+    IPAddress addr;
+    const bool resolved = WiFi.hostByName(host, addr, m_policy.connectTimeoutMs);
+    const unsigned long tlsStart = millis();
+    if (resolved) {
+      UploadLatency::record(m_transport.latencyTarget, UploadLatency::Phase::DNS, tlsStart - lookupStart);
+      const TlsSessionCache::Ticket tlsTicket = TlsSessionCache::attach(m_deps.secureClient, host);
+      connected = m_transport.activeClient->connect(host, port);
+      TlsSessionCache::finish(tlsTicket, connected);
+    }
+    if (connected) {
+      UploadLatency::record(m_transport.latencyTarget, UploadLatency::Phase::TLS, millis() - tlsStart);
+    }
   }
 
   if (connected) {
@@ -146,17 +344,34 @@ void ApiClientTransportController::handleStateConnecting(const AppConfig& cfg) {
 }
 
 void ApiClientTransportController::handleStateSending(const AppConfig& cfg) {
+  const bool keepAlive = keepEdgeAlive(m_runtime.route.targetIsEdge);
+  if (keepAlive && !m_transport.plainClient.connected() &&
+      HttpKeepAlive::retry_after_drop(m_transport.edgeConn, m_transport.plainClient)) {
+    LOG_DEBUG("API", F("Edge keep-alive: socket dropped while idle, reconnecting"));
+    transitionState(HttpState::CONNECTING);
+    return;
+  }
   if (!m_transport.activeClient || !m_transport.activeClient->connected()) {
     updateResult_P(HTTPC_ERROR_CONNECTION_LOST, false, PSTR("Disconnected"));
     transitionState(HttpState::FAILED);
     return;
   }
-  char* buf = sharedBuffer();
-  if (!buf) {
+  const UploadBody& body = m_runtime.route.body;
+  const bool buffered = body.source == UploadBodySource::BUFFER;
+  const char* buf = buffered ? outgoingPayload() : nullptr;
+  if (buffered && !buf) {
     updateResult_P(HTTPC_ERROR_CONNECTION_LOST, false, PSTR("No payload buffer"));
     transitionState(HttpState::FAILED);
     return;
   }
+  if (body.source == UploadBodySource::QUEUE && !UploadBatchStream::valid(m_deps.cacheManager, body.plan)) {
+    // The queue moved since the body was counted; nothing has gone out, so the upload fails here
+    // and the cycle loads the record again.
+    LOG_WARN("API", F("Queue changed before send; retrying upload"));
+    updateResult_P(HTTPC_ERROR_SEND_PAYLOAD_FAILED, false, PSTR("Queue changed"));
+    transitionState(HttpState::FAILED);
+    return;
+  }
 
   if (!m_runtime.route.targetIsEdge) {
     updateCloudTargetCache();
@@ -174,56 +389,107 @@ void ApiClientTransportController::handleStateSending(const AppConfig& cfg) {
   char deviceId[NodeIdentity::kDeviceIdBufferLen];
   NodeIdentity::buildDeviceId(deviceId, sizeof(deviceId));
 
-  m_transport.activeClient->print(F("POST "));
-  m_transport.activeClient->print(path);
-  m_transport.activeClient->print(F(" HTTP/1.1\r\nHost: "));
-  m_transport.activeClient->print(host);
-  m_transport.activeClient->print(
-      F("\r\nConnection: close\r\n"
+  // A gateway body is encrypted under an IV and timestamp fixed here, so it can be produced once
+  // for the signature before the head and again for the socket after it.
+  uint8_t iv[EncryptedBody::kIvLen];
+  const uint32_t timestamp = static_cast<uint32_t>(time(nullptr));
+  char signature[HmacSigner::kHexLen + 1];
+  size_t contentLen = body.plainLen;
+  if (m_runtime.route.targetIsEdge) {
+    CryptoUtils::make_iv(iv);
+    if (!ensureSigningKey() || !sign_edge_body(m_transport.signingKey,
+                                               m_deps.cacheManager,
+                                               body,
+                                               buf,
+                                               m_runtime.route.edgeRecord,
+                                               iv,
+                                               timestamp,
+                                               signature)) {
+      updateResult_P(HTTPC_ERROR_SEND_PAYLOAD_FAILED, false, PSTR("Body not signed"));
+      transitionState(HttpState::FAILED);
+      return;
+    }
+    contentLen = EncryptedBody::body_len(body.plainLen);
+  }
+
+  ClientSink sink{*m_transport.activeClient, m_policy.writeTimeoutMs};
+  RequestWriter out(sink);
+  out.put(F("POST "));
+  out.put(path);
+  out.put(F(" HTTP/1.1\r\nHost: "));
+  out.put(host);
+  out.put(keepAlive ? F("\r\nConnection: keep-alive") : F("\r\nConnection: close"));
+  out.put(
+      F("\r\n"
         "Content-Type: application/json\r\n"
         "Accept: application/json\r\n"
         "User-Agent: "));
-  m_transport.activeClient->print(userAgent);
-  m_transport.activeClient->print(F("\r\nX-Device-ID: "));
-  m_transport.activeClient->print(deviceId);
-  m_transport.activeClient->print(F("\r\nContent-Length: "));
-  m_transport.activeClient->print(m_transport.payloadLen);
-  m_transport.activeClient->print(F("\r\n"));
+  out.put(userAgent);
+  out.put(F("\r\nX-Device-ID: "));
+  out.put(deviceId);
+  out.put(F("\r\nContent-Length: "));
+  out.put_u32(static_cast<uint32_t>(contentLen));
+  out.put(F("\r\n"));
 
   if (m_runtime.route.targetIsEdge) {
-    m_transport.activeClient->print(F("X-Node-ID: "));
-    m_transport.activeClient->print(NODE_ID);
-    m_transport.activeClient->print(F("\r\n"));
-
-    m_transport.activeClient->print(F("X-GH-ID: "));
-    m_transport.activeClient->print(GH_ID);
-    m_transport.activeClient->print(F("\r\n"));
-
-    char signature[65];
-    signPayload(buf, m_transport.payloadLen, signature);
-    m_transport.activeClient->print(F("X-Signature: "));
-    m_transport.activeClient->print(signature);
-    m_transport.activeClient->print(F("\r\n"));
-
-    m_transport.activeClient->print(F("X-Timestamp: "));
-    m_transport.activeClient->print((unsigned long)time(nullptr));
-    m_transport.activeClient->print(F("\r\n"));
+    out.put(F("X-Node-ID: "));
+    out.put_u32(NODE_ID);
+    out.put(F("\r\n"));
+
+    out.put(F("X-GH-ID: "));
+    out.put_u32(GH_ID);
+    out.put(F("\r\n"));
+
+    out.put(F("X-Signature: "));
+    out.put(signature);
+    out.put(F("\r\n"));
+
+    out.put(F("X-Timestamp: "));
+    out.put_u32(timestamp);
+    out.put(F("\r\n"));
   } else {
-    char authBuf[kBearerHeaderBufferLen];
-    if (build_auth_header_for_upload(authBuf, sizeof(authBuf), m_deps.configManager)) {
-      m_transport.activeClient->print(F("Authorization: REDACTED
-      m_transport.activeClient->print(authBuf);
-      m_transport.activeClient->print(F("\r\n"));
+    // The value is built in the writer's chunk where it goes out, right behind the room for the
+    // header name; with that room already reserved, put() copies the name in without a flush.
+    constexpr size_t kAuthNameLen = sizeof("Authorization: ") - 1;
+    char* auth = out.reserve(kAuthNameLen + kBearerHeaderBufferLen);
+    if (auth && build_auth_header_for_upload(auth + kAuthNameLen, kBearerHeaderBufferLen, m_deps.configManager)) {
+      out.put(F("Authorization: "));
+      out.commit(strlen(auth + kAuthNameLen));
+      out.put(F("\r\n"));
     }
   }
 
-  m_transport.activeClient->print(F("\r\n"));
+  out.put(F("\r\n"));
 
-  const StreamWriteResult writeResult =
-      write_all(*m_transport.activeClient, reinterpret_cast<const uint8_t*>(buf), m_transport.payloadLen, m_policy.writeTimeoutMs);
-  releaseSharedBuffer();
+  bool bodyRendered = out.ok();
+  if (bodyRendered && m_runtime.route.targetIsEdge) {
+    bodyRendered = write_edge_body(out, m_deps.cacheManager, body, buf, m_runtime.route.edgeRecord, iv, timestamp);
+  } else if (bodyRendered) {
+    WriterBodyOut bodyOut(out);
+    bodyRendered = render_plain_body(m_deps.cacheManager, body, buf, m_runtime.route.edgeRecord, false, bodyOut);
+  }
+  out.flush();
+  const StreamWriteResult& writeResult = sink.result;
+  // A buffered request on a kept socket may have to go again on a new one; the payload is released
+  // with the rest of the upload once it completes. Other bodies let go of the buffer at dispatch.
+  if (buffered && !m_transport.edgeConn.reused) {
+    releaseSharedBuffer();
+  }
 
-  if (writeResult.written < m_transport.payloadLen) {
+  if (!bodyRendered && out.ok()) {
+    // Content-Length promised a body that can no longer be rendered; the short body fails it.
+    m_transport.activeClient->stop();
+    updateResult_P(HTTPC_ERROR_SEND_PAYLOAD_FAILED, false, PSTR("Body changed"));
+    transitionState(HttpState::FAILED);
+    return;
+  }
+  if (!out.ok()) {
+    if (keepAlive && writeResult.disconnected &&
+        HttpKeepAlive::retry_after_drop(m_transport.edgeConn, m_transport.plainClient)) {
+      LOG_DEBUG("API", F("Edge keep-alive: socket dropped during send, reconnecting"));
+      transitionState(HttpState::CONNECTING);
+      return;
+    }
     updateResult_P(writeResult.disconnected ? HTTPC_ERROR_CONNECTION_LOST : HTTPC_ERROR_SEND_PAYLOAD_FAILED,
                    false,
                    writeResult.timedOut ? PSTR("Write timeout")
@@ -233,6 +499,7 @@ void ApiClientTransportController::handleStateSending(const AppConfig& cfg) {
     return;
   }
 
+  UploadLatency::record(m_transport.latencyTarget, UploadLatency::Phase::SEND, millis() - m_transport.stateEntryTime);
   transitionState(HttpState::WAITING_RESPONSE);
 }
 
@@ -244,14 +511,25 @@ void ApiClientTransportController::handleStateWaiting(unsigned long stateDuratio
   }
 
   if (m_transport.activeClient->available()) {
+    UploadLatency::record(m_transport.latencyTarget, UploadLatency::Phase::FIRST_BYTE, stateDuration);
     transitionState(HttpState::READING_RESPONSE);
   } else {
     if (!m_transport.activeClient->connected()) {
+      if (keepEdgeAlive(m_runtime.route.targetIsEdge) &&
+          HttpKeepAlive::retry_after_drop(m_transport.edgeConn, m_transport.plainClient)) {
+        LOG_DEBUG("API", F("Edge keep-alive: socket closed before response, reconnecting"));
+        transitionState(HttpState::CONNECTING);
+        return;
+      }
       updateResult_P(HTTPC_ERROR_CONNECTION_LOST, false, PSTR("Connection Lost"));
       transitionState(HttpState::FAILED);
       return;
     }
     if (stateDuration > m_policy.waitResponseTimeoutMs) {
+      if (m_runtime.route.targetIsEdge) {
+        // Took the connection but never answered; the next upload starts elsewhere.
+        GatewayScoreboard::record(m_transport.edgeBoard, m_transport.edgeHost, false, 0, millis());
+      }
       updateResult_P(HTTPC_ERROR_READ_TIMEOUT, false, PSTR("Timeout"));
       transitionState(HttpState::FAILED);
     }
@@ -259,10 +537,15 @@ void ApiClientTransportController::handleStateWaiting(unsigned long stateDuratio
 }
 
 void ApiClientTransportController::handleStateReading() {
+  const bool keepAlive = keepEdgeAlive(m_runtime.route.targetIsEdge);
+  HttpKeepAlive::Framing framing;
+  bool bodyComplete = false;
+
   char line[128];
   size_t n = m_transport.activeClient->readBytesUntil('\n', line, sizeof(line) - 1);
   line[n] = '\0';
   Utils::trim_inplace(std::span<char>(line));
+  HttpKeepAlive::note_status_line(framing, line);
 
   const char* p = strchr(line, ' ');
   if (!p) {
@@ -287,12 +570,20 @@ void ApiClientTransportController::handleStateReading() {
                              dateBuf,
                              sizeof(dateBuf),
                              m_transport.lastResponseLocation,
-                             sizeof(m_transport.lastResponseLocation));
+                             sizeof(m_transport.lastResponseLocation),
+                             keepAlive ? &framing : nullptr);
       sync_time_from_http_date(m_deps.ntpClient, dateBuf);
 
       char bodyPreview[192] = {0};
       const size_t bodyLen =
-          read_body_preview(*m_transport.activeClient, bodyPreview, sizeof(bodyPreview), m_policy.previewTimeoutMs);
+          keepAlive ? HttpKeepAlive::read_body(*m_transport.activeClient,
+                                               framing,
+                                               bodyPreview,
+                                               sizeof(bodyPreview),
+                                               m_policy.previewTimeoutMs,
+                                               bodyComplete)
+                    : read_body_preview(
+                          *m_transport.activeClient, bodyPreview, sizeof(bodyPreview), m_policy.previewTimeoutMs);
       const bool wafBlocked = (bodyLen > 0 && response_body_indicates_waf_block(bodyPreview));
       if (wafBlocked) {
         m_transport.lastResult.success = false;
@@ -325,7 +616,14 @@ void ApiClientTransportController::handleStateReading() {
     }
   }
 
-  m_transport.activeClient->stop();
+  if (keepAlive) {
+    HttpKeepAlive::finish(m_transport.edgeConn, m_transport.plainClient, framing, bodyComplete, millis());
+  } else {
+    m_transport.activeClient->stop();
+  }
+  const unsigned long now = millis();
+  UploadLatency::record(m_transport.latencyTarget, UploadLatency::Phase::BODY, now - m_transport.stateEntryTime);
+  UploadLatency::record(m_transport.latencyTarget, UploadLatency::Phase::TOTAL, now - m_transport.requestStartMs);
   transitionState(HttpState::COMPLETE);
 }
 
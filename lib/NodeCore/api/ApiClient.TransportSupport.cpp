@@ -16,7 +16,10 @@
 #include "support/CryptoUtils.h"
 #include "system/Logger.h"
 #include "net/NtpClient.h"
+#include "net/QosProbe.h"
+#include "net/TlsSessionCache.h"
 #include "system/NodeIdentity.h"
+#include "support/HmacSigner.h"
 #include "storage/RtcManager.h"
 #include "sensor/SensorManager.h"
 #include "REDACTED"
@@ -28,6 +31,41 @@
 
 using namespace ApiClientTransportShared;
 
+namespace {
+  // The QoS probe body as a Stream, so HTTPClient sends it without it ever being in memory.
+  class QosProbeBodyStream : public Stream {
+  public:
+    explicit QosProbeBodyStream(size_t total) : m_total(total) {}
+
+    int available() override {
+      return static_cast<int>(m_total - m_offset);
+    }
+    int peek() override {
+      uint8_t c = 0;
+      return QosProbe::body_read(&c, 1, m_offset, m_total) ? c : -1;
+    }
+    int read() override {
+      const int c = peek();
+      if (c >= 0) {
+        m_offset++;
+      }
+      return c;
+    }
+    size_t readBytes(char* buffer, size_t length) override {
+      const size_t n = QosProbe::body_read(reinterpret_cast<uint8_t*>(buffer), length, m_offset, m_total);
+      m_offset += n;
+      return n;
+    }
+    size_t write(uint8_t) override {
+      return 0;
+    }
+
+  private:
+    size_t m_total;
+    size_t m_offset = 0;
+  };
+}  // namespace
+
 void ApiClientTransportController::tryNtpFallbackProbe() {
   if (millis() > 60000 && millis() - m_runtime.lastTimeProbe > 60000) {
     m_runtime.lastTimeProbe = millis();
@@ -52,7 +90,10 @@ bool ApiClientTransportController::probeServerTimeHeader(bool allowInsecure) {
   const char* host = (m_transport.cloudHost[0] != '\0') ? m_transport.cloudHost : fallbackHost;
   const char* path = (m_transport.cloudPath[0] != '\0') ? m_transport.cloudPath : fallbackPath;
 
-  if (!m_deps.secureClient.connect(host, 443)) {
+  const TlsSessionCache::Ticket tlsTicket = TlsSessionCache::attach(m_deps.secureClient, host);
+  const bool connected = m_deps.secureClient.connect(host, 443);
+  TlsSessionCache::finish(tlsTicket, connected);
+  if (!connected) {
     m_deps.secureClient.stop();
     releaseTlsResources();
     m_deps.configManager.releaseStrings();
@@ -171,8 +212,12 @@ void ApiClientTransportController::buildErrorMessage(UploadResult& result) {
 }
 
 void ApiClientTransportController::signPayload(const char* payload, size_t payload_len, char* signatureBuffer) {
-  br_hmac_key_context kc;
-  br_hmac_context ctx;
+  // The key schedule is derived once per token; the config strings are not touched again until
+  // a saved config drops it (applyConfig).
+  if (m_transport.signingKey.ready) {
+    signWithKey(payload, payload_len, signatureBuffer);
+    return;
+  }
 
   const char* token = REDACTED
   const size_t token_len = REDACTED
@@ -184,35 +229,36 @@ void ApiClientTransportController::signPayload(const char* payload, size_t paylo
     LOG_ERROR("REDACTED", F("REDACTED"));
     return;
   }
+  HmacSigner::set_key(m_transport.signingKey, token, token_len);
+  m_deps.configManager.releaseStrings();
+  signWithKey(payload, payload_len, signatureBuffer);
+}
+
+bool ApiClientTransportController::ensureSigningKey() {
+  // signPayload() derives the key first and has nothing to sign without a buffer.
+  if (!m_transport.signingKey.ready) {
+    signPayload(nullptr, 0, nullptr);
+  }
+  return m_transport.signingKey.ready;
+}
+
+void ApiClientTransportController::signWithKey(const char* payload, size_t payload_len, char* signatureBuffer) {
+  if (!signatureBuffer) {
+    return;
+  }
   if (!payload || payload_len == 0) {
-    if (signatureBuffer) {
-      signatureBuffer[0] = '\0';
-    }
-    m_deps.configManager.releaseStrings();
+    signatureBuffer[0] = '\0';
     LOG_ERROR("API", F("Payload empty; cannot sign"));
     return;
   }
-
-  br_hmac_key_init(&kc, &br_sha256_vtable, token, token_len);
-  br_hmac_init(&ctx, &kc, 0);
-  br_hmac_update(&ctx, payload, payload_len);
-
-  uint8_t digest[32];
-  br_hmac_out(&ctx, digest);
-
-  static const char hex[] = "0123456789abcdef";
-  for (int i = 0; i < 32; i++) {
-    signatureBuffer[i * 2] = hex[(digest[i] >> 4) & 0x0F];
-    signatureBuffer[i * 2 + 1] = hex[digest[i] & 0x0F];
-  }
-  signatureBuffer[64] = '\0';
-  m_deps.configManager.releaseStrings();
+  HmacSigner::sign_hex(m_transport.signingKey, payload, payload_len, signatureBuffer);
 }
 
 bool ApiClientTransportController::executeQosSample(HTTPClient& http,
                                                     const char* url,
                                                     const char* method,
                                                     const char* payload,
+                                                    size_t bodyLen,
                                                     bool useOtaToken,
                                                     const AppConfig& cfg,
                                                     unsigned long& duration) {
@@ -222,12 +268,22 @@ bool ApiClientTransportController::executeQosSample(HTTPClient& http,
   unsigned long startTick = millis();
   int httpCode = -1;
 
-  if (!acquireTlsResources(cfg.ALLOW_INSECURE_HTTPS())) {
-    duration = millis() - startTick;
-    return false;
+  // Edge gateways answer plain HTTP on the client the upload path keeps alive; close that first.
+  const bool plain = (strncmp_P(url, PSTR("http://"), 7) == 0);
+  TlsSessionCache::Ticket tlsTicket;
+  bool begun = false;
+  if (plain) {
+    HttpKeepAlive::close(m_transport.edgeConn, m_transport.plainClient);
+    begun = http.begin(m_transport.plainClient, url);
+  } else {
+    if (!acquireTlsResources(cfg.ALLOW_INSECURE_HTTPS())) {
+      duration = millis() - startTick;
+      return false;
+    }
+    tlsTicket = TlsSessionCache::attachUrl(m_deps.secureClient, url);
+    begun = http.begin(m_deps.secureClient, url);
   }
-
-  if (http.begin(m_deps.secureClient, url)) {
+  if (begun) {
     char path[8] = {0};
     resolveCloudTarget(url, nullptr, 0, path, sizeof(path));
 
@@ -246,14 +302,22 @@ bool ApiClientTransportController::executeQosSample(HTTPClient& http,
 
     if (strcmp_P(method, PSTR("POST")) == 0) {
       http.addHeader(F("Content-Type"), F("application/json"));
-      httpCode = http.POST(payload);
+      if (bodyLen > 0) {
+        QosProbeBodyStream body(bodyLen);
+        httpCode = http.sendRequest("POST", &body, bodyLen);
+      } else {
+        httpCode = http.POST(payload);
+      }
     } else {
       httpCode = http.GET();
     }
     http.end();
   }
+  TlsSessionCache::settle(tlsTicket, httpCode > 0);
 
-  releaseTlsResources();
+  if (!plain) {
+    releaseTlsResources();
+  }
   duration = millis() - startTick;
   return (httpCode > 0);
 }
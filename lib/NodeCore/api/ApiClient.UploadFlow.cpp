@@ -14,6 +14,7 @@
 #include "system/ConfigManager.h"
 #include "support/CryptoUtils.h"
 #include "system/Logger.h"
+#include "net/GatewayScoreboard.h"
 #include "net/NtpClient.h"
 #include "system/NodeIdentity.h"
 #include "sensor/SensorManager.h"
@@ -25,6 +26,7 @@
 #include "storage/RtcManager.h"
 
 #include "api/ApiClient.Health.h"
+#include "api/ApiClient.TransportShared.h"
 #include "api/ApiClient.UploadShared.h"
 
 using namespace ApiClientUploadShared;
@@ -68,21 +70,33 @@ UploadResult ApiClientUploadController::performLocalGatewayUpload(const char* pa
     return result;
   }
 
-  char gatewayUrls[4][MAX_URL_LEN] = {{0}};
+  const ApiClientTransportShared::EdgeGatewayTargets targets =
+      ApiClientTransportShared::resolveEdgeGatewayTargets(m_api.m_deps.configManager);
+  const char* hosts[] = {targets.primaryMdns, targets.primaryIp, targets.secondaryMdns, targets.secondaryIp};
+  uint8_t order[sizeof(hosts) / sizeof(hosts[0])];
+  const size_t hostCount = GatewayScoreboard::order(m_api.m_transport.edgeBoard,
+                                                    hosts,
+                                                    sizeof(hosts) / sizeof(hosts[0]),
+                                                    order,
+                                                    sizeof(order),
+                                                    m_policy.edgeHttpTimeoutMs);
   char dataPath[sizeof("/api/data")];
   copy_trunc_P(dataPath, sizeof(dataPath), PSTR("/api/data"));
-  const size_t gatewayUrlCount = build_gateway_url_candidates(gatewayUrls, 4, m_api.m_deps.configManager, dataPath);
-  if (gatewayUrlCount == 0) {
+  if (hostCount == 0) {
     result.httpCode = HTTPC_ERROR_CONNECTION_FAILED;
     copy_trunc_P(result.message, sizeof(result.message), PSTR("Gateway URL fail"));
     return result;
   }
 
+  // One-shot request on an HTTPClient that is freed right after; it takes plainClient over, so
+  // the upload state machine's kept socket is closed rather than reconnected underneath it.
+  HttpKeepAlive::close(m_api.m_transport.edgeConn, m_api.m_transport.plainClient);
   m_api.m_transport.httpClient->setReuse(false);
   m_transport.httpClient->setTimeout(m_policy.edgeHttpTimeoutMs);
-  for (size_t i = 0; i < gatewayUrlCount; ++i) {
-    const char* gatewayUrl = gatewayUrls[i];
-    if (!gatewayUrl || gatewayUrl[0] == '\0') {
+  for (size_t k = 0; k < hostCount; ++k) {
+    const char* host = hosts[order[k]];
+    char gatewayUrl[MAX_URL_LEN] = {0};
+    if (!build_gateway_url_from_host_str(gatewayUrl, sizeof(gatewayUrl), host, dataPath)) {
       continue;
     }
 
@@ -100,6 +114,8 @@ UploadResult ApiClientUploadController::performLocalGatewayUpload(const char* pa
     m_api.m_transport.httpClient->addHeader(F("User-Agent"), userAgent);
     m_api.m_transport.httpClient->addHeader(F("X-Device-ID"), deviceId);
     const int httpCode = m_api.m_transport.httpClient->POST(reinterpret_cast<const uint8_t*>(payload), length);
+    // Any HTTP status means the gateway answered; the POST timing covers more than a round trip.
+    GatewayScoreboard::record(m_api.m_transport.edgeBoard, host, httpCode > 0, 0, millis());
     result.httpCode = static_cast<int16_t>(httpCode);
     result.success = (httpCode >= 200 && httpCode < 300);
     if (result.success) {
@@ -127,6 +143,10 @@ void ApiClientUploadController::clearCurrentRecordFlags() {
 void ApiClientUploadController::clearLoadedRecordContext() {
   clearCurrentRecordFlags();
   m_api.m_runtime.route.loadedRecordSource = ApiClient::UploadRecordSource::NONE;
+  m_api.m_runtime.route.batchRtcRecords = 0;
+  m_api.m_runtime.route.batchLittleFsRecords = 0;
+  m_api.m_runtime.route.body = ApiClient::UploadBody();
+  m_api.discardReadAheadRecord();
 }
 
 void ApiClientUploadController::resetQueuePopRecovery() {
@@ -166,6 +186,8 @@ bool ApiClientUploadController::finishLoadedRecordSuccess(const AppConfig& cfg,
                                                           int httpCode,
                                                           bool setIdleOnPopFailure) {
   const ApiClient::UploadRecordSource uploadedFrom = m_api.m_runtime.route.loadedRecordSource;
+  const uint32_t batchRecords =
+      static_cast<uint32_t>(m_api.m_runtime.route.batchRtcRecords) + m_api.m_runtime.route.batchLittleFsRecords;
   if (!m_api.popLoadedRecord()) {
     if (setIdleOnPopFailure) {
       m_api.m_runtime.uploadState = ApiClient::UploadState::IDLE;
@@ -187,12 +209,11 @@ bool ApiClientUploadController::finishLoadedRecordSuccess(const AppConfig& cfg,
   pos = append_literal_P(msg, sizeof(msg), pos, PSTR("[SYSTEM] Upload OK (HTTP "));
   pos = append_i32(msg, sizeof(msg), pos, httpCode);
   pos = append_literal_P(msg, sizeof(msg), pos, PSTR(") via "));
-  pos = append_literal_P(msg,
-                         sizeof(msg),
-                         pos,
-                         uploadedFrom == ApiClient::UploadRecordSource::RTC ? PSTR("RTC")
-                         : uploadedFrom == ApiClient::UploadRecordSource::LITTLEFS ? PSTR("LittleFS")
-                                                                                   : PSTR("Unknown"));
+  pos = append_literal_P(msg, sizeof(msg), pos, m_api.uploadSourceLabelP(uploadedFrom));
+  if (batchRecords > 1) {
+    pos = append_literal_P(msg, sizeof(msg), pos, PSTR(" x"));
+    pos = append_u32(msg, sizeof(msg), pos, batchRecords);
+  }
   if (pos > 0) {
     m_api.broadcastEncrypted(std::string_view(msg, pos));
   }
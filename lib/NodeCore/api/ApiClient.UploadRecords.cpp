@@ -14,6 +14,7 @@
 #include "system/ConfigManager.h"
 #include "support/CryptoUtils.h"
 #include "system/Logger.h"
+#include "net/EdgeWireCodec.h"
 #include "net/NtpClient.h"
 #include "storage/RtcManager.h"
 #include "sensor/SensorManager.h"
@@ -117,23 +118,15 @@ bool ApiClientUploadController::appendEmergencyRecordToLittleFs(const ApiClient:
                                                                 bool announce) {
   static constexpr uint8_t kFallbackFsWriteRetries = 2;
 
-  if (!m_api.ensureSharedBuffer()) {
-    return false;
-  }
-  char* buf = m_api.sharedBuffer();
-  const size_t buf_len = m_api.sharedBufferSize();
-  if (!buf || buf_len == 0) {
-    return false;
-  }
-
-  size_t payloadLen = 0;
-  if (!buildPayloadFromEmergencyRecord(record, buf, buf_len, payloadLen)) {
-    LOG_ERROR("API", F("Fallback payload build failed"));
-    return false;
-  }
+  RtcSensorRecord compact{};
+  compact.timestamp = record.timestamp;
+  compact.temp10 = record.temp10;
+  compact.hum10 = record.hum10;
+  compact.lux = record.lux;
+  compact.rssi = record.rssi;
 
   for (uint8_t fsAttempt = 1; fsAttempt <= kFallbackFsWriteRetries; ++fsAttempt) {
-    if (m_api.m_deps.cacheManager.write(buf, payloadLen)) {
+    if (m_api.m_deps.cacheManager.write_sensor_record(compact)) {
       resetRtcFallbackRecovery();
       if (announce) {
         LOG_WARN("API", F("RTC append failed, record stored directly to LittleFS fallback"));
@@ -190,6 +183,10 @@ bool ApiClientUploadController::tryDirectSendEmergencyRecord(const ApiClient::Em
   }
 
   if (directToEdge) {
+    if (EDGE_WIRE_CBOR) {
+      m_api.m_runtime.route.edgeRecord = emergency_sample(record);
+      m_api.m_runtime.route.edgeRecordTyped = true;
+    }
     const size_t edgeLen = m_api.prepareEdgePayload(payloadLen);
     if (edgeLen > 0) {
       result = m_api.performLocalGatewayUpload(buf, edgeLen);
@@ -34,6 +34,10 @@ int ApiClient::checkGatewayMode() {
   return ApiClientUploadRuntimeController(*this).checkGatewayMode();
 }
 
+void ApiClient::probeDemotedGateway() {
+  ApiClientUploadRuntimeController(*this).probeDemotedGateway();
+}
+
 size_t ApiClient::prepareEdgePayload(size_t rawLen) {
   return ApiClientUploadRuntimeController(*this).prepareEdgePayload(rawLen);
 }
@@ -46,6 +50,14 @@ bool ApiClient::dispatchQueuedUploadRecord(size_t record_len, bool isTargetEdge)
   return ApiClientUploadRuntimeController(*this).dispatchQueuedUploadRecord(record_len, isTargetEdge);
 }
 
+uint16_t ApiClient::resolveUploadBatchCapacity(bool isTargetEdge) {
+  return ApiClientUploadRuntimeController(*this).resolveUploadBatchCapacity(isTargetEdge);
+}
+
+size_t ApiClient::assembleUploadBatch(size_t record_len, bool isTargetEdge) {
+  return ApiClientUploadRuntimeController(*this).assembleUploadBatch(record_len, isTargetEdge);
+}
+
 bool ApiClient::trySendLiveSnapshotToGateway() {
   return ApiClientUploadRuntimeController(*this).trySendLiveSnapshotToGateway();
 }
@@ -0,0 +1,236 @@
+#include "api/ApiClient.UploadRuntimeController.h"
+
+#include <ESP8266WiFi.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "storage/CacheManager.h"
+#include "support/CryptoUtils.h"
+#include "system/Logger.h"
+#include "storage/RtcManager.h"
+
+#include "api/ApiClient.Health.h"
+#include "api/ApiClient.UploadShared.h"
+
+using namespace ApiClientUploadShared;
+
+// ApiClient.UploadRuntimeBatch.cpp - queued upload bodies: streamed plans and buffered JSON arrays
+
+namespace {
+  // Largest plaintext whose "<iv>:<ciphertext>" base64 form fits ENCRYPTION_BUFFER_SIZE, the most
+  // a gateway body carries even though the node no longer encrypts it in one piece.
+  constexpr size_t kEdgeBatchPlainLimit = ((CryptoUtils::ENCRYPTION_BUFFER_SIZE - 32U) / 4U) * 3U - 20U;
+}  // namespace
+
+uint16_t ApiClientUploadRuntimeController::resolveUploadBatchCapacity(bool isTargetEdge) {
+  if (ApiClientDetail::kUploadBatchMaxRecords <= 1) {
+    return 1;
+  }
+  // The batch buffer is held through the connect, so the TLS guard must still hold with it allocated.
+  const ApiClientHealth::HeapBudget budget =
+      isTargetEdge ? ApiClientHealth::captureApiHeapBudget(m_ctx) : ApiClientHealth::captureTlsHeapBudget(m_ctx);
+  if (budget.maxBlock <= budget.minBlock || budget.freeHeap <= budget.minTotal) {
+    return 1;
+  }
+  const uint32_t headroom = std::min(budget.maxBlock - budget.minBlock, budget.freeHeap - budget.minTotal);
+  const uint32_t records = headroom / ApiClientDetail::kUploadBatchRecordSlot;
+  return static_cast<uint16_t>(
+      std::clamp<uint32_t>(records, 1U, static_cast<uint32_t>(ApiClientDetail::kUploadBatchMaxRecords)));
+}
+
+size_t ApiClientUploadRuntimeController::assembleUploadBatch(size_t record_len, bool isTargetEdge) {
+  auto& route = m_runtime.route;
+  route.batchRtcRecords = 0;
+  route.batchLittleFsRecords = 0;
+
+  const bool fromRtc = route.loadedRecordSource == ApiClient::UploadRecordSource::RTC;
+  const bool fromAlerts = route.loadedRecordSource == ApiClient::UploadRecordSource::PRIORITY;
+  if (!fromRtc && !fromAlerts && route.loadedRecordSource != ApiClient::UploadRecordSource::LITTLEFS) {
+    return 0;
+  }
+  // An alert batch stays inside the priority lane; its LittleFS counter pops from that lane.
+  const CacheLane lane = fromAlerts ? CacheLane::PRIORITY : CacheLane::ROUTINE;
+  const uint32_t lfsBytes = m_deps.cacheManager.get_lane_size(lane);
+  const bool hasMore = fromRtc ? (RtcManager::getCount() > 1 || lfsBytes > 0)
+                               : (lfsBytes > CacheManager::SENSOR_RECORD_LEN + CacheManager::RECORD_OVERHEAD_BYTES);
+  if (!hasMore) {
+    return 0;
+  }
+  const uint16_t capacity = resolveUploadBatchCapacity(isTargetEdge);
+  if (capacity < 2) {
+    return 0;
+  }
+
+  const char* first = m_api.sharedBuffer();
+  if (!first || record_len == 0) {
+    return 0;
+  }
+  if (!m_api.ensureBatchBuffer(static_cast<size_t>(capacity) * ApiClientDetail::kUploadBatchRecordSlot + 2U)) {
+    return 0;
+  }
+  char* batch = m_api.outgoingPayload();
+  const size_t batchSize = m_resources.batchBufferSize;
+  const size_t plainLimit = isTargetEdge ? std::min(batchSize - 1U, kEdgeBatchPlainLimit) : batchSize - 1U;
+  const int32_t nonActiveRssi =
+      isTargetEdge ? static_cast<int32_t>(resolve_nonactive_rssi(m_deps.wifiManager)) : 0;
+
+  // Records are written straight into their slot; the shared buffer keeps the first record intact
+  // so any bail-out below falls back to the single-record path untouched.
+  size_t pos = 0;
+  uint16_t records = 0;
+  batch[pos++] = '[';
+  auto slotStart = [&]() -> size_t { return pos + (records > 0 ? 1U : 0U); };
+  auto slotSpace = [&](size_t start) -> size_t { return (start + 2U < batchSize) ? batchSize - start - 1U : 0U; };
+  auto commitSlot = [&](size_t start, size_t len) -> bool {
+    batch[start + len] = '\0';
+    if (isTargetEdge) {
+      len = decorate_edge_record(batch + start, slotSpace(start), len, nonActiveRssi);
+      if (len == 0) {
+        return false;
+      }
+    }
+    if (start + len + 1U > plainLimit) {
+      return false;
+    }
+    if (start > pos) {
+      batch[pos] = ',';
+    }
+    pos = start + len;
+    records++;
+    return true;
+  };
+
+  size_t start = slotStart();
+  if (record_len >= slotSpace(start)) {
+    m_api.releaseBatchBuffer();
+    return 0;
+  }
+  memcpy(batch + start, first, record_len);
+  if (!commitSlot(start, record_len)) {
+    m_api.releaseBatchBuffer();
+    return 0;
+  }
+
+  bool continueToLittleFs = true;
+  CacheManager::PeekCursor lfsCursor = m_deps.cacheManager.peek_begin(lane);
+  if (fromRtc) {
+    // The whole run from one RTC read; the loaded record is its first entry.
+    RtcSensorRecord rtcRun[RTC_MAX_RECORDS];
+    uint16_t rtcSeqs[RTC_MAX_RECORDS];
+    uint16_t rtcLen = 0;
+    const uint16_t rtcWanted = static_cast<uint16_t>(std::min<uint32_t>(capacity, RTC_MAX_RECORDS));
+    const RtcReadStatus status = RtcManager::peekRun(rtcRun, rtcSeqs, rtcWanted, rtcLen, true);
+    if (rtcLen == 0) {
+      m_api.releaseBatchBuffer();
+      return 0;
+    }
+    route.batchRtcRecords = 1;
+    route.batchRtcLastSeq = rtcSeqs[0];
+    // A run cut short by a corrupt slot does not go on into LittleFS.
+    continueToLittleFs = (status == RtcReadStatus::NONE);
+    for (uint16_t i = 1; i < rtcLen && records < capacity; ++i) {
+      start = slotStart();
+      size_t len = 0;
+      if (!build_payload_from_rtc_record(batch + start, slotSpace(start), rtcRun[i], len) || !commitSlot(start, len)) {
+        continueToLittleFs = false;
+        break;
+      }
+      route.batchRtcRecords++;
+      route.batchRtcLastSeq = rtcSeqs[i];
+    }
+  } else {
+    // The loaded record was rendered from the tail entry, whose on-disk form may differ
+    // (compact record or block sample), so step over it with a scratch read into the next slot.
+    start = slotStart();
+    size_t skipped = 0;
+    if (slotSpace(start) < 2U ||
+        m_deps.cacheManager.peek_next(lfsCursor, batch + start, slotSpace(start) - 1U, skipped) !=
+            CacheReadError::NONE) {
+      m_api.releaseBatchBuffer();
+      return 0;
+    }
+    route.batchLittleFsRecords = 1;
+  }
+
+  while (continueToLittleFs && records < capacity) {
+    start = slotStart();
+    const size_t space = slotSpace(start);
+    if (space < 2U) {
+      break;
+    }
+    size_t len = 0;
+    if (m_deps.cacheManager.peek_next(lfsCursor, batch + start, space - 1U, len) != CacheReadError::NONE ||
+        !render_cached_record(batch + start, space, len)) {
+      break;
+    }
+    if (!commitSlot(start, len)) {
+      break;
+    }
+    route.batchLittleFsRecords++;
+    ESP.wdtFeed();
+  }
+
+  if (records < 2) {
+    route.batchRtcRecords = 0;
+    route.batchLittleFsRecords = 0;
+    m_api.releaseBatchBuffer();
+    return 0;
+  }
+  batch[pos++] = ']';
+  batch[pos] = '\0';
+  // A gateway batch stays plaintext here; the transport encrypts it while it is sent.
+
+  LOG_INFO("API",
+           F("Batch: %u records (RTC %u, LittleFS %u, %u B)"),
+           static_cast<unsigned>(records),
+           static_cast<unsigned>(route.batchRtcRecords),
+           static_cast<unsigned>(route.batchLittleFsRecords),
+           static_cast<unsigned>(pos));
+  return pos;
+}
+
+size_t ApiClientUploadRuntimeController::planQueuedUploadBody(bool isTargetEdge) {
+  auto& route = m_runtime.route;
+  route.batchRtcRecords = 0;
+  route.batchLittleFsRecords = 0;
+
+  const bool fromRtc = route.loadedRecordSource == ApiClient::UploadRecordSource::RTC;
+  const bool fromAlerts = route.loadedRecordSource == ApiClient::UploadRecordSource::PRIORITY;
+  if (!fromRtc && !fromAlerts && route.loadedRecordSource != ApiClient::UploadRecordSource::LITTLEFS) {
+    return 0;
+  }
+  const CacheLane lane = fromAlerts ? CacheLane::PRIORITY : CacheLane::ROUTINE;
+  // Only one record is ever rendered at a time, so the batch size no longer depends on the heap.
+  std::array<char, ApiClientDetail::kUploadBatchRecordSlot + 1> slot{};
+  const WireRecordRenderer render{isTargetEdge, route.body.nonActiveRssi};
+  const UploadBatchStream::Plan plan =
+      UploadBatchStream::plan(m_deps.cacheManager,
+                              fromRtc,
+                              lane,
+                              ApiClientDetail::kUploadBatchMaxRecords,
+                              isTargetEdge ? static_cast<uint32_t>(kEdgeBatchPlainLimit) : UINT32_MAX,
+                              slot.data(),
+                              slot.size(),
+                              render,
+                              render);
+  if (!plan.active) {
+    return 0;
+  }
+
+  route.body.source = ApiClient::UploadBodySource::QUEUE;
+  route.body.plan = plan;
+  if (plan.records() > 1) {
+    route.batchRtcRecords = plan.rtcRecords;
+    route.batchRtcLastSeq = plan.lastRtcSeq;
+    route.batchLittleFsRecords = plan.laneRecords;
+    LOG_INFO("API",
+             F("Batch: %u records (RTC %u, LittleFS %u, %u B streamed)"),
+             static_cast<unsigned>(plan.records()),
+             static_cast<unsigned>(plan.rtcRecords),
+             static_cast<unsigned>(plan.laneRecords),
+             static_cast<unsigned>(plan.bodyLen));
+  }
+  return plan.bodyLen;
+}
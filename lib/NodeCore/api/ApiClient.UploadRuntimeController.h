@@ -24,9 +24,14 @@ public:
   bool isHeapHealthy();
   void processGatewayResult(const UploadResult& res);
   int checkGatewayMode();
+  void probeDemotedGateway();
   size_t prepareEdgePayload(size_t rawLen);
+  size_t prepareEdgeBody(size_t rawLen);
   void handleUploadCycle();
   bool dispatchQueuedUploadRecord(size_t record_len, bool isTargetEdge);
+  uint16_t resolveUploadBatchCapacity(bool isTargetEdge);
+  size_t assembleUploadBatch(size_t record_len, bool isTargetEdge);
+  size_t planQueuedUploadBody(bool isTargetEdge);
   bool trySendLiveSnapshotToGateway();
 
 private:
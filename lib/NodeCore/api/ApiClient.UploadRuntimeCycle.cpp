@@ -14,6 +14,7 @@
 #include "system/ConfigManager.h"
 #include "support/CryptoUtils.h"
 #include "system/Logger.h"
+#include "net/EdgeWireCodec.h"
 #include "net/NtpClient.h"
 #include "storage/RtcManager.h"
 #include "sensor/SensorManager.h"
@@ -37,59 +38,31 @@ size_t ApiClientUploadRuntimeController::prepareEdgePayload(size_t rawLen) {
   if (!buf || buf_len == 0) {
     return 0;
   }
-  char* closingBrace = strrchr(buf, '}');
-  if (!closingBrace) {
-    return 0;
-  }
-
-  char sendTimeValue[24];
-  copy_default_datetime(sendTimeValue, sizeof(sendTimeValue));
-  size_t sendTimeLen = sizeof("1970-01-01 00:00:00") - 1;
-  (void)extract_recorded_at_value(buf, sendTimeValue, sizeof(sendTimeValue), sendTimeLen);
-
-  if (!strip_recorded_at_field(buf, rawLen)) {
-    return 0;
-  }
-  closingBrace = strrchr(buf, '}');
-  if (!closingBrace) {
-    return 0;
-  }
-
   const int32_t nonActiveRssi = static_cast<int32_t>(resolve_nonactive_rssi(m_api.m_deps.wifiManager));
-
-  char edgeOnlyFields[64];
-  size_t fieldsPos = 0;
-  if (!append_bytes_strict_P(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, PSTR(",\"rssi_nonactive\":"))) {
-    return 0;
-  }
-  if (!append_i32_strict(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, nonActiveRssi)) {
-    return 0;
-  }
-  if (!append_bytes_strict_P(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, PSTR(",\"send_time\":\""))) {
-    return 0;
-  }
-  if (!append_bytes_strict(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, sendTimeValue, sendTimeLen)) {
-    return 0;
-  }
-  if (!append_char_strict(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, '"')) {
-    return 0;
-  }
-  if (!append_char_strict(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, '}')) {
-    return 0;
-  }
-
-  const size_t insertPos = static_cast<size_t>(closingBrace - buf);
-  if (insertPos + fieldsPos >= buf_len) {
-    return 0;
+  auto& route = m_api.m_runtime.route;
+  const bool typed = route.edgeRecordTyped;
+  route.edgeRecordTyped = false;
+
+  // CBOR encodes the typed record as is; the JSON record is patched for the gateway instead.
+  std::array<uint8_t, EdgeWireCodec::kMaxEncodedLen> wire{};
+  std::string_view plain;
+  if (EDGE_WIRE_CBOR && typed) {
+    const size_t wireLen = EdgeWireCodec::encode(
+        wire.data(), wire.size(), route.edgeRecord, edge_envelope(route.edgeRecord, nonActiveRssi));
+    plain = std::string_view(reinterpret_cast<const char*>(wire.data()), wireLen);
+  }
+  if (plain.empty()) {
+    rawLen = decorate_edge_record(buf, buf_len, rawLen, nonActiveRssi);
+    if (rawLen == 0) {
+      return 0;
+    }
+    plain = std::string_view(buf, rawLen);
   }
-  memcpy(buf + insertPos, edgeOnlyFields, fieldsPos + 1);
-  rawLen = insertPos + fieldsPos;
 
   std::array<char, CryptoUtils::ENCRYPTION_BUFFER_SIZE + 4> encBuffer{};
   strcpy_P(encBuffer.data(), PSTR("ENC:"));
 
-  size_t encLen = CryptoUtils::fast_serialize_encrypted_main(
-      std::string_view(buf, rawLen), encBuffer.data() + 4, encBuffer.size() - 4);
+  size_t encLen = CryptoUtils::fast_serialize_encrypted_main(plain, encBuffer.data() + 4, encBuffer.size() - 4);
 
   if (encLen == 0) {
     return 0;
@@ -105,6 +78,31 @@ size_t ApiClientUploadRuntimeController::prepareEdgePayload(size_t rawLen) {
   return totalLen;
 }
 
+size_t ApiClientUploadRuntimeController::prepareEdgeBody(size_t rawLen) {
+  auto& route = m_api.m_runtime.route;
+  auto& body = route.body;
+  const bool typed = route.edgeRecordTyped;
+  route.edgeRecordTyped = false;
+  // CBOR is encoded from the typed record each time the request is written, so only its length is
+  // taken here; the JSON record is decorated in the shared buffer and sent from there.
+  if (EDGE_WIRE_CBOR && typed) {
+    std::array<uint8_t, EdgeWireCodec::kMaxEncodedLen> wire{};
+    const size_t wireLen = EdgeWireCodec::encode(
+        wire.data(), wire.size(), route.edgeRecord, edge_envelope(route.edgeRecord, body.nonActiveRssi));
+    if (wireLen > 0) {
+      body.source = ApiClient::UploadBodySource::TYPED;
+      return wireLen;
+    }
+  }
+  char* buf = m_api.sharedBuffer();
+  const size_t buf_len = m_api.sharedBufferSize();
+  if (!buf || buf_len == 0) {
+    return 0;
+  }
+  body.source = ApiClient::UploadBodySource::BUFFER;
+  return decorate_edge_record(buf, buf_len, rawLen, body.nonActiveRssi);
+}
+
 void ApiClientUploadRuntimeController::handleUploadCycle() {
   if (m_api.m_transport.httpState != ApiClient::HttpState::IDLE) {
     return;
@@ -220,20 +218,41 @@ bool ApiClientUploadRuntimeController::dispatchQueuedUploadRecord(size_t record_
     return false;
   }
 
+  auto& route = m_api.m_runtime.route;
+  auto& body = route.body;
+  body = ApiClient::UploadBody();
   if (isTargetEdge) {
-    const size_t encLen = prepareEdgePayload(record_len);
-    if (encLen == 0) {
-      LOG_ERROR("API", F("Encryption failed. Skipping."));
-      m_api.resetQueuedUploadCycle(true);
-      return false;
-    }
-    m_api.broadcastUploadDispatch(false, true, record_len);
-    m_api.startUpload(buf, encLen, true);
-  } else {
-    m_api.broadcastUploadDispatch(false, false, record_len);
-    m_api.startUpload(buf, record_len, false);
+    body.nonActiveRssi = static_cast<int32_t>(resolve_nonactive_rssi(m_api.m_deps.wifiManager));
   }
 
+  // Streamed, the body is rendered from storage whenever the request is written; buffered, a batch
+  // is assembled in the batch buffer. Either way a gateway body is encrypted while it is sent.
+  size_t plainLen =
+      UPLOAD_STREAM_BATCH ? planQueuedUploadBody(isTargetEdge) : assembleUploadBatch(record_len, isTargetEdge);
+  if (plainLen > 0 && isTargetEdge && EDGE_WIRE_CBOR && route.edgeRecordTyped &&
+      route.batchRtcRecords == 0 && route.batchLittleFsRecords == 0) {
+    // A lone gateway record goes in its typed form.
+    body.source = ApiClient::UploadBodySource::BUFFER;
+    body.plan = UploadBatchStream::Plan();
+    plainLen = 0;
+  }
+  if (plainLen == 0) {
+    plainLen = isTargetEdge ? prepareEdgeBody(record_len) : record_len;
+  }
+  if (plainLen == 0) {
+    LOG_ERROR("API", F("Upload body could not be rendered. Skipping."));
+    m_api.resetQueuedUploadCycle(true);
+    return false;
+  }
+  body.plainLen = static_cast<uint32_t>(plainLen);
+
+  m_api.broadcastUploadDispatch(false, isTargetEdge, plainLen);
+  const bool buffered = body.source == ApiClient::UploadBodySource::BUFFER;
+  if (!buffered) {
+    m_api.releaseSharedBuffer();
+  }
+  m_api.startUpload(buffered ? m_api.outgoingPayload() : nullptr, plainLen, isTargetEdge);
+
   if (m_api.m_transport.httpState == ApiClient::HttpState::IDLE) {
     LOG_WARN("API", F("Queued upload did not start"));
     m_api.resetQueuedUploadCycle(true);
@@ -278,15 +297,31 @@ bool ApiClientUploadRuntimeController::trySendLiveSnapshotToGateway() {
     return false;
   }
 
+  // The snapshot is rendered here only for its length; the transport renders it again from a copy,
+  // since a newer snapshot may replace the pending one while this one is in flight.
+  auto& route = m_api.m_runtime.route;
+  auto& body = route.body;
+  body = ApiClient::UploadBody();
+  body.live = m_api.m_runtime.queue.pendingLiveSnapshot;
+  body.nonActiveRssi = static_cast<int32_t>(resolve_nonactive_rssi(m_api.m_deps.wifiManager));
   size_t record_len = 0;
-  if (!m_api.buildPayloadFromEmergencyRecord(m_api.m_runtime.queue.pendingLiveSnapshot, buf, buf_len, record_len)) {
+  if (!m_api.buildPayloadFromEmergencyRecord(body.live, buf, buf_len, record_len)) {
     return false;
   }
 
-  const size_t encLen = prepareEdgePayload(record_len);
-  if (encLen == 0) {
+  if (EDGE_WIRE_CBOR) {
+    route.edgeRecord = emergency_sample(body.live);
+    route.edgeRecordTyped = true;
+  }
+  const size_t plainLen = prepareEdgeBody(record_len);
+  if (plainLen == 0) {
     return false;
   }
+  if (body.source == ApiClient::UploadBodySource::BUFFER) {
+    body.source = ApiClient::UploadBodySource::LIVE_SNAPSHOT;
+  }
+  body.plainLen = static_cast<uint32_t>(plainLen);
+  m_api.releaseSharedBuffer();
 
   char msg[96];
   int n = snprintf_P(msg, sizeof(msg), PSTR("[UPLOAD] EDGE live snapshot (%u B)"), static_cast<unsigned>(record_len));
@@ -297,7 +332,7 @@ bool ApiClientUploadRuntimeController::trySendLiveSnapshotToGateway() {
 
   m_api.m_runtime.queue.liveSnapshotPending = false;
   m_api.m_runtime.queue.liveSnapshotInFlight = true;
-  m_api.startUpload(buf, encLen, true);
+  m_api.startUpload(nullptr, plainLen, true);
   if (m_api.m_transport.httpState == ApiClient::HttpState::IDLE) {
     m_api.m_runtime.queue.liveSnapshotInFlight = false;
     m_api.m_runtime.queue.liveSnapshotPending = true;
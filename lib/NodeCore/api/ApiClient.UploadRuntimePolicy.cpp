@@ -14,6 +14,7 @@
 #include "system/ConfigManager.h"
 #include "support/CryptoUtils.h"
 #include "system/Logger.h"
+#include "net/GatewayScoreboard.h"
 #include "net/NtpClient.h"
 #include "storage/RtcManager.h"
 #include "sensor/SensorManager.h"
@@ -24,10 +25,15 @@
 #include "support/Utils.h"
 
 #include "api/ApiClient.Health.h"
+#include "api/ApiClient.TransportShared.h"
 #include "api/ApiClient.UploadShared.h"
 
 using namespace ApiClientUploadShared;
 
+namespace {
+  constexpr uint16_t kEdgeGatewayPort = 80;
+}  // namespace
+
 void ApiClientUploadRuntimeController::notifyLowMemory(uint32_t maxBlock, uint32_t totalFree) {
   LOG_WARN("MEM", F("Low Mem - Skip. Block: %u, Total: %u"), maxBlock, totalFree);
   char msg[80];
@@ -215,6 +221,37 @@ void ApiClientUploadRuntimeController::processGatewayResult(const UploadResult&
   }
 }
 
+void ApiClientUploadRuntimeController::probeDemotedGateway() {
+  GatewayScoreboard::Board& board = m_transport.edgeBoard;
+  const unsigned long now = millis();
+  if (!GatewayScoreboard::probe_pending(board, now) || !WiFi.isConnected()) {
+    return;
+  }
+  const ApiClientTransportShared::EdgeGatewayTargets targets =
+      ApiClientTransportShared::resolveEdgeGatewayTargets(m_deps.configManager);
+  const char* hosts[] = {targets.primaryMdns, targets.primaryIp, targets.secondaryMdns, targets.secondaryIp};
+  const char* host = GatewayScoreboard::probe_due(board, hosts, sizeof(hosts) / sizeof(hosts[0]), now);
+  if (!host) {
+    // Only hosts no longer configured are demoted; wait out the interval before looking again.
+    GatewayScoreboard::probe_started(board, now);
+    return;
+  }
+
+  GatewayScoreboard::probe_started(board, now);
+  WiFiClient probe;
+  probe.setTimeout(EDGE_GATEWAY_PROBE_TIMEOUT_MS);
+  const unsigned long start = millis();
+  const bool ok = probe.connect(host, kEdgeGatewayPort);
+  const unsigned long connectMs = std::max<unsigned long>(1, millis() - start);
+  probe.stop();
+  GatewayScoreboard::record(board, host, ok, ok ? connectMs : 0, millis());
+  if (ok) {
+    LOG_INFO("API", F("Edge gateway %s answers again (%lu ms); promoted"), host, connectMs);
+  } else {
+    LOG_DEBUG("API", F("Edge gateway %s still unreachable"), host);
+  }
+}
+
 int ApiClientUploadRuntimeController::checkGatewayMode() {
   if (!m_api.m_transport.httpClient) {
     m_api.m_transport.httpClient.reset(new (std::nothrow) HTTPClient());
@@ -222,6 +259,8 @@ int ApiClientUploadRuntimeController::checkGatewayMode() {
       return -1;
     }
   }
+  // HTTPClient takes plainClient over; drop the upload socket kept alive on it.
+  HttpKeepAlive::close(m_api.m_transport.edgeConn, m_api.m_transport.plainClient);
   m_api.m_transport.httpClient->setReuse(false);
   m_transport.httpClient->setTimeout(m_policy.edgeHttpTimeoutMs);
 
@@ -4,7 +4,11 @@
 
 #include <cstring>
 
+#include "storage/CacheManager.h"
+#include "storage/SensorAggregateCodec.h"
 #include "support/GatewayTargeting.h"
+#include "support/SensorPayloadTemplate.h"
+#include "support/TimestampCache.h"
 
 namespace ApiClientUploadShared {
 
@@ -204,6 +208,52 @@ bool strip_recorded_at_field(char* payload, size_t& len) {
   return true;
 }
 
+size_t decorate_edge_record(char* payload, size_t buf_len, size_t len, int32_t nonActiveRssi) {
+  if (!payload || buf_len == 0 || len == 0) {
+    return 0;
+  }
+  char sendTimeValue[24];
+  copy_default_datetime(sendTimeValue, sizeof(sendTimeValue));
+  size_t sendTimeLen = sizeof("1970-01-01 00:00:00") - 1;
+  (void)extract_recorded_at_value(payload, sendTimeValue, sizeof(sendTimeValue), sendTimeLen);
+
+  if (!strip_recorded_at_field(payload, len)) {
+    return 0;
+  }
+  char* closingBrace = strrchr(payload, '}');
+  if (!closingBrace) {
+    return 0;
+  }
+
+  char edgeOnlyFields[64];
+  size_t fieldsPos = 0;
+  if (!append_bytes_strict_P(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, PSTR(",\"rssi_nonactive\":"))) {
+    return 0;
+  }
+  if (!append_i32_strict(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, nonActiveRssi)) {
+    return 0;
+  }
+  if (!append_bytes_strict_P(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, PSTR(",\"send_time\":\""))) {
+    return 0;
+  }
+  if (!append_bytes_strict(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, sendTimeValue, sendTimeLen)) {
+    return 0;
+  }
+  if (!append_char_strict(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, '"')) {
+    return 0;
+  }
+  if (!append_char_strict(edgeOnlyFields, sizeof(edgeOnlyFields), fieldsPos, '}')) {
+    return 0;
+  }
+
+  const size_t insertPos = static_cast<size_t>(closingBrace - payload);
+  if (insertPos + fieldsPos >= buf_len) {
+    return 0;
+  }
+  memcpy(payload + insertPos, edgeOnlyFields, fieldsPos + 1);
+  return insertPos + fieldsPos;
+}
+
 size_t buildSensorPayload(char* out,
                           size_t out_len,
                           uint32_t gh_id,
@@ -270,52 +320,13 @@ size_t buildSensorPayload(char* out,
   return pos;
 }
 
-void format_datetime(char* out, size_t out_len, const tm& t) {
-  if (!out || out_len < 20) {
-    if (out && out_len > 0) {
-      out[0] = '\0';
-    }
-    return;
-  }
-  const uint16_t year = static_cast<uint16_t>(t.tm_year + 1900);
-  const uint8_t mon = static_cast<uint8_t>(t.tm_mon + 1);
-  const uint8_t day = static_cast<uint8_t>(t.tm_mday);
-  const uint8_t hour = static_cast<uint8_t>(t.tm_hour);
-  const uint8_t min = static_cast<uint8_t>(t.tm_min);
-  const uint8_t sec = static_cast<uint8_t>(t.tm_sec);
-
-  out[0] = static_cast<char>('0' + (year / 1000) % 10);
-  out[1] = static_cast<char>('0' + (year / 100) % 10);
-  out[2] = static_cast<char>('0' + (year / 10) % 10);
-  out[3] = static_cast<char>('0' + (year % 10));
-  out[4] = '-';
-  out[5] = static_cast<char>('0' + (mon / 10));
-  out[6] = static_cast<char>('0' + (mon % 10));
-  out[7] = '-';
-  out[8] = static_cast<char>('0' + (day / 10));
-  out[9] = static_cast<char>('0' + (day % 10));
-  out[10] = ' ';
-  out[11] = static_cast<char>('0' + (hour / 10));
-  out[12] = static_cast<char>('0' + (hour % 10));
-  out[13] = ':';
-  out[14] = static_cast<char>('0' + (min / 10));
-  out[15] = static_cast<char>('0' + (min % 10));
-  out[16] = ':';
-  out[17] = static_cast<char>('0' + (sec / 10));
-  out[18] = static_cast<char>('0' + (sec % 10));
-  out[19] = '\0';
-}
-
 void format_record_timestamp(uint32_t timestamp, char* out, size_t out_len) {
   copy_default_datetime(out, out_len);
-  if (timestamp <= NTP_VALID_TIMESTAMP_THRESHOLD) {
+  if (timestamp <= NTP_VALID_TIMESTAMP_THRESHOLD || out_len <= TimestampCache::kLen) {
     return;
   }
-
-  tm timeinfo;
-  const time_t ts = static_cast<time_t>(timestamp);
-  localtime_r(&ts, &timeinfo);
-  format_datetime(out, out_len, timeinfo);
+  // Records of a backlog mostly share a day; only a new day costs a localtime_r().
+  TimestampCache::format(static_cast<time_t>(timestamp), out);
 }
 
 bool build_payload_from_record_fields(char* out,
@@ -328,21 +339,10 @@ bool build_payload_from_record_fields(char* out,
                                       size_t& payload_len) {
   char timeBuf[20];
   format_record_timestamp(timestamp, timeBuf, sizeof(timeBuf));
-  payload_len = buildSensorPayload(out,
-                                   out_len,
-                                   static_cast<uint32_t>(GH_ID),
-                                   static_cast<uint32_t>(NODE_ID),
-                                   temp10,
-                                   hum10,
-                                   lux,
-                                   rssi,
-                                   timeBuf,
-                                   19);
-  if (payload_len == 0) {
-    return false;
-  }
-  out[payload_len] = '\0';
-  return true;
+  // Same bytes as buildSensorPayload() with this node's ids, from the compile-time template.
+  payload_len = SensorPayloadTemplate::Layout<static_cast<uint32_t>(GH_ID), static_cast<uint32_t>(NODE_ID)>::render(
+      out, out_len, temp10, hum10, lux, rssi, timeBuf);
+  return payload_len != 0;
 }
 
 bool build_payload_from_rtc_record(
@@ -357,4 +357,101 @@ bool build_payload_from_rtc_record(
                                           payload_len);
 }
 
+bool build_payload_from_aggregate(
+    char* out, size_t out_len, const SensorAggregateCodec::SensorAggregate& agg, size_t& payload_len) {
+  if (!build_payload_from_record_fields(
+          out, out_len, agg.start, agg.tempMean10, agg.humMean10, agg.luxMean, agg.rssiMean, payload_len)) {
+    return false;
+  }
+  // Reopen the object and append the window summary.
+  size_t pos = payload_len - 1;
+  if (!append_bytes_strict_P(out, out_len, pos, PSTR(",\"t_min\":")) ||
+      !append_fixed1_strict(out, out_len, pos, SensorNormalization::clampTemperatureTenths(agg.tempMin10)) ||
+      !append_bytes_strict_P(out, out_len, pos, PSTR(",\"t_max\":")) ||
+      !append_fixed1_strict(out, out_len, pos, SensorNormalization::clampTemperatureTenths(agg.tempMax10)) ||
+      !append_bytes_strict_P(out, out_len, pos, PSTR(",\"h_min\":")) ||
+      !append_fixed1_strict(out, out_len, pos, SensorNormalization::clampHumidityTenths(agg.humMin10)) ||
+      !append_bytes_strict_P(out, out_len, pos, PSTR(",\"h_max\":")) ||
+      !append_fixed1_strict(out, out_len, pos, SensorNormalization::clampHumidityTenths(agg.humMax10)) ||
+      !append_bytes_strict_P(out, out_len, pos, PSTR(",\"samples\":")) ||
+      !append_u32_strict(out, out_len, pos, agg.count) ||
+      !append_bytes_strict_P(out, out_len, pos, PSTR(",\"window_s\":")) ||
+      !append_u32_strict(out, out_len, pos, agg.window) ||
+      !append_char_strict(out, out_len, pos, '}')) {
+    return false;
+  }
+  payload_len = pos;
+  out[payload_len] = '\0';
+  return true;
+}
+
+bool render_cached_record(char* buf, size_t buf_len, size_t& len) {
+  RtcSensorRecord record;
+  if (CacheManager::decode_sensor_record(buf, len, record)) {
+    return build_payload_from_rtc_record(buf, buf_len, record, len);
+  }
+  SensorAggregateCodec::SensorAggregate agg;
+  if (SensorAggregateCodec::decode(buf, len, agg)) {
+    return build_payload_from_aggregate(buf, buf_len, agg, len);
+  }
+  return len > 0;
+}
+
+bool decode_cached_sample(const char* buf, size_t len, SensorAggregateCodec::SensorAggregate& out) {
+  RtcSensorRecord record;
+  if (CacheManager::decode_sensor_record(buf, len, record)) {
+    out = SensorAggregateCodec::from_sample(record);
+    return true;
+  }
+  return SensorAggregateCodec::decode(buf, len, out);
+}
+
+SensorAggregateCodec::SensorAggregate emergency_sample(const ApiClientDetail::EmergencyRecord& record) {
+  const RtcSensorRecord sample{record.timestamp, record.temp10, record.hum10, record.lux, record.rssi};
+  return SensorAggregateCodec::from_sample(sample);
+}
+
+EdgeWireCodec::Envelope edge_envelope(const SensorAggregateCodec::SensorAggregate& record, int32_t nonActiveRssi) {
+  EdgeWireCodec::Envelope envelope;
+  envelope.ghId = static_cast<uint32_t>(GH_ID);
+  envelope.nodeId = static_cast<uint32_t>(NODE_ID);
+  envelope.rssiNonActive = nonActiveRssi;
+  envelope.sendTime = (record.start > NTP_VALID_TIMESTAMP_THRESHOLD) ? record.start : 0;
+  return envelope;
+}
+
+bool WireRecordRenderer::operator()(char* out, size_t out_len, const RtcSensorRecord& record, size_t& len) const {
+  return finish(out, out_len, build_payload_from_rtc_record(out, out_len, record, len), len);
+}
+
+bool WireRecordRenderer::operator()(char* out, size_t out_len, size_t& len) const {
+  return finish(out, out_len, render_cached_record(out, out_len, len), len);
+}
+
+bool WireRecordRenderer::operator()(char* out,
+                                    size_t out_len,
+                                    const ApiClientDetail::EmergencyRecord& record,
+                                    size_t& len) const {
+  const bool rendered = build_payload_from_record_fields(out,
+                                                         out_len,
+                                                         record.timestamp,
+                                                         static_cast<int32_t>(record.temp10),
+                                                         static_cast<int32_t>(record.hum10),
+                                                         static_cast<uint32_t>(record.lux),
+                                                         static_cast<int32_t>(record.rssi),
+                                                         len);
+  return finish(out, out_len, rendered, len);
+}
+
+bool WireRecordRenderer::finish(char* out, size_t out_len, bool rendered, size_t& len) const {
+  if (!rendered || len == 0 || len >= out_len) {
+    return false;
+  }
+  out[len] = '\0';
+  if (edge) {
+    len = decorate_edge_record(out, out_len, len, nonActiveRssi);
+  }
+  return len > 0;
+}
+
 }  // namespace ApiClientUploadShared
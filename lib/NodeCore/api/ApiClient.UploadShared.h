@@ -5,8 +5,11 @@
 #include <Arduino.h>
 #include <cstddef>
 
+#include "api/ApiClient.State.h"
 #include "system/ConfigManager.h"
+#include "net/EdgeWireCodec.h"
 #include "storage/RtcManager.h"
+#include "storage/SensorAggregateCodec.h"
 #include "sensor/SensorNormalization.h"
 #include "support/TextBufferUtils.h"
 #include "REDACTED"
@@ -39,6 +42,10 @@ namespace ApiClientUploadShared {
   int16_t resolve_nonactive_rssi(WifiManager& wifiManager);
   bool extract_recorded_at_value(const char* payload, char* out, size_t out_len, size_t& value_len);
   bool strip_recorded_at_field(char* payload, size_t& len);
+  // Rewrites a cloud record in place for the gateway: drops recorded_at, appends rssi_nonactive/send_time.
+  size_t decorate_edge_record(char* payload, size_t buf_len, size_t len, int32_t nonActiveRssi);
+  // Reference builder for any ids; records for this node go through SensorPayloadTemplate, which
+  // writes the same bytes.
   size_t buildSensorPayload(char* out,
                             size_t out_len,
                             uint32_t gh_id,
@@ -49,7 +56,7 @@ namespace ApiClientUploadShared {
                             int32_t rssi,
                             const char* timeStr,
                             size_t timeLen);
-  void format_datetime(char* out, size_t out_len, const tm& t);
+  // "YYYY-MM-DD HH:MM:SS" in local time; the epoch default for timestamps from before NTP.
   void format_record_timestamp(uint32_t timestamp, char* out, size_t out_len);
   bool build_payload_from_record_fields(char* out,
                                         size_t out_len,
@@ -61,4 +68,31 @@ namespace ApiClientUploadShared {
                                         size_t& payload_len);
   bool build_payload_from_rtc_record(
       char* out, size_t out_len, const RtcSensorRecord& record, size_t& payload_len);
+  // Downsampled window: the mean as a regular sample stamped with the first merged sample,
+  // plus min/max, sample count and window length.
+  bool build_payload_from_aggregate(
+      char* out, size_t out_len, const SensorAggregateCodec::SensorAggregate& agg, size_t& payload_len);
+  // LittleFS records may be compact binary samples or aggregates; renders them to JSON in place
+  // (JSON passes through).
+  bool render_cached_record(char* buf, size_t buf_len, size_t& len);
+  // Typed form of a cache entry before it is rendered; false for legacy JSON entries.
+  bool decode_cached_sample(const char* buf, size_t len, SensorAggregateCodec::SensorAggregate& out);
+  SensorAggregateCodec::SensorAggregate emergency_sample(const ApiClientDetail::EmergencyRecord& record);
+  // CBOR envelope for a typed gateway record from this node.
+  EdgeWireCodec::Envelope edge_envelope(const SensorAggregateCodec::SensorAggregate& record, int32_t nonActiveRssi);
+
+  // Renders one body record as it goes on the wire: the cloud JSON, or for the gateway the same
+  // record decorated with rssi_nonactive/send_time. Plugs into UploadBatchStream as both renderers.
+  struct WireRecordRenderer {
+    bool edge = false;
+    int32_t nonActiveRssi = 0;
+
+    bool operator()(char* out, size_t out_len, const RtcSensorRecord& record, size_t& len) const;
+    // A cache entry already read into `out`.
+    bool operator()(char* out, size_t out_len, size_t& len) const;
+    bool operator()(char* out, size_t out_len, const ApiClientDetail::EmergencyRecord& record, size_t& len) const;
+
+  private:
+    bool finish(char* out, size_t out_len, bool rendered, size_t& len) const;
+  };
 }  // namespace ApiClientUploadShared
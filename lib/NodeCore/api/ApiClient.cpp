@@ -21,6 +21,7 @@ bool ApiClient::ensureSharedBuffer() {
 
 void ApiClient::releaseSharedBuffer() {
   m_resources.sharedBuffer.reset();
+  releaseBatchBuffer();
 }
 
 char* ApiClient::sharedBuffer() {
@@ -34,3 +35,29 @@ const char* ApiClient::sharedBuffer() const {
 size_t ApiClient::sharedBufferSize() const {
   return m_resources.sharedBuffer ? m_resources.sharedBuffer->size() : 0;
 }
+
+bool ApiClient::ensureBatchBuffer(size_t size) {
+  if (m_resources.batchBuffer && m_resources.batchBufferSize >= size) {
+    return true;
+  }
+  releaseBatchBuffer();
+  std::unique_ptr<char[]> buf(new (std::nothrow) char[size]);
+  if (!buf) {
+    LOG_WARN("MEM", F("Batch buffer alloc failed (%u B)"), static_cast<unsigned>(size));
+    return false;
+  }
+  buf[0] = '\0';
+  m_resources.batchBuffer.swap(buf);
+  m_resources.batchBufferSize = size;
+  return true;
+}
+
+void ApiClient::releaseBatchBuffer() {
+  m_resources.batchBuffer.reset();
+  m_resources.batchBufferSize = 0;
+}
+
+// Body for the transport state machine: the batch array when one was assembled, else the shared record.
+char* ApiClient::outgoingPayload() {
+  return m_resources.batchBuffer ? m_resources.batchBuffer.get() : sharedBuffer();
+}
@@ -60,6 +60,9 @@ public:
   // --- NEW: QoS Methods ---
   void requestQosUpload();
   void requestQosOta();
+  // Posts `bodyBytes` (0: a full batch) `samples` times (0: default) to the cloud, the relay and
+  // each edge gateway candidate, reporting bytes/s and p50/p90/p99. False while a test runs.
+  bool requestQosThroughput(uint16_t bodyBytes, uint8_t samples);
   void broadcastEncrypted(std::string_view text);
   void broadcastEncrypted(const char* text);
   void broadcastEncrypted(const __FlashStringHelper* text);
@@ -85,6 +88,12 @@ public:
   void setOtaInProgress(bool inProgress);
   [[nodiscard]] bool isUploadActive() const;
 
+  // Deep-sleep upload windows: start draining the backlog now, report when RTC, LittleFS and
+  // the transport are all idle, and leave storage consistent before the node sleeps.
+  void beginUploadWindow();
+  [[nodiscard]] bool isBacklogDrained() const;
+  void prepareForSleep();
+
 private:
   friend class ApiClientLifecycleController;
   friend class ApiClientControlController;
@@ -96,6 +105,8 @@ private:
   using UploadRecordSource = ApiClientDetail::UploadRecordSource;
   using UploadRecordLoad = ApiClientDetail::UploadRecordLoad;
   using EmergencyRecord = ApiClientDetail::EmergencyRecord;
+  using UploadBodySource = ApiClientDetail::UploadBodySource;
+  using UploadBody = ApiClientDetail::UploadBody;
   using EmergencyQueueReason = ApiClientDetail::EmergencyQueueReason;
   static constexpr uint8_t kEmergencyQueueCapacity = ApiClientDetail::kEmergencyQueueCapacity;
   using RoutingState = ApiClientDetail::RoutingState;
@@ -119,6 +130,9 @@ private:
   [[nodiscard]] char* sharedBuffer();
   [[nodiscard]] const char* sharedBuffer() const;
   [[nodiscard]] size_t sharedBufferSize() const;
+  [[nodiscard]] bool ensureBatchBuffer(size_t size);
+  void releaseBatchBuffer();
+  [[nodiscard]] char* outgoingPayload();
   [[nodiscard]] bool ensureTrustAnchors();
   [[nodiscard]] const BearSSL::X509List* activeTrustAnchors() const;
   [[nodiscard]] bool acquireTlsResources(bool allowInsecure);
@@ -129,6 +143,8 @@ private:
   static PGM_P uploadSourceLabelP(UploadRecordSource source);
   static void copyUploadSourceLabel(char* out, size_t out_len, UploadRecordSource source);
   UploadRecordLoad loadRecordForUpload(size_t& record_len);
+  void readAheadNextRecord();
+  void discardReadAheadRecord();
   UploadRecordLoad loadRecordFromRtc(size_t& record_len);
   UploadRecordLoad loadRecordFromLittleFs(size_t& record_len);
   [[nodiscard]] bool enqueueEmergencyRecord(const EmergencyRecord& record);
@@ -154,6 +170,8 @@ private:
   bool finishLoadedRecordSuccess(const AppConfig& cfg, int httpCode, bool setIdleOnPopFailure);
   void resetQueuedUploadCycle(bool resetTimer);
   bool dispatchQueuedUploadRecord(size_t record_len, bool isTargetEdge);
+  [[nodiscard]] uint16_t resolveUploadBatchCapacity(bool isTargetEdge);
+  [[nodiscard]] size_t assembleUploadBatch(size_t record_len, bool isTargetEdge);
   [[nodiscard]] bool recoverPendingQueuePop(const AppConfig& cfg, bool immediate, UploadResult* result);
   void logEmergencyQueueState(EmergencyQueueReason reason);
   [[nodiscard]] bool trySendLiveSnapshotToGateway();
@@ -187,6 +205,7 @@ private:
 
   // --- NEW: Centralized Mode Control ---
   int checkGatewayMode();  // Returns 0(Cloud), 1(Local), 2(Auto), or -1(Fail)
+  void probeDemotedGateway();
   void processGatewayResult(const UploadResult& res);
   void markImmediateUploadDeferred(UploadResult& result);
   void resetImmediateUploadPollState();
@@ -241,6 +260,7 @@ private:
                         const char* url,
                         const char* method,
                         const char* payload,
+                        size_t bodyLen,
                         bool useOtaToken,
                         const AppConfig& cfg,
                         unsigned long& duration);
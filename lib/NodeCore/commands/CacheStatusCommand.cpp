@@ -88,6 +88,9 @@ void CacheStatusCommand::execute(const CommandContext& context) {
                      PSTR("  LittleFS: %lu/%lu bytes\n"),
                      static_cast<unsigned long>(size_bytes),
                      static_cast<unsigned long>(MAX_CACHE_DATA_SIZE));
+  Utils::ws_printf_P(context.client,
+                     PSTR("  Alerts: %lu bytes queued ahead\n"),
+                     static_cast<unsigned long>(m_cacheManager.get_lane_size(CacheLane::PRIORITY)));
   Utils::ws_printf_P(context.client,
                      PSTR("  Emergency: %u/%u | Backpressure: %s\n"),
                      static_cast<unsigned>(m_apiClient.getEmergencyQueueDepth()),
@@ -109,4 +112,25 @@ void CacheStatusCommand::execute(const CommandContext& context) {
                      static_cast<unsigned>(kWorstCaseLittleFsRecordBytes));
   Utils::ws_printf_P(context.client, PSTR("  Head: %u\n"), head);
   Utils::ws_printf_P(context.client, PSTR("  Tail: %u\n"), tail);
+
+  const CacheIoStats& io = m_cacheManager.io_stats();
+  Utils::ws_printf_P(context.client,
+                     PSTR("  Writes: %lu records | %lu B logical | %lu B framed | retries %lu\n"),
+                     static_cast<unsigned long>(io.appends),
+                     static_cast<unsigned long>(io.logicalBytes),
+                     static_cast<unsigned long>(io.framedBytes),
+                     static_cast<unsigned long>(io.writeRetries));
+  Utils::ws_printf_P(context.client,
+                     PSTR("  Metadata: %lu header writes | %lu flushes | trims %lu (%lu B) | downsampled %lu\n"),
+                     static_cast<unsigned long>(io.headerWrites),
+                     static_cast<unsigned long>(io.flushes),
+                     static_cast<unsigned long>(io.trims),
+                     static_cast<unsigned long>(io.trimmedBytes),
+                     static_cast<unsigned long>(io.downsampledEntries));
+  Utils::ws_printf_P(context.client,
+                     PSTR("  IO Time: write %lu ms | trim %lu ms | flush %lu ms | worst write %lu us\n"),
+                     static_cast<unsigned long>(io.writeMicros / 1000ULL),
+                     static_cast<unsigned long>(io.trimMicros / 1000ULL),
+                     static_cast<unsigned long>(io.flushMicros / 1000ULL),
+                     static_cast<unsigned long>(io.maxWriteMicros));
 }
@@ -0,0 +1,99 @@
+#include "LatencyCommand.h"
+
+#include "CommandContext.h"
+#include "net/UploadLatency.h"
+#include "support/Utils.h"
+
+namespace {
+  void copyName(char* out, size_t outLen, PGM_P name_P) {
+    strncpy_P(out, name_P, outLen - 1);
+    out[outLen - 1] = '\0';
+  }
+
+  // "n=.. avg=.. p50=.. p95=.. max=.." followed by the bucket counts up to the last used one.
+  void printHistogram(AsyncWebSocketClient* client, PGM_P phase_P, const UploadLatency::Histogram& h) {
+    char phase[12];
+    copyName(phase, sizeof(phase), phase_P);
+    char buckets[UploadLatency::kBuckets * 6 + 1] = {0};
+    size_t last = 0;
+    for (size_t i = 0; i < UploadLatency::kBuckets; ++i) {
+      if (h.buckets[i] > 0) {
+        last = i;
+      }
+    }
+    size_t pos = 0;
+    for (size_t i = 0; i <= last && pos < sizeof(buckets); ++i) {
+      const int written = snprintf_P(
+          buckets + pos, sizeof(buckets) - pos, PSTR("%s%u"), i ? " " : "", static_cast<unsigned>(h.buckets[i]));
+      if (written < 0) {
+        break;
+      }
+      pos += static_cast<size_t>(written);
+    }
+    Utils::ws_printf_P(client,
+                       PSTR("  %-10s n=%lu avg=%lu p50=%lu p95=%lu max=%lu ms  [%s]\n"),
+                       phase,
+                       static_cast<unsigned long>(h.count),
+                       static_cast<unsigned long>(h.averageMs()),
+                       static_cast<unsigned long>(h.percentileMs(50)),
+                       static_cast<unsigned long>(h.percentileMs(95)),
+                       static_cast<unsigned long>(h.maxMs),
+                       buckets);
+  }
+
+  void printReport(AsyncWebSocketClient* client) {
+    Utils::ws_printf_P(client,
+                       PSTR("Upload latency (last %lu s; buckets <1,1,2,4..16384+ ms)\n"),
+                       UploadLatency::sinceResetMs() / 1000UL);
+    const UploadLatency::Failures& failures = UploadLatency::failures();
+    for (size_t t = 0; t < UploadLatency::kTargets; ++t) {
+      const auto target = static_cast<UploadLatency::Target>(t);
+      const UploadLatency::Histogram& total = UploadLatency::histogram(target, UploadLatency::Phase::TOTAL);
+      if (total.count == 0 && failures.count[t] == 0) {
+        continue;
+      }
+      char name[8];
+      copyName(name, sizeof(name), UploadLatency::targetName_P(target));
+      Utils::ws_printf_P(client,
+                         PSTR("%s: %lu ok, %lu failed\n"),
+                         name,
+                         static_cast<unsigned long>(total.count),
+                         static_cast<unsigned long>(failures.count[t]));
+      for (size_t p = 0; p < UploadLatency::kPhases; ++p) {
+        const auto phase = static_cast<UploadLatency::Phase>(p);
+        const UploadLatency::Histogram& h = UploadLatency::histogram(target, phase);
+        if (h.count > 0) {
+          printHistogram(client, UploadLatency::phaseName_P(phase), h);
+        }
+      }
+    }
+  }
+}  // namespace
+
+void LatencyCommand::execute(const CommandContext& context) {
+  if (!context.client || !context.client->canSend()) return;
+
+  char arg[8] = {0};
+  if (context.args) {
+    const char* src = context.args;
+    while (*src == ' ') src++;
+    size_t len = 0;
+    while (*src != '\0' && *src != ' ' && len < sizeof(arg) - 1) {
+      arg[len++] = *src++;
+    }
+    arg[len] = '\0';
+  }
+
+  if (arg[0] == '\0' || strcasecmp_P(arg, PSTR("show")) == 0) {
+    printReport(context.client);
+    return;
+  }
+  if (strcasecmp_P(arg, PSTR("reset")) == 0) {
+    // Print what is being dropped, like heapreset does with the watermarks.
+    printReport(context.client);
+    UploadLatency::reset();
+    Utils::ws_printf_P(context.client, PSTR("Latency histograms cleared\n"));
+    return;
+  }
+  Utils::ws_printf_P(context.client, PSTR("Usage: latency [show|reset]\n"));
+}
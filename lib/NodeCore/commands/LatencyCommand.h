@@ -0,0 +1,21 @@
+#ifndef LATENCY_COMMAND_H
+#define LATENCY_COMMAND_H
+
+#include "ICommand.h"
+
+// Reads the static UploadLatency histograms; no services needed.
+class LatencyCommand : public ICommand {
+public:
+  PGM_P getName_P() const override { return PSTR("latency"); }
+  uint32_t getNameHash() const override { return CompileTimeUtils::ct_hash("latency"); }
+  PGM_P getDescription_P() const override {
+    return PSTR("Upload latency per phase. Usage: latency [show|reset]");
+  }
+  CommandSection helpSection() const override { return CommandSection::SYSTEM; }
+  bool requiresAuth() const override {
+    return true;
+  }
+  void execute(const CommandContext& context) override;
+};
+
+#endif  // LATENCY_COMMAND_H
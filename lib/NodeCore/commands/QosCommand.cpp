@@ -16,3 +16,26 @@ void QosOtaCommand:REDACTED
   m_apiClient.requestQosOta();
   Utils::ws_printf_P(context.client, PSTR("QoS OTA Test scheduled. Please wait for results..."));
 }
+
+QosThroughputCommand::QosThroughputCommand(ApiClient& apiClient) : m_apiClient(apiClient) {}
+
+void QosThroughputCommand::execute(const CommandContext& context) {
+  unsigned long bodyBytes = 0;
+  unsigned long samples = 0;
+  const char* cursor = context.args ? context.args : "";
+  char* end = nullptr;
+  bodyBytes = strtoul(cursor, &end, 10);
+  if (end != cursor) {
+    cursor = end;
+    samples = strtoul(cursor, &end, 10);
+  }
+  if (bodyBytes > 0xFFFF || samples > 0xFF) {
+    Utils::ws_printf_P(context.client, PSTR("Usage: qosbw [bytes] [samples]\n"));
+    return;
+  }
+  if (!m_apiClient.requestQosThroughput(static_cast<uint16_t>(bodyBytes), static_cast<uint8_t>(samples))) {
+    Utils::ws_printf_P(context.client, PSTR("A QoS test is already running.\n"));
+    return;
+  }
+  Utils::ws_printf_P(context.client, PSTR("QoS Throughput Test scheduled. Please wait for results..."));
+}
@@ -23,6 +23,24 @@ private:
   ApiClient& m_apiClient;
 };
 
+class QosThroughputCommand : public ICommand {
+public:
+  explicit QosThroughputCommand(ApiClient& apiClient);
+  PGM_P getName_P() const override { return PSTR("qosbw"); }
+  uint32_t getNameHash() const override { return CompileTimeUtils::ct_hash("qosbw"); }
+  PGM_P getDescription_P() const override {
+    return PSTR("Throughput and p50/p90/p99 to cloud, relay and gateways. Usage: qosbw [bytes] [samples]");
+  }
+  CommandSection helpSection() const override { return CommandSection::SYSTEM; }
+  bool requiresAuth() const override {
+    return true;
+  }
+  void execute(const CommandContext& context) override;
+
+private:
+  ApiClient& m_apiClient;
+};
+
 class QosOtaCommand : REDACTED
 public:
   explicit QosOtaCommand(ApiClient& apiClient);
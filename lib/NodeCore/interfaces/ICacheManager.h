@@ -3,8 +3,33 @@
 
 #include <Arduino.h>
 
+#include <span>
+
 enum class CacheReadError { NONE, CACHE_EMPTY, FILE_READ_ERROR, OUT_OF_MEMORY, CORRUPT_DATA, SCANNING };
 
+// Independent FIFOs inside one cache. PRIORITY holds alert samples that must not wait behind
+// the routine backlog; uploads drain it first and routine eviction never touches it.
+enum class CacheLane : uint8_t { ROUTINE, PRIORITY };
+
+// Cumulative storage I/O since boot, for flash-wear and loop-latency diagnostics.
+// Times are wall-clock micros() spent blocked in the named operation.
+struct CacheIoStats {
+  uint32_t appends = 0;         // records accepted by write()
+  uint32_t logicalBytes = 0;    // payload bytes handed to write()
+  uint32_t framedBytes = 0;     // bytes appended to flash, record framing included
+  uint32_t headerWrites = 0;    // metadata rewrites (ring header and index, segment cursor)
+  uint32_t flushes = 0;
+  uint32_t writeRetries = 0;    // extra attempts after a failed or unverified append
+  uint32_t trims = 0;           // writes that had to evict old records first
+  uint32_t trimmedBytes = 0;
+  uint32_t downsampledEntries = 0;  // samples and aggregates folded into coarser aggregates
+  uint32_t resets = 0;          // wipes by reset() (clearcache, factory reset)
+  uint64_t writeMicros = 0;     // appending records (verify and retries included)
+  uint64_t flushMicros = 0;     // persisting metadata and syncing the file
+  uint64_t trimMicros = 0;      // evicting records to make room
+  uint32_t maxWriteMicros = 0;  // slowest single write(), including any trim or flush it caused
+};
+
 // ============================================================================
 // CRTP Base Class for Zero-Overhead Cache Interface
 // ============================================================================
@@ -23,26 +48,53 @@ public:
     static_cast<Derived*>(this)->resetImpl();
   }
   
-  [[nodiscard]] bool write(const char* data, uint16_t len) {
-    return static_cast<Derived*>(this)->writeImpl(data, len);
+  [[nodiscard]] bool write(const char* data, uint16_t len, CacheLane lane = CacheLane::ROUTINE) {
+    return static_cast<Derived*>(this)->writeImpl(data, len, lane);
   }
   
-  [[nodiscard]] CacheReadError read_one(char* out_buffer, size_t buffer_size, size_t& out_len) {
-    return static_cast<Derived*>(this)->read_oneImpl(out_buffer, buffer_size, out_len);
+  [[nodiscard]] CacheReadError read_one(char* out_buffer,
+                                        size_t buffer_size,
+                                        size_t& out_len,
+                                        CacheLane lane = CacheLane::ROUTINE) {
+    return static_cast<Derived*>(this)->read_oneImpl(out_buffer, buffer_size, out_len, lane);
   }
   
-  [[nodiscard]] bool pop_one() {
-    return static_cast<Derived*>(this)->pop_oneImpl();
+  [[nodiscard]] bool pop_one(CacheLane lane = CacheLane::ROUTINE) {
+    return static_cast<Derived*>(this)->pop_oneImpl(lane);
+  }
+
+  // Copies up to maxRecords entries from the tail into `out`, back to back, without
+  // consuming them; entry i is lengths[i] bytes. Stops early when `out` is full.
+  [[nodiscard]] CacheReadError read_many(std::span<char> out,
+                                         std::span<uint16_t> lengths,
+                                         size_t maxRecords,
+                                         size_t& outRecords,
+                                         CacheLane lane = CacheLane::ROUTINE) {
+    return static_cast<Derived*>(this)->read_manyImpl(out, lengths, maxRecords, outRecords, lane);
+  }
+
+  // Consumes up to `count` entries from the tail; returns how many were removed.
+  [[nodiscard]] size_t pop_many(size_t count, CacheLane lane = CacheLane::ROUTINE) {
+    return static_cast<Derived*>(this)->pop_manyImpl(count, lane);
   }
   
   void get_status(uint32_t& size_bytes, uint32_t& head, uint32_t& tail) {
     static_cast<Derived*>(this)->get_statusImpl(size_bytes, head, tail);
   }
   
+  // Bytes held across all lanes.
   uint32_t get_size() {
     return static_cast<Derived*>(this)->get_sizeImpl();
   }
 
+  uint32_t get_lane_size(CacheLane lane) {
+    return static_cast<Derived*>(this)->get_lane_sizeImpl(lane);
+  }
+
+  [[nodiscard]] const CacheIoStats& io_stats() const {
+    return static_cast<const Derived*>(this)->io_statsImpl();
+  }
+
 protected:
   ICacheManager() = default;
   ~ICacheManager() = default;
@@ -0,0 +1,240 @@
+#ifndef EDGE_WIRE_CODEC_H
+#define EDGE_WIRE_CODEC_H
+
+#include <Arduino.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "sensor/SensorNormalization.h"
+#include "storage/SensorAggregateCodec.h"
+
+// Send single records to the edge gateway as CBOR instead of JSON. Off by default: the gateway
+// must run a decoder that accepts both (scripts/decode_edge_payload.py tells them apart by the
+// first plaintext byte). Batches and records only held as legacy JSON still go as JSON.
+#ifndef EDGE_WIRE_CBOR
+#define EDGE_WIRE_CBOR 0
+#endif
+
+// ============================================================================
+// Compact binary edge record (CBOR, RFC 8949)
+// ============================================================================
+// The JSON edge record is rendered for the cloud first and then patched for the gateway:
+// recorded_at is cut out and re-added as send_time, rssi_nonactive spliced in before the closing
+// brace. Here the typed record is encoded directly into one CBOR map with small integer keys,
+// readings as integer tenths and send_time as an epoch-time tag, about a third of the JSON
+// before encryption and base64.
+//
+//   0 gh_id            1 node_id         2 temperature (0.1 degC)   3 humidity (0.1 %RH)
+//   4 light_intensity  5 rssi            6 rssi_nonactive           7 send_time (tag 1, or null
+//                                                                     before the clock synced)
+//   aggregates only:   8 t_min  9 t_max  10 h_min  11 h_max  12 samples  13 window_s
+//
+// Keys are never renumbered; a decoder skips keys it does not know.
+namespace EdgeWireCodec {
+
+  // Prefixed: GH_ID and NODE_ID are also the build macros from generated/node_config.h.
+  enum Key : uint8_t {
+    KEY_GH_ID = 0,
+    KEY_NODE_ID = 1,
+    KEY_TEMPERATURE = 2,
+    KEY_HUMIDITY = 3,
+    KEY_LIGHT = 4,
+    KEY_RSSI = 5,
+    KEY_RSSI_NONACTIVE = 6,
+    KEY_SEND_TIME = 7,
+    KEY_T_MIN = 8,
+    KEY_T_MAX = 9,
+    KEY_H_MIN = 10,
+    KEY_H_MAX = 11,
+    KEY_SAMPLES = 12,
+    KEY_WINDOW_S = 13,
+  };
+
+  // Every field at its widest.
+  static constexpr size_t kMaxEncodedLen = 80;
+
+  // The edge fields next to the reading; `sendTime` 0 means the clock was not synced.
+  struct Envelope {
+    uint32_t ghId = 0;
+    uint32_t nodeId = 0;
+    int32_t rssiNonActive = 0;
+    uint32_t sendTime = 0;
+  };
+
+  namespace detail {
+    inline bool put_head(uint8_t* out, size_t outLen, size_t& pos, uint8_t major, uint32_t value) {
+      const uint8_t type = static_cast<uint8_t>(major << 5);
+      if (value < 24) {
+        if (pos + 1 > outLen) {
+          return false;
+        }
+        out[pos++] = static_cast<uint8_t>(type | value);
+      } else if (value <= 0xFF) {
+        if (pos + 2 > outLen) {
+          return false;
+        }
+        out[pos++] = static_cast<uint8_t>(type | 24);
+        out[pos++] = static_cast<uint8_t>(value);
+      } else if (value <= 0xFFFF) {
+        if (pos + 3 > outLen) {
+          return false;
+        }
+        out[pos++] = static_cast<uint8_t>(type | 25);
+        out[pos++] = static_cast<uint8_t>(value >> 8);
+        out[pos++] = static_cast<uint8_t>(value);
+      } else {
+        if (pos + 5 > outLen) {
+          return false;
+        }
+        out[pos++] = static_cast<uint8_t>(type | 26);
+        out[pos++] = static_cast<uint8_t>(value >> 24);
+        out[pos++] = static_cast<uint8_t>(value >> 16);
+        out[pos++] = static_cast<uint8_t>(value >> 8);
+        out[pos++] = static_cast<uint8_t>(value);
+      }
+      return true;
+    }
+
+    inline bool put_int(uint8_t* out, size_t outLen, size_t& pos, int32_t value) {
+      return value >= 0 ? put_head(out, outLen, pos, 0, static_cast<uint32_t>(value))
+                        : put_head(out, outLen, pos, 1, static_cast<uint32_t>(-1 - value));
+    }
+
+    inline bool put_field(uint8_t* out, size_t outLen, size_t& pos, Key key, int32_t value) {
+      return put_head(out, outLen, pos, 0, key) && put_int(out, outLen, pos, value);
+    }
+
+    inline bool put_field_u32(uint8_t* out, size_t outLen, size_t& pos, Key key, uint32_t value) {
+      return put_head(out, outLen, pos, 0, key) && put_head(out, outLen, pos, 0, value);
+    }
+
+    // One head: major type and argument. Indefinite lengths and 64-bit arguments are not used.
+    inline bool get_head(const uint8_t* in, size_t len, size_t& pos, uint8_t& major, uint32_t& value) {
+      if (pos >= len) {
+        return false;
+      }
+      const uint8_t initial = in[pos++];
+      major = static_cast<uint8_t>(initial >> 5);
+      const uint8_t info = static_cast<uint8_t>(initial & 0x1F);
+      if (info < 24) {
+        value = info;
+        return true;
+      }
+      size_t bytes = 0;
+      if (info == 24) {
+        bytes = 1;
+      } else if (info == 25) {
+        bytes = 2;
+      } else if (info == 26) {
+        bytes = 4;
+      } else {
+        return false;
+      }
+      if (pos + bytes > len) {
+        return false;
+      }
+      value = 0;
+      for (size_t i = 0; i < bytes; ++i) {
+        value = (value << 8) | in[pos++];
+      }
+      return true;
+    }
+  }  // namespace detail
+
+  // Encodes `record` (a sample is a one-sample aggregate with no window) with the same clamping
+  // the JSON record gets. Returns the encoded length, 0 when `out` is too small.
+  inline size_t encode(uint8_t* out,
+                       size_t outLen,
+                       const SensorAggregateCodec::SensorAggregate& record,
+                       const Envelope& envelope) {
+    using namespace SensorNormalization;
+    if (!out) {
+      return 0;
+    }
+    const bool aggregate = record.count > 1 || record.window > 0;
+    size_t pos = 0;
+    bool ok = detail::put_head(out, outLen, pos, 5, aggregate ? 14 : 8) &&
+              detail::put_field_u32(out, outLen, pos, KEY_GH_ID, envelope.ghId) &&
+              detail::put_field_u32(out, outLen, pos, KEY_NODE_ID, envelope.nodeId) &&
+              detail::put_field(out, outLen, pos, KEY_TEMPERATURE, clampTemperatureTenths(record.tempMean10)) &&
+              detail::put_field(out, outLen, pos, KEY_HUMIDITY, clampHumidityTenths(record.humMean10)) &&
+              detail::put_field_u32(out, outLen, pos, KEY_LIGHT, clampLightUInt(record.luxMean)) &&
+              detail::put_field(out, outLen, pos, KEY_RSSI, record.rssiMean) &&
+              detail::put_field(out, outLen, pos, KEY_RSSI_NONACTIVE, envelope.rssiNonActive) &&
+              detail::put_head(out, outLen, pos, 0, KEY_SEND_TIME);
+    if (ok && envelope.sendTime != 0) {
+      ok = detail::put_head(out, outLen, pos, 6, 1) && detail::put_head(out, outLen, pos, 0, envelope.sendTime);
+    } else if (ok) {
+      ok = detail::put_head(out, outLen, pos, 7, 22);  // null
+    }
+    if (ok && aggregate) {
+      ok = detail::put_field(out, outLen, pos, KEY_T_MIN, clampTemperatureTenths(record.tempMin10)) &&
+           detail::put_field(out, outLen, pos, KEY_T_MAX, clampTemperatureTenths(record.tempMax10)) &&
+           detail::put_field(out, outLen, pos, KEY_H_MIN, clampHumidityTenths(record.humMin10)) &&
+           detail::put_field(out, outLen, pos, KEY_H_MAX, clampHumidityTenths(record.humMax10)) &&
+           detail::put_field_u32(out, outLen, pos, KEY_SAMPLES, record.count) &&
+           detail::put_field_u32(out, outLen, pos, KEY_WINDOW_S, record.window);
+    }
+    return ok ? pos : 0;
+  }
+
+  // Inverse of encode(), for the native tests and on-device diagnostics; the gateway side lives
+  // in scripts/decode_edge_payload.py. `record.start` is send_time (0 when null).
+  inline bool decode(const uint8_t* in,
+                     size_t len,
+                     SensorAggregateCodec::SensorAggregate& record,
+                     Envelope& envelope) {
+    uint8_t major = 0;
+    uint32_t entries = 0;
+    size_t pos = 0;
+    if (!in || !detail::get_head(in, len, pos, major, entries) || major != 5) {
+      return false;
+    }
+    record = SensorAggregateCodec::SensorAggregate{};
+    record.count = 1;
+    envelope = Envelope();
+    for (uint32_t i = 0; i < entries; ++i) {
+      uint32_t key = 0;
+      uint32_t arg = 0;
+      if (!detail::get_head(in, len, pos, major, key) || major != 0 || !detail::get_head(in, len, pos, major, arg)) {
+        return false;
+      }
+      if (major == 6 && arg == 1) {
+        if (!detail::get_head(in, len, pos, major, arg) || major != 0) {
+          return false;
+        }
+      } else if (major == 7) {
+        if (arg != 22) {
+          return false;
+        }
+        arg = 0;
+      } else if (major > 1) {
+        return false;
+      }
+      const int32_t value = (major == 1) ? -1 - static_cast<int32_t>(arg) : static_cast<int32_t>(arg);
+      switch (key) {
+        case KEY_GH_ID: envelope.ghId = arg; break;
+        case KEY_NODE_ID: envelope.nodeId = arg; break;
+        case KEY_TEMPERATURE: record.tempMean10 = static_cast<int16_t>(value); break;
+        case KEY_HUMIDITY: record.humMean10 = static_cast<int16_t>(value); break;
+        case KEY_LIGHT: record.luxMean = static_cast<uint16_t>(arg); break;
+        case KEY_RSSI: record.rssiMean = static_cast<int16_t>(value); break;
+        case KEY_RSSI_NONACTIVE: envelope.rssiNonActive = value; break;
+        case KEY_SEND_TIME: envelope.sendTime = arg; break;
+        case KEY_T_MIN: record.tempMin10 = static_cast<int16_t>(value); break;
+        case KEY_T_MAX: record.tempMax10 = static_cast<int16_t>(value); break;
+        case KEY_H_MIN: record.humMin10 = static_cast<int16_t>(value); break;
+        case KEY_H_MAX: record.humMax10 = static_cast<int16_t>(value); break;
+        case KEY_SAMPLES: record.count = static_cast<uint16_t>(arg); break;
+        case KEY_WINDOW_S: record.window = static_cast<uint16_t>(arg); break;
+        default: break;
+      }
+    }
+    record.start = envelope.sendTime;
+    return pos == len;
+  }
+
+}  // namespace EdgeWireCodec
+
+#endif  // EDGE_WIRE_CODEC_H
@@ -0,0 +1,140 @@
+#ifndef ENCRYPTED_BODY_H
+#define ENCRYPTED_BODY_H
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// ============================================================================
+// Streamed gateway body encryption
+// ============================================================================
+// A gateway body is "ENC:" + base64(iv) + ":" + base64(AES-256-CBC(ts || plaintext || PKCS#7)),
+// ts being the send time as a big-endian uint32. CryptoUtils builds that in a buffer sized for the
+// whole ciphertext. The Encoder produces the same bytes from plaintext handed to it in pieces: it
+// holds one 48-byte run (three AES blocks, which base64 turns into 64 digits without padding),
+// encrypts and encodes it once full and passes the digits on. Only the last run is padded.
+//
+// The body length follows from the plaintext length alone, so the Content-Length goes out ahead of
+// the body. With the IV and timestamp fixed up front the same body can be produced twice: once
+// into the HMAC for X-Signature, once onto the socket.
+//
+// The cipher is any callable `bool(uint8_t* iv, uint8_t* data, size_t len)` that CBC-encrypts
+// whole blocks in place and leaves the last ciphertext block in `iv`, as br_aes_ct_cbcenc_run()
+// does; the emitter any `bool(const char* data, size_t len)`.
+namespace EncryptedBody {
+
+  static constexpr size_t kIvLen = 16;
+  static constexpr size_t kTimestampLen = 4;
+  static constexpr size_t kRunBytes = 48;
+  static constexpr size_t kRunDigits = 64;
+  // "ENC:", the IV's 24 digits and ':'.
+  static constexpr size_t kPrefixLen = 4 + ((kIvLen + 2) / 3) * 4 + 1;
+
+  // Ciphertext for `plainLen` bytes of plaintext: the timestamp and 1..16 bytes of padding on top.
+  constexpr size_t cipher_len(size_t plainLen) {
+    return ((kTimestampLen + plainLen) / 16 + 1) * 16;
+  }
+
+  constexpr size_t body_len(size_t plainLen) {
+    return kPrefixLen + ((cipher_len(plainLen) + 2) / 3) * 4;
+  }
+
+  // Standard alphabet with '=' padding, as libb64 writes it once its line breaks are stripped.
+  // `out` takes ((len + 2) / 3) * 4 digits.
+  inline size_t base64(const uint8_t* data, size_t len, char* out) {
+    static const char kDigits[] PROGMEM = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t pos = 0;
+    for (size_t i = 0; i < len; i += 3) {
+      const size_t n = std::min<size_t>(3, len - i);
+      const uint32_t bits = (static_cast<uint32_t>(data[i]) << 16) |
+                            (n > 1 ? static_cast<uint32_t>(data[i + 1]) << 8 : 0U) |
+                            (n > 2 ? static_cast<uint32_t>(data[i + 2]) : 0U);
+      out[pos++] = static_cast<char>(pgm_read_byte(&kDigits[(bits >> 18) & 0x3F]));
+      out[pos++] = static_cast<char>(pgm_read_byte(&kDigits[(bits >> 12) & 0x3F]));
+      out[pos++] = n > 1 ? static_cast<char>(pgm_read_byte(&kDigits[(bits >> 6) & 0x3F])) : '=';
+      out[pos++] = n > 2 ? static_cast<char>(pgm_read_byte(&kDigits[bits & 0x3F])) : '=';
+    }
+    return pos;
+  }
+
+  template <typename Cipher, typename Emit>
+  class Encoder {
+  public:
+    // `plainLen` is what the plaintext will add up to; finish() fails on anything else.
+    Encoder(Cipher& cipher, Emit& emit, const uint8_t* iv, uint32_t timestamp, size_t plainLen)
+        : m_cipher(cipher), m_emit(emit), m_remaining(plainLen) {
+      memcpy(m_iv, iv, kIvLen);
+      m_run[0] = static_cast<uint8_t>(timestamp >> 24);
+      m_run[1] = static_cast<uint8_t>(timestamp >> 16);
+      m_run[2] = static_cast<uint8_t>(timestamp >> 8);
+      m_run[3] = static_cast<uint8_t>(timestamp);
+      m_fill = kTimestampLen;
+    }
+
+    Encoder(const Encoder&) = delete;
+    Encoder& operator=(const Encoder&) = delete;
+
+    // Emits "ENC:<iv>:"; the IV is chained over by the first run, so this comes first.
+    bool begin() {
+      char digits[kPrefixLen - 5];
+      const size_t n = base64(m_iv, kIvLen, digits);
+      m_ok = m_ok && m_emit("ENC:", 4) && m_emit(digits, n) && m_emit(":", 1);
+      return m_ok;
+    }
+
+    bool put(const char* data, size_t len) {
+      if (!m_ok || !data || len > m_remaining) {
+        m_ok = false;
+        return false;
+      }
+      m_remaining -= len;
+      while (len > 0) {
+        const size_t n = std::min(len, kRunBytes - m_fill);
+        memcpy(m_run + m_fill, data, n);
+        m_fill += n;
+        data += n;
+        len -= n;
+        if (m_fill == kRunBytes && !seal(kRunBytes)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // Pads and emits the last run.
+    bool finish() {
+      if (!m_ok || m_remaining != 0) {
+        m_ok = false;
+        return false;
+      }
+      const size_t pad = 16 - (m_fill % 16);
+      memset(m_run + m_fill, static_cast<int>(pad), pad);
+      return seal(m_fill + pad);
+    }
+
+    bool ok() const {
+      return m_ok;
+    }
+
+  private:
+    bool seal(size_t len) {
+      char digits[kRunDigits];
+      m_ok = m_cipher(m_iv, m_run, len) && m_emit(digits, base64(m_run, len, digits));
+      m_fill = 0;
+      return m_ok;
+    }
+
+    Cipher& m_cipher;
+    Emit& m_emit;
+    uint8_t m_iv[kIvLen];
+    uint8_t m_run[kRunBytes];
+    size_t m_fill = 0;
+    size_t m_remaining = 0;
+    bool m_ok = true;
+  };
+
+}  // namespace EncryptedBody
+
+#endif  // ENCRYPTED_BODY_H
@@ -0,0 +1,236 @@
+#ifndef GATEWAY_SCOREBOARD_H
+#define GATEWAY_SCOREBOARD_H
+
+#include <Arduino.h>
+#include <string.h>
+#include <strings.h>
+
+// Order edge gateway candidates by how they have been answering instead of trying them in the
+// fixed configured order. Off keeps the fixed order (primary mDNS, primary IP, secondary mDNS,
+// secondary IP).
+#ifndef EDGE_GATEWAY_SCOREBOARD
+#define EDGE_GATEWAY_SCOREBOARD 1
+#endif
+// A demoted candidate is re-probed with a bare TCP connect, one at most per interval, while the
+// uploader is idle.
+#ifndef EDGE_GATEWAY_REPROBE_MS
+#define EDGE_GATEWAY_REPROBE_MS 60000UL
+#endif
+// Connect timeout of such a probe; kept short since it runs on the loop.
+#ifndef EDGE_GATEWAY_PROBE_TIMEOUT_MS
+#define EDGE_GATEWAY_PROBE_TIMEOUT_MS 400UL
+#endif
+
+static_assert(EDGE_GATEWAY_REPROBE_MS >= 1000, "EDGE_GATEWAY_REPROBE_MS too short; probes would run back to back");
+static_assert(EDGE_GATEWAY_PROBE_TIMEOUT_MS >= 50 && EDGE_GATEWAY_PROBE_TIMEOUT_MS <= 5000,
+              "EDGE_GATEWAY_PROBE_TIMEOUT_MS out of range");
+
+// ============================================================================
+// Edge gateway candidate scoreboard
+// ============================================================================
+// Every edge upload walked the same four candidates in the same order, so a primary mDNS name
+// that no longer resolves cost a full connect timeout on every record before the IP behind it
+// was tried. The scoreboard keeps, per host, a moving success rate and a moving connect time
+// (one TCP round trip, plus the name lookup for mDNS names) and orders the candidates by the
+// time an attempt is expected to cost:
+//
+//   cost = rtt + (1 - success rate) * connect timeout
+//
+// The candidate that last answered stays first, so a steady state costs one round trip. A
+// candidate whose last attempt failed is demoted behind every healthy one (it is still tried
+// when nothing else answers) and gets a probe of its own every EDGE_GATEWAY_REPROBE_MS, which
+// promotes it again once it answers.
+//
+// Candidates never tried go after the healthy ones that were (and before the demoted ones), in
+// the configured order, so a fresh board tries them as before and a working gateway is not
+// passed over for one nobody has measured.
+namespace GatewayScoreboard {
+
+  static constexpr size_t kSlots = 4;
+  static constexpr size_t kHostLen = 48;
+  static constexpr uint16_t kHealthMax = 1024;  // success rate in 1/1024
+
+  struct Slot {
+    char host[kHostLen] = {0};
+    uint16_t health = kHealthMax;
+    uint16_t rttMs = 0;  // moving connect time; 0 until the first one was measured
+    uint8_t failStreak = 0;
+    unsigned long lastTryMs = 0;
+    uint32_t successes = 0;
+    uint32_t failures = 0;
+  };
+
+  struct Board {
+    Slot slots[kSlots];
+    unsigned long lastProbeMs = 0;
+    uint32_t probes = 0;
+    uint32_t promotions = 0;
+    uint32_t demotions = 0;
+  };
+
+  inline Slot* find(Board& board, const char* host) {
+    if (!host || host[0] == '\0') {
+      return nullptr;
+    }
+    for (Slot& slot : board.slots) {
+      if (slot.host[0] != '\0' && strcasecmp(slot.host, host) == 0) {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  // The host's slot, taking over a free one or the one tried longest ago (the configured
+  // gateways changed).
+  inline Slot* slot_for(Board& board, const char* host, unsigned long now) {
+    Slot* slot = find(board, host);
+    if (slot || !host || host[0] == '\0') {
+      return slot;
+    }
+    slot = &board.slots[0];
+    for (Slot& candidate : board.slots) {
+      if (candidate.host[0] == '\0') {
+        slot = &candidate;
+        break;
+      }
+      if (now - candidate.lastTryMs > now - slot->lastTryMs) {
+        slot = &candidate;
+      }
+    }
+    *slot = Slot();
+    strncpy(slot->host, host, sizeof(slot->host) - 1);
+    slot->lastTryMs = now;
+    return slot;
+  }
+
+  inline bool demoted(const Slot* slot) {
+    return slot && slot->failStreak > 0;
+  }
+
+  // Expected milliseconds an attempt on `host` costs; unknown hosts sort last among the healthy.
+  inline uint32_t cost(Board& board, const char* host, uint32_t timeoutMs) {
+    const Slot* slot = find(board, host);
+    if (!slot) {
+      return UINT32_MAX;
+    }
+    return slot->rttMs + static_cast<uint32_t>((static_cast<uint64_t>(kHealthMax - slot->health) * timeoutMs) /
+                                               kHealthMax);
+  }
+
+  // Records an attempt on `host`. `rttMs` 0 records the outcome only.
+  inline void record(Board& board, const char* host, bool ok, uint32_t rttMs, unsigned long now) {
+    Slot* slot = slot_for(board, host, now);
+    if (!slot) {
+      return;
+    }
+    slot->lastTryMs = now;
+    // Moving averages over about four attempts.
+    slot->health = static_cast<uint16_t>(slot->health - slot->health / 4 + (ok ? kHealthMax / 4 : 0));
+    if (ok) {
+      if (slot->failStreak > 0) {
+        board.promotions++;
+      }
+      slot->failStreak = 0;
+      slot->successes++;
+      if (rttMs > 0) {
+        const uint32_t sample = (rttMs > 0xFFFF) ? 0xFFFF : rttMs;
+        slot->rttMs = (slot->rttMs == 0) ? static_cast<uint16_t>(sample)
+                                         : static_cast<uint16_t>(slot->rttMs - slot->rttMs / 4 + sample / 4);
+      }
+      return;
+    }
+    if (slot->failStreak == 0) {
+      board.demotions++;
+    }
+    if (slot->failStreak < 0xFF) {
+      slot->failStreak++;
+    }
+    slot->failures++;
+  }
+
+  // Fills `order` with the indices of the distinct, non-empty `hosts` in the order to try them:
+  // healthy candidates by cost, then demoted ones by cost; ties keep the configured order.
+  // Returns how many were written.
+  inline size_t order(
+      Board& board, const char* const* hosts, size_t count, uint8_t* order, size_t orderLen, uint32_t timeoutMs) {
+    if (!hosts || !order) {
+      return 0;
+    }
+    uint32_t costs[kSlots * 2];
+    bool late[kSlots * 2];
+    size_t n = 0;
+    for (size_t i = 0; i < count && n < orderLen && n < (sizeof(costs) / sizeof(costs[0])); ++i) {
+      const char* host = hosts[i];
+      if (!host || host[0] == '\0') {
+        continue;
+      }
+      bool duplicate = false;
+      for (size_t j = 0; j < n; ++j) {
+        if (strcasecmp(hosts[order[j]], host) == 0) {
+          duplicate = true;
+          break;
+        }
+      }
+      if (duplicate) {
+        continue;
+      }
+      const uint32_t c = EDGE_GATEWAY_SCOREBOARD ? cost(board, host, timeoutMs) : 0;
+      const bool d = EDGE_GATEWAY_SCOREBOARD && demoted(find(board, host));
+      // Insertion sort; stable, and there are four entries at most.
+      size_t pos = n;
+      while (pos > 0 && (late[pos - 1] > d || (late[pos - 1] == d && costs[pos - 1] > c))) {
+        order[pos] = order[pos - 1];
+        costs[pos] = costs[pos - 1];
+        late[pos] = late[pos - 1];
+        --pos;
+      }
+      order[pos] = static_cast<uint8_t>(i);
+      costs[pos] = c;
+      late[pos] = d;
+      ++n;
+    }
+    return n;
+  }
+
+  // Cheap check for the loop: some demoted candidate waits for a probe and the interval is up.
+  inline bool probe_pending(const Board& board, unsigned long now) {
+    if (!EDGE_GATEWAY_SCOREBOARD || (board.probes > 0 && now - board.lastProbeMs < EDGE_GATEWAY_REPROBE_MS)) {
+      return false;
+    }
+    for (const Slot& slot : board.slots) {
+      if (slot.host[0] != '\0' && demoted(&slot) && now - slot.lastTryMs >= EDGE_GATEWAY_REPROBE_MS) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The demoted candidate among `hosts` to probe now, if a probe is due: the one tried longest ago.
+  inline const char* probe_due(Board& board, const char* const* hosts, size_t count, unsigned long now) {
+    if (!hosts || !probe_pending(board, now)) {
+      return nullptr;
+    }
+    const char* due = nullptr;
+    unsigned long dueIdle = 0;
+    for (size_t i = 0; i < count; ++i) {
+      const Slot* slot = find(board, hosts[i]);
+      if (!demoted(slot) || now - slot->lastTryMs < EDGE_GATEWAY_REPROBE_MS) {
+        continue;
+      }
+      if (!due || now - slot->lastTryMs > dueIdle) {
+        due = hosts[i];
+        dueIdle = now - slot->lastTryMs;
+      }
+    }
+    return due;
+  }
+
+  // Marks a probe started, so the next one waits a full interval.
+  inline void probe_started(Board& board, unsigned long now) {
+    board.lastProbeMs = now;
+    board.probes++;
+  }
+
+}  // namespace GatewayScoreboard
+
+#endif  // GATEWAY_SCOREBOARD_H
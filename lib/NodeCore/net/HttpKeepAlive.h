@@ -0,0 +1,316 @@
+#ifndef HTTP_KEEP_ALIVE_H
+#define HTTP_KEEP_ALIVE_H
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// Keep the plain-HTTP socket to the edge gateway open between uploads. Off leaves every request
+// on its own connection ("Connection: close"), as before.
+#ifndef EDGE_KEEPALIVE
+#define EDGE_KEEPALIVE 1
+#endif
+// A kept socket idle for longer than this is closed instead of reused. Stays below the 5 s
+// keep-alive timeout common to gateway HTTP servers, so the node gives up first.
+#ifndef EDGE_KEEPALIVE_IDLE_MS
+#define EDGE_KEEPALIVE_IDLE_MS 4000UL
+#endif
+// Requests served by one socket before it is closed and opened afresh.
+#ifndef EDGE_KEEPALIVE_MAX_REQUESTS
+#define EDGE_KEEPALIVE_MAX_REQUESTS 100
+#endif
+
+static_assert(EDGE_KEEPALIVE_IDLE_MS >= 100, "EDGE_KEEPALIVE_IDLE_MS too short to reuse anything");
+static_assert(EDGE_KEEPALIVE_MAX_REQUESTS > 0 && EDGE_KEEPALIVE_MAX_REQUESTS <= 0xFFFF,
+              "EDGE_KEEPALIVE_MAX_REQUESTS out of range");
+
+// ============================================================================
+// HTTP/1.1 keep-alive for the edge gateway socket
+// ============================================================================
+// The upload state machine opens a TCP connection per record; on a drain that is a SYN/ACK round
+// trip and a TIME_WAIT slot on the gateway for every record. Here the socket outlives the
+// request when the response was framed (Content-Length or chunked), did not ask to close and the
+// connection stays quiet until the next upload. Anything unexpected - stray bytes, a server
+// close, idle expiry - closes it and the next request connects as before.
+//
+// A server may close a kept socket just as the next request goes out. A request sent on a
+// reused socket that sees no response is therefore retried once on a new connection; the
+// payload is still in the shared buffer at that point.
+//
+// Templated on the client so the native tests can drive it with a mock gateway socket.
+namespace HttpKeepAlive {
+
+  static constexpr size_t kHostLen = 48;
+
+  // The kept socket and the request currently using it.
+  struct Connection {
+    char host[kHostLen] = {0};
+    uint16_t port = 0;
+    unsigned long lastUsedMs = 0;
+    uint16_t requests = 0;  // responses read on this socket
+    bool open = false;
+    bool reused = false;   // the current request went out on a kept socket
+    bool retried = false;  // the current request already reconnected once
+    uint32_t connects = 0;
+    uint32_t reuses = 0;
+    uint32_t retries = 0;
+  };
+
+  // How the response body ends and whether the server keeps the socket.
+  struct Framing {
+    int32_t contentLength = -1;
+    bool chunked = false;
+    bool close = false;
+  };
+
+  inline const char* header_value(const char* line, const char* name) {
+    const size_t nameLen = strlen(name);
+    if (strncasecmp(line, name, nameLen) != 0 || line[nameLen] != ':') {
+      return nullptr;
+    }
+    const char* value = line + nameLen + 1;
+    while (*value == ' ' || *value == '\t') {
+      ++value;
+    }
+    return value;
+  }
+
+  inline bool contains_token(const char* value, const char* token) {
+    const size_t tokenLen = strlen(token);
+    for (const char* p = value; *p; ++p) {
+      if (strncasecmp(p, token, tokenLen) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Starts a response. HTTP/1.0 closes unless told otherwise; 204 and 304 carry no body.
+  inline void note_status_line(Framing& framing, const char* line) {
+    framing = Framing();
+    if (!line) {
+      framing.close = true;
+      return;
+    }
+    if (strncmp(line, "HTTP/1.0", 8) == 0) {
+      framing.close = true;
+    }
+    const char* code = strchr(line, ' ');
+    if (code && (strncmp(code + 1, "204", 3) == 0 || strncmp(code + 1, "304", 3) == 0)) {
+      framing.contentLength = 0;
+    }
+  }
+
+  inline void note_header(Framing& framing, const char* line) {
+    if (!line) {
+      return;
+    }
+    const char* value = header_value(line, "Content-Length");
+    if (value) {
+      char* end = nullptr;
+      const long len = strtol(value, &end, 10);
+      if (end != value && len >= 0) {
+        framing.contentLength = static_cast<int32_t>(len);
+      } else {
+        framing.close = true;
+      }
+      return;
+    }
+    value = header_value(line, "Connection");
+    if (value) {
+      if (contains_token(value, "close")) {
+        framing.close = true;
+      } else if (contains_token(value, "keep-alive")) {
+        framing.close = false;
+      }
+      return;
+    }
+    value = header_value(line, "Transfer-Encoding");
+    if (value && contains_token(value, "chunked")) {
+      framing.chunked = true;
+    }
+  }
+
+  template <typename Client>
+  void close(Connection& conn, Client& client) {
+    if (conn.open || client.connected()) {
+      client.stop();
+    }
+    conn.open = false;
+    conn.reused = false;
+    conn.requests = 0;
+  }
+
+  // Starts a request: forgets which socket the previous one used.
+  inline void begin_request(Connection& conn) {
+    conn.reused = false;
+    conn.retried = false;
+  }
+
+  // True when the kept socket can carry the next request to host:port. A socket that went stale
+  // is closed; one kept for a different host is left for that host.
+  template <typename Client>
+  bool reuse(Connection& conn, Client& client, const char* host, uint16_t port, unsigned long now) {
+    if (!conn.open) {
+      return false;
+    }
+    if (!client.connected() || client.available() > 0 || now - conn.lastUsedMs >= EDGE_KEEPALIVE_IDLE_MS ||
+        conn.requests >= EDGE_KEEPALIVE_MAX_REQUESTS) {
+      close(conn, client);
+      return false;
+    }
+    if (!host || port != conn.port || strcasecmp(host, conn.host) != 0) {
+      return false;
+    }
+    conn.reused = true;
+    conn.reuses++;
+    return true;
+  }
+
+  // Records a fresh connect to host:port.
+  inline void opened(Connection& conn, const char* host, uint16_t port, unsigned long now) {
+    strncpy(conn.host, host ? host : "", sizeof(conn.host) - 1);
+    conn.host[sizeof(conn.host) - 1] = '\0';
+    conn.port = port;
+    conn.lastUsedMs = now;
+    conn.requests = 0;
+    conn.open = true;
+    conn.reused = false;
+    conn.connects++;
+  }
+
+  // True when the current request went out on a kept socket the server has since dropped, and
+  // may go again on a new connection. Closes the socket and spends the one retry.
+  template <typename Client>
+  bool retry_after_drop(Connection& conn, Client& client) {
+    if (!conn.reused || conn.retried) {
+      return false;
+    }
+    close(conn, client);
+    conn.retried = true;
+    conn.retries++;
+    return true;
+  }
+
+  template <typename Client>
+  int read_byte(Client& client, unsigned long start, unsigned long timeoutMs) {
+    while (client.available() <= 0) {
+      if (!client.connected() || millis() - start >= timeoutMs) {
+        return -1;
+      }
+      yield();
+    }
+    return client.read();
+  }
+
+  template <typename Client>
+  bool read_line(Client& client, char* out, size_t outLen, unsigned long start, unsigned long timeoutMs) {
+    size_t pos = 0;
+    for (;;) {
+      const int c = read_byte(client, start, timeoutMs);
+      if (c < 0) {
+        return false;
+      }
+      if (c == '\n') {
+        break;
+      }
+      if (c != '\r' && pos + 1 < outLen) {
+        out[pos++] = static_cast<char>(c);
+      }
+    }
+    out[pos] = '\0';
+    return true;
+  }
+
+  // Reads the whole response body as framed, keeping its start in `out`. `complete` says the
+  // socket is positioned at the next response; a close-delimited body never is.
+  template <typename Client>
+  size_t read_body(
+      Client& client, const Framing& framing, char* out, size_t outLen, unsigned long timeoutMs, bool& complete) {
+    complete = false;
+    if (!out || outLen == 0) {
+      return 0;
+    }
+    out[0] = '\0';
+    size_t pos = 0;
+    const unsigned long start = millis();
+    auto keep = [&](int c) {
+      if (pos + 1 < outLen) {
+        out[pos++] = static_cast<char>(c);
+      }
+    };
+
+    if (framing.chunked) {
+      char line[16];
+      for (;;) {
+        if (!read_line(client, line, sizeof(line), start, timeoutMs)) {
+          break;
+        }
+        const unsigned long chunkLen = strtoul(line, nullptr, 16);
+        if (chunkLen == 0) {
+          // Trailer section, ended by an empty line.
+          while (read_line(client, line, sizeof(line), start, timeoutMs)) {
+            if (line[0] == '\0') {
+              complete = true;
+              break;
+            }
+          }
+          break;
+        }
+        unsigned long remaining = chunkLen;
+        while (remaining > 0) {
+          const int c = read_byte(client, start, timeoutMs);
+          if (c < 0) {
+            break;
+          }
+          keep(c);
+          --remaining;
+        }
+        if (remaining > 0 || !read_line(client, line, sizeof(line), start, timeoutMs)) {
+          break;
+        }
+      }
+    } else if (framing.contentLength >= 0) {
+      int32_t remaining = framing.contentLength;
+      while (remaining > 0) {
+        const int c = read_byte(client, start, timeoutMs);
+        if (c < 0) {
+          break;
+        }
+        keep(c);
+        --remaining;
+      }
+      complete = (remaining == 0);
+    } else {
+      while (pos + 1 < outLen) {
+        const int c = read_byte(client, start, timeoutMs);
+        if (c < 0) {
+          break;
+        }
+        keep(c);
+      }
+    }
+    out[pos] = '\0';
+    return pos;
+  }
+
+  // Ends a request: keeps the socket for the next one when the response allows it.
+  template <typename Client>
+  void finish(Connection& conn, Client& client, const Framing& framing, bool complete, unsigned long now) {
+    if (!conn.open) {
+      client.stop();
+      return;
+    }
+    conn.requests++;
+    if (!complete || framing.close || conn.requests >= EDGE_KEEPALIVE_MAX_REQUESTS || !client.connected()) {
+      close(conn, client);
+      return;
+    }
+    conn.lastUsedMs = now;
+    conn.reused = false;
+  }
+
+}  // namespace HttpKeepAlive
+
+#endif  // HTTP_KEEP_ALIVE_H
@@ -0,0 +1,159 @@
+#ifndef HTTP_STREAM_WRITER_H
+#define HTTP_STREAM_WRITER_H
+
+#include <Arduino.h>
+#include <string.h>
+
+#include <algorithm>
+
+// Stack buffer the request head and small body pieces are gathered in before they reach the
+// socket. One chunk normally holds the whole header block.
+#ifndef HTTP_STREAM_CHUNK_BYTES
+#define HTTP_STREAM_CHUNK_BYTES 384
+#endif
+
+static_assert(HTTP_STREAM_CHUNK_BYTES >= 64 && HTTP_STREAM_CHUNK_BYTES <= 1460,
+              "HTTP_STREAM_CHUNK_BYTES must lie between 64 B and one TCP segment");
+
+// ============================================================================
+// Coalescing request writer
+// ============================================================================
+// print() on WiFiClient hands every header line to lwIP as its own write, which on a request
+// with a dozen header fragments means a dozen small segments (or a dozen Nagle stalls). The
+// writer gathers them in a fixed stack chunk and hands the sink whole chunks; a body piece too
+// large for the chunk goes straight through without a copy.
+//
+// The sink is any callable `size_t(const uint8_t* data, size_t len)` returning the bytes it
+// took; a short count fails the writer and everything after it is dropped.
+namespace HttpStreamWriter {
+
+  template <typename Sink>
+  class Writer {
+  public:
+    explicit Writer(Sink& sink) : m_sink(sink) {}
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    bool put(const char* data, size_t len) {
+      if (m_failed || !data) {
+        return false;
+      }
+      if (len > sizeof(m_chunk) - m_fill) {
+        if (!flush()) {
+          return false;
+        }
+        if (len >= sizeof(m_chunk)) {
+          return forward(reinterpret_cast<const uint8_t*>(data), len);
+        }
+      }
+      memcpy(m_chunk + m_fill, data, len);
+      m_fill += len;
+      return true;
+    }
+
+    bool put(const char* s) {
+      return s ? put(s, strlen(s)) : false;
+    }
+
+    bool put_P(PGM_P s) {
+      if (!s) {
+        return false;
+      }
+      size_t remaining = strlen_P(s);
+      while (remaining > 0) {
+        if (m_fill == sizeof(m_chunk) && !flush()) {
+          return false;
+        }
+        const size_t n = std::min(remaining, sizeof(m_chunk) - m_fill);
+        memcpy_P(m_chunk + m_fill, s, n);
+        m_fill += n;
+        s += n;
+        remaining -= n;
+      }
+      return !m_failed;
+    }
+
+    bool put(const __FlashStringHelper* s) {
+      return put_P(reinterpret_cast<PGM_P>(s));
+    }
+
+    bool put_u32(uint32_t value) {
+      char digits[11];
+      size_t pos = sizeof(digits);
+      do {
+        digits[--pos] = static_cast<char>('0' + (value % 10U));
+        value /= 10U;
+      } while (value > 0);
+      return put(digits + pos, sizeof(digits) - pos);
+    }
+
+    // Room for `len` bytes at the end of the chunk, for text rendered in place (a header value,
+    // a body record) instead of being copied in; the chunk is flushed first if it is short of
+    // room. The caller writes up to `len` bytes there and passes what it used to commit().
+    // nullptr when `len` is larger than the chunk or the writer has failed.
+    char* reserve(size_t len) {
+      if (m_failed || len > sizeof(m_chunk)) {
+        return nullptr;
+      }
+      if (len > sizeof(m_chunk) - m_fill && !flush()) {
+        return nullptr;
+      }
+      return m_chunk + m_fill;
+    }
+
+    bool commit(size_t len) {
+      if (m_failed || len > sizeof(m_chunk) - m_fill) {
+        m_failed = true;
+        return false;
+      }
+      m_fill += len;
+      return true;
+    }
+
+    // Hands whatever is gathered to the sink.
+    bool flush() {
+      if (m_failed) {
+        return false;
+      }
+      if (m_fill == 0) {
+        return true;
+      }
+      const size_t fill = m_fill;
+      m_fill = 0;
+      return forward(reinterpret_cast<const uint8_t*>(m_chunk), fill);
+    }
+
+    // Bytes the sink accepted so far.
+    size_t written() const {
+      return m_written;
+    }
+    uint16_t sinkWrites() const {
+      return m_sinkWrites;
+    }
+    bool ok() const {
+      return !m_failed;
+    }
+
+  private:
+    bool forward(const uint8_t* data, size_t len) {
+      const size_t n = m_sink(data, len);
+      m_written += n;
+      m_sinkWrites++;
+      if (n < len) {
+        m_failed = true;
+      }
+      return !m_failed;
+    }
+
+    Sink& m_sink;
+    char m_chunk[HTTP_STREAM_CHUNK_BYTES];
+    size_t m_fill = 0;
+    size_t m_written = 0;
+    uint16_t m_sinkWrites = 0;
+    bool m_failed = false;
+  };
+
+}  // namespace HttpStreamWriter
+
+#endif  // HTTP_STREAM_WRITER_H
@@ -7,6 +7,7 @@
 
 #include "system/ConfigManager.h"  // For NTP_VALID_TIMESTAMP_THRESHOLD
 #include "support/CryptoUtils.h"
+#include "support/TimestampCache.h"
 #include "system/Logger.h"
 #include "storage/Paths.h"
 #include "REDACTED"
@@ -80,6 +81,8 @@ void NtpClient::startSync() {
   // configTime automatically sends NTP packets.
   // Use pool.ntp.org with google as backup.
   configTime(AppConstants::TIMEZONE_OFFSET_SEC, 0, "pool.ntp.org", "time.google.com");
+  // Days cached before this were converted without the offset (a time snapshot loaded at boot).
+  TimestampCache::invalidate();
 
   m_sync_in_progress = true;
   m_syncTimeoutTimer.reset();
@@ -0,0 +1,112 @@
+#ifndef QOS_PROBE_H
+#define QOS_PROBE_H
+
+#include <Arduino.h>
+#include <string.h>
+
+#include <algorithm>
+
+// Requests per target in a throughput sweep when none is asked for, and the most it keeps.
+#ifndef QOS_PROBE_DEFAULT_SAMPLES
+#define QOS_PROBE_DEFAULT_SAMPLES 20
+#endif
+#ifndef QOS_PROBE_MAX_SAMPLES
+#define QOS_PROBE_MAX_SAMPLES 64
+#endif
+
+static_assert(QOS_PROBE_MAX_SAMPLES >= 5 && QOS_PROBE_MAX_SAMPLES <= 255, "QOS_PROBE_MAX_SAMPLES out of range");
+static_assert(QOS_PROBE_DEFAULT_SAMPLES >= 1 && QOS_PROBE_DEFAULT_SAMPLES <= QOS_PROBE_MAX_SAMPLES,
+              "QOS_PROBE_DEFAULT_SAMPLES out of range");
+
+// ============================================================================
+// QoS throughput probe
+// ============================================================================
+// The latency probe posts a 14-byte body five times, which says nothing about how a link copes
+// with a batch upload. The throughput probe posts a body of a chosen size, up to a full batch,
+// to each upload target in turn and keeps every request's round trip, so the report can give
+// bytes per second and p50/p90/p99 instead of min/avg/max over five samples.
+//
+// The body is generated while it is sent (a JSON object padded to the requested length), so a
+// large probe costs no heap beyond the HTTP client's own buffers.
+namespace QosProbe {
+
+  static constexpr uint8_t kMaxSamples = QOS_PROBE_MAX_SAMPLES;
+  static constexpr uint8_t kDefaultSamples = QOS_PROBE_DEFAULT_SAMPLES;
+
+  namespace detail {
+    static constexpr char kHead[] = "{\"qos_test\":1,\"pad\":\"";
+    static constexpr char kTail[] = "\"}";
+    static constexpr size_t kHeadLen = sizeof(kHead) - 1;
+    static constexpr size_t kTailLen = sizeof(kTail) - 1;
+  }  // namespace detail
+
+  // Shortest body the probe sends: the object with an empty pad.
+  static constexpr size_t kMinBodyLen = detail::kHeadLen + detail::kTailLen;
+
+  // Copies bytes [offset, offset + len) of the `total`-byte probe body into `out`. Returns how
+  // many were copied (fewer at the end of the body).
+  inline size_t body_read(uint8_t* out, size_t len, size_t offset, size_t total) {
+    using namespace detail;
+    if (!out || total < kMinBodyLen || offset >= total) {
+      return 0;
+    }
+    const size_t n = std::min(len, total - offset);
+    const size_t padEnd = total - kTailLen;
+    for (size_t i = 0; i < n; ++i) {
+      const size_t at = offset + i;
+      if (at < kHeadLen) {
+        out[i] = static_cast<uint8_t>(kHead[at]);
+      } else if (at < padEnd) {
+        out[i] = static_cast<uint8_t>('a' + (at % 26));
+      } else {
+        out[i] = static_cast<uint8_t>(kTail[at - padEnd]);
+      }
+    }
+    return n;
+  }
+
+  // The round trips of one target's requests.
+  struct Window {
+    uint16_t latencyMs[kMaxSamples] = {0};
+    uint8_t count = 0;
+    uint32_t bytes = 0;   // request bodies that got an answer
+    uint32_t busyMs = 0;  // the round trips those took
+
+    void reset() {
+      *this = Window();
+    }
+
+    // One answered request of `bodyLen` bytes; a full window keeps its samples.
+    void add(uint32_t ms, size_t bodyLen) {
+      if (count >= kMaxSamples) {
+        return;
+      }
+      latencyMs[count++] = static_cast<uint16_t>(std::min<uint32_t>(ms, 0xFFFF));
+      bytes += static_cast<uint32_t>(bodyLen);
+      busyMs += ms;
+    }
+
+    // Sorts the samples; percentile() needs it, add() must not be called after.
+    void finish() {
+      std::sort(latencyMs, latencyMs + count);
+    }
+
+    // Nearest-rank percentile of the sorted samples; 0 without any.
+    uint32_t percentile(uint8_t pct) const {
+      if (count == 0) {
+        return 0;
+      }
+      size_t rank = (static_cast<size_t>(count) * pct + 99) / 100;
+      rank = std::max<size_t>(rank, 1);
+      return latencyMs[std::min<size_t>(rank, count) - 1];
+    }
+
+    // Body bytes moved per second of request time, handshakes included, as a batch upload sees it.
+    uint32_t bytesPerSec() const {
+      return busyMs ? static_cast<uint32_t>((static_cast<uint64_t>(bytes) * 1000ULL) / busyMs) : 0;
+    }
+  };
+
+}  // namespace QosProbe
+
+#endif  // QOS_PROBE_H
@@ -0,0 +1,138 @@
+#include "net/TlsSessionCache.h"
+
+#include <string.h>
+#include <strings.h>
+
+#include "system/Logger.h"
+
+TlsSessionCache::Entry TlsSessionCache::entries[TLS_SESSION_CACHE_SLOTS];
+uint32_t TlsSessionCache::useCounter = 0;
+TlsSessionCache::Stats TlsSessionCache::counters;
+
+int8_t TlsSessionCache::findOrClaim(const char* host, size_t hostLen) {
+  if (!host || hostLen == 0 || hostLen >= kHostLen) {
+    return -1;
+  }
+
+  int8_t victim = 0;
+  for (int8_t i = 0; i < TLS_SESSION_CACHE_SLOTS; ++i) {
+    Entry& e = entries[i];
+    if (strncasecmp(e.host, host, hostLen) == 0 && e.host[hostLen] == '\0') {
+      e.lastUsed = ++useCounter;
+      return i;
+    }
+    if (e.lastUsed < entries[victim].lastUsed) {
+      victim = i;
+    }
+  }
+
+  Entry& e = entries[victim];
+  memcpy(e.host, host, hostLen);
+  e.host[hostLen] = '\0';
+  e.session = BearSSL::Session();
+  e.established = false;
+  e.lastUsed = ++useCounter;
+  return victim;
+}
+
+// The core's Session wraps a single br_ssl_session_parameters, and its getSession() accessor is
+// private to WiFiClientSecureCtx, so the parameters are read through the wrapper itself.
+const br_ssl_session_parameters& TlsSessionCache::parameters(const BearSSL::Session& session) {
+  static_assert(sizeof(BearSSL::Session) == sizeof(br_ssl_session_parameters),
+                "BearSSL::Session no longer wraps br_ssl_session_parameters alone");
+  return *reinterpret_cast<const br_ssl_session_parameters*>(&session);
+}
+
+TlsSessionCache::Ticket TlsSessionCache::attach(BearSSL::WiFiClientSecure& client, const char* host) {
+  return attachUrl(client, host);
+}
+
+TlsSessionCache::Ticket TlsSessionCache::attachUrl(BearSSL::WiFiClientSecure& client, const char* url) {
+  Ticket ticket;
+  ticket.startMs = millis();
+
+  const char* host = url;
+  if (host) {
+    const char* scheme = strstr(host, "://");
+    if (scheme) {
+      host = scheme + 3;
+    }
+  }
+  size_t hostLen = host ? strcspn(host, ":/?#") : 0;
+
+  ticket.slot = findOrClaim(host, hostLen);
+  if (ticket.slot < 0) {
+    client.setSession(nullptr);
+    return ticket;
+  }
+  Entry& e = entries[ticket.slot];
+  ticket.offered = e.established;
+  if (ticket.offered) {
+    const br_ssl_session_parameters& params = parameters(e.session);
+    ticket.sessionIdLen = params.session_id_len;
+    memcpy(ticket.sessionId, params.session_id, sizeof(ticket.sessionId));
+  }
+  client.setSession(&e.session);
+  return ticket;
+}
+
+void TlsSessionCache::settle(const Ticket& ticket, bool connected) {
+  if (ticket.slot < 0) {
+    return;
+  }
+  Entry& e = entries[ticket.slot];
+  if (!connected) {
+    e.session = BearSSL::Session();
+  }
+  e.established = connected;
+}
+
+bool TlsSessionCache::finish(const Ticket& ticket, bool connected) {
+  const uint32_t elapsed = millis() - ticket.startMs;
+  settle(ticket, connected);
+  if (!connected) {
+    counters.failures++;
+    return false;
+  }
+
+  // On resumption the server echoes the offered ID; a full handshake leaves a new one behind.
+  bool resumed = false;
+  if (ticket.offered && ticket.sessionIdLen > 0) {
+    const br_ssl_session_parameters& params = parameters(entries[ticket.slot].session);
+    resumed = params.session_id_len == ticket.sessionIdLen &&
+              memcmp(params.session_id, ticket.sessionId, ticket.sessionIdLen) == 0;
+  }
+  if (ticket.offered && !resumed) {
+    counters.declinedResumes++;
+  }
+
+  counters.lastMs = elapsed;
+  counters.lastResumed = resumed;
+  if (resumed) {
+    counters.resumedHandshakes++;
+    counters.resumedMsTotal += elapsed;
+  } else {
+    counters.fullHandshakes++;
+    counters.fullMsTotal += elapsed;
+  }
+  LOG_INFO("TLS",
+           F("Connect + handshake %lu ms (%s session)"),
+           static_cast<unsigned long>(elapsed),
+           resumed ? "resumed" : (ticket.offered ? "declined, new" : "new"));
+  return resumed;
+}
+
+const TlsSessionCache::Stats& TlsSessionCache::stats() {
+  return counters;
+}
+
+void TlsSessionCache::clear() {
+  for (Entry& e : entries) {
+    e.host[0] = '\0';
+    e.session = BearSSL::Session();
+    e.lastUsed = 0;
+    e.established = false;
+  }
+  useCounter = 0;
+  counters = Stats();
+}
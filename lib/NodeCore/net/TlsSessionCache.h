@@ -0,0 +1,90 @@
+#ifndef TLS_SESSION_CACHE_H
+#define TLS_SESSION_CACHE_H
+
+#include <Arduino.h>
+#include <WiFiClientSecureBearSSL.h>
+
+// Hosts whose TLS session is kept for resumption (cloud API, relay, OTA server).
+#ifndef TLS_SESSION_CACHE_SLOTS
+#define TLS_SESSION_CACHE_SLOTS 2
+#endif
+
+static_assert(TLS_SESSION_CACHE_SLOTS > 0 && TLS_SESSION_CACHE_SLOTS <= 8, "TLS_SESSION_CACHE_SLOTS out of range");
+
+// ============================================================================
+// TLS session resumption cache
+// ============================================================================
+// ApiClient and OtaManager share one BearSSL client. A full handshake costs seconds of CPU and
+// the peak heap of the RSA/ECDHE maths; an abbreviated one reuses the master secret the server
+// handed out last time. The sessions live in static storage, so they outlast
+// releaseTlsResources() and are handed to the client before each connect, keyed by host so a
+// relay or OTA request does not clobber the cloud API's session.
+//
+// A handshake counts as resumed only when the server echoed the offered session ID back (RFC 5246
+// 7.4.1.3). A server that turns the session down hands out a new ID, and that connect counts as
+// a full handshake and a declined resume.
+class TlsSessionCache {
+public:
+  // One connect: the slot the client was pointed at, the session ID it offered and when the
+  // handshake started.
+  struct Ticket {
+    int8_t slot = -1;
+    bool offered = false;
+    uint8_t sessionIdLen = 0;
+    uint8_t sessionId[32];
+    unsigned long startMs = 0;
+  };
+
+  struct Stats {
+    uint32_t fullHandshakes = 0;
+    uint32_t resumedHandshakes = 0;
+    uint32_t failures = 0;
+    uint32_t declinedResumes = 0;
+    uint32_t fullMsTotal = 0;
+    uint32_t resumedMsTotal = 0;
+    uint32_t lastMs = 0;
+    bool lastResumed = false;
+
+    uint32_t averageFullMs() const {
+      return fullHandshakes ? fullMsTotal / fullHandshakes : 0;
+    }
+    uint32_t averageResumedMs() const {
+      return resumedHandshakes ? resumedMsTotal / resumedHandshakes : 0;
+    }
+  };
+
+  // Points `client` at the session cached for `host`, evicting the least recently used slot
+  // for a new host. Hosts that do not fit a slot connect without a session.
+  static Ticket attach(BearSSL::WiFiClientSecure& client, const char* host);
+  // Same, for an "http(s)://host[:port]/path" URL handed to HTTPClient.
+  static Ticket attachUrl(BearSSL::WiFiClientSecure& client, const char* url);
+
+  // Records the outcome of an explicit connect() started after attach(), with its handshake
+  // time, and returns whether the server resumed the offered session. A failed connect drops the
+  // slot's session so the next attempt starts clean.
+  static bool finish(const Ticket& ticket, bool connected);
+  // Outcome only, for HTTPClient requests where the handshake cannot be timed on its own.
+  static void settle(const Ticket& ticket, bool connected);
+
+  static const Stats& stats();
+  static void clear();
+
+private:
+  static constexpr size_t kHostLen = 48;
+
+  struct Entry {
+    char host[kHostLen];
+    BearSSL::Session session;
+    uint32_t lastUsed;
+    bool established;
+  };
+
+  static Entry entries[TLS_SESSION_CACHE_SLOTS];
+  static uint32_t useCounter;
+  static Stats counters;
+
+  static int8_t findOrClaim(const char* host, size_t hostLen);
+  static const br_ssl_session_parameters& parameters(const BearSSL::Session& session);
+};
+
+#endif  // TLS_SESSION_CACHE_H
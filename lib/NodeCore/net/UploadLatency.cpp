@@ -0,0 +1,119 @@
+#include "net/UploadLatency.h"
+
+UploadLatency::Histogram UploadLatency::histograms[UploadLatency::kTargets][UploadLatency::kPhases];
+UploadLatency::Failures UploadLatency::failureCounts;
+unsigned long UploadLatency::resetMs = 0;
+
+size_t UploadLatency::bucketFor(uint32_t ms) {
+  size_t index = 0;
+  while (ms > 0 && index < kBuckets - 1) {
+    ms >>= 1;
+    ++index;
+  }
+  return index;
+}
+
+uint32_t UploadLatency::bucketUpperMs(size_t index) {
+  return (index == 0) ? 1U : (1UL << index);
+}
+
+uint32_t UploadLatency::Histogram::percentileMs(uint8_t pct) const {
+  if (count == 0) {
+    return 0;
+  }
+  uint32_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    seen += buckets[i];
+    // The pct-th percentile is the first bucket holding ceil(count * pct / 100) samples.
+    if (seen * 100ULL >= static_cast<uint64_t>(count) * pct) {
+      const uint32_t upper = (i == kBuckets - 1) ? maxMs : bucketUpperMs(i);
+      return (upper < maxMs) ? upper : maxMs;
+    }
+  }
+  return maxMs;
+}
+
+void UploadLatency::record(Target target, Phase phase, uint32_t ms) {
+  const size_t t = static_cast<size_t>(target);
+  const size_t p = static_cast<size_t>(phase);
+  if (t >= kTargets || p >= kPhases) {
+    return;
+  }
+  Histogram& h = histograms[t][p];
+  uint16_t& bucket = h.buckets[bucketFor(ms)];
+  if (bucket == 0xFFFF) {
+    // A saturated bucket would skew the percentiles; keep the shape and drop the sample.
+    return;
+  }
+  bucket++;
+  h.count++;
+  h.totalMs += ms;
+  if (ms > h.maxMs) {
+    h.maxMs = ms;
+  }
+}
+
+void UploadLatency::recordFailure(Target target) {
+  const size_t t = static_cast<size_t>(target);
+  if (t < kTargets) {
+    failureCounts.count[t]++;
+  }
+}
+
+const UploadLatency::Histogram& UploadLatency::histogram(Target target, Phase phase) {
+  const size_t t = static_cast<size_t>(target);
+  const size_t p = static_cast<size_t>(phase);
+  return histograms[(t < kTargets) ? t : 0][(p < kPhases) ? p : 0];
+}
+
+const UploadLatency::Failures& UploadLatency::failures() {
+  return failureCounts;
+}
+
+unsigned long UploadLatency::sinceResetMs() {
+  return millis() - resetMs;
+}
+
+void UploadLatency::reset() {
+  for (auto& row : histograms) {
+    for (Histogram& h : row) {
+      h = Histogram();
+    }
+  }
+  failureCounts = Failures();
+  resetMs = millis();
+}
+
+PGM_P UploadLatency::targetName_P(Target target) {
+  switch (target) {
+    case Target::CLOUD:
+      return PSTR("cloud");
+    case Target::RELAY:
+      return PSTR("relay");
+    case Target::EDGE:
+      return PSTR("edge");
+    default:
+      return PSTR("unknown");
+  }
+}
+
+PGM_P UploadLatency::phaseName_P(Phase phase) {
+  switch (phase) {
+    case Phase::DNS:
+      return PSTR("dns");
+    case Phase::CONNECT:
+      return PSTR("connect");
+    case Phase::TLS:
+      return PSTR("tls");
+    case Phase::SEND:
+      return PSTR("send");
+    case Phase::FIRST_BYTE:
+      return PSTR("firstByte");
+    case Phase::BODY:
+      return PSTR("body");
+    case Phase::TOTAL:
+      return PSTR("total");
+    default:
+      return PSTR("unknown");
+  }
+}
@@ -0,0 +1,70 @@
+#ifndef UPLOAD_LATENCY_H
+#define UPLOAD_LATENCY_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// Per-phase upload latency histograms
+// ============================================================================
+// UploadResult says whether an upload worked, not where a slow one spent its time. The
+// transport timestamps every step of a request - name lookup, TCP connect, TLS handshake,
+// sending the request, waiting for the first response byte, reading the rest - and adds each
+// duration to a fixed log2 histogram for the target the request went to (cloud direct, relay,
+// edge gateway).
+//
+// Bucket 0 counts durations under 1 ms, bucket i those in [2^(i-1), 2^i) ms, and the last one
+// everything from 2^(kBuckets-2) ms up. Counts saturate rather than wrap. The histograms live in
+// static storage (about 1 KB) and are cleared by reset(), like the heap watermarks.
+//
+// On TLS targets BearSSL runs the TCP and TLS handshakes in one call, so TLS covers both and
+// CONNECT stays empty; the edge gateway is plain HTTP and has CONNECT only.
+class UploadLatency {
+public:
+  enum class Target : uint8_t { CLOUD, RELAY, EDGE };
+  enum class Phase : uint8_t { DNS, CONNECT, TLS, SEND, FIRST_BYTE, BODY, TOTAL };
+
+  static constexpr size_t kTargets = 3;
+  static constexpr size_t kPhases = 7;
+  static constexpr size_t kBuckets = 16;
+
+  struct Histogram {
+    uint16_t buckets[kBuckets] = {0};
+    uint32_t count = 0;
+    uint32_t totalMs = 0;
+    uint32_t maxMs = 0;
+
+    uint32_t averageMs() const {
+      return count ? totalMs / count : 0;
+    }
+    // Upper edge of the bucket holding the pct-th percentile; 0 when empty.
+    uint32_t percentileMs(uint8_t pct) const;
+  };
+
+  // Requests that failed after they started, per target.
+  struct Failures {
+    uint32_t count[kTargets] = {0};
+  };
+
+  static size_t bucketFor(uint32_t ms);
+  // Upper edge of bucket `index` in ms (the last bucket reports the largest duration seen).
+  static uint32_t bucketUpperMs(size_t index);
+
+  static void record(Target target, Phase phase, uint32_t ms);
+  static void recordFailure(Target target);
+
+  static const Histogram& histogram(Target target, Phase phase);
+  static const Failures& failures();
+  // Milliseconds the histograms have been collecting since boot or the last reset().
+  static unsigned long sinceResetMs();
+  static void reset();
+
+  static PGM_P targetName_P(Target target);
+  static PGM_P phaseName_P(Phase phase);
+
+private:
+  static Histogram histograms[kTargets][kPhases];
+  static Failures failureCounts;
+  static unsigned long resetMs;
+};
+
+#endif  // UPLOAD_LATENCY_H
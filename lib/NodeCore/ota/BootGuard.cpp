@@ -147,6 +147,17 @@ void BootGuard::incrementCrashCount() {
   write();
 }
 
+void BootGuard::recordDeepSleepWake() {
+  if (!read()) {
+    clear();
+  }
+  const uint32_t reason = static_cast<uint32_t>(RebootReason::DEEP_SLEEP);
+  if (data.lastReasonRaw != reason) {
+    data.lastReasonRaw = reason;
+    write();
+  }
+}
+
 void BootGuard::setRebootReason(BootGuard::RebootReason reason) {
   // FIX: Validate enum value
   if (!isValidReason(reason)) {
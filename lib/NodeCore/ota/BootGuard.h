@@ -34,6 +34,9 @@ public:
 
   static void markStable();
   static void incrementCrashCount();
+  // Timer-wake fast path for deep-sleep duty cycling: records DEEP_SLEEP without crash
+  // accounting, and only writes RTC when the stored reason changes.
+  static void recordDeepSleepWake();
   static void clear();
   static uint32_t getCrashCount();
 
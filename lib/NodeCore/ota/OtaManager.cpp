@@ -14,6 +14,7 @@
 #include "system/ConfigManager.h"
 #include "system/Logger.h"
 #include "net/NtpClient.h"
+#include "net/TlsSessionCache.h"
 #include "system/NodeIdentity.h"
 #include "REDACTED"
 #include "REDACTED"
@@ -332,11 +333,13 @@ void OtaManager:REDACTED
     return;
   }
 
+  const TlsSessionCache::Ticket checkTicket = TlsSessionCache::attachUrl(m_secureClient, fullOtaUrl);
   if (http.begin(m_secureClient, fullOtaUrl)) {
     if (hasCheckAuth) {
       http.addHeader(F("REDACTED"), checkAuthHeader);
     }
     int httpCode = http.GET();
+    TlsSessionCache::settle(checkTicket, httpCode > 0);
     if (httpCode == HTTP_CODE_OK) {
       char payload[256];
       int n = http.getStream().readBytes(payload, sizeof(payload) - 1);
@@ -444,12 +447,14 @@ void OtaManager:REDACTED
     HTTPClient updateHttp;
     updateHttp.setTimeout(m_policy.downloadHttpTimeoutMs);
     updateHttp.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    const TlsSessionCache::Ticket downloadTicket = TlsSessionCache::attachUrl(m_secureClient, firmwareUrl);
     if (updateHttp.begin(m_secureClient, String(firmwareUrl))) {
       if (hasDownloadAuth) {
         updateHttp.addHeader(F("REDACTED"), downloadAuthHeader);
       }
       updateHttp.addHeader(F("X-Device-ID"), deviceId);
       t_httpUpdate_return updateResult = ESPhttpUpdate.update(updateHttp, FIRMWARE_VERSION);
+      TlsSessionCache::settle(downloadTicket, updateResult != HTTP_UPDATE_FAILED);
       if (updateResult == HTTP_UPDATE_FAILED) {
         LOG_ERROR("OTA", F("Update failed: REDACTED
         finishCloudOtaSession();
@@ -48,6 +48,21 @@ void SensorManager::resume() {
   }
 }
 
+bool SensorManager::sampleOnce() {
+  attemptSensorInitOrRecovery();
+  if (m_shtState.isOk && m_sht.readSample()) {
+    m_temperature = m_sht.getTemperature();
+    m_humidity = m_sht.getHumidity();
+  }
+  if (m_bh1750State.isOk) {
+    const float lux = m_lightMeter.readLightLevel();
+    if (lux >= 0) {
+      m_lightLevel = lux;
+    }
+  }
+  return m_temperature != INVALID_TEMP || m_lightLevel != INVALID_LUX;
+}
+
 void SensorManager::handleImpl() {
   switch (m_currentState) {
     case State::INITIALIZING: handleInitializing(); break;
@@ -41,6 +41,9 @@ public:
   void handleImpl();
   void pause();
   void resume();
+  // Blocking init + single read for deep-sleep sample wakes, which never reach the state
+  // machine. Returns false when neither sensor produced a value.
+  bool sampleOnce();
   SensorReading getTempImpl() const;
   SensorReading getHumidityImpl() const;
   SensorReading getLightImpl() const;
@@ -0,0 +1,182 @@
+#ifndef CACHE_DOWNSAMPLER_H
+#define CACHE_DOWNSAMPLER_H
+
+#include <Arduino.h>
+
+#include "interfaces/ICacheManager.h"
+#include "storage/SensorAggregateCodec.h"
+#include "system/ConfigManager.h"  // For NTP_VALID_TIMESTAMP_THRESHOLD
+
+// Fill level (percent of the routine lane) above which the oldest samples are merged.
+#ifndef CACHE_DOWNSAMPLE_START_PCT
+#define CACHE_DOWNSAMPLE_START_PCT 75
+#endif
+// Window length, in seconds, that raw samples are merged into. Aggregates that cycle back to
+// the tail are merged again into windows CACHE_DOWNSAMPLE_FACTOR times longer, up to
+// CACHE_DOWNSAMPLE_MAX_WINDOW_S, so the older the history the coarser it gets.
+#ifndef CACHE_DOWNSAMPLE_WINDOW_S
+#define CACHE_DOWNSAMPLE_WINDOW_S 600
+#endif
+#ifndef CACHE_DOWNSAMPLE_FACTOR
+#define CACHE_DOWNSAMPLE_FACTOR 6
+#endif
+#ifndef CACHE_DOWNSAMPLE_MAX_WINDOW_S
+#define CACHE_DOWNSAMPLE_MAX_WINDOW_S 21600
+#endif
+// Cache bytes read per downsample pass; bounds the time one loop iteration spends on it.
+#ifndef CACHE_DOWNSAMPLE_BUDGET_BYTES
+#define CACHE_DOWNSAMPLE_BUDGET_BYTES 512
+#endif
+
+static_assert(CACHE_DOWNSAMPLE_START_PCT > 0 && CACHE_DOWNSAMPLE_START_PCT < 100,
+              "CACHE_DOWNSAMPLE_START_PCT must leave headroom below a full cache");
+static_assert(CACHE_DOWNSAMPLE_WINDOW_S > 0 && CACHE_DOWNSAMPLE_WINDOW_S <= CACHE_DOWNSAMPLE_MAX_WINDOW_S &&
+                  CACHE_DOWNSAMPLE_MAX_WINDOW_S <= 0xFFFF,
+              "Downsample windows must fit an aggregate's 16-bit window field");
+static_assert(CACHE_DOWNSAMPLE_FACTOR >= 2, "CACHE_DOWNSAMPLE_FACTOR must coarsen each level");
+
+// ============================================================================
+// Age-based downsampling of the routine backlog
+// ============================================================================
+// Instead of letting a full cache drop its oldest samples outright, each pass reads entries
+// from the tail, folds them into per-window aggregates, appends those at the head and only then
+// pops the entries they replace. A crash in between leaves both copies, never neither.
+//
+// Aggregates are appended behind newer data, so the backlog is no longer strictly time-ordered;
+// every record carries its own timestamp. When an aggregate comes back round to the tail it is
+// merged again at the next coarser window, and at the coarsest window it is carried over as is
+// so the entries behind it can still be merged. A pass is only committed when it frees more than
+// it appends, which bounds the extra flash writes by the data coming in. Once the lane is all
+// coarsest history nothing frees space any more, and the oldest aggregates are left to the
+// normal trim. Legacy JSON records and samples taken before the clock was set (timestamp 0 or
+// otherwise pre-NTP) stop a pass: they all land in bucket 0, and merging them would fold hours
+// of readings into one 1970 point.
+namespace CacheDownsampler {
+
+  static constexpr uint32_t kWindowSeconds = CACHE_DOWNSAMPLE_WINDOW_S;
+  static constexpr uint32_t kMaxWindowSeconds = CACHE_DOWNSAMPLE_MAX_WINDOW_S;
+  static constexpr uint8_t kMaxWindowsPerPass = 8;
+
+  // Result of one pass: entries consumed from the tail and aggregate records appended.
+  struct PassResult {
+    uint16_t entries = 0;
+    uint8_t aggregates = 0;
+  };
+
+  // Per-engine state kept between passes.
+  struct State {
+    uint32_t idleSize = 0;  // lane size at which the last pass found nothing worth merging
+  };
+
+  // Window an aggregate built for `window` seconds is merged into next.
+  [[maybe_unused]] inline uint32_t next_window(uint32_t window) {
+    const uint32_t next = window * CACHE_DOWNSAMPLE_FACTOR;
+    return (next > kMaxWindowSeconds) ? kMaxWindowSeconds : next;
+  }
+
+  // One pass over at most `budgetBytes` of the routine lane of `cache`, which holds up to
+  // `capacityBytes`. Does nothing below the start threshold, or until the lane changes after a
+  // pass that could not free anything.
+  template <typename Cache>
+  PassResult step(Cache& cache, State& state, uint32_t capacityBytes, uint32_t budgetBytes) {
+    PassResult result;
+    const uint32_t used = cache.get_lane_size(CacheLane::ROUTINE);
+    if (used <= capacityBytes / 100U * CACHE_DOWNSAMPLE_START_PCT || used == state.idleSize) {
+      return result;
+    }
+
+    SensorAggregateCodec::Accumulator windows[kMaxWindowsPerPass];
+    uint16_t entries[kMaxWindowsPerPass] = {};
+    uint32_t windowOffset[kMaxWindowsPerPass + 1] = {};  // tail offset where each window starts
+    uint8_t open = 0;
+    uint32_t openBucket = 0;
+    bool windowClosed = false;  // nothing more of the last window's bucket follows
+
+    typename Cache::PeekCursor cursor = cache.peek_begin();
+    char buf[SensorAggregateCodec::kRecordLen + 1];
+    uint32_t offset = cursor.offset;
+    while (offset < budgetBytes) {
+      size_t len = 0;
+      if (cache.peek_next(cursor, buf, sizeof(buf), len) != CacheReadError::NONE) {
+        break;
+      }
+      RtcSensorRecord sample;
+      SensorAggregateCodec::SensorAggregate agg;
+      uint32_t window = 0;
+      if (Cache::decode_sensor_record(buf, len, sample)) {
+        agg = SensorAggregateCodec::from_sample(sample);
+        window = kWindowSeconds;
+      } else if (SensorAggregateCodec::decode(buf, len, agg)) {
+        window = next_window(agg.window);
+      }
+      if (window == 0 || agg.start <= NTP_VALID_TIMESTAMP_THRESHOLD) {
+        windowClosed = true;
+        break;
+      }
+
+      const uint32_t bucket = agg.start / window;
+      SensorAggregateCodec::Accumulator* acc = (open > 0) ? &windows[open - 1] : nullptr;
+      if (!acc || acc->window != window || bucket != openBucket || acc->count > 0xFFFFU - agg.count) {
+        if (open == kMaxWindowsPerPass) {
+          windowClosed = true;
+          break;
+        }
+        windowOffset[open] = offset;
+        acc = &windows[open++];
+        acc->window = static_cast<uint16_t>(window);
+        openBucket = bucket;
+      }
+      acc->merge(agg);
+      entries[open - 1]++;
+      offset = cursor.offset;
+      ESP.wdtFeed();
+    }
+    windowOffset[open] = offset;
+
+    // A window cut short by the budget is left for the next pass rather than split in two,
+    // unless it is all this pass found.
+    if (!windowClosed && open > 1) {
+      open--;
+    }
+
+    // Offsets only move past whole frames, so a window ending inside a block undercounts what
+    // it frees; that errs towards skipping a pass, never towards growing the lane.
+    const uint32_t appended = open * (SensorAggregateCodec::kRecordLen + Cache::RECORD_OVERHEAD_BYTES);
+    if (open == 0 || appended >= windowOffset[open] - windowOffset[0]) {
+      state.idleSize = used;
+      return result;
+    }
+
+    // In a full cache the appends would trim the very entries being merged, so those are popped
+    // first instead; a crash in between then loses only what the trim would have dropped anyway.
+    const bool popFirst = used + appended > capacityBytes;
+    if (popFirst) {
+      uint16_t total = 0;
+      for (uint8_t i = 0; i < open; ++i) {
+        total = static_cast<uint16_t>(total + entries[i]);
+      }
+      result.entries = static_cast<uint16_t>(cache.pop_many(total));
+      if (result.entries != total) {
+        return result;
+      }
+    }
+
+    uint16_t merged = 0;
+    char record[SensorAggregateCodec::kRecordLen];
+    for (uint8_t i = 0; i < open; ++i) {
+      SensorAggregateCodec::encode(windows[i].finish(), record);
+      if (!cache.write(record, SensorAggregateCodec::kRecordLen)) {
+        break;
+      }
+      merged = static_cast<uint16_t>(merged + entries[i]);
+      result.aggregates++;
+    }
+    if (!popFirst) {
+      result.entries = static_cast<uint16_t>(cache.pop_many(merged));
+    }
+    return result;
+  }
+
+}  // namespace CacheDownsampler
+
+#endif  // CACHE_DOWNSAMPLER_H
@@ -1,34 +1,101 @@
 #include "storage/CacheManager.h"
 
+#if !defined(CACHE_ENGINE_SEGMENTED)
+
 #include <system/ConfigManager.h>
 #include <FS.h>
 #include <LittleFS.h>
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 
 #include "system/Logger.h"
 #include "storage/Paths.h"
+#include "storage/SensorBlockCodec.h"
 #include "support/Crc32.h"
 
 #define CACHE_MAGIC 0xDEADBEEF
+// v4: framed JSON records with sync magic. v5: adds tagged binary sensor records.
+// v6: adds delta blocks and the per-block consumed-sample index (tailSkip).
+#define CACHE_FORMAT_VERSION 6
+#define CACHE_FORMAT_MIN_VERSION 4
 
 #ifndef CACHE_VERIFY_WRITE
 #define CACHE_VERIFY_WRITE 0
 #endif
 
+#ifndef CACHE_CHECKPOINT_SLOTS
+#define CACHE_CHECKPOINT_SLOTS 32
+#endif
+
+// Read-ahead page for ring reads; matches the LittleFS read cache so one refill costs one
+// flash read.
+#ifndef CACHE_READ_PAGE_BYTES
+#define CACHE_READ_PAGE_BYTES 256
+#endif
+
+// Ring size of the priority lane file; 4 KB holds ~190 compact alert samples.
+#ifndef CACHE_PRIORITY_LANE_BYTES
+#define CACHE_PRIORITY_LANE_BYTES 4096
+#endif
+#define CHECKPOINT_MAGIC 0xC4EC1D00
+#define PRIORITY_LANE_MAGIC 0xA1E27A7E
+
 struct CacheHeader {
   uint32_t magic;
   uint32_t head;
   uint32_t tail;
   uint32_t size;
   uint16_t version;
+  uint16_t tailSkip;  // samples already consumed from the delta block at tail (was padding before v6)
   uint32_t crc;
 };
+static_assert(sizeof(CacheHeader) == 24, "CacheHeader size fixes CACHE_DATA_START; keep the layout stable.");
 
 static CacheHeader cacheHeader;
 const uint32_t CACHE_DATA_START = sizeof(CacheHeader);
 
+// Priority lane: the same header + ring layout in its own small file. Keeping it out of
+// /cache.dat means a header rewrite of one lane never copies the other lane's blocks, and
+// the routine file format is unchanged.
+static CacheHeader priorityHeader;
+static bool priorityHeaderDirty = false;
+
+// Ring the record helpers below operate on. Every public entry point selects its lane
+// first; the checkpoint index and trimCacheForWrite() only ever cover the routine lane.
+static CacheHeader* ring = &cacheHeader;
+static uint32_t ringBytes = MAX_CACHE_DATA_SIZE;
+
+// Sparse index of record boundaries seen by write(), saved to Paths::CACHE_INDEX whenever the
+// header is flushed. Recovery jumps to the nearest boundary ahead of a damaged tail instead of
+// scanning the ring byte by byte for RECORD_MAGIC. Slot value 0 means unused.
+struct CheckpointIndex {
+  uint32_t magic;
+  uint16_t next;  // slot overwritten by the next checkpoint
+  uint16_t slots;
+  uint32_t positions[CACHE_CHECKPOINT_SLOTS];
+  uint32_t crc;
+};
+
+static CheckpointIndex checkpointIndex;
+static bool checkpointDirty = false;
+static uint32_t bytesSinceCheckpoint = 0;
+static uint32_t syncScanBytes = 0;  // bytes walked by performSyncScan since boot
+static CacheIoStats ioStats;
+
+// Last file-aligned page read from /cache.dat. A record's magic, length, payload and CRC, and
+// the overlapping chunks of a sync scan, are served from here instead of one seek+read each.
+// Dropped on every data write (trims only move the tail and always precede a write) and
+// whenever the file is reopened.
+struct ReadPage {
+  uint32_t base;  // file offset of buf[0], a multiple of CACHE_READ_PAGE_BYTES
+  uint16_t len;   // valid bytes; 0 = empty
+  uint8_t buf[CACHE_READ_PAGE_BYTES];
+};
+static ReadPage readPage;
+static bool readPageEnabled = true;  // cleared by the native benchmark to measure direct reads
+
 // =========================================================================
 // == FORWARD DECLARATIONS & STATIC HELPERS (MUST BE TOP)
 // =========================================================================
@@ -38,7 +105,9 @@ static constexpr uint32_t SYNC_SCAN_BUDGET_BYTES = 1024;
 static constexpr uint32_t TRIM_BUDGET_BYTES = 2048;
 static constexpr uint16_t CACHE_FLUSH_MUTATION_THRESHOLD = 32;
 static constexpr unsigned long CACHE_FLUSH_MAX_DELAY_MS = 120000UL;
+static constexpr uint32_t CHECKPOINT_INTERVAL_BYTES = MAX_CACHE_DATA_SIZE / CACHE_CHECKPOINT_SLOTS;
 static ScanResult performSyncScan(File& cacheFile, uint32_t budgetBytes);
+static ScanResult recoverSync(File& cacheFile, uint32_t budgetBytes);
 static void advanceTailPointer(uint32_t total_record_size);
 static void updateHeadPointer(uint32_t total_len);
 static bool trimCacheForWrite(File& cacheFile, uint32_t total_len_on_disk);
@@ -53,27 +122,79 @@ static constexpr uint16_t RECORD_MAGIC = 0xA55A;  // Active Error Correction Syn
 static_assert(MAX_PAYLOAD_SIZE + sizeof(uint32_t) + sizeof(uint16_t) + sizeof(RECORD_MAGIC) < MAX_CACHE_DATA_SIZE,
               "FATAL: Record size exceeds Cache Size. Pointer arithmetic will fail.");
 static_assert(MAX_CACHE_DATA_SIZE < 0xFFFFFFFF, "FATAL: Cache size must fit in uint32_t.");
+static_assert(CacheManager::RECORD_OVERHEAD_BYTES == sizeof(RECORD_MAGIC) + sizeof(uint16_t) + sizeof(uint32_t),
+              "RECORD_OVERHEAD_BYTES must match the on-disk record framing.");
+static_assert(CacheManager::SENSOR_BLOCK_MAX_BYTES <= MAX_PAYLOAD_SIZE,
+              "Delta blocks must pass the MAX_PAYLOAD_SIZE record length check.");
+static_assert(CACHE_READ_PAGE_BYTES > 0 && CACHE_READ_PAGE_BYTES <= 4096,
+              "CACHE_READ_PAGE_BYTES must be a non-zero page no larger than a flash sector.");
+static_assert(CACHE_PRIORITY_LANE_BYTES >= 2 * (MAX_PAYLOAD_SIZE + CacheManager::RECORD_OVERHEAD_BYTES),
+              "CACHE_PRIORITY_LANE_BYTES must hold at least two maximum-size records.");
 
 static uint32_t calculate_header_crc(const CacheHeader& header) {
   return Crc32::compute((const uint8_t*)&header, offsetof(CacheHeader, crc));
 }
 
+static void invalidateReadPage() {
+  readPage.len = 0;
+}
+
+static void selectLane(CacheLane lane) {
+  CacheHeader* const selected = (lane == CacheLane::PRIORITY) ? &priorityHeader : &cacheHeader;
+  if (selected != ring) {
+    invalidateReadPage();  // the page belongs to the other lane's file
+  }
+  ring = selected;
+  ringBytes = (lane == CacheLane::PRIORITY) ? CACHE_PRIORITY_LANE_BYTES : MAX_CACHE_DATA_SIZE;
+}
+
+// Reads a span that does not cross the wrap point. Whatever the page holds is copied out;
+// the rest refills the page one aligned page at a time, except that a remainder of a whole
+// page or more (large payloads, read_many windows) is read straight from the file.
+static size_t readSpan(File& file, uint32_t pos, uint8_t* buf, size_t len) {
+  if (!readPageEnabled) {
+    file.seek(pos);
+    return file.read(buf, len);
+  }
+  size_t done = 0;
+  while (done < len) {
+    const uint32_t at = pos + static_cast<uint32_t>(done);
+    if (readPage.len == 0 || at < readPage.base || at >= readPage.base + readPage.len) {
+      if (len - done >= CACHE_READ_PAGE_BYTES) {
+        file.seek(at);
+        return done + file.read(buf + done, len - done);
+      }
+      const uint32_t base = at - (at % CACHE_READ_PAGE_BYTES);
+      const uint32_t dataEnd = CACHE_DATA_START + ringBytes;
+      file.seek(base);
+      readPage.base = base;
+      const size_t want = std::min<uint32_t>(CACHE_READ_PAGE_BYTES, dataEnd - base);
+      readPage.len = static_cast<uint16_t>(file.read(readPage.buf, want));
+      if (at >= readPage.base + readPage.len) {
+        return done;  // past the end of the file
+      }
+    }
+    const size_t n = std::min<size_t>(len - done, readPage.base + readPage.len - at);
+    memcpy(buf + done, readPage.buf + (at - readPage.base), n);
+    done += n;
+  }
+  return done;
+}
+
 static size_t readWithWrap(File& file, uint32_t pos, uint8_t* buf, size_t len) {
   if (pos < CACHE_DATA_START)
     return 0;
 
-  pos = CACHE_DATA_START + (pos - CACHE_DATA_START) % MAX_CACHE_DATA_SIZE;
-  file.seek(pos);
+  pos = CACHE_DATA_START + (pos - CACHE_DATA_START) % ringBytes;
 
-  uint32_t space_before_wrap = (CACHE_DATA_START + MAX_CACHE_DATA_SIZE) - pos;
+  uint32_t space_before_wrap = (CACHE_DATA_START + ringBytes) - pos;
   if (len <= space_before_wrap) {
-    return file.read(buf, len);
+    return readSpan(file, pos, buf, len);
   } else {
-    size_t bytes_read = file.read(buf, space_before_wrap);
-    file.seek(CACHE_DATA_START);
+    size_t bytes_read = readSpan(file, pos, buf, space_before_wrap);
     // Only continue reading if we got what we requested
     if (bytes_read == space_before_wrap) {
-      bytes_read += file.read(buf + space_before_wrap, len - space_before_wrap);
+      bytes_read += readSpan(file, CACHE_DATA_START, buf + space_before_wrap, len - space_before_wrap);
     }
     return bytes_read;
   }
@@ -82,11 +203,12 @@ static size_t readWithWrap(File& file, uint32_t pos, uint8_t* buf, size_t len) {
 static size_t writeWithWrap(File& file, uint32_t pos, const uint8_t* buf, size_t len) {
   if (pos < CACHE_DATA_START)
     return 0;
+  invalidateReadPage();
 
-  pos = CACHE_DATA_START + (pos - CACHE_DATA_START) % MAX_CACHE_DATA_SIZE;
+  pos = CACHE_DATA_START + (pos - CACHE_DATA_START) % ringBytes;
   file.seek(pos);
 
-  uint32_t space_before_wrap = (MAX_CACHE_DATA_SIZE + CACHE_DATA_START) - pos;
+  uint32_t space_before_wrap = (CACHE_DATA_START + ringBytes) - pos;
   if (len <= space_before_wrap) {
     return file.write(buf, len);
   } else {
@@ -106,7 +228,7 @@ static bool verifyWithWrap(File& file, uint32_t pos, const uint8_t* expectedBuf,
     return false;
 
   // Align position to wrap boundary immediately
-  uint32_t logical_pos = CACHE_DATA_START + (pos - CACHE_DATA_START) % MAX_CACHE_DATA_SIZE;
+  uint32_t logical_pos = CACHE_DATA_START + (pos - CACHE_DATA_START) % ringBytes;
 
   uint8_t verifyBuf[64];
   size_t remaining = len;
@@ -146,9 +268,38 @@ static bool writeCacheHeader(File& file) {
     return false;
   cacheHeader.crc = calculate_header_crc(cacheHeader);
   file.seek(0);
+  ioStats.headerWrites++;
   return (file.write((uint8_t*)&cacheHeader, sizeof(CacheHeader)) == sizeof(CacheHeader));
 }
 
+static bool readPriorityHeader(File& file) {
+  file.seek(0);
+  return file.read((uint8_t*)&priorityHeader, sizeof(CacheHeader)) == sizeof(CacheHeader) &&
+         priorityHeader.magic == PRIORITY_LANE_MAGIC && priorityHeader.version == CACHE_FORMAT_VERSION &&
+         calculate_header_crc(priorityHeader) == priorityHeader.crc && priorityHeader.head >= CACHE_DATA_START &&
+         priorityHeader.head < CACHE_DATA_START + CACHE_PRIORITY_LANE_BYTES &&
+         priorityHeader.tail >= CACHE_DATA_START && priorityHeader.tail < CACHE_DATA_START + CACHE_PRIORITY_LANE_BYTES &&
+         priorityHeader.size <= CACHE_PRIORITY_LANE_BYTES;
+}
+
+static bool writePriorityHeader(File& file) {
+  if (!file)
+    return false;
+  priorityHeader.crc = calculate_header_crc(priorityHeader);
+  file.seek(0);
+  ioStats.headerWrites++;
+  return (file.write((uint8_t*)&priorityHeader, sizeof(CacheHeader)) == sizeof(CacheHeader));
+}
+
+static void resetPriorityHeader() {
+  priorityHeader.magic = PRIORITY_LANE_MAGIC;
+  priorityHeader.version = CACHE_FORMAT_VERSION;
+  priorityHeader.tailSkip = 0;
+  priorityHeader.head = CACHE_DATA_START;
+  priorityHeader.tail = CACHE_DATA_START;
+  priorityHeader.size = 0;
+}
+
 // --- Additional helpers for complexity reduction ---
 
 static bool writeRecordData(
@@ -201,52 +352,53 @@ static bool verifyRecordData(
 #endif  // CACHE_VERIFY_WRITE
 
 static void updateHeadPointer(uint32_t total_len) {
-  uint32_t final_pos = cacheHeader.head + total_len;
-  if (final_pos >= (CACHE_DATA_START + MAX_CACHE_DATA_SIZE)) {
-    cacheHeader.head = CACHE_DATA_START + (final_pos - (CACHE_DATA_START + MAX_CACHE_DATA_SIZE));
+  uint32_t final_pos = ring->head + total_len;
+  if (final_pos >= (CACHE_DATA_START + ringBytes)) {
+    ring->head = CACHE_DATA_START + (final_pos - (CACHE_DATA_START + ringBytes));
   } else {
-    cacheHeader.head = final_pos;
+    ring->head = final_pos;
   }
-  cacheHeader.size += total_len;
+  ring->size += total_len;
 
   // RUNTIME INVARIANT CHECK (Formal Safety)
-  if (cacheHeader.head < CACHE_DATA_START || cacheHeader.head >= CACHE_DATA_START + MAX_CACHE_DATA_SIZE) {
-    LOG_ERROR("CACHE", F("CRITICAL: Head out of bounds (0x%08X). Resetting."), cacheHeader.head);
-    cacheHeader.head = CACHE_DATA_START;
-    cacheHeader.tail = CACHE_DATA_START;
-    cacheHeader.size = 0;
+  if (ring->head < CACHE_DATA_START || ring->head >= CACHE_DATA_START + ringBytes) {
+    LOG_ERROR("CACHE", F("CRITICAL: Head out of bounds (0x%08X). Resetting."), ring->head);
+    ring->head = CACHE_DATA_START;
+    ring->tail = CACHE_DATA_START;
+    ring->size = 0;
   }
 }
 
 static void advanceTailPointer(uint32_t total_record_size) {
-  uint32_t new_tail = cacheHeader.tail + total_record_size;
-  if (new_tail >= MAX_CACHE_DATA_SIZE + CACHE_DATA_START) {
-    cacheHeader.tail = CACHE_DATA_START + (new_tail - (MAX_CACHE_DATA_SIZE + CACHE_DATA_START));
+  ring->tailSkip = 0;  // any tail move leaves the partially consumed block behind
+  uint32_t new_tail = ring->tail + total_record_size;
+  if (new_tail >= CACHE_DATA_START + ringBytes) {
+    ring->tail = CACHE_DATA_START + (new_tail - (CACHE_DATA_START + ringBytes));
   } else {
-    cacheHeader.tail = new_tail;
+    ring->tail = new_tail;
   }
 
   // RUNTIME INVARIANT CHECK (Formal Safety)
-  if (cacheHeader.tail < CACHE_DATA_START || cacheHeader.tail >= CACHE_DATA_START + MAX_CACHE_DATA_SIZE) {
-    LOG_ERROR("CACHE", F("CRITICAL INVARIANT VIOLATION: Tail out of bounds (0x%08X). Resetting."), cacheHeader.tail);
+  if (ring->tail < CACHE_DATA_START || ring->tail >= CACHE_DATA_START + ringBytes) {
+    LOG_ERROR("CACHE", F("CRITICAL INVARIANT VIOLATION: Tail out of bounds (0x%08X). Resetting."), ring->tail);
     // We cannot call resetImpl() here because it's static and needs instance context?
     // Actually resetImpl accesses static cacheHeader but needs m_file object.
     // Since this is critical failure, we force size=0 (Empty) to prevent OOB access.
-    cacheHeader.head = CACHE_DATA_START;
-    cacheHeader.tail = CACHE_DATA_START;
-    cacheHeader.size = 0;
+    ring->head = CACHE_DATA_START;
+    ring->tail = CACHE_DATA_START;
+    ring->size = 0;
     return;
   }
 
-  if (cacheHeader.size < total_record_size) {
-    cacheHeader.size = 0;
+  if (ring->size < total_record_size) {
+    ring->size = 0;
   } else {
-    cacheHeader.size -= total_record_size;
+    ring->size -= total_record_size;
   }
 
-  if (cacheHeader.size == 0) {
-    cacheHeader.head = CACHE_DATA_START;
-    cacheHeader.tail = CACHE_DATA_START;
+  if (ring->size == 0) {
+    ring->head = CACHE_DATA_START;
+    ring->tail = CACHE_DATA_START;
   }
 }
 
@@ -265,10 +417,10 @@ static ScanResult performSyncScan(File& cacheFile, uint32_t budgetBytes) {
   // We scan until we find MAGIC or run out of data
   // record MAGIC is 2 bytes.
 
-  while (cacheHeader.size > sizeof(RECORD_MAGIC)) {
+  while (ring->size > sizeof(RECORD_MAGIC)) {
     // Determine how much to read (up to local buffer size)
     // We must read at least sizeof(magic) to check.
-    size_t chunk = std::min((size_t)cacheHeader.size, SCAN_BUF_SIZE);
+    size_t chunk = std::min((size_t)ring->size, SCAN_BUF_SIZE);
     if (!unlimited) {
       if (bytesScanned >= budgetBytes)
         return ScanResult::NEED_MORE;
@@ -285,7 +437,7 @@ static ScanResult performSyncScan(File& cacheFile, uint32_t budgetBytes) {
     // readWithWrap reads from 'logical tail'.
 
     // Logic: Read chunk from current tail.
-    size_t actual = readWithWrap(cacheFile, cacheHeader.tail, buf, chunk);
+    size_t actual = readWithWrap(cacheFile, ring->tail, buf, chunk);
     if (actual < sizeof(RECORD_MAGIC))
       return ScanResult::EMPTY;  // Should not happen given buffer check
 
@@ -305,6 +457,7 @@ static ScanResult performSyncScan(File& cacheFile, uint32_t budgetBytes) {
         // FOUND!
         // Advance tail by 'i' bytes to align exactly on Magic
         advanceTailPointer(i);
+        syncScanBytes += static_cast<uint32_t>(i);
         LOG_INFO("CACHE", F("Sync: Found Magic at offset +%u"), i);
         return ScanResult::FOUND;
       }
@@ -322,6 +475,7 @@ static ScanResult performSyncScan(File& cacheFile, uint32_t budgetBytes) {
     size_t step = actual - 1;
     advanceTailPointer(step);
     bytesScanned += step;
+    syncScanBytes += static_cast<uint32_t>(step);
     if (!unlimited && bytesScanned >= budgetBytes)
       return ScanResult::NEED_MORE;
 
@@ -333,13 +487,137 @@ static ScanResult performSyncScan(File& cacheFile, uint32_t budgetBytes) {
   }
 
   // If we are here, we exhausted the cache scanning for magic.
-  if (cacheHeader.size <= sizeof(RECORD_MAGIC)) {
+  if (ring->size <= sizeof(RECORD_MAGIC)) {
     LOG_WARN("CACHE", F("Sync: Failed. Cache exhausted."));
-    advanceTailPointer(cacheHeader.size);  // Clear all
+    advanceTailPointer(ring->size);  // Clear all
   }
   return ScanResult::EMPTY;
 }
 
+static void resetCheckpoints() {
+  memset(&checkpointIndex, 0, sizeof(checkpointIndex));
+  checkpointIndex.magic = CHECKPOINT_MAGIC;
+  checkpointIndex.slots = CACHE_CHECKPOINT_SLOTS;
+  checkpointDirty = true;
+  bytesSinceCheckpoint = 0;
+}
+
+static void loadCheckpoints() {
+  bytesSinceCheckpoint = 0;
+  File indexFile = LittleFS.open(Paths::CACHE_INDEX, "r");
+  const bool ok = indexFile &&
+                  indexFile.read((uint8_t*)&checkpointIndex, sizeof(checkpointIndex)) == sizeof(checkpointIndex) &&
+                  checkpointIndex.magic == CHECKPOINT_MAGIC && checkpointIndex.slots == CACHE_CHECKPOINT_SLOTS &&
+                  checkpointIndex.next < CACHE_CHECKPOINT_SLOTS &&
+                  checkpointIndex.crc ==
+                      Crc32::compute((const uint8_t*)&checkpointIndex, offsetof(CheckpointIndex, crc));
+  if (indexFile)
+    indexFile.close();
+  if (!ok) {
+    resetCheckpoints();
+    return;
+  }
+  checkpointDirty = false;
+}
+
+static void saveCheckpoints() {
+  if (!checkpointDirty)
+    return;
+  checkpointIndex.crc = Crc32::compute((const uint8_t*)&checkpointIndex, offsetof(CheckpointIndex, crc));
+  File indexFile = LittleFS.open(Paths::CACHE_INDEX, "w");
+  if (!indexFile)
+    return;
+  ioStats.headerWrites++;
+  if (indexFile.write((const uint8_t*)&checkpointIndex, sizeof(checkpointIndex)) == sizeof(checkpointIndex))
+    checkpointDirty = false;
+  indexFile.close();
+}
+
+// Called with the start of every record written; keeps one boundary per interval.
+static void noteCheckpoint(uint32_t record_pos, uint32_t record_bytes) {
+  bytesSinceCheckpoint += record_bytes;
+  if (bytesSinceCheckpoint < CHECKPOINT_INTERVAL_BYTES)
+    return;
+  bytesSinceCheckpoint = 0;
+  checkpointIndex.positions[checkpointIndex.next] = record_pos;
+  checkpointIndex.next = static_cast<uint16_t>((checkpointIndex.next + 1) % CACHE_CHECKPOINT_SLOTS);
+  checkpointDirty = true;
+}
+
+// A checkpoint is only trusted if a whole record still verifies there.
+static bool verifyRecordAt(File& cacheFile, uint32_t pos) {
+  uint16_t frame[2];
+  if (readWithWrap(cacheFile, pos, (uint8_t*)frame, sizeof(frame)) != sizeof(frame))
+    return false;
+  const uint16_t record_len = frame[1];
+  if (frame[0] != RECORD_MAGIC || record_len == 0 || record_len > MAX_PAYLOAD_SIZE)
+    return false;
+  uint8_t payload[MAX_PAYLOAD_SIZE];
+  uint32_t stored_crc;
+  if (readWithWrap(cacheFile, pos + sizeof(frame), payload, record_len) != record_len ||
+      readWithWrap(cacheFile, pos + sizeof(frame) + record_len, (uint8_t*)&stored_crc, sizeof(stored_crc)) !=
+          sizeof(stored_crc))
+    return false;
+  return Crc32::compute(payload, record_len) == stored_crc;
+}
+
+// Moves the tail to the nearest indexed boundary ahead of it that still verifies.
+static bool jumpToCheckpoint(File& cacheFile) {
+  if (ring != &cacheHeader)
+    return false;
+  uint32_t floor = 0;
+  for (uint16_t attempt = 0; attempt < CACHE_CHECKPOINT_SLOTS; ++attempt) {
+    uint32_t best = UINT32_MAX;
+    for (uint16_t slot = 0; slot < CACHE_CHECKPOINT_SLOTS; ++slot) {
+      const uint32_t pos = checkpointIndex.positions[slot];
+      if (pos < CACHE_DATA_START || pos >= CACHE_DATA_START + ringBytes)
+        continue;
+      const uint32_t distance = (pos + ringBytes - ring->tail) % ringBytes;
+      if (distance > floor && distance < best &&
+          distance + CacheManager::RECORD_OVERHEAD_BYTES <= ring->size)
+        best = distance;
+    }
+    if (best == UINT32_MAX)
+      return false;
+    if (verifyRecordAt(cacheFile, ring->tail + best)) {
+      LOG_WARN("CACHE", F("Sync: Jumped %u bytes to checkpoint."), best);
+      advanceTailPointer(best);
+      return true;
+    }
+    floor = best;
+  }
+  return false;
+}
+
+// Resync order: a record-sized local scan (a single damaged record loses nothing more), then
+// the checkpoint index, and only then the budgeted byte scan.
+static ScanResult recoverSync(File& cacheFile, uint32_t budgetBytes) {
+  const ScanResult local = performSyncScan(cacheFile, MAX_PAYLOAD_SIZE + CacheManager::RECORD_OVERHEAD_BYTES);
+  if (local != ScanResult::NEED_MORE)
+    return local;
+  if (jumpToCheckpoint(cacheFile))
+    return ScanResult::FOUND;
+  return performSyncScan(cacheFile, budgetBytes);
+}
+
+// Narrows a delta block read from the tail to the sample selected by tailSkip, rewritten
+// in place as a compact record. Non-block records pass through untouched.
+static bool selectTailBlockSample(char* buf, size_t buffer_size, size_t& len) {
+  const uint8_t count = SensorBlockCodec::sample_count((const uint8_t*)buf, len);
+  if (count == 0)
+    return true;
+
+  RtcSensorRecord sample;
+  if (ring->tailSkip >= count || buffer_size < CacheManager::SENSOR_RECORD_LEN ||
+      !SensorBlockCodec::decode_at((const uint8_t*)buf, len, static_cast<uint8_t>(ring->tailSkip), sample)) {
+    return false;
+  }
+  buf[0] = static_cast<char>(CacheManager::SENSOR_RECORD_TAG);
+  memcpy(buf + 1, &sample, sizeof(sample));
+  len = CacheManager::SENSOR_RECORD_LEN;
+  return true;
+}
+
 // =========================================================================
 // == CLASS IMPLEMENTATION
 // =========================================================================
@@ -349,6 +627,7 @@ CacheManager::CacheManager() {}
 void CacheManager::initImpl() {
   if (m_file)
     return;  // Already open
+  invalidateReadPage();
 
   if (!LittleFS.exists(Paths::CACHE_FILE)) {
     m_file = LittleFS.open(Paths::CACHE_FILE, "w+");
@@ -358,13 +637,16 @@ void CacheManager::initImpl() {
     }
 
     cacheHeader.magic = CACHE_MAGIC;
-    cacheHeader.version = 4;  // Version 4: Added Magic Byte
+    cacheHeader.version = CACHE_FORMAT_VERSION;
+    cacheHeader.tailSkip = 0;
     cacheHeader.head = CACHE_DATA_START;
     cacheHeader.tail = CACHE_DATA_START;
     cacheHeader.size = 0;
     if (!writeCacheHeader(m_file)) {
       return;
     }
+    resetCheckpoints();
+    saveCheckpoints();
   } else {
     m_file = LittleFS.open(Paths::CACHE_FILE, "r+");
     if (!m_file) {
@@ -372,43 +654,122 @@ void CacheManager::initImpl() {
       return;
     }
 
-    if (!readCacheHeader(m_file) || cacheHeader.magic != CACHE_MAGIC || cacheHeader.version < 4 ||
+    if (!readCacheHeader(m_file) || cacheHeader.magic != CACHE_MAGIC ||
+        cacheHeader.version < CACHE_FORMAT_MIN_VERSION || cacheHeader.version > CACHE_FORMAT_VERSION ||
         calculate_header_crc(cacheHeader) != cacheHeader.crc) {
       LOG_ERROR("CACHE", F("Cache header invalid. Resetting."));
       m_file.close();
       resetImpl();
       return;
     }
+    if (cacheHeader.version < CACHE_FORMAT_VERSION) {
+      // Older files hold only record types this version still reads; just stamp the new version.
+      LOG_INFO("CACHE", F("Upgrading cache header v%u -> v%u"), cacheHeader.version, CACHE_FORMAT_VERSION);
+      cacheHeader.version = CACHE_FORMAT_VERSION;
+      cacheHeader.tailSkip = 0;
+      if (writeCacheHeader(m_file)) {
+        m_file.flush();
+      }
+    }
+    loadCheckpoints();
   }
+  openPriorityLane();
   m_dirty = false;
+  priorityHeaderDirty = false;
   m_pendingMutations = 0;
   m_lastFlushMs = millis();
-  LOG_INFO("CACHE", F("Init OK. Size: %u bytes"), cacheHeader.size);
+
+  // A dirty shutdown can leave the persisted tail inside a record that was trimmed and
+  // overwritten afterwards; realign now so the first upload does not start with a scan.
+  // Lazy opens happen inside read/pop calls, so hand the caller its lane back afterwards.
+  const CacheLane callerLane = (ring == &priorityHeader) ? CacheLane::PRIORITY : CacheLane::ROUTINE;
+  for (const CacheLane lane : {CacheLane::PRIORITY, CacheLane::ROUTINE}) {
+    selectLane(lane);
+    File& file = laneFile();
+    uint16_t tailMagic = 0;
+    if (file && ring->size > 0 &&
+        readWithWrap(file, ring->tail, (uint8_t*)&tailMagic, sizeof(tailMagic)) == sizeof(tailMagic) &&
+        tailMagic != RECORD_MAGIC) {
+      LOG_WARN("CACHE", F("Tail out of sync after restart. Recovering..."));
+      (void)recoverSync(file, SYNC_SCAN_BUDGET_BYTES);
+      markDirty();
+    }
+  }
+  selectLane(callerLane);
+  LOG_INFO("CACHE", F("Init OK. Size: %u bytes (priority %u)"), cacheHeader.size, priorityHeader.size);
 }
 
 void CacheManager::resetImpl() {
   LOG_WARN("CACHE", F("Resetting cache file..."));
+  ioStats.resets++;
   if (m_file)
     m_file.close();
+  if (m_priorityFile)
+    m_priorityFile.close();
   LittleFS.remove(Paths::CACHE_FILE);
+  LittleFS.remove(Paths::CACHE_INDEX);
+  LittleFS.remove(Paths::CACHE_PRIORITY_FILE);
   initImpl();
 }
 
+// A missing or damaged lane file only costs the alerts queued in it; the routine ring is kept.
+void CacheManager::openPriorityLane() {
+  if (m_priorityFile)
+    m_priorityFile.close();
+  if (LittleFS.exists(Paths::CACHE_PRIORITY_FILE)) {
+    m_priorityFile = LittleFS.open(Paths::CACHE_PRIORITY_FILE, "r+");
+    if (m_priorityFile && readPriorityHeader(m_priorityFile))
+      return;
+    LOG_WARN("CACHE", F("Priority lane header invalid. Resetting lane."));
+    if (m_priorityFile)
+      m_priorityFile.close();
+  }
+  m_priorityFile = LittleFS.open(Paths::CACHE_PRIORITY_FILE, "w+");
+  if (!m_priorityFile) {
+    LOG_ERROR("CACHE", F("Failed to create priority lane file!"));
+    return;
+  }
+  resetPriorityHeader();
+  if (writePriorityHeader(m_priorityFile))
+    m_priorityFile.flush();
+}
+
+File& CacheManager::laneFile() {
+  return (ring == &priorityHeader) ? m_priorityFile : m_file;
+}
+
 void CacheManager::flush() {
   if (!m_dirty || !m_file)
     return;
 
+  const uint32_t started = micros();
   if (writeCacheHeader(m_file)) {
     m_file.flush();
+    if (priorityHeaderDirty && writePriorityHeader(m_priorityFile)) {
+      m_priorityFile.flush();
+      priorityHeaderDirty = false;
+    }
+    saveCheckpoints();
     m_dirty = false;
     m_pendingMutations = 0;
     m_lastFlushMs = millis();
     // LOG_DEBUG("CACHE", F("Header flushed."));
   }
+  ioStats.flushes++;
+  ioStats.flushMicros += micros() - started;
+}
+
+CacheDownsampler::PassResult CacheManager::downsample_step(uint32_t budgetBytes) {
+  const CacheDownsampler::PassResult pass = CacheDownsampler::step(*this, m_downsample, MAX_CACHE_DATA_SIZE, budgetBytes);
+  ioStats.downsampledEntries += pass.entries;
+  return pass;
 }
 
 void CacheManager::markDirty() {
   m_dirty = true;
+  if (ring == &priorityHeader) {
+    priorityHeaderDirty = true;
+  }
   if (m_pendingMutations < 0xFFFFu) {
     m_pendingMutations++;
   }
@@ -425,6 +786,7 @@ void CacheManager::markDirty() {
 
 // Pass file handle to prevent race conditions during file operations.
 // Returns true if cache was trimmed successfully.
+// Evicts from the routine lane only (selected by the caller); queued alerts are never trimmed.
 static bool trimCacheForWrite(File& cacheFile, uint32_t total_len_on_disk) {
   if (cacheHeader.size + total_len_on_disk <= REDACTED
     return true;
@@ -453,7 +815,7 @@ static bool trimCacheForWrite(File& cacheFile, uint32_t total_len_on_disk) {
     // ACTIVE ERROR CORRECTION: Sync Loss Detection
     if (magic != RECORD_MAGIC) {
       LOG_WARN("CACHE", F("Trim: Sync Loss (0x%04X). Resyncing..."), magic);
-      ScanResult scan = performSyncScan(cacheFile, SYNC_SCAN_BUDGET_BYTES);
+      ScanResult scan = recoverSync(cacheFile, SYNC_SCAN_BUDGET_BYTES);
       if (scan == ScanResult::FOUND) {
         // Found valid record!
         // CRITICAL FIX: Do NOT pop it immediately.
@@ -516,16 +878,19 @@ static bool tryWriteWithRetry(File& cacheFile, const char* data, uint16_t record
 
   for (int attempt = 1; attempt <= MAX_RETRIES; attempt++) {
     ESP.wdtFeed();
+    if (attempt > 1) {
+      ioStats.writeRetries++;
+    }
 
     // 1. Write Data
-    if (!writeRecordData(cacheFile, cacheHeader.head, data, record_len, payload_crc)) {
+    if (!writeRecordData(cacheFile, ring->head, data, record_len, payload_crc)) {
       continue;  // Write failed (e.g. FS full or hardware error), retry
     }
 
     // 2. Validate (Read-Back) - MAXIMUM SAFETY
 #if CACHE_VERIFY_WRITE
     cacheFile.flush();  // Ensure physically on media before reading back
-    if (verifyRecordData(cacheFile, cacheHeader.head, data, record_len, payload_crc)) {
+    if (verifyRecordData(cacheFile, ring->head, data, record_len, payload_crc)) {
       return true;  // Success!
     }
 
@@ -544,7 +909,7 @@ static bool tryWriteWithRetry(File& cacheFile, const char* data, uint16_t record
 // Main Write Operation
 // =============================================================================
 
-bool CacheManager::writeImpl(const char* data, uint16_t len) {
+bool CacheManager::writeImpl(const char* data, uint16_t len, CacheLane lane) {
   if (len == 0)
     return true;
   if (!m_file)
@@ -558,7 +923,25 @@ bool CacheManager::writeImpl(const char* data, uint16_t len) {
 
   // OPTIMIZATION: Removed hasFilesystemSpace check (O(N) overhead)
 
-  if (!trimCacheForWrite(m_file, total_len_on_disk)) {
+  // An alert that does not fit the priority lane takes the routine path, so a full cache
+  // gives up routine samples before any queued alert.
+  selectLane(lane);
+  if (lane == CacheLane::PRIORITY && priorityHeader.size + total_len_on_disk > CACHE_PRIORITY_LANE_BYTES) {
+    LOG_WARN("CACHE", F("Priority lane full (%u bytes). Storing alert in routine lane."), priorityHeader.size);
+    selectLane(CacheLane::ROUTINE);
+  }
+  const bool routineLane = (ring == &cacheHeader);
+
+  const uint32_t started = micros();
+  const uint32_t sizeBefore = cacheHeader.size;
+  const bool needsTrim = routineLane && sizeBefore + total_len_on_disk > MAX_CACHE_DATA_SIZE;
+  const bool trimmed = !routineLane || trimCacheForWrite(m_file, total_len_on_disk);
+  if (needsTrim) {
+    ioStats.trims++;
+    ioStats.trimmedBytes += sizeBefore - cacheHeader.size;
+    ioStats.trimMicros += micros() - started;
+  }
+  if (!trimmed) {
     LOG_ERROR("CACHE", F("Failed to trim cache (Full/Corrupt). Write aborted."));
     // NO RESET. Preserve existing data.
     // If the cache is physically broken or full of untouchable garbage, we just stop writing new data.
@@ -566,17 +949,26 @@ bool CacheManager::writeImpl(const char* data, uint16_t len) {
     return false;
   }
 
-  if (cacheHeader.size + total_len_on_disk > MAX_CACHE_DATA_SIZE) {
+  if (ring->size + total_len_on_disk > ringBytes) {
     LOG_ERROR("CACHE", F("Record is too large to fit in cache."));
     return false;
   }
 
   // Write with retry
-  if (!tryWriteWithRetry(m_file, data, record_len, payload_crc)) {
+  const uint32_t appendStarted = micros();
+  const bool written = tryWriteWithRetry(laneFile(), data, record_len, payload_crc);
+  ioStats.writeMicros += micros() - appendStarted;
+  if (!written) {
     return false;
   }
 
+  if (routineLane) {
+    noteCheckpoint(cacheHeader.head, total_len_on_disk);
+  }
   updateHeadPointer(total_len_on_disk);
+  ioStats.appends++;
+  ioStats.logicalBytes += record_len;
+  ioStats.framedBytes += total_len_on_disk;
 
   // POWER SAFETY: Write header but DELAY flushing to reduce wear
   // We only set the dirty flag. The background timer (30min) or shutdown will flush.
@@ -584,23 +976,29 @@ bool CacheManager::writeImpl(const char* data, uint16_t len) {
   // m_file.flush();
   // }
   markDirty();
+  const uint32_t elapsed = micros() - started;
+  if (elapsed > ioStats.maxWriteMicros) {
+    ioStats.maxWriteMicros = elapsed;
+  }
   return true;
 }
 
-CacheReadError CacheManager::read_oneImpl(char* out_buffer, size_t buffer_size, size_t& out_len) {
+CacheReadError CacheManager::read_oneImpl(char* out_buffer, size_t buffer_size, size_t& out_len, CacheLane lane) {
   out_len = 0;
-  if (cacheHeader.size == 0) {
+  selectLane(lane);
+  if (ring->size == 0) {
     return CacheReadError::CACHE_EMPTY;
   }
 
   if (!m_file)
     initImpl();
-  if (!m_file)
+  File& file = laneFile();
+  if (!file)
     return CacheReadError::FILE_READ_ERROR;
 
   // 1. Verify Magic
   uint16_t magic;
-  if (readWithWrap(m_file, cacheHeader.tail, (uint8_t*)&magic, sizeof(magic)) != sizeof(magic)) {
+  if (readWithWrap(file, ring->tail, (uint8_t*)&magic, sizeof(magic)) != sizeof(magic)) {
     return CacheReadError::FILE_READ_ERROR;
   }
 
@@ -612,26 +1010,29 @@ CacheReadError CacheManager::read_oneImpl(char* out_buffer, size_t buffer_size,
     bool salvaged = false;
     uint16_t presumed_len;
     // Peek at length (offset 2 bytes)
-    if (readWithWrap(m_file, cacheHeader.tail + sizeof(RECORD_MAGIC), (uint8_t*)&presumed_len, sizeof(presumed_len)) ==
+    if (readWithWrap(file, ring->tail + sizeof(RECORD_MAGIC), (uint8_t*)&presumed_len, sizeof(presumed_len)) ==
         sizeof(presumed_len)) {
       if (presumed_len > 0 && presumed_len <= MAX_PAYLOAD_SIZE) {
         // Length looks sanity. Let's try to verify CRC.
         // We need to read presumed data + CRC
-        uint32_t check_offset = cacheHeader.tail + sizeof(RECORD_MAGIC) + sizeof(presumed_len);
+        uint32_t check_offset = ring->tail + sizeof(RECORD_MAGIC) + sizeof(presumed_len);
         uint32_t stored_crc_offset = check_offset + presumed_len;
         uint32_t stored_crc;
 
         // Read stored CRC
-        if (readWithWrap(m_file, stored_crc_offset, (uint8_t*)&stored_crc, sizeof(stored_crc)) == sizeof(stored_crc)) {
+        if (readWithWrap(file, stored_crc_offset, (uint8_t*)&stored_crc, sizeof(stored_crc)) == sizeof(stored_crc)) {
           // We can't really "verify" CRC without reading data into buffer.
           // But we are in read_oneImpl, so we HAVE the buffer!
           if (presumed_len <= buffer_size) {
-            readWithWrap(m_file, check_offset, (uint8_t*)out_buffer, presumed_len);
+            readWithWrap(file, check_offset, (uint8_t*)out_buffer, presumed_len);
             uint32_t calc_crc = Crc32::compute((const uint8_t*)out_buffer, presumed_len);
             if (calc_crc == stored_crc) {
               LOG_WARN("CACHE", F("Deep Recovery: Magic corrupt (0x%04X) but CRC OK! Salvaging."), magic);
               out_len = presumed_len;
-              salvaged = true;
+              salvaged = selectTailBlockSample(out_buffer, buffer_size, out_len);
+              if (!salvaged) {
+                out_len = 0;
+              }
             }
           }
         }
@@ -643,7 +1044,7 @@ CacheReadError CacheManager::read_oneImpl(char* out_buffer, size_t buffer_size,
       // We must SKIP this specific bad area to find the next valid record.
       LOG_WARN("CACHE", F("Read: Sync Loss & Recovery Failed. Resyncing..."));
 
-      ScanResult scan = performSyncScan(m_file, SYNC_SCAN_BUDGET_BYTES);
+      ScanResult scan = recoverSync(file, SYNC_SCAN_BUDGET_BYTES);
       if (scan == ScanResult::FOUND)
         return CacheReadError::CORRUPT_DATA;
       if (scan == ScanResult::NEED_MORE)
@@ -656,7 +1057,7 @@ CacheReadError CacheManager::read_oneImpl(char* out_buffer, size_t buffer_size,
   }
 
   uint16_t record_len;
-  if (readWithWrap(m_file, cacheHeader.tail + sizeof(RECORD_MAGIC), (uint8_t*)&record_len, sizeof(record_len)) !=
+  if (readWithWrap(file, ring->tail + sizeof(RECORD_MAGIC), (uint8_t*)&record_len, sizeof(record_len)) !=
       sizeof(record_len)) {
     LOG_ERROR("CACHE", F("storage/CacheManager::read_one: Failed to read record length."));
     return CacheReadError::FILE_READ_ERROR;
@@ -667,7 +1068,7 @@ CacheReadError CacheManager::read_oneImpl(char* out_buffer, size_t buffer_size,
               F("storage/CacheManager::read_one: Invalid record length %u (Max: %u). Discarding corrupted record."),
               record_len,
               MAX_PAYLOAD_SIZE);
-    (void)pop_one();
+    (void)pop_oneImpl(lane);
     return CacheReadError::CORRUPT_DATA;
   }
 
@@ -677,8 +1078,8 @@ CacheReadError CacheManager::read_oneImpl(char* out_buffer, size_t buffer_size,
     return CacheReadError::OUT_OF_MEMORY;
   }
 
-  uint32_t payload_offset = cacheHeader.tail + sizeof(RECORD_MAGIC) + sizeof(record_len);
-  size_t bytes_read = readWithWrap(m_file, payload_offset, (uint8_t*)out_buffer, record_len);
+  uint32_t payload_offset = ring->tail + sizeof(RECORD_MAGIC) + sizeof(record_len);
+  size_t bytes_read = readWithWrap(file, payload_offset, (uint8_t*)out_buffer, record_len);
 
   if (bytes_read != record_len) {
     LOG_ERROR(
@@ -688,7 +1089,7 @@ CacheReadError CacheManager::read_oneImpl(char* out_buffer, size_t buffer_size,
 
   uint32_t stored_crc;
   uint32_t crc_offset = payload_offset + record_len;
-  if (readWithWrap(m_file, crc_offset, (uint8_t*)&stored_crc, sizeof(stored_crc)) != sizeof(stored_crc)) {
+  if (readWithWrap(file, crc_offset, (uint8_t*)&stored_crc, sizeof(stored_crc)) != sizeof(stored_crc)) {
     LOG_ERROR("CACHE", F("storage/CacheManager::read_one: Failed to read stored CRC."));
     return CacheReadError::FILE_READ_ERROR;
   }
@@ -697,26 +1098,35 @@ CacheReadError CacheManager::read_oneImpl(char* out_buffer, size_t buffer_size,
   if (calculated_crc != stored_crc) {
     LOG_ERROR(
         "CACHE", F("CRC mismatch! Data corrupted. Stored: 0x%08X, Calc: 0x%08X. Discarding."), stored_crc, calculated_crc);
-    (void)pop_oneImpl();
+    (void)pop_oneImpl(lane);
     return CacheReadError::CORRUPT_DATA;
   }
 
   out_len = record_len;
+  if (!selectTailBlockSample(out_buffer, buffer_size, out_len)) {
+    LOG_ERROR("CACHE", F("Delta block unreadable at sample %u. Discarding block."), ring->tailSkip);
+    advanceTailPointer(record_len + RECORD_OVERHEAD_BYTES);
+    markDirty();
+    out_len = 0;
+    return CacheReadError::CORRUPT_DATA;
+  }
   return CacheReadError::NONE;
 }
 
-bool CacheManager::pop_oneImpl() {
-  if (cacheHeader.size == 0)
+bool CacheManager::pop_oneImpl(CacheLane lane) {
+  selectLane(lane);
+  if (ring->size == 0)
     return true;
 
   if (!m_file)
     initImpl();
-  if (!m_file)
+  File& file = laneFile();
+  if (!file)
     return false;
 
   // 1. Check Magic (Sync Logic)
   uint16_t magic;
-  if (readWithWrap(m_file, cacheHeader.tail, (uint8_t*)&magic, sizeof(magic)) != sizeof(magic)) {
+  if (readWithWrap(file, ring->tail, (uint8_t*)&magic, sizeof(magic)) != sizeof(magic)) {
     // Physical read error? Skip 1 byte and try again next time.
     // Treat as "Popped/Skipped" to avoid infinite loops if the caller keeps calling pop.
     LOG_ERROR("CACHE", F("Pop: Physical Read Error. Skipping 1 byte."));
@@ -727,7 +1137,7 @@ bool CacheManager::pop_oneImpl() {
 
   if (magic != RECORD_MAGIC) {
     LOG_WARN("CACHE", F("Pop: Sync Loss. Resyncing..."));
-    ScanResult scan = performSyncScan(m_file, SYNC_SCAN_BUDGET_BYTES);
+    ScanResult scan = recoverSync(file, SYNC_SCAN_BUDGET_BYTES);
     if (scan == ScanResult::FOUND) {
       // We found valid record. Proceed to pop it (Standard behavior)
       // Fall through to read-len and advance.
@@ -737,7 +1147,7 @@ bool CacheManager::pop_oneImpl() {
   }
 
   uint16_t record_len;
-  if (readWithWrap(m_file, cacheHeader.tail + sizeof(RECORD_MAGIC), (uint8_t*)&record_len, sizeof(record_len)) !=
+  if (readWithWrap(file, ring->tail + sizeof(RECORD_MAGIC), (uint8_t*)&record_len, sizeof(record_len)) !=
       sizeof(record_len)) {
     LOG_ERROR("CACHE", F("Pop: Len Read Fail. Skipping 1 byte."));
     advanceTailPointer(1);
@@ -755,6 +1165,17 @@ bool CacheManager::pop_oneImpl() {
     return true;
   }
 
+  // Delta block: consume one sample; the block itself goes once its last sample is popped.
+  uint8_t blockHead[2];
+  if (record_len <= MAX_PAYLOAD_SIZE &&
+      readWithWrap(file, ring->tail + sizeof(RECORD_MAGIC) + sizeof(record_len), blockHead, sizeof(blockHead)) ==
+          sizeof(blockHead) &&
+      blockHead[0] == SensorBlockCodec::kTag && static_cast<uint32_t>(ring->tailSkip) + 1U < blockHead[1]) {
+    ring->tailSkip++;
+    markDirty();
+    return true;
+  }
+
   uint32_t total_record_size = REDACTED
   advanceTailPointer(total_record_size);
 
@@ -766,12 +1187,286 @@ bool CacheManager::pop_oneImpl() {
   return true;
 }
 
+CacheReadError CacheManager::read_manyImpl(std::span<char> out,
+                                          std::span<uint16_t> lengths,
+                                          size_t maxRecords,
+                                          size_t& outRecords,
+                                          CacheLane lane) {
+  outRecords = 0;
+  selectLane(lane);
+  maxRecords = std::min(maxRecords, lengths.size());
+  if (ring->size == 0)
+    return CacheReadError::CACHE_EMPTY;
+  if (maxRecords == 0 || out.empty())
+    return CacheReadError::OUT_OF_MEMORY;
+
+  if (!m_file)
+    initImpl();
+  File& file = laneFile();
+  if (!file)
+    return CacheReadError::FILE_READ_ERROR;
+
+  // Single forward pass: the window always fits one whole framed record and is only
+  // refilled when the next record runs past it, so reads never seek backwards.
+  uint8_t window[MAX_PAYLOAD_SIZE + RECORD_OVERHEAD_BYTES];
+  uint32_t winStart = 0;
+  size_t winLen = 0;
+  auto ensureWindow = [&](uint32_t offset, size_t len) -> bool {
+    if (offset >= winStart && offset + len <= winStart + winLen)
+      return true;
+    const size_t want = std::min<size_t>(sizeof(window), ring->size - offset);
+    winStart = offset;
+    winLen = readWithWrap(file, ring->tail + offset, window, want);
+    return len <= winLen;
+  };
+
+  CacheReadError status = CacheReadError::NONE;
+  uint32_t offset = 0;
+  uint16_t sample = ring->tailSkip;
+  size_t used = 0;
+  while (outRecords < maxRecords && offset < ring->size) {
+    if (!ensureWindow(offset, sizeof(RECORD_MAGIC) + sizeof(uint16_t))) {
+      status = CacheReadError::FILE_READ_ERROR;
+      break;
+    }
+    uint16_t magic;
+    uint16_t record_len;
+    memcpy(&magic, window + (offset - winStart), sizeof(magic));
+    memcpy(&record_len, window + (offset - winStart) + sizeof(magic), sizeof(record_len));
+    if (magic != RECORD_MAGIC || record_len == 0 || record_len > MAX_PAYLOAD_SIZE ||
+        offset + record_len + RECORD_OVERHEAD_BYTES > ring->size) {
+      status = CacheReadError::CORRUPT_DATA;
+      break;
+    }
+    const uint32_t total_record_size = record_len + RECORD_OVERHEAD_BYTES;
+    if (!ensureWindow(offset, total_record_size)) {
+      status = CacheReadError::FILE_READ_ERROR;
+      break;
+    }
+    const uint8_t* payload = window + (offset - winStart) + sizeof(RECORD_MAGIC) + sizeof(record_len);
+    uint32_t stored_crc;
+    memcpy(&stored_crc, payload + record_len, sizeof(stored_crc));
+    if (Crc32::compute(payload, record_len) != stored_crc) {
+      status = CacheReadError::CORRUPT_DATA;
+      break;
+    }
+
+    const uint8_t count = SensorBlockCodec::sample_count(payload, record_len);
+    if (count == 0) {
+      if (used + record_len > out.size())
+        break;
+      memcpy(out.data() + used, payload, record_len);
+      lengths[outRecords++] = record_len;
+      used += record_len;
+      offset += total_record_size;
+      sample = 0;
+      continue;
+    }
+
+    RtcSensorRecord decoded;
+    if (sample >= count || !SensorBlockCodec::decode_at(payload, record_len, static_cast<uint8_t>(sample), decoded)) {
+      status = CacheReadError::CORRUPT_DATA;
+      break;
+    }
+    if (used + SENSOR_RECORD_LEN > out.size())
+      break;
+    out[used] = static_cast<char>(SENSOR_RECORD_TAG);
+    memcpy(out.data() + used + 1, &decoded, sizeof(decoded));
+    lengths[outRecords++] = SENSOR_RECORD_LEN;
+    used += SENSOR_RECORD_LEN;
+    if (++sample >= count) {
+      offset += total_record_size;
+      sample = 0;
+    }
+  }
+
+  if (outRecords > 0)
+    return CacheReadError::NONE;
+  if (status != CacheReadError::NONE)
+    return status;
+  return (offset >= ring->size) ? CacheReadError::CACHE_EMPTY : CacheReadError::OUT_OF_MEMORY;
+}
+
+size_t CacheManager::pop_manyImpl(size_t count, CacheLane lane) {
+  selectLane(lane);
+  if (count == 0 || ring->size == 0)
+    return 0;
+
+  if (!m_file)
+    initImpl();
+  File& file = laneFile();
+  if (!file)
+    return 0;
+
+  // Walks record headers forward and moves the tail in memory; the header is marked dirty
+  // once for the whole call. Sync loss stops the walk and is left to pop_one() to resync.
+  size_t popped = 0;
+  while (popped < count && ring->size > 0) {
+    ESP.wdtFeed();
+    uint8_t frame[6];  // magic (2) + length (2) + block tag (1) + sample count (1)
+    const size_t want = std::min<size_t>(sizeof(frame), ring->size);
+    const size_t got = readWithWrap(file, ring->tail, frame, want);
+    if (got < sizeof(RECORD_MAGIC) + sizeof(uint16_t))
+      break;
+    uint16_t magic;
+    uint16_t record_len;
+    memcpy(&magic, frame, sizeof(magic));
+    memcpy(&record_len, frame + sizeof(magic), sizeof(record_len));
+    if (magic != RECORD_MAGIC || record_len == 0 || record_len > MAX_PAYLOAD_SIZE)
+      break;
+
+    const bool isBlock = (got == sizeof(frame) && record_len >= SensorBlockCodec::kHeaderBytes &&
+                          frame[4] == SensorBlockCodec::kTag);
+    if (isBlock && ring->tailSkip < frame[5]) {
+      const size_t remaining = frame[5] - ring->tailSkip;
+      if (count - popped < remaining) {
+        ring->tailSkip = static_cast<uint16_t>(ring->tailSkip + (count - popped));
+        popped = count;
+        break;
+      }
+      popped += remaining;
+    } else if (!isBlock) {
+      popped++;
+    }
+    // A block whose samples were all consumed already is just dropped.
+    advanceTailPointer(record_len + RECORD_OVERHEAD_BYTES);
+  }
+
+  if (popped > 0)
+    markDirty();
+  return popped;
+}
+
+CacheManager::PeekCursor CacheManager::peek_begin(CacheLane lane) const {
+  PeekCursor cursor;
+  cursor.lane = lane;
+  cursor.sample = (lane == CacheLane::PRIORITY) ? priorityHeader.tailSkip : cacheHeader.tailSkip;
+  return cursor;
+}
+
+CacheReadError CacheManager::peek_next(PeekCursor& cursor, char* out_buffer, size_t buffer_size, size_t& out_len) {
+  out_len = 0;
+  selectLane(cursor.lane);
+  if (cursor.offset >= ring->size) {
+    return CacheReadError::CACHE_EMPTY;
+  }
+
+  if (!m_file)
+    initImpl();
+  File& file = laneFile();
+  if (!file)
+    return CacheReadError::FILE_READ_ERROR;
+
+  const uint32_t record_pos = ring->tail + cursor.offset;
+  uint16_t magic;
+  if (readWithWrap(file, record_pos, (uint8_t*)&magic, sizeof(magic)) != sizeof(magic)) {
+    return CacheReadError::FILE_READ_ERROR;
+  }
+  if (magic != RECORD_MAGIC) {
+    return CacheReadError::CORRUPT_DATA;
+  }
+
+  uint16_t record_len;
+  if (readWithWrap(file, record_pos + sizeof(RECORD_MAGIC), (uint8_t*)&record_len, sizeof(record_len)) !=
+      sizeof(record_len)) {
+    return CacheReadError::FILE_READ_ERROR;
+  }
+  if (record_len == 0 || record_len > MAX_PAYLOAD_SIZE ||
+      cursor.offset + record_len + RECORD_OVERHEAD_BYTES > ring->size) {
+    return CacheReadError::CORRUPT_DATA;
+  }
+
+  // Blocks are validated whole, so read them into scratch even when the caller's buffer is small.
+  uint8_t scratch[MAX_PAYLOAD_SIZE];
+  uint8_t* payload = scratch;
+  if (record_len <= buffer_size) {
+    payload = (uint8_t*)out_buffer;
+  }
+
+  const uint32_t payload_pos = record_pos + sizeof(RECORD_MAGIC) + sizeof(record_len);
+  if (readWithWrap(file, payload_pos, payload, record_len) != record_len) {
+    return CacheReadError::FILE_READ_ERROR;
+  }
+  uint32_t stored_crc;
+  if (readWithWrap(file, payload_pos + record_len, (uint8_t*)&stored_crc, sizeof(stored_crc)) !=
+      sizeof(stored_crc)) {
+    return CacheReadError::FILE_READ_ERROR;
+  }
+  if (Crc32::compute(payload, record_len) != stored_crc) {
+    return CacheReadError::CORRUPT_DATA;
+  }
+
+  const uint8_t count = SensorBlockCodec::sample_count(payload, record_len);
+  if (count == 0) {
+    if (payload != (uint8_t*)out_buffer) {
+      return CacheReadError::OUT_OF_MEMORY;
+    }
+    cursor.offset += record_len + RECORD_OVERHEAD_BYTES;
+    cursor.sample = 0;
+    out_len = record_len;
+    return CacheReadError::NONE;
+  }
+
+  RtcSensorRecord sample;
+  if (cursor.sample >= count || !SensorBlockCodec::decode_at(payload, record_len, static_cast<uint8_t>(cursor.sample), sample)) {
+    return CacheReadError::CORRUPT_DATA;
+  }
+  if (buffer_size < SENSOR_RECORD_LEN) {
+    return CacheReadError::OUT_OF_MEMORY;
+  }
+  out_buffer[0] = static_cast<char>(SENSOR_RECORD_TAG);
+  memcpy(out_buffer + 1, &sample, sizeof(sample));
+  out_len = SENSOR_RECORD_LEN;
+  if (++cursor.sample >= count) {
+    cursor.offset += record_len + RECORD_OVERHEAD_BYTES;
+    cursor.sample = 0;
+  }
+  return CacheReadError::NONE;
+}
+
+bool CacheManager::write_sensor_record(const RtcSensorRecord& record, CacheLane lane) {
+  char packed[SENSOR_RECORD_LEN];
+  packed[0] = static_cast<char>(SENSOR_RECORD_TAG);
+  memcpy(packed + 1, &record, sizeof(record));
+  return writeImpl(packed, SENSOR_RECORD_LEN, lane);
+}
+
+size_t CacheManager::write_sensor_block(const RtcSensorRecord* records, size_t count) {
+  if (!records || count == 0)
+    return 0;
+
+  uint8_t block[SENSOR_BLOCK_MAX_BYTES];
+  size_t encoded = 0;
+  const size_t len = SensorBlockCodec::encode(records, count, block, sizeof(block), encoded);
+  if (len == 0 || encoded == 0)
+    return 0;
+  return writeImpl((const char*)block, static_cast<uint16_t>(len), CacheLane::ROUTINE) ? encoded : 0;
+}
+
+bool CacheManager::decode_sensor_record(const char* data, size_t len, RtcSensorRecord& out) {
+  if (!data || len != SENSOR_RECORD_LEN || static_cast<uint8_t>(data[0]) != SENSOR_RECORD_TAG) {
+    return false;
+  }
+  memcpy(&out, data + 1, sizeof(out));
+  return true;
+}
+
 void CacheManager::get_statusImpl(uint32_t& size_bytes, uint32_t& head, uint32_t& tail) {
   size_bytes = cacheHeader.size;
   head = cacheHeader.head;
   tail = cacheHeader.tail;
 }
 
+const CacheIoStats& CacheManager::io_statsImpl() const {
+  return ioStats;
+}
+
 uint32_t CacheManager::get_sizeImpl() {
-  return cacheHeader.size;
+  return cacheHeader.size + priorityHeader.size;
 }
+
+uint32_t CacheManager::get_lane_sizeImpl(CacheLane lane) {
+  return (lane == CacheLane::PRIORITY) ? priorityHeader.size : cacheHeader.size;
+}
+
+#endif  // !CACHE_ENGINE_SEGMENTED
@@ -2,8 +2,18 @@
 #define CACHE_MANAGER_H
 
 #include "interfaces/ICacheManager.h"
+#include "storage/CacheDownsampler.h"
+#include "storage/RtcManager.h"
 #include <FS.h>
 
+#if defined(CACHE_ENGINE_SEGMENTED)
+#include "storage/SegmentedCacheManager.h"
+
+// Build-time engine selection: the rest of the firmware only ever names CacheManager.
+class CacheManager final : public SegmentedCacheManager {};
+
+#else
+
 // ============================================================================
 // CacheManager with CRTP (Zero Virtual Overhead)
 // ============================================================================
@@ -21,21 +31,78 @@ public:
   // CRTP implementation methods
   void initImpl();
   void resetImpl();
-  [[nodiscard]] bool writeImpl(const char* data, uint16_t len);
-  CacheReadError read_oneImpl(char* out_buffer, size_t buffer_size, size_t& out_len);
-  [[nodiscard]] bool pop_oneImpl();
+  // A PRIORITY write that does not fit the priority lane spills into the routine lane,
+  // evicting the oldest routine data instead of an older alert.
+  [[nodiscard]] bool writeImpl(const char* data, uint16_t len, CacheLane lane);
+  CacheReadError read_oneImpl(char* out_buffer, size_t buffer_size, size_t& out_len, CacheLane lane);
+  [[nodiscard]] bool pop_oneImpl(CacheLane lane);
+  CacheReadError read_manyImpl(std::span<char> out,
+                               std::span<uint16_t> lengths,
+                               size_t maxRecords,
+                               size_t& outRecords,
+                               CacheLane lane);
+  [[nodiscard]] size_t pop_manyImpl(size_t count, CacheLane lane);
+  // Reports the routine lane only; see get_lane_size() for the priority lane.
   void get_statusImpl(uint32_t& size_bytes, uint32_t& head, uint32_t& tail);
   [[nodiscard]] uint32_t get_sizeImpl();
+  [[nodiscard]] uint32_t get_lane_sizeImpl(CacheLane lane);
+  [[nodiscard]] const CacheIoStats& io_statsImpl() const;
   
   // Custom method (not in ICacheManager for now) to reduce write amplification
   void flush();
 
+  // One budgeted pass of age-based downsampling (see CacheDownsampler.h), run from the main loop.
+  CacheDownsampler::PassResult downsample_step(uint32_t budgetBytes = CACHE_DOWNSAMPLE_BUDGET_BYTES);
+
+  // On-disk framing per record: magic (2) + length (2) + CRC32 (4).
+  static constexpr uint32_t RECORD_OVERHEAD_BYTES = 8;
+
+  // Read-ahead position: byte offset of a framed record from the tail, plus the sample
+  // index inside it when that record is a delta block.
+  struct PeekCursor {
+    uint32_t offset = 0;
+    uint16_t sample = 0;
+    CacheLane lane = CacheLane::ROUTINE;
+  };
+
+  // Read-ahead for batched uploads, starting at peek_begin(). Each call validates and
+  // copies out the entry under `cursor` (block samples come out as compact records),
+  // then moves `cursor` past it. Never moves the tail and never repairs: corruption
+  // stops the read-ahead and is left for read_one()/pop_one() to recover.
+  [[nodiscard]] PeekCursor peek_begin(CacheLane lane = CacheLane::ROUTINE) const;
+  CacheReadError peek_next(PeekCursor& cursor, char* out_buffer, size_t buffer_size, size_t& out_len);
+
+  // Compact sensor record (cache format v5): a type tag followed by the raw 12-byte
+  // RtcSensorRecord, rendered to JSON only when it is sent. Legacy records are JSON
+  // text and always start with '{', so the tag never collides with them.
+  static constexpr uint8_t SENSOR_RECORD_TAG = 0x01;
+  static constexpr uint16_t SENSOR_RECORD_LEN = 1 + sizeof(RtcSensorRecord);
+
+  [[nodiscard]] bool write_sensor_record(const RtcSensorRecord& record, CacheLane lane = CacheLane::ROUTINE);
+  [[nodiscard]] static bool decode_sensor_record(const char* data, size_t len, RtcSensorRecord& out);
+
+  // Delta block (cache format v6, see SensorBlockCodec.h): one framed record holding a run of
+  // samples, sized so a full block plus framing fills one 256-byte LittleFS page. read_one()
+  // yields its samples one at a time as compact records and pop_one() consumes them in order.
+  static constexpr uint32_t LITTLEFS_PAGE_BYTES = 256;
+  static constexpr uint16_t SENSOR_BLOCK_MAX_BYTES = LITTLEFS_PAGE_BYTES - RECORD_OVERHEAD_BYTES;
+
+  // Appends the longest prefix of `records` that fits one block; returns how many were stored.
+  [[nodiscard]] size_t write_sensor_block(const RtcSensorRecord* records, size_t count);
+
 private:
   void markDirty();
+  void openPriorityLane();
+  // File backing the lane the ring helpers currently operate on.
+  fs::File& laneFile();
   bool m_dirty = false;
   uint16_t m_pendingMutations = 0;
   unsigned long m_lastFlushMs = 0;
   fs::File m_file;
+  fs::File m_priorityFile;
+  CacheDownsampler::State m_downsample;
 };
 
+#endif  // CACHE_ENGINE_SEGMENTED
+
 #endif  // CACHE_MANAGER_H
@@ -31,6 +31,13 @@ namespace Paths {
   
   /// Sensor data cache (store-and-forward)
   constexpr const char* CACHE_FILE = "/cache.dat";
+  /// Sparse record-boundary index for cache recovery
+  constexpr const char* CACHE_INDEX = "/cache.idx";
+  /// Cache priority lane (alert samples drained ahead of the routine ring)
+  constexpr const char* CACHE_PRIORITY_FILE = "/cache_hi.dat";
+  /// Segmented cache engine: segment files are <prefix>NN.log, plus the tail cursor
+  constexpr const char* CACHE_SEGMENT_PREFIX = "/cseg";
+  constexpr const char* CACHE_SEGMENT_CURSOR = "/cseg.pos";
   
   /// Crash log for post-mortem analysis
   constexpr const char* CRASH_LOG = "/crash.log";
@@ -0,0 +1,143 @@
+#ifndef QUEUE_READ_AHEAD_H
+#define QUEUE_READ_AHEAD_H
+
+#include <Arduino.h>
+
+#include "interfaces/ICacheManager.h"
+#include "storage/RtcManager.h"
+
+// ============================================================================
+// Read-ahead of the next queued upload record
+// ============================================================================
+// While an upload waits for its response, the record that will be at the front of the queue
+// once it succeeds is read and rendered into a spare buffer. The upload order is the priority
+// lane, then RTC, then the routine lane, so the read-ahead skips the entries the in-flight
+// upload will pop in each and takes the first one left.
+//
+// Nothing is consumed here. A ticket records where the record came from and the cache's
+// eviction counters, and valid() checks at commit time that nothing jumped the queue (an alert,
+// a new RTC sample ahead of the routine lane) and nothing reshaped the tail (trim, downsampling,
+// reset) in the meantime. A stale ticket is discarded and the record loaded as usual.
+namespace QueueReadAhead {
+
+  enum class Source : uint8_t { NONE, PRIORITY, RTC, ROUTINE };
+
+  // Entries of each queue the in-flight upload pops when it succeeds.
+  struct InFlight {
+    uint16_t priority = 0;
+    uint16_t rtc = 0;
+    uint16_t routine = 0;
+  };
+
+  struct Ticket {
+    Source source = Source::NONE;
+    size_t length = 0;
+    uint16_t rtcSeq = 0;
+    uint32_t trims = 0;
+    uint32_t downsampled = 0;
+    uint32_t resets = 0;
+  };
+
+  // Copies the entry `skip` places behind the lane's tail into `out`; CACHE_EMPTY when the lane
+  // holds no more than `skip` entries.
+  template <typename Cache>
+  CacheReadError peek_lane_at(Cache& cache, CacheLane lane, uint16_t skip, char* out, size_t outLen, size_t& len) {
+    typename Cache::PeekCursor cursor = cache.peek_begin(lane);
+    for (uint16_t i = 0; i <= skip; ++i) {
+      len = 0;
+      const CacheReadError err = cache.peek_next(cursor, out, outLen - 1, len);
+      if (err != CacheReadError::NONE) {
+        return err;
+      }
+    }
+    return CacheReadError::NONE;
+  }
+
+  // Reads and renders the record that follows `inFlight` into `out`. `renderRtc(out, outLen,
+  // record, len)` and `renderCached(out, outLen, len)` produce the upload payload, exactly as the
+  // regular load would. Returns a ticket with Source::NONE when there is nothing to read ahead or
+  // the read hit anything but a clean record.
+  template <typename Cache, typename RenderRtc, typename RenderCached>
+  Ticket read(Cache& cache,
+              const InFlight& inFlight,
+              char* out,
+              size_t outLen,
+              RenderRtc renderRtc,
+              RenderCached renderCached) {
+    Ticket ticket;
+    if (!out || outLen < 2) {
+      return ticket;
+    }
+    const CacheIoStats& io = cache.io_stats();
+    ticket.trims = io.trims;
+    ticket.downsampled = io.downsampledEntries;
+    ticket.resets = io.resets;
+
+    size_t len = 0;
+    if (cache.get_lane_size(CacheLane::PRIORITY) > 0) {
+      const CacheReadError err = peek_lane_at(cache, CacheLane::PRIORITY, inFlight.priority, out, outLen, len);
+      if (err == CacheReadError::NONE) {
+        if (renderCached(out, outLen, len)) {
+          ticket.source = Source::PRIORITY;
+          ticket.length = len;
+        }
+        return ticket;
+      }
+      if (err != CacheReadError::CACHE_EMPTY) {
+        return ticket;
+      }
+    }
+
+    RtcSensorRecord record{};
+    uint16_t seq = 0;
+    const RtcReadStatus rtcStatus = RtcManager::peekAtEx(inFlight.rtc, record, seq);
+    if (rtcStatus == RtcReadStatus::NONE) {
+      if (renderRtc(out, outLen, record, len)) {
+        ticket.source = Source::RTC;
+        ticket.length = len;
+        ticket.rtcSeq = seq;
+      }
+      return ticket;
+    }
+    if (rtcStatus != RtcReadStatus::CACHE_EMPTY) {
+      return ticket;
+    }
+
+    if (peek_lane_at(cache, CacheLane::ROUTINE, inFlight.routine, out, outLen, len) == CacheReadError::NONE &&
+        renderCached(out, outLen, len)) {
+      ticket.source = Source::ROUTINE;
+      ticket.length = len;
+    }
+    return ticket;
+  }
+
+  // True when the ticket's record is still the one the regular load would return now, after
+  // the in-flight entries were popped.
+  template <typename Cache>
+  bool valid(Cache& cache, const Ticket& ticket) {
+    if (ticket.source == Source::NONE) {
+      return false;
+    }
+    const CacheIoStats& io = cache.io_stats();
+    if (io.trims != ticket.trims || io.downsampledEntries != ticket.downsampled || io.resets != ticket.resets) {
+      return false;
+    }
+    const bool alertsWaiting = cache.get_lane_size(CacheLane::PRIORITY) > 0;
+    switch (ticket.source) {
+      case Source::PRIORITY:
+        return alertsWaiting;
+      case Source::RTC: {
+        RtcSensorRecord record{};
+        uint16_t seq = 0;
+        return !alertsWaiting && RtcManager::peekAtEx(0, record, seq) == RtcReadStatus::NONE && seq == ticket.rtcSeq;
+      }
+      case Source::ROUTINE:
+        return !alertsWaiting && RtcManager::getCount() == 0 && cache.get_lane_size(CacheLane::ROUTINE) > 0;
+      default:
+        return false;
+    }
+  }
+
+}  // namespace QueueReadAhead
+
+#endif  // QUEUE_READ_AHEAD_H
@@ -21,36 +21,97 @@ struct alignas(4) LegacyRtcSensorDataV1 {
 
 static_assert(sizeof(LegacyRtcSensorDataV1) == 364, "Legacy RTC V1 layout must remain 364 bytes.");
 
+struct alignas(4) LegacyRtcRecordV2 {
+  uint16_t magic;
+  uint16_t seq;
+  uint32_t timestamp;
+  int16_t temp10;
+  int16_t hum10;
+  uint16_t lux;
+  int16_t rssi;
+  uint32_t crc;
+};
+
+struct alignas(4) LegacyRtcHeaderV2 {
+  uint32_t blockMagic;
+  uint16_t version;
+  uint16_t maxRecords;
+  uint16_t head;
+  uint16_t tail;
+  uint16_t count;
+  uint16_t nextSeq;
+  uint32_t headerCrc;
+};
+
+static constexpr uint16_t kLegacyV2Records = 17;
+
+struct alignas(4) LegacyRtcSensorDataV2 {
+  LegacyRtcHeaderV2 header;
+  LegacyRtcRecordV2 records[kLegacyV2Records];
+  uint32_t reserved;
+};
+
+static_assert(sizeof(LegacyRtcSensorDataV2) == 364, "Legacy RTC V2 layout must remain 364 bytes.");
+
+// tsDelta value for a sample taken before NTP sync; such samples keep timestamp 0.
+static constexpr uint16_t kNoTimestamp = 0xFFFF;
+
 bool seqBefore(uint16_t a, uint16_t b) {
   if (a == b) return false;
   return static_cast<uint16_t>(b - a) < 0x8000;
 }
 
+// nextSeq of the last valid header seen this boot. A reset carries on from it, so sequence numbers
+// handed out before the reset (say, to a batch still in flight) never name records stored after it.
+uint16_t seqFloor = 0;
+
+void putU16(uint8_t* out, uint16_t value) {
+  out[0] = static_cast<uint8_t>(value & 0xFFU);
+  out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+uint16_t getU16(const uint8_t* in) {
+  return static_cast<uint16_t>(in[0] | (static_cast<uint16_t>(in[1]) << 8));
+}
+
+int16_t signExtend12(uint16_t value) {
+  return static_cast<int16_t>((value & 0x800U) ? (value | 0xF000U) : (value & 0x0FFFU));
+}
+
+bool fits12(int16_t value) {
+  return value >= -2048 && value <= 2047;
+}
+
 }  // namespace
 
 RtcSensorData RtcManager::data;
+uint64_t RtcManager::dirtyRegions = 0;
 
 void RtcManager::resetDataInMemory() {
   memset(&data, 0, sizeof(data));
+  dirtyRegions = kAllDirty;
   data.header.blockMagic = RTC_SENSOR_MAGIC;
   data.header.version = RTC_LAYOUT_VERSION;
   data.header.maxRecords = RTC_MAX_RECORDS;
   data.header.head = 0;
   data.header.tail = 0;
   data.header.count = 0;
-  data.header.nextSeq = 0;
+  data.header.nextSeq = seqFloor;
+  data.header.baseTimestamp = 0;
   data.header.headerCrc = calculateHeaderCrc(data.header);
 }
 
-uint32_t RtcManager::calculateHeaderCrc(const RtcHeaderV2& header) {
-  return Crc32::compute(&header, offsetof(RtcHeaderV2, headerCrc));
+uint32_t RtcManager::calculateHeaderCrc(const RtcHeaderV3& header) {
+  return Crc32::compute(&header, offsetof(RtcHeaderV3, headerCrc));
 }
 
-uint32_t RtcManager::calculateRecordCrc(const RtcRecordV2& record) {
-  return Crc32::compute(&record, offsetof(RtcRecordV2, crc));
+uint8_t RtcManager::calculateRecordCheck(const RtcRecordV3& record, uint16_t seq) {
+  uint32_t crc = Crc32::compute(&seq, sizeof(seq));
+  crc = Crc32::compute(&record, offsetof(RtcRecordV3, check), crc);
+  return static_cast<uint8_t>(crc & 0xFFU);
 }
 
-bool RtcManager::validateHeader(const RtcHeaderV2& header) {
+bool RtcManager::validateHeader(const RtcHeaderV3& header) {
   if (header.blockMagic != RTC_SENSOR_MAGIC) {
     return false;
   }
@@ -66,30 +127,111 @@ bool RtcManager::validateHeader(const RtcHeaderV2& header) {
   return (header.headerCrc == calculateHeaderCrc(header));
 }
 
-bool RtcManager::isRecordValid(const RtcRecordV2& record) {
-  if (record.magic != RTC_RECORD_MAGIC) {
+uint16_t RtcManager::slotIndex(uint16_t offset) {
+  return static_cast<uint16_t>((data.header.tail + offset) % RTC_MAX_RECORDS);
+}
+
+// Slots hold consecutive sequence numbers ending just before nextSeq.
+uint16_t RtcManager::slotSeq(uint16_t offset) {
+  return static_cast<uint16_t>(data.header.nextSeq - data.header.count + offset);
+}
+
+bool RtcManager::isSlotValid(uint16_t offset) {
+  const RtcRecordV3& slot = data.records[slotIndex(offset)];
+  return slot.check == calculateRecordCheck(slot, slotSeq(offset));
+}
+
+bool RtcManager::fitsSlot(const RtcSensorRecord& payload) {
+  return fits12(payload.temp10) && fits12(payload.hum10) && payload.rssi >= -128 && payload.rssi <= 127;
+}
+
+// Earliest and latest of `timestamp` and the stored timestamps.
+void RtcManager::timestampSpan(uint32_t timestamp, uint32_t& lo, uint32_t& hi) {
+  const uint32_t base = data.header.baseTimestamp;
+  lo = timestamp;
+  hi = timestamp;
+  for (uint16_t offset = 0; offset < data.header.count; ++offset) {
+    const uint16_t delta = getU16(data.records[slotIndex(offset)].tsDelta);
+    if (delta == kNoTimestamp || !isSlotValid(offset)) {
+      continue;
+    }
+    lo = std::min(lo, base + delta);
+    hi = std::max(hi, base + delta);
+  }
+}
+
+bool RtcManager::timestampFits(uint32_t timestamp) {
+  if (timestamp == 0 || data.header.count == 0) {
+    return true;
+  }
+  uint32_t lo = 0;
+  uint32_t hi = 0;
+  timestampSpan(timestamp, lo, hi);
+  return hi - lo < kNoTimestamp;
+}
+
+// Makes `timestamp` expressible as a delta from the header base, moving the base back or forward
+// over the stored samples if needed. Fails when the stored span plus `timestamp` exceeds a delta.
+bool RtcManager::fitTimestamp(uint32_t timestamp) {
+  if (timestamp == 0) {
+    return true;
+  }
+  if (data.header.count == 0) {
+    data.header.baseTimestamp = timestamp;
+    return true;
+  }
+  const uint32_t base = data.header.baseTimestamp;
+  if (timestamp >= base && timestamp - base < kNoTimestamp) {
+    return true;
+  }
+
+  uint32_t lo = 0;
+  uint32_t hi = 0;
+  timestampSpan(timestamp, lo, hi);
+  if (hi - lo >= kNoTimestamp) {
     return false;
   }
-  return (record.crc == calculateRecordCrc(record));
+
+  for (uint16_t offset = 0; offset < data.header.count; ++offset) {
+    const uint16_t index = slotIndex(offset);
+    RtcRecordV3& slot = data.records[index];
+    const uint16_t delta = getU16(slot.tsDelta);
+    if (delta == kNoTimestamp || !isSlotValid(offset)) {
+      continue;
+    }
+    putU16(slot.tsDelta, static_cast<uint16_t>(base + delta - lo));
+    slot.check = calculateRecordCheck(slot, slotSeq(offset));
+    markSlotDirty(index);
+  }
+  data.header.baseTimestamp = lo;
+  LOG_DEBUG("RTC", F("RTC timestamp base moved to %lu"), static_cast<unsigned long>(lo));
+  return true;
 }
 
-void RtcManager::setSlotFromPayload(RtcRecordV2& slot, const RtcSensorRecord& payload, uint16_t seq) {
-  memset(&slot, 0, sizeof(slot));
-  slot.magic = RTC_RECORD_MAGIC;
-  slot.seq = seq;
-  slot.timestamp = payload.timestamp;
-  slot.temp10 = payload.temp10;
-  slot.hum10 = payload.hum10;
-  slot.lux = payload.lux;
-  slot.rssi = payload.rssi;
-  slot.crc = calculateRecordCrc(slot);
+// Caller guarantees fitsSlot(payload) and fitTimestamp(payload.timestamp).
+void RtcManager::setSlotFromPayload(uint16_t offset, const RtcSensorRecord& payload) {
+  const uint16_t index = slotIndex(offset);
+  RtcRecordV3& slot = data.records[index];
+  const uint16_t temp = static_cast<uint16_t>(payload.temp10) & 0x0FFFU;
+  const uint16_t hum = static_cast<uint16_t>(payload.hum10) & 0x0FFFU;
+  putU16(slot.tsDelta,
+         (payload.timestamp == 0) ? kNoTimestamp
+                                  : static_cast<uint16_t>(payload.timestamp - data.header.baseTimestamp));
+  slot.tempHum[0] = static_cast<uint8_t>(temp & 0xFFU);
+  slot.tempHum[1] = static_cast<uint8_t>((temp >> 8) | ((hum & 0x0FU) << 4));
+  slot.tempHum[2] = static_cast<uint8_t>(hum >> 4);
+  putU16(slot.lux, payload.lux);
+  slot.rssi = static_cast<int8_t>(payload.rssi);
+  slot.check = calculateRecordCheck(slot, slotSeq(offset));
+  markSlotDirty(index);
 }
 
-void RtcManager::payloadFromSlot(RtcSensorRecord& outRecord, const RtcRecordV2& slot) {
-  outRecord.timestamp = slot.timestamp;
-  outRecord.temp10 = slot.temp10;
-  outRecord.hum10 = slot.hum10;
-  outRecord.lux = slot.lux;
+void RtcManager::payloadFromSlot(RtcSensorRecord& outRecord, const RtcRecordV3& slot) {
+  const uint16_t delta = getU16(slot.tsDelta);
+  outRecord.timestamp = (delta == kNoTimestamp) ? 0U : data.header.baseTimestamp + delta;
+  outRecord.temp10 = signExtend12(static_cast<uint16_t>(slot.tempHum[0] | ((slot.tempHum[1] & 0x0FU) << 8)));
+  outRecord.hum10 = signExtend12(static_cast<uint16_t>((slot.tempHum[1] >> 4) | (slot.tempHum[2] << 4)));
+  outRecord.lux = getU16(slot.lux);
   outRecord.rssi = slot.rssi;
 }
 
@@ -98,19 +240,66 @@ bool RtcManager::readRaw() {
     LOG_WARN("RTC", F("RTC read failed"));
     return false;
   }
+  dirtyRegions = 0;
   return true;
 }
 
-bool RtcManager::writeRaw() {
-  if (!system_rtc_mem_write(RTC_SENSOR_BLOCK_OFFSET, &data, sizeof(data))) {
+void RtcManager::markSlotDirty(uint16_t index) {
+  dirtyRegions |= (1ULL << (1U + index));
+}
+
+// Writes `count` adjacent regions starting at region `first` with one RTC call, widened to the
+// RTC blocks they touch; the widened bytes are rewritten with what they already hold.
+bool RtcManager::writeRegions(uint8_t first, uint8_t count) {
+  const auto regionOffset = [](uint8_t region) -> size_t {
+    if (region == 0) return 0;
+    if (region <= RTC_MAX_RECORDS) return offsetof(RtcSensorData, records) + (region - 1U) * sizeof(RtcRecordV3);
+    return offsetof(RtcSensorData, reserved);
+  };
+  constexpr size_t kBlockMask = ~static_cast<size_t>(3);
+  const size_t begin = regionOffset(first) & kBlockMask;
+  const size_t end = (first + count >= kDirtyRegions) ? sizeof(data) : (regionOffset(first + count) + 3U) & kBlockMask;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&data);
+  if (!system_rtc_mem_write(static_cast<uint8_t>(RTC_SENSOR_BLOCK_OFFSET + begin / 4),
+                            bytes + begin,
+                            static_cast<uint16_t>(end - begin))) {
     LOG_ERROR("RTC", F("RTC write failed"));
     return false;
   }
   return true;
 }
 
+// Slots go out before the header, so an interrupted append never publishes an unwritten slot.
+// Pops only move the header, which goes out in a single write.
+bool RtcManager::writeRaw() {
+  uint8_t region = 1;
+  while (region < kDirtyRegions) {
+    if ((dirtyRegions & (1ULL << region)) == 0) {
+      region++;
+      continue;
+    }
+    uint8_t run = 1;
+    while (region + run < kDirtyRegions && (dirtyRegions & (1ULL << (region + run))) != 0) {
+      run++;
+    }
+    if (!writeRegions(region, run)) {
+      return false;
+    }
+    dirtyRegions &= ~(((1ULL << run) - 1ULL) << region);
+    region = static_cast<uint8_t>(region + run);
+  }
+  if ((dirtyRegions & 1ULL) != 0) {
+    if (!writeRegions(0, 1)) {
+      return false;
+    }
+    dirtyRegions &= ~1ULL;
+  }
+  return true;
+}
+
 bool RtcManager::writeData() {
   data.header.headerCrc = calculateHeaderCrc(data.header);
+  dirtyRegions |= 1ULL;
   return writeRaw();
 }
 
@@ -127,101 +316,134 @@ bool RtcManager::legacyCrcValid(const void* legacyData) {
   return (crc == v1->crc);
 }
 
-bool RtcManager::tryMigrateFromLegacy() {
-  const LegacyRtcSensorDataV1* oldData = reinterpret_cast<const LegacyRtcSensorDataV1*>(&data);
-  if (oldData->magic != RTC_SENSOR_MAGIC) {
-    return false;
-  }
-  if (oldData->count > 29 || oldData->head >= 29 || oldData->tail >= 29) {
-    return false;
-  }
-  if (!legacyCrcValid(oldData)) {
-    LOG_WARN("RTC", F("Legacy RTC block detected but CRC invalid"));
-    return false;
+// Rebuilds the V3 image from `count` samples, oldest first. Keeps the newest ones that fit the
+// slots and a single timestamp base; returns how many were kept.
+uint16_t RtcManager::importRecords(const RtcSensorRecord* records, uint16_t count) {
+  uint16_t first = count;
+  uint32_t lo = UINT32_MAX;
+  uint32_t hi = 0;
+  while (first > 0 && count - first < RTC_MAX_RECORDS) {
+    const uint32_t ts = records[first - 1].timestamp;
+    if (ts != 0) {
+      if (std::max(hi, ts) - std::min(lo, ts) >= kNoTimestamp) {
+        break;
+      }
+      lo = std::min(lo, ts);
+      hi = std::max(hi, ts);
+    }
+    first--;
   }
 
-  const uint16_t available = static_cast<uint16_t>(std::min<uint16_t>(oldData->count, 29));
-  const uint16_t importCount = static_cast<uint16_t>(std::min<uint16_t>(available, RTC_MAX_RECORDS));
-  const uint16_t startOffset = static_cast<uint16_t>(available > importCount ? available - importCount : 0);
-
   resetDataInMemory();
-  for (uint16_t i = 0; i < importCount; ++i) {
-    const uint16_t legacyIndex = static_cast<uint16_t>((oldData->tail + startOffset + i) % 29);
-    setSlotFromPayload(data.records[i], oldData->records[legacyIndex], i);
+  data.header.baseTimestamp = (hi > 0) ? lo : 0;
+  for (uint16_t i = first; i < count; ++i) {
+    if (!fitsSlot(records[i])) {
+      continue;
+    }
+    setSlotFromPayload(data.header.count, records[i]);
+    data.header.count++;
+    data.header.nextSeq++;
   }
   data.header.tail = 0;
-  data.header.count = importCount;
-  data.header.head = static_cast<uint16_t>(importCount % RTC_MAX_RECORDS);
-  data.header.nextSeq = importCount;
-
-  if (!writeData()) {
-    return false;
-  }
+  data.header.head = static_cast<uint16_t>(data.header.count % RTC_MAX_RECORDS);
+  return data.header.count;
+}
 
-  if (available > importCount) {
-    LOG_WARN("RTC",
-             F("Legacy migration truncated %u -> %u records due RTC V2 capacity"),
-             static_cast<unsigned>(available),
-             static_cast<unsigned>(importCount));
-  } else {
-    LOG_INFO("RTC", F("Legacy RTC migrated: %u records"), static_cast<unsigned>(importCount));
-  }
-  return true;
+bool RtcManager::tryMigrateFromLegacy() {
+  return migrateFromV2() || migrateFromV1();
 }
 
-bool RtcManager::salvageFromCurrentSlots() {
+// V2 cleared every slot it popped, so the live records are exactly the slots that still pass
+// their CRC; ordering them by sequence number also recovers a V2 image whose header is corrupt.
+bool RtcManager::migrateFromV2() {
+  const LegacyRtcSensorDataV2* oldData = reinterpret_cast<const LegacyRtcSensorDataV2*>(&data);
+  const bool headerValid = oldData->header.blockMagic == RTC_SENSOR_MAGIC && oldData->header.version == 2 &&
+                           oldData->header.headerCrc ==
+                               Crc32::compute(&oldData->header, offsetof(LegacyRtcHeaderV2, headerCrc));
+
   struct SlotCopy {
     uint16_t seq;
     RtcSensorRecord payload;
   };
 
-  SlotCopy valid[RTC_MAX_RECORDS];
+  SlotCopy valid[kLegacyV2Records];
   uint16_t validCount = 0;
-
-  for (uint16_t i = 0; i < RTC_MAX_RECORDS; ++i) {
-    const RtcRecordV2& slot = data.records[i];
-    if (!isRecordValid(slot)) {
+  for (uint16_t i = 0; i < kLegacyV2Records; ++i) {
+    const LegacyRtcRecordV2& slot = oldData->records[i];
+    if (slot.magic != RTC_RECORD_MAGIC || slot.crc != Crc32::compute(&slot, offsetof(LegacyRtcRecordV2, crc))) {
       continue;
     }
     valid[validCount].seq = slot.seq;
-    payloadFromSlot(valid[validCount].payload, slot);
+    valid[validCount].payload = {slot.timestamp, slot.temp10, slot.hum10, slot.lux, slot.rssi};
     validCount++;
   }
+  if (validCount == 0 && !headerValid) {
+    return false;
+  }
 
-  if (validCount > 0) {
-    std::sort(valid, valid + validCount, [](const SlotCopy& a, const SlotCopy& b) {
-      return seqBefore(a.seq, b.seq);
-    });
-
-    uint16_t writeIndex = 0;
-    for (uint16_t i = 0; i < validCount; ++i) {
-      if (writeIndex > 0 && valid[writeIndex - 1].seq == valid[i].seq) {
-        continue;
-      }
-      valid[writeIndex] = valid[i];
-      writeIndex++;
+  std::sort(valid, valid + validCount, [](const SlotCopy& a, const SlotCopy& b) {
+    return seqBefore(a.seq, b.seq);
+  });
+  RtcSensorRecord payloads[kLegacyV2Records];
+  uint16_t unique = 0;
+  for (uint16_t i = 0; i < validCount; ++i) {
+    if (i > 0 && valid[i - 1].seq == valid[i].seq) {
+      continue;
     }
-    validCount = writeIndex;
+    payloads[unique++] = valid[i].payload;
   }
 
-  resetDataInMemory();
-  const uint16_t count = static_cast<uint16_t>(std::min<uint16_t>(validCount, RTC_MAX_RECORDS));
-  for (uint16_t i = 0; i < count; ++i) {
-    setSlotFromPayload(data.records[i], valid[i].payload, valid[i].seq);
+  const uint16_t imported = importRecords(payloads, unique);
+  if (!writeData()) {
+    return false;
+  }
+
+  if (imported < unique) {
+    LOG_WARN("RTC",
+             F("RTC V2 migration kept %u of %u records"),
+             static_cast<unsigned>(imported),
+             static_cast<unsigned>(unique));
+  } else {
+    LOG_INFO("RTC",
+             F("RTC V2 migrated: %u records%s"),
+             static_cast<unsigned>(imported),
+             headerValid ? "" : " (header corrupt)");
+  }
+  return true;
+}
+
+bool RtcManager::migrateFromV1() {
+  const LegacyRtcSensorDataV1* oldData = reinterpret_cast<const LegacyRtcSensorDataV1*>(&data);
+  if (oldData->magic != RTC_SENSOR_MAGIC) {
+    return false;
+  }
+  if (oldData->count > 29 || oldData->head >= 29 || oldData->tail >= 29) {
+    return false;
+  }
+  if (!legacyCrcValid(oldData)) {
+    LOG_WARN("RTC", F("Legacy RTC block detected but CRC invalid"));
+    return false;
   }
-  data.header.tail = 0;
-  data.header.count = count;
-  data.header.head = static_cast<uint16_t>(count % RTC_MAX_RECORDS);
-  data.header.nextSeq = (count > 0) ? static_cast<uint16_t>(valid[count - 1].seq + 1U) : 0;
 
+  // Copied out first: the V3 image is rebuilt over the same buffer.
+  const uint16_t available = oldData->count;
+  RtcSensorRecord payloads[29];
+  for (uint16_t i = 0; i < available; ++i) {
+    payloads[i] = oldData->records[(oldData->tail + i) % 29];
+  }
+
+  const uint16_t imported = importRecords(payloads, available);
   if (!writeData()) {
     return false;
   }
 
-  if (count == 0) {
-    LOG_WARN("RTC", F("RTC header corrupt and no valid slots, reset fresh"));
+  if (available > imported) {
+    LOG_WARN("RTC",
+             F("Legacy migration truncated %u -> %u records due RTC V3 capacity"),
+             static_cast<unsigned>(available),
+             static_cast<unsigned>(imported));
   } else {
-    LOG_WARN("RTC", F("RTC header corrupt, salvaged %u slots"), static_cast<unsigned>(count));
+    LOG_INFO("RTC", F("Legacy RTC migrated: %u records"), static_cast<unsigned>(imported));
   }
   return true;
 }
@@ -238,15 +460,14 @@ RtcReadStatus RtcManager::sanitizeFrontSlots(uint16_t budgetSlots) {
   uint16_t removed = 0;
   while (data.header.count > 0 && removed < budgetSlots) {
     const uint16_t tail = data.header.tail;
-    if (isRecordValid(data.records[tail])) {
+    if (isSlotValid(0)) {
       break;
     }
 
     LOG_WARN("RTC",
              F("Dropping corrupt RTC slot idx=%u seq=%u"),
              static_cast<unsigned>(tail),
-             static_cast<unsigned>(data.records[tail].seq));
-    memset(&data.records[tail], 0, sizeof(RtcRecordV2));
+             static_cast<unsigned>(slotSeq(0)));
     data.header.tail = static_cast<uint16_t>((tail + 1U) % RTC_MAX_RECORDS);
     data.header.count--;
     removed++;
@@ -259,13 +480,13 @@ RtcReadStatus RtcManager::sanitizeFrontSlots(uint16_t budgetSlots) {
 
   if (removed > 0) {
     if (!writeData()) return RtcReadStatus::FILE_READ_ERROR;
-    if (data.header.count > 0 && !isRecordValid(data.records[data.header.tail])) {
+    if (data.header.count > 0 && !isSlotValid(0)) {
       return RtcReadStatus::SCANNING;
     }
     return RtcReadStatus::CORRUPT_DATA;
   }
 
-  if (data.header.count > 0 && !isRecordValid(data.records[data.header.tail])) {
+  if (data.header.count > 0 && !isSlotValid(0)) {
     return RtcReadStatus::SCANNING;
   }
 
@@ -278,6 +499,7 @@ RtcReadStatus RtcManager::loadAndHeal() {
   }
 
   if (validateHeader(data.header)) {
+    seqFloor = data.header.nextSeq;
     return sanitizeFrontSlots(RTC_RECOVERY_BUDGET_SLOTS);
   }
 
@@ -285,10 +507,9 @@ RtcReadStatus RtcManager::loadAndHeal() {
     return RtcReadStatus::CORRUPT_DATA;
   }
 
-  if (salvageFromCurrentSlots()) {
-    return RtcReadStatus::CORRUPT_DATA;
-  }
-
+  // V3 slots hold neither absolute timestamps nor sequence numbers, so without a valid header
+  // there is nothing to salvage them against.
+  LOG_WARN("RTC", F("RTC header invalid, reset fresh"));
   resetDataInMemory();
   if (!writeData()) {
     return RtcReadStatus::FILE_READ_ERROR;
@@ -319,21 +540,30 @@ bool RtcManager::append(uint32_t timestamp, int16_t temp10, int16_t hum10, uint1
     return false;
   }
 
-  if (data.header.count >= RTC_MAX_RECORDS) {
-    LOG_WARN("RTC", F("RTC full, overwriting oldest slot"));
-    data.header.tail = static_cast<uint16_t>((data.header.tail + 1U) % RTC_MAX_RECORDS);
-    data.header.count--;
-  }
-
   RtcSensorRecord payload;
   payload.timestamp = timestamp;
   payload.temp10 = temp10;
   payload.hum10 = hum10;
   payload.lux = lux;
   payload.rssi = rssi;
+  if (!fitsSlot(payload)) {
+    LOG_WARN("RTC", F("Sample outside RTC slot range"));
+    return false;
+  }
+
+  if (data.header.count >= RTC_MAX_RECORDS) {
+    LOG_WARN("RTC", F("RTC full, overwriting oldest slot"));
+    data.header.tail = static_cast<uint16_t>((data.header.tail + 1U) % RTC_MAX_RECORDS);
+    data.header.count--;
+  }
+
+  // Nothing was written yet; the next call reloads the image from RTC memory.
+  if (!fitTimestamp(timestamp)) {
+    LOG_WARN("RTC", F("Sample timestamp %lu too far from RTC base"), static_cast<unsigned long>(timestamp));
+    return false;
+  }
 
-  RtcRecordV2& slot = data.records[data.header.head];
-  setSlotFromPayload(slot, payload, data.header.nextSeq);
+  setSlotFromPayload(data.header.count, payload);
 
   data.header.head = static_cast<uint16_t>((data.header.head + 1U) % RTC_MAX_RECORDS);
   data.header.count++;
@@ -358,11 +588,10 @@ RtcReadStatus RtcManager::peekEx(RtcSensorRecord& outRecord) {
   if (data.header.count == 0) {
     return RtcReadStatus::CACHE_EMPTY;
   }
-  const RtcRecordV2& slot = data.records[data.header.tail];
-  if (!isRecordValid(slot)) {
+  if (!isSlotValid(0)) {
     return RtcReadStatus::CORRUPT_DATA;
   }
-  payloadFromSlot(outRecord, slot);
+  payloadFromSlot(outRecord, data.records[data.header.tail]);
   return RtcReadStatus::NONE;
 }
 
@@ -372,9 +601,7 @@ RtcReadStatus RtcManager::popEx(RtcSensorRecord& outRecord) {
     return status;
   }
 
-  const uint16_t oldTail = data.header.tail;
-  memset(&data.records[oldTail], 0, sizeof(RtcRecordV2));
-  data.header.tail = static_cast<uint16_t>((oldTail + 1U) % RTC_MAX_RECORDS);
+  data.header.tail = static_cast<uint16_t>((data.header.tail + 1U) % RTC_MAX_RECORDS);
   data.header.count--;
   if (data.header.count == 0) {
     data.header.head = 0;
@@ -387,6 +614,85 @@ RtcReadStatus RtcManager::popEx(RtcSensorRecord& outRecord) {
   return RtcReadStatus::NONE;
 }
 
+RtcReadStatus RtcManager::peekAtEx(uint16_t offset, RtcSensorRecord& outRecord, uint16_t& outSeq) {
+  RtcReadStatus status = loadAndHeal();
+  if (status != RtcReadStatus::NONE) {
+    return status;
+  }
+  if (offset >= data.header.count) {
+    return RtcReadStatus::CACHE_EMPTY;
+  }
+  if (!isSlotValid(offset)) {
+    return RtcReadStatus::CORRUPT_DATA;
+  }
+  payloadFromSlot(outRecord, data.records[slotIndex(offset)]);
+  outSeq = slotSeq(offset);
+  return RtcReadStatus::NONE;
+}
+
+RtcReadStatus RtcManager::peekRun(RtcSensorRecord* outRecords,
+                                  uint16_t* outSeqs,
+                                  uint16_t maxRecords,
+                                  uint16_t& outCount,
+                                  bool contiguous) {
+  outCount = 0;
+  if (!outRecords || !outSeqs || maxRecords == 0) {
+    return RtcReadStatus::FILE_READ_ERROR;
+  }
+  RtcReadStatus status = loadAndHeal();
+  if (status != RtcReadStatus::NONE) {
+    return status;
+  }
+  if (data.header.count == 0) {
+    return RtcReadStatus::CACHE_EMPTY;
+  }
+  for (uint16_t offset = 0; offset < data.header.count && outCount < maxRecords; ++offset) {
+    if (!isSlotValid(offset)) {
+      if (contiguous) {
+        return RtcReadStatus::CORRUPT_DATA;
+      }
+      continue;  // dropped along with its neighbours by popThroughSeq
+    }
+    payloadFromSlot(outRecords[outCount], data.records[slotIndex(offset)]);
+    outSeqs[outCount] = slotSeq(offset);
+    outCount++;
+  }
+  return RtcReadStatus::NONE;
+}
+
+RtcReadStatus RtcManager::popThroughSeq(uint16_t lastSeq, uint16_t maxRecords, uint16_t& outPopped) {
+  outPopped = 0;
+  RtcReadStatus status = loadAndHeal();
+  if (status == RtcReadStatus::FILE_READ_ERROR) {
+    return status;
+  }
+  if (data.header.count == 0) {
+    return RtcReadStatus::CACHE_EMPTY;
+  }
+
+  // Sequence-bounded so a slot healed away between peek and pop never makes us drop an unsent record.
+  // A watermark outside the stored range, or reaching past more records than were read, belongs to
+  // records already gone: a header heal or reset restarts the sequence, and what is stored now was
+  // never sent.
+  const uint16_t tailSeq = slotSeq(0);
+  if (seqBefore(lastSeq, tailSeq) || !seqBefore(lastSeq, data.header.nextSeq) ||
+      static_cast<uint16_t>(lastSeq - tailSeq) >= maxRecords) {
+    return RtcReadStatus::NONE;
+  }
+  outPopped = static_cast<uint16_t>(lastSeq - tailSeq + 1U);
+  data.header.tail = static_cast<uint16_t>((data.header.tail + outPopped) % RTC_MAX_RECORDS);
+  data.header.count = static_cast<uint16_t>(data.header.count - outPopped);
+  if (data.header.count == 0) {
+    data.header.head = 0;
+    data.header.tail = 0;
+  }
+
+  if (!writeData()) {
+    return RtcReadStatus::FILE_READ_ERROR;
+  }
+  return RtcReadStatus::NONE;
+}
+
 bool RtcManager::pop(RtcSensorRecord& outRecord) {
   return popEx(outRecord) == RtcReadStatus::NONE;
 }
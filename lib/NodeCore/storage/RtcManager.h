@@ -2,6 +2,7 @@
 #define RTC_MANAGER_H
 
 #include <Arduino.h>
+#include <stddef.h>
 #include <user_interface.h>
 
 // Public payload shape for caller (without RTC metadata).
@@ -16,11 +17,13 @@ struct alignas(4) RtcSensorRecord {
 // BootGuard occupies blocks 96..100 (20 bytes), so sensor cache starts at 101.
 #define RTC_SENSOR_BLOCK_OFFSET 101
 #define RTC_SENSOR_MAGIC 0xCAFEBABE
+// Per-record marker of layout V2; only recognised when migrating an older image.
 #define RTC_RECORD_MAGIC 0xBEEF
 
-// Layout V2 uses per-record CRC32 and magic marker.
-#define RTC_LAYOUT_VERSION 2
-#define RTC_MAX_RECORDS 17
+// Layout V3 packs records into 9-byte slots: timestamps are deltas from a base kept in the
+// header and each slot carries an 8-bit check instead of a magic and CRC32.
+#define RTC_LAYOUT_VERSION 3
+#define RTC_MAX_RECORDS 37
 #define RTC_RECOVERY_BUDGET_SLOTS 4
 
 // ESP8266 user RTC memory is blocks [64, 192), each block is 4 bytes.
@@ -35,18 +38,21 @@ enum class RtcReadStatus {
   SCANNING,
 };
 
-struct alignas(4) RtcRecordV2 {
-  uint16_t magic;
-  uint16_t seq;
-  uint32_t timestamp;
-  int16_t temp10;
-  int16_t hum10;
-  uint16_t lux;
-  int16_t rssi;
-  uint32_t crc;
+// One sample in layout V3, little-endian byte fields so the slots pack without padding:
+//   tsDelta  seconds after header.baseTimestamp; 0xFFFF marks a sample taken without valid time
+//   tempHum  temp10 and hum10 as two signed 12-bit fields
+//   check    low byte of a CRC32 over the slot's sequence number and the bytes before it
+// The sequence number is implied by the slot's position behind header.nextSeq, so a stale slot
+// from an earlier lap fails the check at its new position.
+struct RtcRecordV3 {
+  uint8_t tsDelta[2];
+  uint8_t tempHum[3];
+  uint8_t lux[2];
+  int8_t rssi;
+  uint8_t check;
 };
 
-struct alignas(4) RtcHeaderV2 {
+struct alignas(4) RtcHeaderV3 {
   uint32_t blockMagic;
   uint16_t version;
   uint16_t maxRecords;
@@ -54,32 +60,42 @@ struct alignas(4) RtcHeaderV2 {
   uint16_t tail;
   uint16_t count;
   uint16_t nextSeq;
+  uint32_t baseTimestamp;
   uint32_t headerCrc;
 };
 
+static constexpr size_t RTC_SENSOR_DATA_BYTES = 364;
+
 struct alignas(4) RtcSensorData {
-  RtcHeaderV2 header;
-  RtcRecordV2 records[RTC_MAX_RECORDS];
-  uint32_t reserved;
+  RtcHeaderV3 header;
+  RtcRecordV3 records[RTC_MAX_RECORDS];
+  uint8_t reserved[RTC_SENSOR_DATA_BYTES - sizeof(RtcHeaderV3) - RTC_MAX_RECORDS * sizeof(RtcRecordV3)];
 };
 
 static_assert(sizeof(RtcSensorRecord) == 12, "RtcSensorRecord payload must remain 12 bytes.");
-static_assert(sizeof(RtcRecordV2) == 20, "RtcRecordV2 layout must remain 20 bytes.");
-static_assert(sizeof(RtcHeaderV2) == 20, "RtcHeaderV2 layout must remain 20 bytes.");
-static_assert(sizeof(RtcSensorData) == 364, "RtcSensorData must remain 364 bytes in RTC.");
+static_assert(sizeof(RtcRecordV3) == 9, "RtcRecordV3 layout must remain 9 bytes.");
+static_assert(sizeof(RtcHeaderV3) == 24, "RtcHeaderV3 layout must remain 24 bytes.");
+static_assert(sizeof(RtcSensorData) == RTC_SENSOR_DATA_BYTES, "RtcSensorData must remain 364 bytes in RTC.");
 static_assert(sizeof(RtcSensorData) % 4 == 0, "RtcSensorData must be 4-byte aligned for system_rtc_mem_* API");
 static_assert((RTC_SENSOR_BLOCK_OFFSET >= RTC_USER_BLOCK_START),
               "RTC_SENSOR_BLOCK_OFFSET must be in ESP8266 RTC user region");
 static_assert((RTC_SENSOR_BLOCK_OFFSET + (sizeof(RtcSensorData) / 4)) <= RTC_USER_BLOCK_END,
               "RtcSensorData overflows ESP8266 RTC user region");
+static_assert(offsetof(RtcSensorData, records) % 4 == 0, "Record slots must start on an RTC block boundary");
 
 class RtcManager {
 public:
   static void init();
 
-  // Appends a new sensor record to SRAM caching. Returns true if successful.
+  // Appends a new sensor record to SRAM caching. Returns true if successful. Fails for values the
+  // V3 slot cannot hold (temp10/hum10 outside 12 bits, rssi outside 8 bits, or a timestamp more
+  // than ~18 h from the stored ones), so the caller falls back to LittleFS for those.
   static bool append(uint32_t timestamp, int16_t temp10, int16_t hum10, uint16_t lux, int16_t rssi);
 
+  // Whether a sample stamped `timestamp` would still fit next to the stored ones, which span at
+  // most ~18 h. Uses the records loaded by the last call.
+  static bool timestampFits(uint32_t timestamp);
+
   // Checks if RTC is completely full and requires an immediate LittleFS flush
   static bool isFull();
 
@@ -87,6 +103,24 @@ public:
   static RtcReadStatus peekEx(RtcSensorRecord& outRecord);
   static RtcReadStatus popEx(RtcSensorRecord& outRecord);
 
+  // Batch API: reads the record `offset` slots behind the tail along with its sequence number,
+  // and drops every front record up to and including `lastSeq` with a single RTC write. Drops
+  // nothing when `lastSeq` is not stored or more than `maxRecords` slots would go.
+  static RtcReadStatus peekAtEx(uint16_t offset, RtcSensorRecord& outRecord, uint16_t& outSeq);
+  static RtcReadStatus popThroughSeq(uint16_t lastSeq, uint16_t maxRecords, uint16_t& outPopped);
+
+  // Bulk flush API: copies up to `maxRecords` valid front records and their sequence numbers from
+  // a single RTC read, skipping corrupt slots. The sequence number of the last record persisted
+  // elsewhere is the watermark to hand to popThroughSeq afterwards.
+  // With `contiguous` the run instead ends at the first corrupt slot (CORRUPT_DATA, with the
+  // records before it), so it starts at the front record and holds the queue in order, as an
+  // upload batch needs.
+  static RtcReadStatus peekRun(RtcSensorRecord* outRecords,
+                               uint16_t* outSeqs,
+                               uint16_t maxRecords,
+                               uint16_t& outCount,
+                               bool contiguous = false);
+
   // Pops the oldest sensor record (e.g. on successful cloud sync). Returns true if a record was popped.
   static bool pop(RtcSensorRecord& outRecord);
 
@@ -105,24 +139,41 @@ public:
 private:
   static RtcSensorData data;
 
+  // RTC writes only cover what changed since the last read or write. Regions are the header
+  // (bit 0), each record slot (bit 1 + index) and the reserved tail; slots do not end on block
+  // boundaries, so each write is widened to the whole blocks it touches.
+  static constexpr uint8_t kDirtyRegions = RTC_MAX_RECORDS + 2;
+  static_assert(kDirtyRegions < 64, "Dirty region mask must fit 64 bits");
+  static constexpr uint64_t kAllDirty = (1ULL << kDirtyRegions) - 1ULL;
+  static uint64_t dirtyRegions;
+
   static bool readRaw();
   static bool writeRaw();
   static bool writeData();
   static void resetDataInMemory();
+  static void markSlotDirty(uint16_t index);
+  static bool writeRegions(uint8_t first, uint8_t count);
 
-  static bool validateHeader(const RtcHeaderV2& header);
-  static uint32_t calculateHeaderCrc(const RtcHeaderV2& header);
-  static uint32_t calculateRecordCrc(const RtcRecordV2& record);
-  static bool isRecordValid(const RtcRecordV2& record);
+  static bool validateHeader(const RtcHeaderV3& header);
+  static uint32_t calculateHeaderCrc(const RtcHeaderV3& header);
+  static uint8_t calculateRecordCheck(const RtcRecordV3& record, uint16_t seq);
+  static uint16_t slotIndex(uint16_t offset);
+  static uint16_t slotSeq(uint16_t offset);
+  static bool isSlotValid(uint16_t offset);
 
   static RtcReadStatus loadAndHeal();
   static RtcReadStatus sanitizeFrontSlots(uint16_t budgetSlots);
-  static bool salvageFromCurrentSlots();
   static bool tryMigrateFromLegacy();
+  static bool migrateFromV2();
+  static bool migrateFromV1();
   static bool legacyCrcValid(const void* legacyData);
+  static uint16_t importRecords(const RtcSensorRecord* records, uint16_t count);
 
-  static void setSlotFromPayload(RtcRecordV2& slot, const RtcSensorRecord& payload, uint16_t seq);
-  static void payloadFromSlot(RtcSensorRecord& outRecord, const RtcRecordV2& slot);
+  static bool fitsSlot(const RtcSensorRecord& payload);
+  static void timestampSpan(uint32_t timestamp, uint32_t& lo, uint32_t& hi);
+  static bool fitTimestamp(uint32_t timestamp);
+  static void setSlotFromPayload(uint16_t offset, const RtcSensorRecord& payload);
+  static void payloadFromSlot(RtcSensorRecord& outRecord, const RtcRecordV3& slot);
 };
 
 #endif // RTC_MANAGER_H
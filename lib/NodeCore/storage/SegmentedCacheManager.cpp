@@ -0,0 +1,705 @@
+#include "storage/SegmentedCacheManager.h"
+
+#include <system/ConfigManager.h>
+#include <FS.h>
+#include <LittleFS.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include "system/Logger.h"
+#include "storage/Paths.h"
+#include "storage/SensorBlockCodec.h"
+#include "support/Crc32.h"
+
+namespace {
+  constexpr uint32_t kSegmentMagic = 0x53454743;  // "CGES" little-endian: segment file header
+  constexpr uint32_t kCursorMagic = 0x52534743;   // tail cursor file
+  constexpr uint16_t kRecordMagic = 0xA55A;       // same sync marker as CacheManager records
+  constexpr uint16_t kFlushMutationThreshold = 32;
+  constexpr unsigned long kFlushMaxDelayMs = 120000UL;
+
+  struct SegmentHeader {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t crc;
+  };
+  constexpr uint32_t kSegmentHeaderBytes = sizeof(SegmentHeader);
+
+  // Oldest unconsumed position; the only state rewritten in place.
+  struct SegmentCursor {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t offset;
+    uint16_t skip;
+    uint16_t reserved;
+    uint32_t crc;
+  };
+
+  static_assert(SegmentedCacheManager::RECORD_OVERHEAD_BYTES ==
+                    sizeof(kRecordMagic) + sizeof(uint16_t) + sizeof(uint32_t),
+                "RECORD_OVERHEAD_BYTES must match the on-disk record framing.");
+  static_assert(kSegmentHeaderBytes + MAX_PAYLOAD_SIZE + SegmentedCacheManager::RECORD_OVERHEAD_BYTES <=
+                    SegmentedCacheManager::SEGMENT_BYTES,
+                "A segment must hold at least one maximum-size record.");
+  static_assert(SegmentedCacheManager::SEGMENT_BYTES <= 0xFFFFu, "Segment lengths are tracked as uint16_t.");
+  static_assert(SegmentedCacheManager::SEGMENT_COUNT >= 2, "Rotation needs at least two segments.");
+  static_assert(static_cast<size_t>(SegmentedCacheManager::SEGMENT_BYTES) * SegmentedCacheManager::SEGMENT_COUNT <=
+                    MAX_CACHE_DATA_SIZE + SegmentedCacheManager::SEGMENT_BYTES,
+                "Segment set must stay within the cache budget.");
+
+  template <typename T>
+  uint32_t crcOf(const T& value) {
+    return Crc32::compute(reinterpret_cast<const uint8_t*>(&value), offsetof(T, crc));
+  }
+
+  void segmentPath(char* out, size_t out_len, uint8_t slot) {
+    snprintf(out, out_len, "%s%02u.log", Paths::CACHE_SEGMENT_PREFIX, static_cast<unsigned>(slot));
+  }
+}  // namespace
+
+SegmentedCacheManager::SegmentedCacheManager() {}
+
+void SegmentedCacheManager::loadCursor(uint32_t& seq, uint32_t& offset, uint16_t& skip, bool& valid) {
+  valid = false;
+  if (!LittleFS.exists(Paths::CACHE_SEGMENT_CURSOR))
+    return;
+  fs::File file = LittleFS.open(Paths::CACHE_SEGMENT_CURSOR, "r");
+  if (!file)
+    return;
+  SegmentCursor cursor{};
+  const bool ok = file.read(reinterpret_cast<uint8_t*>(&cursor), sizeof(cursor)) == sizeof(cursor);
+  file.close();
+  if (!ok || cursor.magic != kCursorMagic || cursor.crc != crcOf(cursor))
+    return;
+  seq = cursor.seq;
+  offset = cursor.offset;
+  skip = cursor.skip;
+  valid = true;
+}
+
+// Append position of the newest segment: the end of its last intact record. Anything after
+// it is a torn write and gets overwritten by the next append.
+uint32_t SegmentedCacheManager::scanValidEnd(fs::File& file, uint32_t fileSize) {
+  uint8_t scratch[MAX_PAYLOAD_SIZE + sizeof(uint32_t)];
+  uint32_t pos = kSegmentHeaderBytes;
+  while (pos + RECORD_OVERHEAD_BYTES <= fileSize) {
+    uint16_t head[2];
+    file.seek(pos);
+    if (file.read(reinterpret_cast<uint8_t*>(head), sizeof(head)) != sizeof(head))
+      break;
+    const uint16_t record_len = head[1];
+    if (head[0] != kRecordMagic || record_len == 0 || record_len > MAX_PAYLOAD_SIZE ||
+        pos + record_len + RECORD_OVERHEAD_BYTES > fileSize)
+      break;
+    if (file.read(scratch, record_len + sizeof(uint32_t)) != record_len + sizeof(uint32_t))
+      break;
+    uint32_t stored_crc;
+    memcpy(&stored_crc, scratch + record_len, sizeof(stored_crc));
+    if (Crc32::compute(scratch, record_len) != stored_crc)
+      break;
+    pos += record_len + RECORD_OVERHEAD_BYTES;
+  }
+  return pos;
+}
+
+void SegmentedCacheManager::initImpl() {
+  if (m_initialized)
+    return;
+
+  uint32_t cursorSeq = 0;
+  uint32_t cursorOffset = 0;
+  uint16_t cursorSkip = 0;
+  bool cursorValid = false;
+  loadCursor(cursorSeq, cursorOffset, cursorSkip, cursorValid);
+
+  // Discover live segments by probing every slot; each header carries its sequence number.
+  uint32_t seqs[SEGMENT_COUNT] = {};
+  bool present[SEGMENT_COUNT] = {};
+  bool any = false;
+  uint32_t newest = 0;
+  uint32_t oldest = 0;
+  char path[16];
+  for (uint8_t slot = 0; slot < SEGMENT_COUNT; ++slot) {
+    m_segmentLen[slot] = 0;
+    segmentPath(path, sizeof(path), slot);
+    if (!LittleFS.exists(path))
+      continue;
+    fs::File file = LittleFS.open(path, "r");
+    SegmentHeader header{};
+    const bool ok = file && file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+                     header.magic == kSegmentMagic && header.crc == crcOf(header) && slotOf(header.seq) == slot &&
+                     file.size() <= SEGMENT_BYTES;
+    const size_t fileSize = ok ? file.size() : 0;
+    if (file)
+      file.close();
+    if (!ok) {
+      LOG_WARN("CACHE", F("Segment slot %u invalid. Removing."), slot);
+      LittleFS.remove(path);
+      continue;
+    }
+    present[slot] = true;
+    seqs[slot] = header.seq;
+    m_segmentLen[slot] = static_cast<uint16_t>(fileSize);
+    newest = (!any || header.seq > newest) ? header.seq : newest;
+    oldest = (!any || header.seq < oldest) ? header.seq : oldest;
+    any = true;
+  }
+
+  m_hasSegments = false;
+  m_headSeq = cursorValid ? cursorSeq : 0;
+  m_tailSeq = m_headSeq;
+  m_tailOffset = kSegmentHeaderBytes;
+  m_tailSkip = 0;
+  m_size = 0;
+
+  if (any) {
+    // Resume at the persisted cursor when it still names a live segment; segments older than
+    // it, or outside the newest window, were consumed before a crash and are removed now.
+    m_headSeq = newest;
+    m_tailSeq = oldest;
+    if (newest - oldest >= SEGMENT_COUNT)
+      m_tailSeq = newest - SEGMENT_COUNT + 1;
+    if (cursorValid && cursorSeq >= m_tailSeq && cursorSeq <= newest) {
+      m_tailSeq = cursorSeq;
+      m_tailOffset = cursorOffset;
+      m_tailSkip = cursorSkip;
+    }
+    for (uint8_t slot = 0; slot < SEGMENT_COUNT; ++slot) {
+      if (present[slot] && seqs[slot] < m_tailSeq) {
+        segmentPath(path, sizeof(path), slot);
+        LittleFS.remove(path);
+        m_segmentLen[slot] = 0;
+      }
+    }
+    m_hasSegments = true;
+
+    const uint8_t headSlot = slotOf(m_headSeq);
+    segmentPath(path, sizeof(path), headSlot);
+    m_headFile = LittleFS.open(path, "r+");
+    if (m_headFile) {
+      m_segmentLen[headSlot] = static_cast<uint16_t>(scanValidEnd(m_headFile, m_segmentLen[headSlot]));
+    } else {
+      LOG_ERROR("CACHE", F("Failed to open head segment %u."), m_headSeq);
+    }
+
+    const uint32_t tailLen = m_segmentLen[slotOf(m_tailSeq)];
+    if (m_tailOffset < kSegmentHeaderBytes || m_tailOffset > tailLen) {
+      m_tailOffset = kSegmentHeaderBytes;
+      m_tailSkip = 0;
+    }
+    for (uint32_t seq = m_tailSeq; seq <= m_headSeq; ++seq) {
+      const uint32_t len = m_segmentLen[slotOf(seq)];
+      if (len > kSegmentHeaderBytes)
+        m_size += len - kSegmentHeaderBytes;
+    }
+    const uint32_t consumed = m_tailOffset - kSegmentHeaderBytes;
+    m_size = (m_size > consumed) ? m_size - consumed : 0;
+  }
+
+  m_initialized = true;
+  m_dirty = false;
+  m_cursorDirty = false;
+  m_pendingMutations = 0;
+  m_lastFlushMs = millis();
+  LOG_INFO("CACHE", F("Segments OK. Size: %u bytes (seq %u..%u)"), m_size, m_tailSeq, m_headSeq);
+}
+
+void SegmentedCacheManager::resetImpl() {
+  LOG_WARN("CACHE", F("Resetting cache segments..."));
+  m_ioStats.resets++;
+  if (m_headFile)
+    m_headFile.close();
+  if (m_readFile)
+    m_readFile.close();
+  char path[16];
+  for (uint8_t slot = 0; slot < SEGMENT_COUNT; ++slot) {
+    segmentPath(path, sizeof(path), slot);
+    if (LittleFS.exists(path))
+      LittleFS.remove(path);
+    m_segmentLen[slot] = 0;
+  }
+  LittleFS.remove(Paths::CACHE_SEGMENT_CURSOR);
+  m_initialized = false;
+  initImpl();
+}
+
+void SegmentedCacheManager::flush() {
+  if (!m_dirty)
+    return;
+
+  const uint32_t started = micros();
+  m_ioStats.flushes++;
+  if (m_headFile)
+    m_headFile.flush();
+  if (m_cursorDirty) {
+    SegmentCursor cursor{kCursorMagic, m_hasSegments ? m_tailSeq : m_headSeq, m_tailOffset, m_tailSkip, 0, 0};
+    cursor.crc = crcOf(cursor);
+    fs::File file = LittleFS.open(Paths::CACHE_SEGMENT_CURSOR, "w");
+    const bool ok = file && file.write(reinterpret_cast<const uint8_t*>(&cursor), sizeof(cursor)) == sizeof(cursor);
+    if (file)
+      file.close();
+    m_ioStats.headerWrites++;
+    if (!ok) {
+      m_ioStats.flushMicros += micros() - started;
+      LOG_WARN("CACHE", F("Segment cursor write failed."));
+      return;
+    }
+    m_cursorDirty = false;
+  }
+  m_dirty = false;
+  m_pendingMutations = 0;
+  m_lastFlushMs = millis();
+  m_ioStats.flushMicros += micros() - started;
+}
+
+CacheDownsampler::PassResult SegmentedCacheManager::downsample_step(uint32_t budgetBytes) {
+  static constexpr uint32_t kPassAppendBytes =
+      CacheDownsampler::kMaxWindowsPerPass * (SensorAggregateCodec::kRecordLen + RECORD_OVERHEAD_BYTES);
+  const bool headHasRoom = m_headFile && m_segmentLen[slotOf(m_headSeq)] + kPassAppendBytes <= SEGMENT_BYTES;
+  if (m_hasSegments && !headHasRoom && m_headSeq + 1 - m_tailSeq >= SEGMENT_COUNT)
+    return {};
+  const CacheDownsampler::PassResult pass =
+      CacheDownsampler::step(*this, m_downsample, static_cast<uint32_t>(SEGMENT_BYTES) * SEGMENT_COUNT, budgetBytes);
+  m_ioStats.downsampledEntries += pass.entries;
+  return pass;
+}
+
+void SegmentedCacheManager::markDirty() {
+  m_dirty = true;
+  if (m_pendingMutations < 0xFFFFu) {
+    m_pendingMutations++;
+  }
+  const unsigned long now = millis();
+  const bool timedOut = (m_lastFlushMs == 0 || now < m_lastFlushMs || (now - m_lastFlushMs) >= kFlushMaxDelayMs);
+  if (m_pendingMutations >= kFlushMutationThreshold || timedOut) {
+    flush();
+  }
+}
+
+// =============================================================================
+// Segment lifecycle
+// =============================================================================
+
+fs::File* SegmentedCacheManager::segmentFile(uint32_t seq) {
+  if (seq == m_headSeq && m_headFile)
+    return &m_headFile;
+  if (m_readFile && m_readSeq == seq)
+    return &m_readFile;
+  if (m_readFile)
+    m_readFile.close();
+  char path[16];
+  segmentPath(path, sizeof(path), slotOf(seq));
+  m_readFile = LittleFS.open(path, "r");
+  m_readSeq = seq;
+  return m_readFile ? &m_readFile : nullptr;
+}
+
+bool SegmentedCacheManager::openHeadSegment(uint32_t seq) {
+  char path[16];
+  const uint8_t slot = slotOf(seq);
+  segmentPath(path, sizeof(path), slot);
+  m_headFile = LittleFS.open(path, "w+");
+  if (!m_headFile) {
+    LOG_ERROR("CACHE", F("Failed to create segment %u."), seq);
+    return false;
+  }
+  SegmentHeader header{kSegmentMagic, seq, 0};
+  header.crc = crcOf(header);
+  if (m_headFile.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) != sizeof(header)) {
+    LOG_ERROR("CACHE", F("Failed to write segment %u header."), seq);
+    m_headFile.close();
+    LittleFS.remove(path);
+    return false;
+  }
+  m_headSeq = seq;
+  m_segmentLen[slot] = kSegmentHeaderBytes;
+  return true;
+}
+
+// Deletes the tail segment whole (consumed, or evicted when every slot is in use).
+void SegmentedCacheManager::dropTailSegment() {
+  const uint8_t slot = slotOf(m_tailSeq);
+  const uint32_t len = m_segmentLen[slot];
+  const uint32_t remaining = (len > m_tailOffset) ? len - m_tailOffset : 0;
+  m_size = (m_size > remaining) ? m_size - remaining : 0;
+
+  if (m_readFile && m_readSeq == m_tailSeq)
+    m_readFile.close();
+  const bool wasHead = (m_tailSeq == m_headSeq);
+  if (wasHead && m_headFile)
+    m_headFile.close();
+  char path[16];
+  segmentPath(path, sizeof(path), slot);
+  LittleFS.remove(path);
+  m_segmentLen[slot] = 0;
+
+  m_tailSkip = 0;
+  m_tailOffset = kSegmentHeaderBytes;
+  m_cursorDirty = true;
+  if (wasHead) {
+    m_hasSegments = false;
+    m_size = 0;
+    return;
+  }
+  m_tailSeq++;
+}
+
+bool SegmentedCacheManager::rotate() {
+  if (m_headFile) {
+    m_headFile.flush();
+    m_headFile.close();
+  }
+  if (m_hasSegments && m_size == 0)
+    dropTailSegment();  // drained: the old head is not worth keeping
+
+  const uint32_t next = m_headSeq + 1;
+  if (m_hasSegments && next - m_tailSeq >= SEGMENT_COUNT) {
+    LOG_WARN("CACHE", F("Segments full. Dropping oldest (seq %u)."), m_tailSeq);
+    const uint32_t started = micros();
+    const uint32_t sizeBefore = m_size;
+    dropTailSegment();
+    m_ioStats.trims++;
+    m_ioStats.trimmedBytes += sizeBefore - m_size;
+    m_ioStats.trimMicros += micros() - started;
+  }
+  if (!openHeadSegment(next))
+    return false;
+  if (!m_hasSegments) {
+    m_hasSegments = true;
+    m_tailSeq = next;
+    m_tailOffset = kSegmentHeaderBytes;
+    m_tailSkip = 0;
+    m_cursorDirty = true;
+  }
+  return true;
+}
+
+void SegmentedCacheManager::advanceTail(uint32_t bytes) {
+  m_tailOffset += bytes;
+  m_size = (m_size > bytes) ? m_size - bytes : 0;
+  m_tailSkip = 0;
+  m_cursorDirty = true;
+  // Fully consumed segments are plain file deletes; the head stays open for appends.
+  while (m_hasSegments && m_tailSeq != m_headSeq && m_tailOffset >= m_segmentLen[slotOf(m_tailSeq)]) {
+    dropTailSegment();
+  }
+}
+
+// =============================================================================
+// Record access
+// =============================================================================
+
+bool SegmentedCacheManager::normalizeCursor(PeekCursor& cursor) const {
+  if (!m_hasSegments || cursor.seq < m_tailSeq)
+    return false;
+  while (cursor.seq <= m_headSeq) {
+    if (cursor.offset < m_segmentLen[slotOf(cursor.seq)])
+      return true;
+    if (cursor.seq == m_headSeq)
+      return false;
+    cursor.seq++;
+    cursor.offset = kSegmentHeaderBytes;
+    cursor.sample = 0;
+  }
+  return false;
+}
+
+SegmentedCacheManager::FrameStatus SegmentedCacheManager::readFrame(const PeekCursor& cursor,
+                                                                    uint8_t* payload,
+                                                                    uint16_t& record_len) {
+  fs::File* file = segmentFile(cursor.seq);
+  if (!file)
+    return FrameStatus::IO_ERROR;
+  const uint32_t end = m_segmentLen[slotOf(cursor.seq)];
+  uint16_t head[2];
+  if (cursor.offset + sizeof(head) > end)
+    return FrameStatus::CORRUPT;
+  file->seek(cursor.offset);
+  if (file->read(reinterpret_cast<uint8_t*>(head), sizeof(head)) != sizeof(head))
+    return FrameStatus::IO_ERROR;
+  record_len = head[1];
+  if (head[0] != kRecordMagic || record_len == 0 || record_len > MAX_PAYLOAD_SIZE ||
+      cursor.offset + record_len + RECORD_OVERHEAD_BYTES > end)
+    return FrameStatus::CORRUPT;
+  if (file->read(payload, record_len + sizeof(uint32_t)) != record_len + sizeof(uint32_t))
+    return FrameStatus::IO_ERROR;
+  uint32_t stored_crc;
+  memcpy(&stored_crc, payload + record_len, sizeof(stored_crc));
+  return (Crc32::compute(payload, record_len) == stored_crc) ? FrameStatus::OK : FrameStatus::CORRUPT;
+}
+
+CacheReadError SegmentedCacheManager::readEntry(PeekCursor& cursor, char* out_buffer, size_t buffer_size, size_t& out_len) {
+  out_len = 0;
+  if (!normalizeCursor(cursor))
+    return CacheReadError::CACHE_EMPTY;
+
+  uint8_t payload[MAX_PAYLOAD_SIZE + sizeof(uint32_t)];
+  uint16_t record_len = 0;
+  const FrameStatus frame = readFrame(cursor, payload, record_len);
+  if (frame == FrameStatus::IO_ERROR)
+    return CacheReadError::FILE_READ_ERROR;
+  if (frame == FrameStatus::CORRUPT)
+    return CacheReadError::CORRUPT_DATA;
+
+  const uint8_t count = SensorBlockCodec::sample_count(payload, record_len);
+  if (count == 0) {
+    if (record_len > buffer_size)
+      return CacheReadError::OUT_OF_MEMORY;
+    memcpy(out_buffer, payload, record_len);
+    out_len = record_len;
+    cursor.offset += record_len + RECORD_OVERHEAD_BYTES;
+    cursor.sample = 0;
+    (void)normalizeCursor(cursor);  // never park on a segment end that pops may delete
+    return CacheReadError::NONE;
+  }
+
+  RtcSensorRecord sample;
+  if (cursor.sample >= count ||
+      !SensorBlockCodec::decode_at(payload, record_len, static_cast<uint8_t>(cursor.sample), sample))
+    return CacheReadError::CORRUPT_DATA;
+  if (buffer_size < SENSOR_RECORD_LEN)
+    return CacheReadError::OUT_OF_MEMORY;
+  out_buffer[0] = static_cast<char>(SENSOR_RECORD_TAG);
+  memcpy(out_buffer + 1, &sample, sizeof(sample));
+  out_len = SENSOR_RECORD_LEN;
+  if (++cursor.sample >= count) {
+    cursor.offset += record_len + RECORD_OVERHEAD_BYTES;
+    cursor.sample = 0;
+    (void)normalizeCursor(cursor);
+  }
+  return CacheReadError::NONE;
+}
+
+// Consumes up to maxEntries from the tail record (a block may yield several) and reports how
+// many in `consumed`. A frame that does not parse takes the rest of its segment with it, since
+// records after it cannot be located; that returns false so batch pops stop there.
+bool SegmentedCacheManager::popStep(size_t maxEntries, size_t& consumed) {
+  consumed = 0;
+  if (!m_hasSegments || m_size == 0 || maxEntries == 0)
+    return false;
+  const uint32_t end = m_segmentLen[slotOf(m_tailSeq)];
+  const uint32_t left = (end > m_tailOffset) ? end - m_tailOffset : 0;
+  uint8_t frame[6];  // magic (2) + length (2) + block tag (1) + sample count (1)
+  const size_t want = (left < sizeof(frame)) ? left : sizeof(frame);
+  fs::File* file = segmentFile(m_tailSeq);
+  bool ok = file && want >= sizeof(kRecordMagic) + sizeof(uint16_t);
+  if (ok) {
+    file->seek(m_tailOffset);
+    ok = file->read(frame, want) == want;
+  }
+  uint16_t magic = 0;
+  uint16_t record_len = 0;
+  if (ok) {
+    memcpy(&magic, frame, sizeof(magic));
+    memcpy(&record_len, frame + sizeof(magic), sizeof(record_len));
+    ok = magic == kRecordMagic && record_len > 0 && record_len <= MAX_PAYLOAD_SIZE &&
+         record_len + RECORD_OVERHEAD_BYTES <= left;
+  }
+  if (!ok) {
+    LOG_WARN("CACHE", F("Pop: segment %u unreadable at +%u. Skipping remainder."), m_tailSeq, m_tailOffset);
+    advanceTail(left);
+    return false;
+  }
+
+  const bool isBlock =
+      want == sizeof(frame) && record_len >= SensorBlockCodec::kHeaderBytes && frame[4] == SensorBlockCodec::kTag;
+  if (isBlock && m_tailSkip < frame[5]) {
+    const size_t remaining = frame[5] - m_tailSkip;
+    if (maxEntries < remaining) {
+      m_tailSkip = static_cast<uint16_t>(m_tailSkip + maxEntries);
+      m_cursorDirty = true;
+      consumed = maxEntries;
+      return true;
+    }
+    consumed = remaining;
+  } else if (!isBlock) {
+    consumed = 1;
+  }
+  // A block whose samples were all consumed already is just dropped.
+  advanceTail(record_len + RECORD_OVERHEAD_BYTES);
+  return true;
+}
+
+bool SegmentedCacheManager::writeImpl(const char* data, uint16_t len, CacheLane /*lane*/) {
+  if (len == 0)
+    return true;
+  if (!m_initialized)
+    initImpl();
+  if (len > MAX_PAYLOAD_SIZE) {
+    LOG_ERROR("CACHE", F("Record is too large to fit in cache."));
+    return false;
+  }
+
+  const uint32_t started = micros();
+  const uint32_t total = len + RECORD_OVERHEAD_BYTES;
+  if (!m_hasSegments || !m_headFile || m_segmentLen[slotOf(m_headSeq)] + total > SEGMENT_BYTES) {
+    if (!rotate()) {
+      LOG_ERROR("CACHE", F("No writable segment. Write aborted."));
+      return false;
+    }
+  }
+
+  // One sequential append per record.
+  uint8_t frame[MAX_PAYLOAD_SIZE + RECORD_OVERHEAD_BYTES];
+  const uint32_t payload_crc = Crc32::compute(reinterpret_cast<const uint8_t*>(data), len);
+  memcpy(frame, &kRecordMagic, sizeof(kRecordMagic));
+  memcpy(frame + sizeof(kRecordMagic), &len, sizeof(len));
+  memcpy(frame + sizeof(kRecordMagic) + sizeof(len), data, len);
+  memcpy(frame + sizeof(kRecordMagic) + sizeof(len) + len, &payload_crc, sizeof(payload_crc));
+
+  const uint8_t slot = slotOf(m_headSeq);
+  const uint32_t appendStarted = micros();
+  m_headFile.seek(m_segmentLen[slot]);
+  const bool written = m_headFile.write(frame, total) == total;
+  m_ioStats.writeMicros += micros() - appendStarted;
+  if (!written) {
+    LOG_ERROR("CACHE", F("Segment %u append failed."), m_headSeq);
+    return false;
+  }
+  m_segmentLen[slot] = static_cast<uint16_t>(m_segmentLen[slot] + total);
+  m_size += total;
+  m_ioStats.appends++;
+  m_ioStats.logicalBytes += len;
+  m_ioStats.framedBytes += total;
+  markDirty();
+  const uint32_t elapsed = micros() - started;
+  if (elapsed > m_ioStats.maxWriteMicros) {
+    m_ioStats.maxWriteMicros = elapsed;
+  }
+  return true;
+}
+
+CacheReadError SegmentedCacheManager::read_oneImpl(char* out_buffer,
+                                                   size_t buffer_size,
+                                                   size_t& out_len,
+                                                   CacheLane lane) {
+  out_len = 0;
+  if (!m_initialized)
+    initImpl();
+  if (m_size == 0 || lane != CacheLane::ROUTINE)
+    return CacheReadError::CACHE_EMPTY;
+
+  PeekCursor cursor = peek_begin();
+  const CacheReadError err = readEntry(cursor, out_buffer, buffer_size, out_len);
+  if (err == CacheReadError::CORRUPT_DATA) {
+    const uint32_t end = m_segmentLen[slotOf(m_tailSeq)];
+    LOG_ERROR("CACHE", F("Segment %u corrupt at +%u. Discarding remainder."), m_tailSeq, m_tailOffset);
+    advanceTail((end > m_tailOffset) ? end - m_tailOffset : 0);
+    markDirty();
+  }
+  return err;
+}
+
+bool SegmentedCacheManager::pop_oneImpl(CacheLane lane) {
+  if (!m_initialized)
+    initImpl();
+  if (m_size == 0 || lane != CacheLane::ROUTINE)
+    return true;
+  size_t consumed = 0;
+  (void)popStep(1, consumed);
+  markDirty();
+  return true;
+}
+
+CacheReadError SegmentedCacheManager::read_manyImpl(std::span<char> out,
+                                                    std::span<uint16_t> lengths,
+                                                    size_t maxRecords,
+                                                    size_t& outRecords,
+                                                    CacheLane lane) {
+  outRecords = 0;
+  if (maxRecords > lengths.size())
+    maxRecords = lengths.size();
+  if (!m_initialized)
+    initImpl();
+  if (m_size == 0 || lane != CacheLane::ROUTINE)
+    return CacheReadError::CACHE_EMPTY;
+  if (maxRecords == 0 || out.empty())
+    return CacheReadError::OUT_OF_MEMORY;
+
+  PeekCursor cursor = peek_begin();
+  size_t used = 0;
+  CacheReadError status = CacheReadError::NONE;
+  while (outRecords < maxRecords) {
+    size_t len = 0;
+    status = readEntry(cursor, out.data() + used, out.size() - used, len);
+    if (status != CacheReadError::NONE)
+      break;
+    lengths[outRecords++] = static_cast<uint16_t>(len);
+    used += len;
+  }
+  return (outRecords > 0) ? CacheReadError::NONE : status;
+}
+
+size_t SegmentedCacheManager::pop_manyImpl(size_t count, CacheLane lane) {
+  if (!m_initialized)
+    initImpl();
+  if (lane != CacheLane::ROUTINE)
+    return 0;
+  size_t popped = 0;
+  while (popped < count && m_size > 0) {
+    size_t consumed = 0;
+    if (!popStep(count - popped, consumed))
+      break;
+    popped += consumed;
+  }
+  if (popped > 0)
+    markDirty();
+  return popped;
+}
+
+SegmentedCacheManager::PeekCursor SegmentedCacheManager::peek_begin(CacheLane lane) const {
+  PeekCursor cursor;
+  cursor.lane = lane;
+  cursor.seq = m_tailSeq;
+  cursor.offset = m_tailOffset;
+  cursor.sample = m_tailSkip;
+  return cursor;
+}
+
+CacheReadError SegmentedCacheManager::peek_next(PeekCursor& cursor, char* out_buffer, size_t buffer_size, size_t& out_len) {
+  out_len = 0;
+  if (!m_initialized)
+    initImpl();
+  if (m_size == 0 || cursor.lane != CacheLane::ROUTINE)
+    return CacheReadError::CACHE_EMPTY;
+  return readEntry(cursor, out_buffer, buffer_size, out_len);
+}
+
+bool SegmentedCacheManager::write_sensor_record(const RtcSensorRecord& record, CacheLane lane) {
+  char packed[SENSOR_RECORD_LEN];
+  packed[0] = static_cast<char>(SENSOR_RECORD_TAG);
+  memcpy(packed + 1, &record, sizeof(record));
+  return writeImpl(packed, SENSOR_RECORD_LEN, lane);
+}
+
+size_t SegmentedCacheManager::write_sensor_block(const RtcSensorRecord* records, size_t count) {
+  if (!records || count == 0)
+    return 0;
+
+  uint8_t block[SENSOR_BLOCK_MAX_BYTES];
+  size_t encoded = 0;
+  const size_t len = SensorBlockCodec::encode(records, count, block, sizeof(block), encoded);
+  if (len == 0 || encoded == 0)
+    return 0;
+  return writeImpl(reinterpret_cast<const char*>(block), static_cast<uint16_t>(len), CacheLane::ROUTINE) ? encoded : 0;
+}
+
+bool SegmentedCacheManager::decode_sensor_record(const char* data, size_t len, RtcSensorRecord& out) {
+  if (!data || len != SENSOR_RECORD_LEN || static_cast<uint8_t>(data[0]) != SENSOR_RECORD_TAG) {
+    return false;
+  }
+  memcpy(&out, data + 1, sizeof(out));
+  return true;
+}
+
+void SegmentedCacheManager::get_statusImpl(uint32_t& size_bytes, uint32_t& head, uint32_t& tail) {
+  size_bytes = m_size;
+  head = m_headSeq;
+  tail = m_tailSeq;
+}
+
+uint32_t SegmentedCacheManager::get_sizeImpl() {
+  return m_size;
+}
@@ -0,0 +1,124 @@
+#ifndef SEGMENTED_CACHE_MANAGER_H
+#define SEGMENTED_CACHE_MANAGER_H
+
+#include "interfaces/ICacheManager.h"
+#include "storage/CacheDownsampler.h"
+#include "storage/RtcManager.h"
+#include <FS.h>
+
+// Segment geometry. The default fills MAX_CACHE_DATA_SIZE with 4 KB files, one LittleFS
+// erase block each, so dropping a consumed segment frees whole blocks without copying.
+#ifndef CACHE_SEGMENT_BYTES
+#define CACHE_SEGMENT_BYTES 4096
+#endif
+#ifndef CACHE_SEGMENT_COUNT
+#define CACHE_SEGMENT_COUNT 25
+#endif
+
+// ============================================================================
+// SegmentedCacheManager - append-only log of fixed-size segment files
+// ============================================================================
+// Alternative engine to the single wrap-around /cache.dat (select with
+// -D CACHE_ENGINE_SEGMENTED). Records use the same framing and payload formats as
+// CacheManager, but are only ever appended to the newest segment; a segment is deleted
+// once its last record is popped, and when all slots are in use the oldest segment is
+// dropped whole. Nothing is rewritten in place except the small tail cursor file.
+
+class SegmentedCacheManager : public ICacheManager<SegmentedCacheManager> {
+  friend class ICacheManager<SegmentedCacheManager>;
+
+public:
+  SegmentedCacheManager();
+
+  SegmentedCacheManager(const SegmentedCacheManager&) = delete;
+  SegmentedCacheManager& operator=(const SegmentedCacheManager&) = delete;
+
+  // CRTP implementation methods. The segment log is a single lane: PRIORITY writes are
+  // appended in order with everything else and the PRIORITY lane always reads empty.
+  void initImpl();
+  void resetImpl();
+  [[nodiscard]] bool writeImpl(const char* data, uint16_t len, CacheLane lane);
+  CacheReadError read_oneImpl(char* out_buffer, size_t buffer_size, size_t& out_len, CacheLane lane);
+  [[nodiscard]] bool pop_oneImpl(CacheLane lane);
+  CacheReadError read_manyImpl(std::span<char> out,
+                               std::span<uint16_t> lengths,
+                               size_t maxRecords,
+                               size_t& outRecords,
+                               CacheLane lane);
+  [[nodiscard]] size_t pop_manyImpl(size_t count, CacheLane lane);
+  // head/tail report the newest and oldest live segment sequence numbers.
+  void get_statusImpl(uint32_t& size_bytes, uint32_t& head, uint32_t& tail);
+  [[nodiscard]] uint32_t get_sizeImpl();
+  [[nodiscard]] uint32_t get_lane_sizeImpl(CacheLane lane) { return (lane == CacheLane::ROUTINE) ? m_size : 0; }
+  // Segment evictions count as trims; cursor file writes count as header writes.
+  [[nodiscard]] const CacheIoStats& io_statsImpl() const { return m_ioStats; }
+
+  // Syncs the open segment and persists the tail cursor if it moved.
+  void flush();
+
+  // Same as CacheManager::downsample_step(); skipped while appending could force the oldest
+  // segment out.
+  CacheDownsampler::PassResult downsample_step(uint32_t budgetBytes = CACHE_DOWNSAMPLE_BUDGET_BYTES);
+
+  // Same record framing and payload formats as CacheManager.
+  static constexpr uint32_t RECORD_OVERHEAD_BYTES = 8;
+  static constexpr uint8_t SENSOR_RECORD_TAG = 0x01;
+  static constexpr uint16_t SENSOR_RECORD_LEN = 1 + sizeof(RtcSensorRecord);
+  static constexpr uint32_t LITTLEFS_PAGE_BYTES = 256;
+  static constexpr uint16_t SENSOR_BLOCK_MAX_BYTES = LITTLEFS_PAGE_BYTES - RECORD_OVERHEAD_BYTES;
+
+  static constexpr uint32_t SEGMENT_BYTES = CACHE_SEGMENT_BYTES;
+  static constexpr uint8_t SEGMENT_COUNT = CACHE_SEGMENT_COUNT;
+
+  struct PeekCursor {
+    uint32_t seq = 0;
+    uint32_t offset = 0;
+    uint16_t sample = 0;
+    CacheLane lane = CacheLane::ROUTINE;
+  };
+
+  [[nodiscard]] PeekCursor peek_begin(CacheLane lane = CacheLane::ROUTINE) const;
+  CacheReadError peek_next(PeekCursor& cursor, char* out_buffer, size_t buffer_size, size_t& out_len);
+
+  [[nodiscard]] bool write_sensor_record(const RtcSensorRecord& record, CacheLane lane = CacheLane::ROUTINE);
+  [[nodiscard]] static bool decode_sensor_record(const char* data, size_t len, RtcSensorRecord& out);
+  [[nodiscard]] size_t write_sensor_block(const RtcSensorRecord* records, size_t count);
+
+private:
+  enum class FrameStatus : uint8_t { OK, IO_ERROR, CORRUPT };
+
+  [[nodiscard]] uint8_t slotOf(uint32_t seq) const { return static_cast<uint8_t>(seq % SEGMENT_COUNT); }
+  fs::File* segmentFile(uint32_t seq);
+  bool openHeadSegment(uint32_t seq);
+  bool rotate();
+  void dropTailSegment();
+  void advanceTail(uint32_t bytes);
+  bool normalizeCursor(PeekCursor& cursor) const;
+  FrameStatus readFrame(const PeekCursor& cursor, uint8_t* payload, uint16_t& record_len);
+  CacheReadError readEntry(PeekCursor& cursor, char* out_buffer, size_t buffer_size, size_t& out_len);
+  bool popStep(size_t maxEntries, size_t& consumed);
+  uint32_t scanValidEnd(fs::File& file, uint32_t fileSize);
+  void loadCursor(uint32_t& seq, uint32_t& offset, uint16_t& skip, bool& valid);
+  void markDirty();
+
+  fs::File m_headFile;
+  fs::File m_readFile;
+  uint32_t m_readSeq = 0;
+  bool m_hasSegments = false;
+  bool m_initialized = false;
+  uint32_t m_headSeq = 0;
+  uint32_t m_tailSeq = 0;
+  uint32_t m_tailOffset = 0;
+  uint16_t m_tailSkip = 0;
+  uint32_t m_size = 0;
+  uint16_t m_segmentLen[CACHE_SEGMENT_COUNT] = {};  // bytes in each slot's file, header included
+
+  bool m_dirty = false;
+  bool m_cursorDirty = false;
+  uint16_t m_pendingMutations = 0;
+  unsigned long m_lastFlushMs = 0;
+  CacheIoStats m_ioStats;
+  CacheDownsampler::State m_downsample;
+};
+
+#endif  // SEGMENTED_CACHE_MANAGER_H
@@ -0,0 +1,115 @@
+#ifndef SENSOR_AGGREGATE_CODEC_H
+#define SENSOR_AGGREGATE_CODEC_H
+
+#include <Arduino.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "storage/RtcManager.h"
+
+// Aggregate record for downsampled cache history: one framed record summarising a time window
+// of samples as min/mean/max temperature and humidity plus mean lux and rssi.
+//
+// Layout: tag (1) | SensorAggregate (24). Like compact records it is rendered to JSON only when
+// it is sent, and the tag never collides with legacy JSON ('{') or the sample formats.
+namespace SensorAggregateCodec {
+
+  static constexpr uint8_t kTag = 0x03;
+
+  struct alignas(4) SensorAggregate {
+    uint32_t start;   // timestamp of the first sample merged
+    uint16_t window;  // seconds per bucket this aggregate was built for
+    uint16_t count;   // samples merged
+    int16_t tempMin10;
+    int16_t tempMean10;
+    int16_t tempMax10;
+    int16_t humMin10;
+    int16_t humMean10;
+    int16_t humMax10;
+    uint16_t luxMean;
+    int16_t rssiMean;
+  };
+  static_assert(sizeof(SensorAggregate) == 24, "SensorAggregate layout is part of the cache format");
+
+  static constexpr uint16_t kRecordLen = 1 + sizeof(SensorAggregate);
+
+  // A single sample as a one-sample aggregate, so samples and aggregates merge the same way.
+  [[maybe_unused]] inline SensorAggregate from_sample(const RtcSensorRecord& s) {
+    return {s.timestamp, 0, 1, s.temp10, s.temp10, s.temp10, s.hum10, s.hum10, s.hum10, s.lux, s.rssi};
+  }
+
+  // Running min/max/sum over the samples of one window; aggregates merge in weighted by count.
+  struct Accumulator {
+    uint16_t window = 0;
+    uint32_t first = 0;
+    uint16_t count = 0;
+    int16_t tempMin10 = 0;
+    int16_t tempMax10 = 0;
+    int16_t humMin10 = 0;
+    int16_t humMax10 = 0;
+    int32_t tempSum = 0;
+    int32_t humSum = 0;
+    uint32_t luxSum = 0;
+    int32_t rssiSum = 0;
+
+    void merge(const SensorAggregate& a) {
+      if (a.count == 0 || count > 0xFFFFU - a.count) {
+        return;
+      }
+      if (count == 0) {
+        first = a.start;
+        tempMin10 = a.tempMin10;
+        tempMax10 = a.tempMax10;
+        humMin10 = a.humMin10;
+        humMax10 = a.humMax10;
+      }
+      first = (a.start < first) ? a.start : first;
+      tempMin10 = (a.tempMin10 < tempMin10) ? a.tempMin10 : tempMin10;
+      tempMax10 = (a.tempMax10 > tempMax10) ? a.tempMax10 : tempMax10;
+      humMin10 = (a.humMin10 < humMin10) ? a.humMin10 : humMin10;
+      humMax10 = (a.humMax10 > humMax10) ? a.humMax10 : humMax10;
+      tempSum += static_cast<int32_t>(a.tempMean10) * a.count;
+      humSum += static_cast<int32_t>(a.humMean10) * a.count;
+      luxSum += static_cast<uint32_t>(a.luxMean) * a.count;
+      rssiSum += static_cast<int32_t>(a.rssiMean) * a.count;
+      count = static_cast<uint16_t>(count + a.count);
+    }
+
+    [[nodiscard]] SensorAggregate finish() const {
+      SensorAggregate out{};
+      if (count == 0) {
+        return out;
+      }
+      const int32_t n = count;
+      out.start = first;
+      out.window = window;
+      out.count = count;
+      out.tempMin10 = tempMin10;
+      out.tempMean10 = static_cast<int16_t>(tempSum / n);
+      out.tempMax10 = tempMax10;
+      out.humMin10 = humMin10;
+      out.humMean10 = static_cast<int16_t>(humSum / n);
+      out.humMax10 = humMax10;
+      out.luxMean = static_cast<uint16_t>(luxSum / static_cast<uint32_t>(count));
+      out.rssiMean = static_cast<int16_t>(rssiSum / n);
+      return out;
+    }
+  };
+
+  [[maybe_unused]] inline void encode(const SensorAggregate& agg, char* out) {
+    out[0] = static_cast<char>(kTag);
+    memcpy(out + 1, &agg, sizeof(agg));
+  }
+
+  [[maybe_unused]] inline bool decode(const char* data, size_t len, SensorAggregate& out) {
+    if (!data || len != kRecordLen || static_cast<uint8_t>(data[0]) != kTag) {
+      return false;
+    }
+    memcpy(&out, data + 1, sizeof(out));
+    return true;
+  }
+
+}  // namespace SensorAggregateCodec
+
+#endif  // SENSOR_AGGREGATE_CODEC_H
@@ -0,0 +1,127 @@
+#ifndef SENSOR_BLOCK_CODEC_H
+#define SENSOR_BLOCK_CODEC_H
+
+#include <Arduino.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "storage/RtcManager.h"
+
+// Delta block encoding for runs of sensor samples stored in the LittleFS cache.
+//
+// Layout: tag (1) | count (1) | first sample as raw RtcSensorRecord (12) | per following sample:
+// zig-zag varints of the timestamp, temp10, hum10, lux and rssi deltas to the previous sample.
+// Steady one-minute samples cost ~6 bytes each instead of 21 for a compact record.
+// Integrity is covered by the cache record CRC that frames the whole block.
+namespace SensorBlockCodec {
+
+  static constexpr uint8_t kTag = 0x02;
+  static constexpr size_t kHeaderBytes = 2 + sizeof(RtcSensorRecord);
+  static constexpr size_t kMaxSampleBytes = 5 * 5;  // five 32-bit varints
+  static constexpr uint8_t kMaxSamples = 0xFF;
+
+  [[maybe_unused]] inline uint32_t zigzag(int32_t v) {
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+  }
+
+  [[maybe_unused]] inline int32_t unzigzag(uint32_t v) {
+    return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1U);
+  }
+
+  [[maybe_unused]] inline size_t put_varint(uint8_t* out, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80U) {
+      out[n++] = static_cast<uint8_t>(v | 0x80U);
+      v >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(v);
+    return n;
+  }
+
+  [[maybe_unused]] inline bool get_varint(const uint8_t* data, size_t len, size_t& pos, uint32_t& out) {
+    out = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+      if (pos >= len) {
+        return false;
+      }
+      const uint8_t b = data[pos++];
+      out |= static_cast<uint32_t>(b & 0x7FU) << shift;
+      if ((b & 0x80U) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  [[maybe_unused]] inline size_t encode_delta(const RtcSensorRecord& prev, const RtcSensorRecord& cur, uint8_t* out) {
+    size_t n = 0;
+    n += put_varint(out + n, zigzag(static_cast<int32_t>(cur.timestamp - prev.timestamp)));
+    n += put_varint(out + n, zigzag(static_cast<int32_t>(cur.temp10) - prev.temp10));
+    n += put_varint(out + n, zigzag(static_cast<int32_t>(cur.hum10) - prev.hum10));
+    n += put_varint(out + n, zigzag(static_cast<int32_t>(cur.lux) - prev.lux));
+    n += put_varint(out + n, zigzag(static_cast<int32_t>(cur.rssi) - prev.rssi));
+    return n;
+  }
+
+  // Packs as many leading samples as fit in `out_len` bytes; returns the block size and the
+  // number of samples taken in `encoded` (0 bytes if not even the first sample fits).
+  [[maybe_unused]] inline size_t encode(
+      const RtcSensorRecord* samples, size_t count, uint8_t* out, size_t out_len, size_t& encoded) {
+    encoded = 0;
+    if (!samples || count == 0 || !out || out_len < kHeaderBytes) {
+      return 0;
+    }
+    out[0] = kTag;
+    memcpy(out + 2, &samples[0], sizeof(RtcSensorRecord));
+    size_t pos = kHeaderBytes;
+    encoded = 1;
+    uint8_t scratch[kMaxSampleBytes];
+    while (encoded < count && encoded < kMaxSamples) {
+      const size_t n = encode_delta(samples[encoded - 1], samples[encoded], scratch);
+      if (pos + n > out_len) {
+        break;
+      }
+      memcpy(out + pos, scratch, n);
+      pos += n;
+      encoded++;
+    }
+    out[1] = static_cast<uint8_t>(encoded);
+    return pos;
+  }
+
+  // Sample count of a block payload, or 0 if `data` is not a block.
+  [[maybe_unused]] inline uint8_t sample_count(const uint8_t* data, size_t len) {
+    if (!data || len < kHeaderBytes || data[0] != kTag) {
+      return 0;
+    }
+    return data[1];
+  }
+
+  // Decodes sample `index` by walking the deltas from the block base.
+  [[maybe_unused]] inline bool decode_at(const uint8_t* data, size_t len, uint8_t index, RtcSensorRecord& out) {
+    const uint8_t count = sample_count(data, len);
+    if (index >= count) {
+      return false;
+    }
+    memcpy(&out, data + 2, sizeof(out));
+    size_t pos = kHeaderBytes;
+    for (uint8_t i = 0; i < index; ++i) {
+      uint32_t dts = 0, dtemp = 0, dhum = 0, dlux = 0, drssi = 0;
+      if (!get_varint(data, len, pos, dts) || !get_varint(data, len, pos, dtemp) ||
+          !get_varint(data, len, pos, dhum) || !get_varint(data, len, pos, dlux) ||
+          !get_varint(data, len, pos, drssi)) {
+        return false;
+      }
+      out.timestamp += static_cast<uint32_t>(unzigzag(dts));
+      out.temp10 = static_cast<int16_t>(out.temp10 + unzigzag(dtemp));
+      out.hum10 = static_cast<int16_t>(out.hum10 + unzigzag(dhum));
+      out.lux = static_cast<uint16_t>(out.lux + unzigzag(dlux));
+      out.rssi = static_cast<int16_t>(out.rssi + unzigzag(drssi));
+    }
+    return true;
+  }
+
+}  // namespace SensorBlockCodec
+
+#endif  // SENSOR_BLOCK_CODEC_H
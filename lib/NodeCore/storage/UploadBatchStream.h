@@ -0,0 +1,242 @@
+#ifndef UPLOAD_BATCH_STREAM_H
+#define UPLOAD_BATCH_STREAM_H
+
+#include <Arduino.h>
+
+#include <algorithm>
+
+#include "interfaces/ICacheManager.h"
+#include "storage/RtcManager.h"
+
+// ============================================================================
+// Streamed upload body
+// ============================================================================
+// A queued upload used to be rendered into the shared payload buffer (a batch into a heap buffer
+// sized for the whole JSON array) and held through the connect. Here the body is walked from
+// storage instead: once when the upload is dispatched, rendering each record only to count the
+// bytes (the Content-Length) and fix which records go, and again whenever the request is sent,
+// rendering the same records straight into it. One record goes as the bare object, more as an
+// array.
+//
+// Between the walks nothing is popped, but the queue can still move underneath: a flush of RTC
+// into the cache, a trim or downsampling pass, or a reset. valid() checks for those before any
+// byte goes out; a record whose length comes out different mid-stream fails the request (the
+// server sees a short body) rather than sending one that does not match its header.
+//
+// The walk hands the body to an `out` with
+//   char* slot(size_t& len)                       room for the next record, `len` bytes of it
+//   bool record(char* rec, size_t len, char sep)  a record rendered there, going out after `sep`
+//                                                 ('[' or ','; '\0' for none)
+//   bool put(const char* data, size_t len)        the closing bracket
+// so a sender can render into its socket chunk in place or pass records through a cipher.
+//
+// Templated on the cache and the renderers like QueueReadAhead, so the native tests can walk a
+// real cache with plain formatters.
+namespace UploadBatchStream {
+
+  struct Plan {
+    bool active = false;
+    bool fromRtc = false;
+    CacheLane lane = CacheLane::ROUTINE;
+    uint16_t rtcRecords = 0;   // RTC records in the body, the loaded one included
+    uint16_t laneRecords = 0;  // cache lane entries in the body, the loaded one included
+    uint16_t firstRtcSeq = 0;
+    uint16_t lastRtcSeq = 0;
+    uint32_t bodyLen = 0;
+    uint32_t trims = 0;
+    uint32_t downsampled = 0;
+    uint32_t resets = 0;
+
+    uint16_t records() const {
+      return static_cast<uint16_t>(rtcRecords + laneRecords);
+    }
+  };
+
+  // Walks the body into `out`. Sizing (`exact` false) follows the queue from the loaded record up
+  // to `maxRecords` records and `maxBytes` bytes and fills in the plan; sending (`exact` true)
+  // follows the plan and fails on anything short of it.
+  template <typename Cache, typename RenderRtc, typename RenderCached, typename Out>
+  bool walk(Cache& cache,
+            Plan& plan,
+            bool exact,
+            uint16_t maxRecords,
+            uint32_t maxBytes,
+            RenderRtc& renderRtc,
+            RenderCached& renderCached,
+            Out& out) {
+    const uint16_t rtcTarget = exact ? plan.rtcRecords : maxRecords;
+    const uint16_t laneTarget = exact ? plan.laneRecords : maxRecords;
+    // Sizing leaves the brackets out; plan() adds them once it knows there is more than one record.
+    const bool array = exact && plan.records() > 1;
+    uint16_t records = 0;
+    uint16_t rtc = 0;
+    uint16_t laneEntries = 0;
+    uint32_t bytes = 0;
+    char sep = array ? '[' : '\0';
+    auto take = [&](char* rec, size_t len) {
+      const uint32_t next = bytes + static_cast<uint32_t>(len) + (sep != '\0' ? 1U : 0U);
+      if (exact ? next > plan.bodyLen : next + (records > 0 ? 2U : 0U) > maxBytes) {
+        return false;
+      }
+      if (!out.record(rec, len, sep)) {
+        return false;
+      }
+      bytes = next;
+      records++;
+      sep = ',';
+      return true;
+    };
+
+    bool continueToLane = true;
+    if (plan.fromRtc) {
+      // The RTC part from one RTC read; the loaded record is the run's first entry.
+      RtcSensorRecord run[RTC_MAX_RECORDS];
+      uint16_t seqs[RTC_MAX_RECORDS];
+      uint16_t runLen = 0;
+      const uint16_t wanted = std::min<uint16_t>(std::min(maxRecords, rtcTarget), RTC_MAX_RECORDS);
+      const RtcReadStatus status = RtcManager::peekRun(run, seqs, wanted, runLen, true);
+      if (runLen == 0 || (exact && seqs[0] != plan.firstRtcSeq)) {
+        return false;
+      }
+      if (!exact) {
+        plan.firstRtcSeq = seqs[0];
+      }
+      // A run cut short by a corrupt slot does not go on into the lane.
+      continueToLane = (status == RtcReadStatus::NONE);
+      for (uint16_t i = 0; i < runLen && records < maxRecords && rtc < rtcTarget; ++i) {
+        size_t cap = 0;
+        char* rec = out.slot(cap);
+        if (!rec) {
+          return false;
+        }
+        size_t len = 0;
+        if (!renderRtc(rec, cap, run[i], len) || !take(rec, len)) {
+          if (exact || records == 0) {
+            return false;
+          }
+          continueToLane = false;
+          break;
+        }
+        rtc++;
+        if (!exact) {
+          plan.lastRtcSeq = seqs[i];
+        }
+      }
+    }
+
+    typename Cache::PeekCursor cursor = cache.peek_begin(plan.lane);
+    while (continueToLane && records < maxRecords && laneEntries < laneTarget) {
+      size_t cap = 0;
+      char* rec = out.slot(cap);
+      if (!rec || cap < 2) {
+        return false;
+      }
+      size_t len = 0;
+      if (cache.peek_next(cursor, rec, cap - 1, len) != CacheReadError::NONE || !renderCached(rec, cap, len) ||
+          !take(rec, len)) {
+        if (exact || records == 0) {
+          return false;
+        }
+        break;
+      }
+      laneEntries++;
+      yield();
+    }
+    if (exact) {
+      if (rtc != plan.rtcRecords || laneEntries != plan.laneRecords) {
+        return false;
+      }
+      if (array && (bytes + 1U > plan.bodyLen || !out.put("]", 1))) {
+        return false;
+      }
+      return bytes + (array ? 1U : 0U) == plan.bodyLen;
+    }
+    plan.rtcRecords = rtc;
+    plan.laneRecords = laneEntries;
+    plan.bodyLen = bytes + (records > 1 ? 2U : 0U);
+    return records > 0;
+  }
+
+  // Sizing `out`: renders into a caller's scratch slot and keeps nothing.
+  struct Counter {
+    char* scratch;
+    size_t scratchLen;
+
+    char* slot(size_t& len) {
+      len = scratchLen;
+      return scratch;
+    }
+    bool record(char*, size_t, char) {
+      return true;
+    }
+    bool put(const char*, size_t) {
+      return true;
+    }
+  };
+
+  // Fixes the records that go with the loaded one (at most `maxRecords`, at most `maxBytes` of
+  // body) and the body length. `slot` is scratch for one rendered record.
+  template <typename Cache, typename RenderRtc, typename RenderCached>
+  Plan plan(Cache& cache,
+            bool fromRtc,
+            CacheLane lane,
+            uint16_t maxRecords,
+            uint32_t maxBytes,
+            char* slot,
+            size_t slotLen,
+            RenderRtc renderRtc,
+            RenderCached renderCached) {
+    Plan p;
+    if (maxRecords == 0 || !slot || slotLen < 2) {
+      return p;
+    }
+    p.fromRtc = fromRtc;
+    p.lane = lane;
+    const CacheIoStats& io = cache.io_stats();
+    p.trims = io.trims;
+    p.downsampled = io.downsampledEntries;
+    p.resets = io.resets;
+
+    Counter counter{slot, slotLen};
+    if (!walk(cache, p, false, maxRecords, maxBytes, renderRtc, renderCached, counter)) {
+      return Plan();
+    }
+    p.active = true;
+    return p;
+  }
+
+  // True when the records the plan counted are still the ones at the front of the queue.
+  template <typename Cache>
+  bool valid(Cache& cache, const Plan& plan) {
+    if (!plan.active) {
+      return false;
+    }
+    const CacheIoStats& io = cache.io_stats();
+    if (io.trims != plan.trims || io.downsampledEntries != plan.downsampled || io.resets != plan.resets) {
+      return false;
+    }
+    if (plan.rtcRecords > 0) {
+      RtcSensorRecord run[RTC_MAX_RECORDS];
+      uint16_t seqs[RTC_MAX_RECORDS];
+      uint16_t runLen = 0;
+      (void)RtcManager::peekRun(run, seqs, std::min<uint16_t>(plan.rtcRecords, RTC_MAX_RECORDS), runLen, true);
+      if (runLen != plan.rtcRecords || seqs[0] != plan.firstRtcSeq) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Sends the planned body through `out`; false when it could not be rendered as planned.
+  template <typename Cache, typename RenderRtc, typename RenderCached, typename Out>
+  bool write(Cache& cache, const Plan& plan, RenderRtc renderRtc, RenderCached renderCached, Out& out) {
+    if (!plan.active) {
+      return false;
+    }
+    Plan p = plan;
+    return walk(cache, p, true, plan.records(), plan.bodyLen, renderRtc, renderCached, out);
+  }
+
+}  // namespace UploadBatchStream
+
+#endif  // UPLOAD_BATCH_STREAM_H
@@ -64,6 +64,18 @@ namespace {
     return (uint32_t)time(nullptr);
   }
 
+  void fill_iv(uint8_t* iv) {
+    os_get_random(iv, CryptoUtils::EncryptedPayload::IV_SIZE);
+
+    // CHANGED: Mix in additional entropy (Micros + RSSI)
+    uint32_t t = micros();
+    int32_t r = WiFi.RSSI();
+    iv[0] ^= static_cast<uint8_t>(t);
+    iv[1] ^= static_cast<uint8_t>(t >> 8);
+    iv[2] ^= static_cast<uint8_t>(t >> 16);
+    iv[3] ^= static_cast<uint8_t>(r);
+  }
+
   std::unique_ptr<CryptoUtils::AES_CBC_Cipher> g_mainCipher;
   std::unique_ptr<CryptoUtils::AES_CBC_Cipher> g_wsCipher;
   uint32_t g_replaySkewWindow = AppConstants::WS_REPLAY_SKEW_SEC_STRICT;
@@ -303,15 +315,7 @@ namespace CryptoUtils {
     uint8_t* work_buf = m_workScratch.get();
     uint8_t* iv = m_ivScratch.get();
 
-    os_get_random(iv, EncryptedPayload::IV_SIZE);
-
-    // CHANGED: Mix in additional entropy (Micros + RSSI)
-    uint32_t t = micros();
-    int32_t r = WiFi.RSSI();
-    iv[0] ^= static_cast<uint8_t>(t);
-    iv[1] ^= static_cast<uint8_t>(t >> 8);
-    iv[2] ^= static_cast<uint8_t>(t >> 16);
-    iv[3] ^= static_cast<uint8_t>(r);
+    fill_iv(iv);
 
     size_t iv_b64_len = base64_encode_to_buffer(iv, EncryptedPayload::IV_SIZE, out_buf, out_len);
     if (iv_b64_len == 0 || iv_b64_len + 2 >= out_len) {
@@ -376,6 +380,22 @@ namespace CryptoUtils {
     return fast_serialize_encrypted(plaintext, out_buf, out_len, sharedCipher());
   }
 
+  void make_iv(uint8_t* iv) {
+    if (iv) {
+      fill_iv(iv);
+    }
+  }
+
+  bool cbc_encrypt_main(uint8_t* iv, uint8_t* data, size_t len) {
+    const AES_CBC_Cipher& cipher = sharedCipher();
+    if (!iv || !data || len == 0 || (len % 16) != 0 || !cipher.get_enc_ctx()) {
+      return false;
+    }
+    // Only reads the key schedule, so neither the cipher's lock nor its scratch buffers are needed.
+    br_aes_ct_cbcenc_run(const_cast<br_aes_ct_cbcenc_keys*>(cipher.get_enc_ctx()), iv, data, len);
+    return true;
+  }
+
   size_t fast_serialize_encrypted_ws(std::string_view plaintext, char* out_buf, size_t out_len) {
     return fast_serialize_encrypted(plaintext, out_buf, out_len, sharedCipherWs());
   }
@@ -41,6 +41,12 @@ namespace CryptoUtils {
     mutable br_aes_ct_cbcdec_keys m_dec_ctx;
   };
 
+  // Fresh IV from the hardware RNG, mixed the way encrypt() mixes its own.
+  void make_iv(uint8_t* iv);
+  // CBC-encrypts whole blocks in place with the main key, leaving the last block in `iv` so the
+  // next call chains on (see net/EncryptedBody.h).
+  bool cbc_encrypt_main(uint8_t* iv, uint8_t* data, size_t len);
+
   String serialize_payload(const EncryptedPayload& payload);
   std::optional<EncryptedPayload> deserialize_payload(std::string_view serialized);
 
@@ -0,0 +1,75 @@
+#ifndef HMAC_SIGNER_H
+#define HMAC_SIGNER_H
+
+#include <Arduino.h>
+#include <bearssl/bearssl_hmac.h>
+#include <string.h>
+
+// ============================================================================
+// HMAC-SHA256 signer with a cached key schedule
+// ============================================================================
+// br_hmac_key_init() hashes the key into the inner and outer pad states, which used to happen
+// on every edge upload, together with fetching the token from the config strings. A Key keeps
+// that schedule once derived; br_hmac_init() on it only copies the two states. The owner drops
+// it when the saved config changes, since the token may have changed with it.
+//
+// An Incremental signs a message that arrives in pieces, such as a gateway body encrypted as it is
+// sent; feeding it the pieces in order gives the same signature as signing them joined in one buffer.
+namespace HmacSigner {
+
+  // Hex digits of a signature, without the terminating NUL.
+  static constexpr size_t kHexLen = 64;
+
+  struct Key {
+    br_hmac_key_context context;
+    bool ready = false;
+  };
+
+  inline void set_key(Key& key, const void* secret, size_t secretLen) {
+    br_hmac_key_init(&key.context, &br_sha256_vtable, secret, secretLen);
+    key.ready = true;
+  }
+
+  // Forgets the schedule; it is derived from the secret, so it is wiped rather than left behind.
+  inline void invalidate(Key& key) {
+    memset(&key.context, 0, sizeof(key.context));
+    key.ready = false;
+  }
+
+  class Incremental {
+  public:
+    explicit Incremental(const Key& key) {
+      br_hmac_init(&m_context, &key.context, 0);
+    }
+
+    void update(const void* data, size_t len) {
+      if (data && len > 0) {
+        br_hmac_update(&m_context, data, len);
+      }
+    }
+
+    // Writes kHexLen lowercase hex digits and a NUL to `out`.
+    void finish_hex(char* out) const {
+      uint8_t digest[32];
+      br_hmac_out(&m_context, digest);
+      static const char hex[] = "0123456789abcdef";
+      for (size_t i = 0; i < sizeof(digest); i++) {
+        out[i * 2] = hex[(digest[i] >> 4) & 0x0F];
+        out[i * 2 + 1] = hex[digest[i] & 0x0F];
+      }
+      out[kHexLen] = '\0';
+    }
+
+  private:
+    br_hmac_context m_context;
+  };
+
+  inline void sign_hex(const Key& key, const void* data, size_t len, char* out) {
+    Incremental hmac(key);
+    hmac.update(data, len);
+    hmac.finish_hex(out);
+  }
+
+}  // namespace HmacSigner
+
+#endif  // HMAC_SIGNER_H
@@ -0,0 +1,176 @@
+#ifndef SENSOR_PAYLOAD_TEMPLATE_H
+#define SENSOR_PAYLOAD_TEMPLATE_H
+
+#include <Arduino.h>
+#include <string.h>
+
+#include <array>
+
+#include "sensor/SensorNormalization.h"
+#include "support/CompileTimeJSON.h"
+
+// ============================================================================
+// Compile-time sensor payload template
+// ============================================================================
+// Every record the uploader sends is the same object with six values filled in:
+//
+//   {"gh_id":G,"node_id":N,"temperature":T.t,"humidity":H.h,"light_intensity":L,"rssi":R,
+//    "recorded_at":"YYYY-MM-DD HH:MM:SS"}
+//
+// buildSensorPayload() assembles it with ten bounds-checked appends per record, re-reading each
+// key from flash and converting every number one digit at a time. Layout builds the constant
+// parts once, at compile time, with the greenhouse and node ids already in them, so a record is
+// five block copies, four numbers written two digits at a time from a pair table, and the
+// 19-character timestamp copied into its fixed slot. The length is known before anything is
+// written, so there is one bounds check.
+//
+// The numbers keep their natural width: the cloud, the relay and the cache readers all see the
+// bytes buildSensorPayload() produces, and padding the slots would change them.
+//
+// The segments and the pair table live in flash (PROGMEM), like the other constant tables here,
+// and are read with memcpy_P; left as plain constants they would sit in DRAM as .rodata.
+namespace SensorPayloadTemplate {
+
+  // Characters of the recorded_at value.
+  static constexpr size_t kTimeLen = 19;
+
+  namespace detail {
+    constexpr size_t digit_count(uint32_t value) {
+      size_t n = 1;
+      while (value >= 10) {
+        value /= 10;
+        ++n;
+      }
+      return n;
+    }
+
+    template <uint32_t Value>
+    consteval auto decimal() {
+      constexpr size_t n = digit_count(Value);
+      std::array<char, n + 1> text{};
+      uint32_t rest = Value;
+      for (size_t i = n; i > 0; --i) {
+        text[i - 1] = static_cast<char>('0' + rest % 10);
+        rest /= 10;
+      }
+      text[n] = '\0';
+      return ct_json::FixedString<n + 1>(text);
+    }
+
+    consteval std::array<char, 200> make_digit_pairs() {
+      std::array<char, 200> pairs{};
+      for (size_t i = 0; i < 100; ++i) {
+        pairs[i * 2] = static_cast<char>('0' + i / 10);
+        pairs[i * 2 + 1] = static_cast<char>('0' + i % 10);
+      }
+      return pairs;
+    }
+
+    // "00" through "99".
+    inline constexpr std::array<char, 200> kDigitPairs PROGMEM = make_digit_pairs();
+
+    // Copies a PROGMEM segment without its NUL.
+    template <size_t N>
+    inline char* put(char* out, const ct_json::FixedString<N>& segment) {
+      memcpy_P(out, segment.data.data(), N - 1);
+      return out + N - 1;
+    }
+
+    // Writes the `digits` decimal digits of `value` (digit_count(value) of them) ending at out + digits.
+    inline char* put_u32(char* out, uint32_t value, size_t digits) {
+      char* p = out + digits;
+      while (value >= 100) {
+        p -= 2;
+        memcpy_P(p, kDigitPairs.data() + (value % 100) * 2, 2);
+        value /= 100;
+      }
+      if (value >= 10) {
+        p -= 2;
+        memcpy_P(p, kDigitPairs.data() + value * 2, 2);
+      } else {
+        *--p = static_cast<char>('0' + value);
+      }
+      return out + digits;
+    }
+
+    inline uint32_t magnitude(int32_t value) {
+      return (value < 0) ? static_cast<uint32_t>(-static_cast<int64_t>(value)) : static_cast<uint32_t>(value);
+    }
+
+    // Length of append_fixed1_strict's form of `value10`: [-]int.frac
+    inline size_t fixed1_len(int32_t value10) {
+      return (value10 < 0 ? 1 : 0) + digit_count(magnitude(value10) / 10) + 2;
+    }
+
+    inline char* put_fixed1(char* out, int32_t value10) {
+      if (value10 < 0) {
+        *out++ = '-';
+      }
+      const uint32_t tenths = magnitude(value10);
+      out = put_u32(out, tenths / 10, digit_count(tenths / 10));
+      *out++ = '.';
+      *out++ = static_cast<char>('0' + tenths % 10);
+      return out;
+    }
+  }  // namespace detail
+
+  template <uint32_t GhId, uint32_t NodeId>
+  struct Layout {
+    static constexpr auto kHead PROGMEM = ct_json::concat(
+        ct_json::concat(ct_json::concat(ct_json::FixedString("{\"gh_id\":"), detail::decimal<GhId>()),
+                        ct_json::concat(ct_json::FixedString(",\"node_id\":"), detail::decimal<NodeId>())),
+        ct_json::FixedString(",\"temperature\":"));
+    static constexpr auto kHumidity PROGMEM = ct_json::FixedString(",\"humidity\":");
+    static constexpr auto kLight PROGMEM = ct_json::FixedString(",\"light_intensity\":");
+    static constexpr auto kRssi PROGMEM = ct_json::FixedString(",\"rssi\":");
+    static constexpr auto kRecordedAt PROGMEM = ct_json::FixedString(",\"recorded_at\":\"");
+    static constexpr auto kTail PROGMEM = ct_json::FixedString("\"}");
+
+    // Longest payload: temperatures and humidity of five characters, five-digit light, an
+    // eleven-character rssi.
+    static constexpr size_t kMaxLen = kHead.size() + 5 + kHumidity.size() + 5 + kLight.size() + 5 + kRssi.size() +
+                                      11 + kRecordedAt.size() + kTimeLen + kTail.size();
+
+    // Writes the payload buildSensorPayload() would for these values and the kTimeLen-character
+    // `timeStr`, NUL-terminated. Returns its length, or 0 when it does not fit `out_len` with
+    // the NUL (nothing is written then).
+    static size_t render(
+        char* out, size_t out_len, int32_t temp10, int32_t hum10, uint32_t lux, int32_t rssi, const char* timeStr) {
+      using namespace detail;
+      if (!out || !timeStr) {
+        return 0;
+      }
+      temp10 = SensorNormalization::clampTemperatureTenths(temp10);
+      hum10 = SensorNormalization::clampHumidityTenths(hum10);
+      lux = SensorNormalization::clampLightUInt(lux);
+      const size_t luxDigits = digit_count(lux);
+      const size_t rssiDigits = digit_count(magnitude(rssi));
+      const size_t len = kHead.size() + fixed1_len(temp10) + kHumidity.size() + fixed1_len(hum10) + kLight.size() +
+                         luxDigits + kRssi.size() + (rssi < 0 ? 1 : 0) + rssiDigits + kRecordedAt.size() + kTimeLen +
+                         kTail.size();
+      if (len >= out_len) {
+        return 0;
+      }
+      char* p = put(out, kHead);
+      p = put_fixed1(p, temp10);
+      p = put(p, kHumidity);
+      p = put_fixed1(p, hum10);
+      p = put(p, kLight);
+      p = put_u32(p, lux, luxDigits);
+      p = put(p, kRssi);
+      if (rssi < 0) {
+        *p++ = '-';
+      }
+      p = put_u32(p, magnitude(rssi), rssiDigits);
+      p = put(p, kRecordedAt);
+      memcpy(p, timeStr, kTimeLen);
+      p += kTimeLen;
+      p = put(p, kTail);
+      *p = '\0';
+      return len;
+    }
+  };
+
+}  // namespace SensorPayloadTemplate
+
+#endif  // SENSOR_PAYLOAD_TEMPLATE_H
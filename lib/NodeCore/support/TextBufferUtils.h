@@ -176,7 +176,7 @@ namespace TextBufferUtils {
   }
 
   [[maybe_unused]] inline bool append_u32_strict(char* out, size_t out_len, size_t& pos, uint32_t value) {
-    char tmp[10];
+    char tmp[11];  // ten digits and u32_to_dec's NUL
     const size_t n = u32_to_dec(tmp, sizeof(tmp), value);
     return append_bytes_strict(out, out_len, pos, tmp, n);
   }
@@ -0,0 +1,76 @@
+#include "support/TimestampCache.h"
+
+#include <string.h>
+
+namespace {
+
+constexpr time_t kDaySeconds = 86400;
+constexpr size_t kDateLen = 11;  // "YYYY-MM-DD "
+
+struct CachedDay {
+  time_t start = 0;
+  char date[kDateLen] = {0};
+  bool valid = false;
+};
+
+CachedDay cachedDay;
+uint32_t conversionCount = 0;
+
+void put2(char* out, uint32_t value) {
+  out[0] = static_cast<char>('0' + (value / 10) % 10);
+  out[1] = static_cast<char>('0' + value % 10);
+}
+
+bool load_day(time_t timestamp) {
+  tm t;
+  conversionCount++;
+  if (!localtime_r(&timestamp, &t)) {
+    return false;
+  }
+  const long secondOfDay = t.tm_hour * 3600L + t.tm_min * 60L + t.tm_sec;
+  if (secondOfDay < 0 || secondOfDay >= kDaySeconds) {
+    return false;
+  }
+  const uint32_t year = static_cast<uint32_t>(t.tm_year + 1900);
+  put2(cachedDay.date, year / 100);
+  put2(cachedDay.date + 2, year);
+  cachedDay.date[4] = '-';
+  put2(cachedDay.date + 5, static_cast<uint32_t>(t.tm_mon + 1));
+  cachedDay.date[7] = '-';
+  put2(cachedDay.date + 8, static_cast<uint32_t>(t.tm_mday));
+  cachedDay.date[10] = ' ';
+  cachedDay.start = timestamp - secondOfDay;
+  cachedDay.valid = true;
+  return true;
+}
+
+}  // namespace
+
+bool TimestampCache::format(time_t timestamp, char* out) {
+  if (!out) {
+    return false;
+  }
+  if (!cachedDay.valid || timestamp < cachedDay.start || timestamp - cachedDay.start >= kDaySeconds) {
+    if (!load_day(timestamp)) {
+      invalidate();
+      return false;
+    }
+  }
+  const uint32_t secondOfDay = static_cast<uint32_t>(timestamp - cachedDay.start);
+  memcpy(out, cachedDay.date, kDateLen);
+  put2(out + 11, secondOfDay / 3600);
+  out[13] = ':';
+  put2(out + 14, (secondOfDay / 60) % 60);
+  out[16] = ':';
+  put2(out + 17, secondOfDay % 60);
+  out[kLen] = '\0';
+  return true;
+}
+
+void TimestampCache::invalidate() {
+  cachedDay = CachedDay();
+}
+
+uint32_t TimestampCache::conversions() {
+  return conversionCount;
+}
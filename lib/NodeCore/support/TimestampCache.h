@@ -0,0 +1,36 @@
+#ifndef TIMESTAMP_CACHE_H
+#define TIMESTAMP_CACHE_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// ============================================================================
+// Local-time formatting with a cached day
+// ============================================================================
+// Rendering a backlog calls localtime_r() once per record, although the records of a flush
+// almost all fall on the same day. The cache keeps the first second and the "YYYY-MM-DD " text
+// of the local day it last converted; a timestamp inside that day only needs its offset into
+// the day split into hours, minutes and seconds. Anything outside it - the next day, an older
+// record, a clock that stepped back - goes through localtime_r() again and becomes the cached
+// day.
+//
+// A day is taken to be 86400 s long, which holds for the fixed offset configTime() sets (no
+// DST). Whoever changes the zone calls invalidate(), so the next timestamp is converted afresh.
+namespace TimestampCache {
+
+  // Characters of "YYYY-MM-DD HH:MM:SS".
+  static constexpr size_t kLen = 19;
+
+  // Writes the local time of `timestamp` and a NUL to `out` (kLen + 1 bytes). False, with `out`
+  // untouched, when localtime_r() cannot convert it.
+  bool format(time_t timestamp, char* out);
+
+  // The zone changed; forget the cached day.
+  void invalidate();
+
+  // localtime_r() calls made so far.
+  uint32_t conversions();
+
+}  // namespace TimestampCache
+
+#endif  // TIMESTAMP_CACHE_H
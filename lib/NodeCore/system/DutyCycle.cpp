@@ -0,0 +1,156 @@
+#include "system/DutyCycle.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <user_interface.h>
+
+#include "storage/RtcManager.h"
+#include "support/Crc32.h"
+#include "system/Logger.h"
+
+#define DUTY_CYCLE_MAGIC 0xD0C1C1E5
+
+static_assert(DUTY_CYCLE_BLOCK_OFFSET >= RTC_USER_BLOCK_START &&
+                  DUTY_CYCLE_BLOCK_OFFSET + sizeof(DutyCycle::RtcState) / 4 <= 96,
+              "DutyCycle state must sit in RTC user memory below BootGuard");
+
+DutyCycle::RtcState DutyCycle::state;
+
+namespace {
+  bool resetWasDeepSleep() {
+    const struct rst_info* rst = system_get_rst_info();
+    return rst && rst->reason == REASON_DEEP_SLEEP_AWAKE;
+  }
+}  // namespace
+
+uint32_t DutyCycle::calculateCrc(const RtcState& s) {
+  return Crc32::compute(&s, offsetof(RtcState, crc));
+}
+
+bool DutyCycle::read(RtcState& out) {
+  if (!system_rtc_mem_read(DUTY_CYCLE_BLOCK_OFFSET, &out, sizeof(out))) {
+    return false;
+  }
+  return out.magic == DUTY_CYCLE_MAGIC && out.crc == calculateCrc(out) && out.settings.sampleIntervalMs > 0;
+}
+
+void DutyCycle::write() {
+  state.magic = DUTY_CYCLE_MAGIC;
+  state.crc = calculateCrc(state);
+  if (!system_rtc_mem_write(DUTY_CYCLE_BLOCK_OFFSET, &state, sizeof(state))) {
+    LOG_ERROR("SLEEP", F("Duty-cycle state write failed"));
+  }
+}
+
+bool DutyCycle::isTimerWake() {
+  RtcState stored;
+  return resetWasDeepSleep() && read(stored);
+}
+
+void DutyCycle::begin() {
+  if (resetWasDeepSleep() && read(state)) {
+    state.wakes++;
+    return;
+  }
+  memset(&state, 0, sizeof(state));
+  LOG_INFO("SLEEP", F("Duty cycle starting fresh"));
+}
+
+void DutyCycle::configure(const Settings& settings) {
+  state.settings = settings;
+}
+
+const DutyCycle::Settings& DutyCycle::settings() {
+  return state.settings;
+}
+
+uint32_t DutyCycle::now() {
+  if (state.clockEpoch == 0) {
+    return 0;
+  }
+  return state.clockEpoch + (state.clockRemMs + millis()) / 1000U;
+}
+
+void DutyCycle::syncClock(uint32_t epoch) {
+  const uint32_t ms = millis();
+  state.clockEpoch = epoch - ms / 1000U;
+  state.clockRemMs = 0;
+}
+
+bool DutyCycle::uploadDue(uint16_t rtcCount, uint32_t msSinceUpload, uint32_t ts) {
+  if (static_cast<uint32_t>(rtcCount) * 100U >= static_cast<uint32_t>(RTC_MAX_RECORDS) * DEEP_SLEEP_UPLOAD_FILL_PCT) {
+    return true;
+  }
+  if (msSinceUpload >= state.settings.uploadIntervalMs) {
+    return true;
+  }
+  // With long sample intervals RTC runs out of timestamp span (a 16-bit delta, ~18 h) before it
+  // fills; upload while the next wake's sample still fits rather than lose it.
+  return ts != 0 && !RtcManager::timestampFits(ts + state.settings.sampleIntervalMs / 1000U + 1U);
+}
+
+DutyCycle::WakeAction DutyCycle::decide(uint16_t rtcCount) {
+  return uploadDue(rtcCount, state.msSinceUpload + millis(), now()) ? WakeAction::UPLOAD : WakeAction::SLEEP;
+}
+
+void DutyCycle::markUploaded() {
+  // Counted from the start of this wake (sleep() adds the awake time back), so upload windows
+  // keep the configured period however long each one stays up.
+  state.msSinceUpload = 0;
+  state.uploadPending = 0;
+}
+
+void DutyCycle::advance(uint32_t elapsedMs) {
+  if (state.clockEpoch != 0) {
+    const uint32_t totalMs = state.clockRemMs + elapsedMs;
+    state.clockEpoch += totalMs / 1000U;
+    state.clockRemMs = static_cast<uint16_t>(totalMs % 1000U);
+  }
+  state.msSinceUpload += elapsedMs;
+}
+
+void DutyCycle::suspend(uint32_t sleepMs, RFMode mode) {
+  state.radioOff = (mode == WAKE_RF_DISABLED) ? 1 : 0;
+  write();
+  LOG_DEBUG("SLEEP",
+            F("Deep sleep %lu ms (awake %lu ms, radio %s)"),
+            static_cast<unsigned long>(sleepMs),
+            static_cast<unsigned long>(millis()),
+            state.radioOff ? "off" : "on");
+  ESP.deepSleep(static_cast<uint64_t>(sleepMs) * 1000ULL, mode);
+}
+
+void DutyCycle::sleep() {
+  // Sleeping for what is left of the interval keeps wakes on a fixed period.
+  const uint32_t awakeMs = millis();
+  const uint32_t intervalMs = state.settings.sampleIntervalMs;
+  const uint32_t sleepMs = (awakeMs < intervalMs) ? intervalMs - awakeMs : intervalMs;
+  advance(awakeMs + sleepMs);
+  state.uploadPending = 0;
+
+  // Powering the radio up costs RF calibration and its idle current on every wake, so it only
+  // comes up for a wake that will upload: the next one, holding one more sample and awake about
+  // as long as this one. A wake that decides otherwise goes through wakeRadio().
+  const uint32_t nextTs = state.clockEpoch != 0 ? state.clockEpoch + (state.clockRemMs + awakeMs) / 1000U : 0;
+  const bool uploadNext = uploadDue(RtcManager::getCount() + 1, state.msSinceUpload + awakeMs, nextTs);
+  suspend(sleepMs, uploadNext ? WAKE_RF_DEFAULT : WAKE_RF_DISABLED);
+}
+
+bool DutyCycle::radioOff() {
+  return state.radioOff != 0;
+}
+
+void DutyCycle::wakeRadio() {
+  // The shortest timer sleep; 0 would sleep until an external reset.
+  advance(millis() + 1U);
+  state.uploadPending = 1;
+  suspend(1, WAKE_RF_DEFAULT);
+}
+
+bool DutyCycle::uploadPending() {
+  return state.uploadPending != 0;
+}
+
+uint32_t DutyCycle::wakeCount() {
+  return state.wakes;
+}
@@ -0,0 +1,99 @@
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <Arduino.h>
+
+// Deep-sleep operating mode for battery nodes: the node wakes on a timer every sample interval,
+// appends one sample to RTC memory and sleeps again; WiFi only comes up when RTC is nearly full
+// or the upload interval has passed. Off by default: mains-powered nodes stay always-on.
+#ifndef DEEP_SLEEP_MODE
+#define DEEP_SLEEP_MODE 0
+#endif
+// RTC fill level (percent of RTC_MAX_RECORDS) that turns a sample wake into an upload wake.
+#ifndef DEEP_SLEEP_UPLOAD_FILL_PCT
+#define DEEP_SLEEP_UPLOAD_FILL_PCT 80
+#endif
+// Longest an upload wake stays up before sleeping again, drained or not.
+#ifndef DEEP_SLEEP_MAX_AWAKE_MS
+#define DEEP_SLEEP_MAX_AWAKE_MS 90000UL
+#endif
+
+static_assert(DEEP_SLEEP_UPLOAD_FILL_PCT > 0 && DEEP_SLEEP_UPLOAD_FILL_PCT <= 100,
+              "DEEP_SLEEP_UPLOAD_FILL_PCT must be a percentage");
+
+// Duty-cycle state lives in RTC blocks 85..95, right below BootGuard (96..100).
+#define DUTY_CYCLE_BLOCK_OFFSET 85
+
+class DutyCycle {
+public:
+  enum class WakeAction : uint8_t { SLEEP, UPLOAD };
+
+  // Config the sample wakes need without mounting LittleFS; refreshed by every full boot.
+  struct Settings {
+    uint32_t sampleIntervalMs;
+    uint32_t uploadIntervalMs;
+    float temperatureOffset;
+    float humidityOffset;
+    float lightFactor;
+  };
+
+  struct alignas(4) RtcState {
+    uint32_t magic;
+    uint32_t clockEpoch;     // unix seconds at millis() == 0 of this wake; 0 until first synced
+    uint16_t clockRemMs;     // sub-second part carried over from the previous wake
+    uint8_t radioOff;        // this wake began with WAKE_RF_DISABLED
+    uint8_t uploadPending;   // woken again with the radio on for an upload already decided on
+    uint32_t msSinceUpload;  // time since the last upload window ended
+    uint32_t wakes;          // timer wakes since the last cold boot
+    Settings settings;
+    uint32_t crc;
+  };
+  static_assert(sizeof(RtcState) == 44, "DutyCycle RtcState layout must remain stable");
+
+  // True when this boot is a deep-sleep timer wake with duty-cycle state to resume from.
+  static bool isTimerWake();
+
+  // Loads the state on a timer wake; anything else starts a fresh cycle (clock unsynced).
+  static void begin();
+
+  static void configure(const Settings& settings);
+  static const Settings& settings();
+
+  // Estimated wall-clock time carried across sleeps, or 0 before the first sync.
+  static uint32_t now();
+  static void syncClock(uint32_t epoch);
+
+  // What this wake should do after its sample went to RTC holding `rtcCount` records: upload
+  // when RTC is nearly full, the upload interval is up, or the next sample's timestamp would not
+  // fit next to the stored ones.
+  static WakeAction decide(uint16_t rtcCount);
+
+  // Ends an upload window: the next one is due an upload interval after this wake began.
+  static void markUploaded();
+
+  // Saves the state and deep-sleeps for the rest of the sample interval. The radio stays off
+  // through the next wake unless that wake is expected to upload. Does not return on hardware.
+  static void sleep();
+
+  // True when this wake began with the radio off; WiFi cannot come up until the next wake.
+  static bool radioOff();
+  // An upload wake that began with the radio off: wakes again at once with it on, skipping that
+  // wake's sample. Does not return on hardware.
+  static void wakeRadio();
+  // True on the wake wakeRadio() asked for.
+  static bool uploadPending();
+
+  static uint32_t wakeCount();
+
+private:
+  static RtcState state;
+
+  static bool read(RtcState& out);
+  static void write();
+  static bool uploadDue(uint16_t rtcCount, uint32_t msSinceUpload, uint32_t ts);
+  static void advance(uint32_t elapsedMs);
+  static void suspend(uint32_t sleepMs, RFMode mode);
+  static uint32_t calculateCrc(const RtcState& s);
+};
+
+#endif  // DUTY_CYCLE_H
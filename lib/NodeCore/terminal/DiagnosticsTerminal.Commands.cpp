@@ -25,6 +25,7 @@
 #include "commands/FsStatusCommand.h"
 #include "commands/GetCalibrationCommand.h"
 #include "commands/GetConfigCommand.h"
+#include "commands/LatencyCommand.h"
 #include "commands/LoginCommand.h"
 #include "commands/LogoutCommand.h"
 #include "commands/ModeCommand.h"
@@ -56,6 +57,7 @@
 #include "REDACTED"
 #include "storage/CacheManager.h"
 #include "net/NtpClient.h"
+#include "net/TlsSessionCache.h"
 #include "storage/RtcManager.h"
 #include "sensor/SensorManager.h"
 #include "system/SystemHealth.h"
@@ -371,6 +373,14 @@ namespace {
               timeSource);
     p.print_P(PSTR("[API] Last success: %s ago\n"), apiSince);
     p.print_P(PSTR("[MODE] Upload: %s | Gateway: %s\n"), uploadMode, gatewayState);
+    const TlsSessionCache::Stats& tls = TlsSessionCache::stats();
+    p.print_P(PSTR("[TLS] Resumed: %lu (avg %lu ms) | Full: %lu (avg %lu ms) | Declined: %lu | Failed: %lu\n"),
+              static_cast<unsigned long>(tls.resumedHandshakes),
+              static_cast<unsigned long>(tls.averageResumedMs()),
+              static_cast<unsigned long>(tls.fullHandshakes),
+              static_cast<unsigned long>(tls.averageFullMs()),
+              static_cast<unsigned long>(tls.declinedResumes),
+              static_cast<unsigned long>(tls.failures));
     p.print_P(PSTR("[CACHE] RTC: %u/%u | LittleFS: %lu/%lu B\n"),
               static_cast<unsigned>(RtcManager::getCount()),
               static_cast<unsigned>(RTC_MAX_RECORDS),
@@ -592,6 +602,9 @@ bool DiagnosticsTerminal::dispatchCommand(uint32_t cmdHash,
     case CmdHash::QOSUPLOAD: {
       return executeTerminalCommand<QosUploadCommand>(ctx, isAuth, m_services.apiClient);
     }
+    case CmdHash::QOSBW: {
+      return executeTerminalCommand<QosThroughputCommand>(ctx, isAuth, m_services.apiClient);
+    }
     case CmdHash::QOSOTA: {
       return executeTerminalCommand<QosOtaCommand>(ctx, isAuth, m_services.apiClient);
     }
@@ -665,6 +678,9 @@ bool DiagnosticsTerminal::dispatchCommand(uint32_t cmdHash,
     case CmdHash::HEAPRESET: {
       return executeTerminalCommand<HeapResetBuiltinCommand>(ctx, isAuth);
     }
+    case CmdHash::LATENCY: {
+      return executeTerminalCommand<LatencyCommand>(ctx, isAuth);
+    }
     case CmdHash::HELP: {
       return executeTerminalCommand<HelpBuiltinCommand>(ctx, isAuth, *this, m_services);
     }
@@ -737,9 +753,11 @@ void renderTerminalHelp(AsyncWebSocketClient* client,
   CrashLogCommand crashLog;
   ClearCrashCommand clearCrash;
   FsStatusCommand fsStatus;
+  LatencyCommand latency;
   ModeCommand mode(services.apiClient);
   UplinkCommand uplink(services.configManager, services.apiClient);
   QosUploadCommand qosUpload(services.apiClient);
+  QosThroughputCommand qosThroughput(services.apiClient);
   QosOtaCommand qosOta(services.apiClient);
   RebootCommand reboot;
   FactoryResetCommand factoryReset(services.configManager, services.cacheManager);
@@ -756,6 +774,7 @@ void renderTerminalHelp(AsyncWebSocketClient* client,
       &wifiAdd,          &wifiRemove,       &openWifi,      &checkUpdate,    &crashLog,
       &clearCrash,       &fsStatus,         &mode,          &uplink,         &qosUpload,      &qosOta,
       &reboot,           &factoryReset,     &formatFs,      &forceOtaInsecure, &heapReset,
+      &qosThroughput,    &latency,
   };
 
   auto sectionHasVisibleEntries = [&](CommandSection section) {
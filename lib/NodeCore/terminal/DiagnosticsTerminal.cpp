@@ -252,6 +252,7 @@ void DiagnosticsTerminal::handle() {
           case CmdHash::GETCONFIG:
           case CmdHash::NETCONFIG:
           case CmdHash::QOSUPLOAD:
+          case CmdHash::QOSBW:
           case CmdHash::QOSOTA:
           case CmdHash::OPENWIFI:
           case CmdHash::READ:
@@ -272,6 +273,7 @@ void DiagnosticsTerminal::handle() {
           case CmdHash::ZEROCAL:
           case CmdHash::MODE:
           case CmdHash::UPLINK:
+          case CmdHash::LATENCY:
             needsAuth = REDACTED
             break;
         }
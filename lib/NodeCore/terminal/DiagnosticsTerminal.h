@@ -47,6 +47,7 @@ namespace CmdHash {
   constexpr uint32_t LOGOUT = CompileTimeUtils::ct_hash("logout");
   constexpr uint32_t NETCONFIG = CompileTimeUtils::ct_hash("netconfig");
   constexpr uint32_t QOSUPLOAD = CompileTimeUtils::ct_hash("qosupload");
+  constexpr uint32_t QOSBW = CompileTimeUtils::ct_hash("qosbw");
   constexpr uint32_t QOSOTA = REDACTED
   constexpr uint32_t OPENWIFI = REDACTED
   constexpr uint32_t READ = CompileTimeUtils::ct_hash("read");
@@ -72,6 +73,7 @@ namespace CmdHash {
   constexpr uint32_t HELP = CompileTimeUtils::ct_hash("help");
   constexpr uint32_t FORCEOTAINSECURE = REDACTED
   constexpr uint32_t HEAPRESET = CompileTimeUtils::ct_hash("heapreset");
+  constexpr uint32_t LATENCY = CompileTimeUtils::ct_hash("latency");
 }  // namespace CmdHash
 
 class DiagnosticsTerminal : public IAuthManager<DiagnosticsTerminal> {
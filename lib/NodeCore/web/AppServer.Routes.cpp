@@ -11,6 +11,8 @@
 #include "system/Logger.h"
 #include "net/NtpClient.h"
 #include "sensor/SensorManager.h"
+#include "storage/CacheManager.h"
+#include "net/UploadLatency.h"
 #include "sensor/SensorNormalization.h"
 #include "system/SystemHealth.h"
 #include "generated/WebAppData.h"
@@ -205,7 +207,7 @@ void AppServer::handleStatusRequest(AsyncWebServerRequest* request) {
     sendJsonResponse_P(request, 503, PSTR("{\"error\":\"Low memory\"}"));
     return;
   }
-  AsyncResponseStream* response = request->beginResponseStream("application/json", 384);
+  AsyncResponseStream* response = request->beginResponseStream("application/json", 640);
   IPAddress ip = WiFi.localIP();
 
   // Get sensor readings
@@ -240,7 +242,7 @@ void AppServer::handleStatusRequest(AsyncWebServerRequest* request) {
   response->printf_P(
       PSTR("{\"firmware\":\"%s\",\"nodeId\":\"%d-%d\",\"freeHeap\":%u,\"minFreeHeap\":%u,\"minMaxBlock\":%u,"
            "\"uptime\":\"%luh\",\"ssid\":\"%s\",\"ip\":\"%u.%u.%u.%u\",\"temperature\":%.1f,\"humidity\":%.1f,"
-           "\"lux\":%u,\"tempValid\":%s,\"humValid\":%s,\"luxValid\":%s}"),
+           "\"lux\":%u,\"tempValid\":%s,\"humValid\":%s,\"luxValid\":%s,"),
       safeFw,
       GH_ID,
       NODE_ID,
@@ -259,6 +261,60 @@ void AppServer::handleStatusRequest(AsyncWebServerRequest* request) {
       tempValid,
       humValid,
       luxValid);
+
+  // Storage write amplification and time blocked in the cache since boot.
+  const CacheIoStats& io = m_cacheManager.io_stats();
+  response->printf_P(
+      PSTR("\"cache\":{\"bytes\":%lu,\"appends\":%lu,\"logicalBytes\":%lu,\"framedBytes\":%lu,"
+           "\"headerWrites\":%lu,\"flushes\":%lu,\"retries\":%lu,\"trims\":%lu,\"trimmedBytes\":%lu,"
+           "\"writeMs\":%lu,\"trimMs\":%lu,\"flushMs\":%lu,\"maxWriteUs\":%lu},"),
+      static_cast<unsigned long>(m_cacheManager.get_size()),
+      static_cast<unsigned long>(io.appends),
+      static_cast<unsigned long>(io.logicalBytes),
+      static_cast<unsigned long>(io.framedBytes),
+      static_cast<unsigned long>(io.headerWrites),
+      static_cast<unsigned long>(io.flushes),
+      static_cast<unsigned long>(io.writeRetries),
+      static_cast<unsigned long>(io.trims),
+      static_cast<unsigned long>(io.trimmedBytes),
+      static_cast<unsigned long>(io.writeMicros / 1000ULL),
+      static_cast<unsigned long>(io.trimMicros / 1000ULL),
+      static_cast<unsigned long>(io.flushMicros / 1000ULL),
+      static_cast<unsigned long>(io.maxWriteMicros));
+
+  // Upload latency per target and phase: [count, p50, p95, max, [log2 ms buckets]], used phases only.
+  response->printf_P(PSTR("\"latency\":{\"sinceResetMs\":%lu"), UploadLatency::sinceResetMs());
+  const UploadLatency::Failures& failures = UploadLatency::failures();
+  for (size_t t = 0; t < UploadLatency::kTargets; ++t) {
+    const auto target = static_cast<UploadLatency::Target>(t);
+    char name[8];
+    strncpy_P(name, UploadLatency::targetName_P(target), sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    response->printf_P(
+        PSTR(",\"%s\":{\"failures\":%lu"), name, static_cast<unsigned long>(failures.count[t]));
+    for (size_t p = 0; p < UploadLatency::kPhases; ++p) {
+      const auto phase = static_cast<UploadLatency::Phase>(p);
+      const UploadLatency::Histogram& h = UploadLatency::histogram(target, phase);
+      if (h.count == 0) {
+        continue;
+      }
+      char phaseName[12];
+      strncpy_P(phaseName, UploadLatency::phaseName_P(phase), sizeof(phaseName) - 1);
+      phaseName[sizeof(phaseName) - 1] = '\0';
+      response->printf_P(PSTR(",\"%s\":[%lu,%lu,%lu,%lu,["),
+                         phaseName,
+                         static_cast<unsigned long>(h.count),
+                         static_cast<unsigned long>(h.percentileMs(50)),
+                         static_cast<unsigned long>(h.percentileMs(95)),
+                         static_cast<unsigned long>(h.maxMs));
+      for (size_t i = 0; i < UploadLatency::kBuckets; ++i) {
+        response->printf_P(PSTR("%s%u"), i ? "," : "", static_cast<unsigned>(h.buckets[i]));
+      }
+      response->print(F("]]"));
+    }
+    response->print(F("}"));
+  }
+  response->print(F("}}"));
   request->send(response);
 }
 
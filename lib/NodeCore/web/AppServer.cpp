@@ -16,13 +16,15 @@ AppServer::AppServer(AsyncWebServer& server,
                      ConfigManager& configManager,
                      SensorManager& sensorManager,
                      WifiManager& wifiManager,
-                     NtpClient& ntpClient)
+                     NtpClient& ntpClient,
+                     CacheManager& cacheManager)
     : m_server(server),
       m_ws(ws),
       m_configManager(configManager),
       m_sensorManager(sensorManager),
       m_wifiManager(wifiManager),
-      m_ntpClient(ntpClient) {}
+      m_ntpClient(ntpClient),
+      m_cacheManager(cacheManager) {}
 
 void AppServer::onWifiStateChanged(WifiManager::State newState) {
   if (newState == WifiManager::State::CONNECTED_STA) {
@@ -14,6 +14,7 @@ class ConfigManager;
 class SensorManager;  // Concrete type for CRTP
 class WifiManager;    // For credential store access
 class NtpClient;
+class CacheManager;   // Concrete type for CRTP
 
 class AppServer : public IWifiStateObserver {
 public:
@@ -22,7 +23,8 @@ public:
             ConfigManager& configManager,
             SensorManager& sensorManager,
             WifiManager& wifiManager,
-            NtpClient& ntpClient);
+            NtpClient& ntpClient,
+            CacheManager& cacheManager);
 
   // Disable copy
   AppServer(const AppServer&) = delete;
@@ -68,6 +70,7 @@ private:
   SensorManager& m_sensorManager;
   WifiManager& m_wifiManager;
   NtpClient& m_ntpClient;
+  CacheManager& m_cacheManager;
 
   std::function<void()> m_flash_request_callback;
   std::function<void()> m_otaStartCallback;
@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""
+Decode an edge gateway upload body back into the JSON record the gateway stores.
+
+The node sends "ENC:<iv_b64>:<ciphertext_b64>": AES-256-CBC over a 4-byte big-endian
+timestamp followed by the record, PKCS7 padded. The record is JSON ('{' or '[') or, on
+firmware built with EDGE_WIRE_CBOR=1, a CBOR map with the integer keys of
+lib/NodeCore/net/EdgeWireCodec.h. Both come out as the same JSON object.
+
+CBOR carries send_time as UTC epoch seconds, while the JSON record holds the node's local time
+(configTime with DEVICE_TIMEZONE_OFFSET_SEC). --tz-offset gives that offset in seconds; the
+default is the firmware's UTC+7.
+
+Examples:
+  python scripts/decode_edge_payload.py "ENC:...:..."
+  python scripts/decode_edge_payload.py --key 000102...1f < body.txt
+  python scripts/decode_edge_payload.py --plain-hex a800020109...
+  python scripts/decode_edge_payload.py --tz-offset 0 "ENC:...:..."
+  python scripts/decode_edge_payload.py --self-test
+
+Decryption needs the 'cryptography' package; --plain-hex and --self-test do not.
+"""
+
+from __future__ import annotations
+
+import argparse
+import base64
+import json
+import sys
+from datetime import datetime, timedelta, timezone
+
+# Placeholder key of lib/NodeCore/support/CryptoUtils.h; pass --key for a real deployment.
+DEFAULT_KEY = bytes(range(32))
+
+# DEVICE_TIMEZONE_OFFSET_SEC of include/config/constants.h (UTC+7).
+DEFAULT_TZ_OFFSET = 7 * 3600
+
+# EdgeWireCodec::Key -> JSON field; tenths are divided back into the JSON's one decimal.
+CBOR_KEYS = {
+    0: ("gh_id", 1),
+    1: ("node_id", 1),
+    2: ("temperature", 10),
+    3: ("humidity", 10),
+    4: ("light_intensity", 1),
+    5: ("rssi", 1),
+    6: ("rssi_nonactive", 1),
+    7: ("send_time", 1),
+    8: ("t_min", 10),
+    9: ("t_max", 10),
+    10: ("h_min", 10),
+    11: ("h_max", 10),
+    12: ("samples", 1),
+    13: ("window_s", 1),
+}
+
+# Golden vector shared with test_edge_wire_cbor in test/test_native_stress/test_simulation.cpp.
+SELF_TEST_HEX = "a80002010902383303190267041904d205384206385007c11a6955b900"
+SELF_TEST_JSON = {
+    "gh_id": 2,
+    "node_id": 9,
+    "temperature": -5.2,
+    "humidity": 61.5,
+    "light_intensity": 1234,
+    "rssi": -67,
+    "rssi_nonactive": -81,
+    "send_time": "2026-01-01 07:00:00",
+}
+
+
+class CborError(ValueError):
+    pass
+
+
+def _cbor_head(data: bytes, pos: int) -> tuple[int, int, int]:
+    if pos >= len(data):
+        raise CborError("truncated")
+    initial = data[pos]
+    pos += 1
+    major, info = initial >> 5, initial & 0x1F
+    if info < 24:
+        return major, info, pos
+    width = {24: 1, 25: 2, 26: 4, 27: 8}.get(info)
+    if width is None or pos + width > len(data):
+        raise CborError(f"unsupported head 0x{initial:02x}")
+    return major, int.from_bytes(data[pos:pos + width], "big"), pos + width
+
+
+def _cbor_item(data: bytes, pos: int):
+    major, arg, pos = _cbor_head(data, pos)
+    if major == 0:
+        return arg, pos
+    if major == 1:
+        return -1 - arg, pos
+    if major == 2 or major == 3:
+        raw = data[pos:pos + arg]
+        if len(raw) != arg:
+            raise CborError("truncated string")
+        return (raw if major == 2 else raw.decode("utf-8")), pos + arg
+    if major == 4:
+        items = []
+        for _ in range(arg):
+            item, pos = _cbor_item(data, pos)
+            items.append(item)
+        return items, pos
+    if major == 5:
+        entries = {}
+        for _ in range(arg):
+            key, pos = _cbor_item(data, pos)
+            entries[key], pos = _cbor_item(data, pos)
+        return entries, pos
+    if major == 6:
+        value, pos = _cbor_item(data, pos)
+        if arg == 1:
+            return datetime.fromtimestamp(value, tz=timezone.utc), pos
+        return value, pos
+    if major == 7 and arg in (20, 21, 22):
+        return {20: False, 21: True, 22: None}[arg], pos
+    raise CborError(f"unsupported item (major {major})")
+
+
+def cbor_to_record(data: bytes, tz_offset: int = DEFAULT_TZ_OFFSET) -> dict:
+    entries, pos = _cbor_item(data, 0)
+    if not isinstance(entries, dict) or pos != len(data):
+        raise CborError("not a single CBOR map")
+    local = timezone(timedelta(seconds=tz_offset))
+    record = {}
+    for key, value in entries.items():
+        if key not in CBOR_KEYS:
+            continue  # newer firmware; unknown keys are skipped
+        name, scale = CBOR_KEYS[key]
+        if isinstance(value, datetime):
+            value = value.astimezone(local).strftime("%Y-%m-%d %H:%M:%S")
+        elif scale != 1 and isinstance(value, int):
+            value = round(value / scale, 1)
+        record[name] = value
+    return record
+
+
+def plaintext_to_record(plain: bytes, tz_offset: int = DEFAULT_TZ_OFFSET):
+    if plain[:1] in (b"{", b"["):
+        return json.loads(plain.decode("utf-8"))
+    if plain and 0xA0 <= plain[0] <= 0xBF:
+        return cbor_to_record(plain, tz_offset)
+    raise ValueError(f"unknown record format (first byte 0x{plain[0]:02x})" if plain else "empty record")
+
+
+def decrypt_body(body: str, key: bytes) -> tuple[int, bytes]:
+    try:
+        from cryptography.hazmat.primitives.ciphers import Cipher, algorithms, modes
+    except ImportError:
+        sys.exit("Decryption needs the 'cryptography' package (pip install cryptography).")
+
+    body = body.strip()
+    if body.startswith("ENC:"):
+        body = body[4:]
+    iv_b64, sep, ct_b64 = body.partition(":")
+    if not sep:
+        raise ValueError("expected <iv_b64>:<ciphertext_b64>")
+    iv, ct = base64.b64decode(iv_b64), base64.b64decode(ct_b64)
+    if len(iv) != 16 or not ct or len(ct) % 16:
+        raise ValueError("bad IV or ciphertext length")
+
+    decryptor = Cipher(algorithms.AES(key), modes.CBC(iv)).decryptor()
+    padded = decryptor.update(ct) + decryptor.finalize()
+    pad = padded[-1]
+    if not 1 <= pad <= 16 or padded[-pad:] != bytes([pad]) * pad:
+        raise ValueError("bad PKCS7 padding (wrong key?)")
+    raw = padded[:-pad]
+    if len(raw) < 4:
+        raise ValueError("payload shorter than its timestamp")
+    return int.from_bytes(raw[:4], "big"), raw[4:]
+
+
+def self_test() -> int:
+    record = cbor_to_record(bytes.fromhex(SELF_TEST_HEX))
+    if record != SELF_TEST_JSON:
+        print(f"self-test FAILED:\n  got      {record}\n  expected {SELF_TEST_JSON}")
+        return 1
+    print(f"self-test ok: {len(SELF_TEST_HEX) // 2} B CBOR == "
+          f"{len(json.dumps(SELF_TEST_JSON, separators=(',', ':')))} B JSON")
+    return 0
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Decode an edge gateway upload body (JSON or CBOR).")
+    parser.add_argument("body", nargs="?", help="ENC:<iv>:<ct> body; read from stdin when omitted")
+    parser.add_argument("--key", help="AES-256 key as 64 hex digits (default: placeholder key)")
+    parser.add_argument("--plain-hex", help="decode an already decrypted record given as hex")
+    parser.add_argument("--tz-offset", type=int, default=DEFAULT_TZ_OFFSET,
+                        help=f"node UTC offset in seconds for send_time (default: {DEFAULT_TZ_OFFSET})")
+    parser.add_argument("--self-test", action="store_true", help="check the decoder against the golden vector")
+    args = parser.parse_args()
+
+    if args.self_test:
+        return self_test()
+
+    if args.plain_hex:
+        print(json.dumps(plaintext_to_record(bytes.fromhex(args.plain_hex), args.tz_offset), indent=2))
+        return 0
+
+    key = bytes.fromhex(args.key) if args.key else DEFAULT_KEY
+    if len(key) != 32:
+        parser.error("--key must be 32 bytes (64 hex digits)")
+    body = args.body if args.body is not None else sys.stdin.read()
+    timestamp, plain = decrypt_body(body, key)
+    print(f"# encrypted at {datetime.fromtimestamp(timestamp, tz=timezone.utc):%Y-%m-%d %H:%M:%S} UTC, "
+          f"{len(plain)} B {'JSON' if plain[:1] in (b'{', b'[') else 'CBOR'}", file=sys.stderr)
+    print(json.dumps(plaintext_to_record(plain, args.tz_offset), indent=2))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
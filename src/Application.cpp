@@ -14,6 +14,7 @@
 #include "REDACTED"
 #include "web/PortalServer.h"
 #include "sensor/SensorManager.h"
+#include "system/DutyCycle.h"
 #include "system/SystemHealth.h"
 #include "config/constants.h"
 #include "generated/node_config.h"
@@ -247,6 +248,48 @@ void Application::handleRunning() {
     ESP.restart();
   }
 
+  handleDutyCycle();
+}
+
+void Application::handleDutyCycle() {
+#if DEEP_SLEEP_MODE
+  // Safe mode and the config portal stay up until someone deals with them.
+  if (!m_dutyCycleTimer.hasElapsed() || BootGuard::getCrashCount() > 5 ||
+      m_services.wifiManager.getState() == WifiManager::State::PORTAL_MODE || m_services.otaManager.isBusy()) {
+    return;
+  }
+
+  ApiClient& api = m_services.apiClient;
+  if (!m_uploadWindowOpen && m_services.wifiManager.getState() == WifiManager::State::CONNECTED_STA) {
+    api.beginUploadWindow();
+    m_uploadWindowOpen = true;
+  }
+
+  const unsigned long awakeMs = millis() - m_bootTime;
+  const bool drained = m_uploadWindowOpen && api.isBacklogDrained();
+  if (!drained && awakeMs < DEEP_SLEEP_MAX_AWAKE_MS) {
+    return;
+  }
+
+  LOG_INFO("SLEEP",
+           F("Upload window %s after %lu ms"),
+           drained ? "drained" : "timed out",
+           static_cast<unsigned long>(awakeMs));
+
+  const AppConfig& config = m_services.configManager.getConfig();
+  DutyCycle::configure({config.SENSOR_SAMPLE_INTERVAL_MS,
+                        config.DATA_UPLOAD_INTERVAL_MS,
+                        config.TEMP_OFFSET,
+                        config.HUMIDITY_OFFSET,
+                        config.LUX_SCALING_FACTOR});
+  const time_t now = time(nullptr);
+  if (now > static_cast<time_t>(NTP_VALID_TIMESTAMP_THRESHOLD)) {
+    DutyCycle::syncClock(static_cast<uint32_t>(now));
+  }
+  DutyCycle::markUploaded();
+  api.prepareForSleep();
+  DutyCycle::sleep();
+#endif
 }
 
 void Application::handleUpdating() {
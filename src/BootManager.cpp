@@ -6,6 +6,7 @@
 
 #include "REDACTED"
 #include "system/CrashHandler.h"
+#include "system/DutyCycle.h"
 #include "app/HAL.h"
 #include "system/Logger.h"
 
@@ -19,6 +20,15 @@ namespace {
 }  // namespace
 
 void BootManager::run() {
+#if DEEP_SLEEP_MODE
+  // Sample wakes only touch RTC: no filesystem mount, crash-handler pass or self-heal checks.
+  // A crash still shows up as a non-deep-sleep reset and takes the full path below.
+  if (DutyCycle::isTimerWake()) {
+    BootGuard::recordDeepSleepWake();
+    return;
+  }
+#endif
+
   // Factory Reset requested via Portal/Command.
   // Keep this before filesystem mount (mirrors previous setup ordering).
   if (BootGuard::getLastRebootReason() == BootGuard::RebootReason::FACTORY_RESET) {
@@ -21,6 +21,8 @@
 #include "sensor/SensorManager.h"
 #include "REDACTED"
 #include "config/constants.h"
+#include "sensor/SensorNormalization.h"
+#include "system/DutyCycle.h"
 
 // Reserve heap to be released during portal mode (keep portal HTTP requests alive).
 // Disable heap reserve to maximize available heap for TLS/HTTP.
@@ -168,7 +170,7 @@ namespace {
           wifiManager(),
           cacheManager(),
           ntpClient(wifiManager),
-          appServer(server, ws, configManager, sensorManager, wifiManager, ntpClient),
+          appServer(server, ws, configManager, sensorManager, wifiManager, ntpClient, cacheManager),
           portalServer(server, wifiManager, configManager, ntpClient),
           apiClient(ws, ntpClient, wifiManager, sensorManager, secureClient, configManager, cacheManager, nullptr),
           otaManager(ntpClient, wifiManager, secureClient, configManager, nullptr),
@@ -242,10 +244,65 @@ namespace {
   };
 
   Runtime* g_runtime = nullptr;
+
+#if DEEP_SLEEP_MODE
+  // Sample wake: one reading into RTC, then back to sleep unless an upload is due. Runs before
+  // the Runtime exists, so nothing here touches LittleFS, config or WiFi.
+  void runSampleWake() {
+    if (DutyCycle::uploadPending()) {
+      // The previous wake sampled and chose to upload with the radio off; this one has it on.
+      LOG_INFO("SLEEP", F("Upload wake (radio on, RTC %u)"), RtcManager::getCount());
+      return;
+    }
+
+    SensorManager sensors;
+    sensors.init();
+    const bool sampled = sensors.sampleOnce();
+
+    const DutyCycle::Settings& settings = DutyCycle::settings();
+    int32_t temp10 = 0;
+    int32_t hum10 = 0;
+    uint16_t lux = 0;
+    const bool tempValid =
+        SensorNormalization::applyTemperatureCalibration(sensors.getTemp(), settings.temperatureOffset, temp10);
+    const bool humValid =
+        SensorNormalization::applyHumidityCalibration(sensors.getHumidity(), settings.humidityOffset, hum10);
+    (void)SensorNormalization::applyLightCalibration(sensors.getLight(), settings.lightFactor, lux);
+
+    if (!sampled || (!tempValid && !humValid)) {
+      // A zeroed record would upload as a real 0 C / 0 % reading; this interval just has no sample.
+      LOG_WARN("SLEEP", F("Sample wake: no sensor reading, nothing stored"));
+      if (DutyCycle::decide(RtcManager::getCount()) == DutyCycle::WakeAction::SLEEP) {
+        DutyCycle::sleep();
+      }
+    } else if (!RtcManager::append(
+                   DutyCycle::now(), static_cast<int16_t>(temp10), static_cast<int16_t>(hum10), lux, 0)) {
+      // WiFi stays off on sample wakes, so there is no RSSI to record. Sleeping now would drop the
+      // sample, and every later one that fails the same way. The full boot records its own reading
+      // with the LittleFS fallback and drains RTC.
+      LOG_ERROR("SLEEP", F("Sample wake: RTC append failed, staying up"));
+    } else if (DutyCycle::decide(RtcManager::getCount()) == DutyCycle::WakeAction::SLEEP) {
+      DutyCycle::sleep();
+    }
+
+    // Staying up means WiFi, which this wake may have started without.
+    if (DutyCycle::radioOff()) {
+      DutyCycle::wakeRadio();
+    }
+    LOG_INFO("SLEEP", F("Upload wake (RTC %u/%u)"), RtcManager::getCount(), static_cast<unsigned>(RTC_MAX_RECORDS));
+  }
+#endif
 }  // namespace
 
 void setup() {
+#if DEEP_SLEEP_MODE
+  const bool timerWake = DutyCycle::isTimerWake();
+  if (!timerWake) {
+    delay(1000);
+  }
+#else
   delay(1000);
+#endif
   static SerialManager serial;
 
   BootManager::run();
@@ -253,6 +310,13 @@ void setup() {
   // Initialize purely volatile RTC cache 
   RtcManager::init();
 
+#if DEEP_SLEEP_MODE
+  DutyCycle::begin();
+  if (timerWake) {
+    runSampleWake();
+  }
+#endif
+
   // --- NORMAL BOOT SEQUENCE ---
   static Runtime runtime;
   runtime.init();
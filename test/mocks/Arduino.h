@@ -53,6 +53,7 @@ class __FlashStringHelper;
 #define memcpy_P memcpy
 #define strcpy_P strcpy
 #define strncpy_P strncpy
+#define pgm_read_byte(ptr) (*(const uint8_t*)(ptr))
 #define pgm_read_dword(ptr) (*(const uint32_t*)(ptr))
 #define pgm_read_ptr(ptr) (*(const void**)(ptr))
 using PGM_P = const char*;
@@ -133,6 +134,7 @@ enum { ENC_TYPE_NONE = 7 };
 // Stub out millis
 inline uint32_t current_millis = 0;
 inline uint32_t millis() { return current_millis; }
+inline uint32_t micros() { return current_millis * 1000U; }
 inline void delay(uint32_t) {}
 
 // Stub out Serial
@@ -7,6 +7,26 @@
 #include <iostream>
 #include <memory>
 
+// ============================================================================
+// I/O counters (reset by tests that measure access patterns)
+// ============================================================================
+struct MockFsStats {
+    size_t reads = 0;
+    size_t writes = 0;
+    size_t seeks = 0;
+    size_t bytesRead = 0;
+    size_t bytesWritten = 0;
+    size_t overwrites = 0;  // writes landing on existing bytes (copy-on-write on real LittleFS)
+    size_t physicalBytes = 0;  // data-block bytes LittleFS would program, see File::endWrite()
+
+    void reset() { *this = MockFsStats{}; }
+};
+
+inline MockFsStats g_mockFsStats;
+
+// Block size used by the physical write model (one 4 KB flash erase sector).
+constexpr size_t kMockFsBlockBytes = 4096;
+
 // ============================================================================
 // Mock File Class
 // ============================================================================
@@ -20,16 +40,25 @@ public:
 
     operator bool() const { return m_valid; }
 
-    void close() { m_valid = false; }
+    void close() {
+        endWrite();
+        m_valid = false;
+    }
     
     size_t write(const uint8_t* buf, size_t size) {
         if (!m_valid) return 0;
+        if (m_writeFrom == kNoWrite) {
+            m_writeFrom = std::min(m_position, m_content->size());
+        }
+        if (m_position < m_content->size()) g_mockFsStats.overwrites++;
         // Expand if needed
         if (m_position + size > m_content->size()) {
             m_content->resize(m_position + size);
         }
         std::copy(buf, buf + size, m_content->begin() + m_position);
         m_position += size;
+        g_mockFsStats.writes++;
+        g_mockFsStats.bytesWritten += size;
         return size;
     }
     
@@ -46,6 +75,8 @@ public:
         
         std::copy(m_content->begin() + m_position, m_content->begin() + m_position + toRead, buf);
         m_position += toRead;
+        g_mockFsStats.reads++;
+        g_mockFsStats.bytesRead += toRead;
         return toRead;
     }
     
@@ -56,6 +87,8 @@ public:
     
     bool seek(uint32_t pos, int mode = 0) { // mode: 0=Set, 1=Cur, 2=End
         if (!m_valid) return false;
+        endWrite();
+        g_mockFsStats.seeks++;
         if (mode == 0) m_position = pos;
         else if (mode == 1) m_position += pos;
         else if (mode == 2) m_position = m_content->size() - pos;
@@ -67,13 +100,27 @@ public:
     
     size_t position() const { return m_position; }
     size_t size() const { return m_valid ? m_content->size() : 0; }
-    void flush() {} // No-op for RAM disk
+    void flush() { endWrite(); }
 
 private:
+    static constexpr size_t kNoWrite = static_cast<size_t>(-1);
+
+    // LittleFS buffers writes until flush, close or seek, then copies the file from the
+    // start of the first touched block to its end into fresh blocks (files are copy-on-write
+    // skip-lists). Appends only copy the partial last block; a rewrite near the start of a
+    // large file costs the whole file. Metadata commits are not modelled.
+    void endWrite() {
+        if (m_writeFrom == kNoWrite) return;
+        const size_t blockStart = (m_writeFrom / kMockFsBlockBytes) * kMockFsBlockBytes;
+        g_mockFsStats.physicalBytes += m_content->size() - blockStart;
+        m_writeFrom = kNoWrite;
+    }
+
     bool m_valid;
     size_t m_position;
     std::string m_name;
     std::shared_ptr<std::vector<uint8_t>> m_content;
+    size_t m_writeFrom = kNoWrite;  // lowest offset written since the last flush
 };
 
 // ============================================================================
@@ -11,6 +11,15 @@
 // 1. Mock Global Hardware Objects (if not in Arduino.h)
 #ifndef ESP_MOCK_DEFINED
 #define ESP_MOCK_DEFINED
+// Deep sleep returns immediately; tests read the requested duration and simulate the wake.
+enum RFMode { RF_DEFAULT = 0, RF_CAL = 1, RF_NO_CAL = 2, RF_DISABLED = 4 };
+#define WAKE_RF_DEFAULT RF_DEFAULT
+#define WAKE_RF_DISABLED RF_DISABLED
+namespace MockDeepSleep {
+    inline uint32_t calls = 0;
+    inline uint64_t lastUs = 0;
+    inline RFMode lastMode = RF_DEFAULT;
+}
 struct EspClass {
     uint32_t getChipId() { return 0x12345678; }
     uint32_t getFreeHeap() { return 20000; }
@@ -19,6 +28,11 @@ struct EspClass {
     void wdtFeed() {}
     void wdtDisable() {}
     void wdtEnable(uint32_t = 0) {}
+    void deepSleep(uint64_t us, RFMode mode = RF_DEFAULT) {
+        MockDeepSleep::calls++;
+        MockDeepSleep::lastUs = us;
+        MockDeepSleep::lastMode = mode;
+    }
 };
 // Use 'inline' or 'extern' to avoid duplicate definition if included multiple times
 // But in a single .cpp test file, static/global is fine.
@@ -1,4 +1,23 @@
 #pragma once
+#include <cstdint>
+#include <cstring>
+
+#include "bearssl/bearssl.h"
+
 namespace BearSSL {
-    class WiFiClientSecure {};
+    // Same layout as the core's: one br_ssl_session_parameters behind a private accessor. Tests
+    // play the server by writing the parameters the way TlsSessionCache reads them.
+    class Session {
+    public:
+        Session() { memset(&_session, 0, sizeof(_session)); }
+    private:
+        br_ssl_session_parameters* getSession() { return &_session; }
+        br_ssl_session_parameters _session;
+    };
+
+    class WiFiClientSecure {
+    public:
+        void setSession(Session* s) { session = s; }
+        Session* session = nullptr;
+    };
 }
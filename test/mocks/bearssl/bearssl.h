@@ -3,6 +3,14 @@
 #include <cstddef>
 #include <cstdint>
 
+typedef struct {
+  unsigned char session_id[32];
+  unsigned char session_id_len;
+  uint16_t version;
+  uint16_t cipher_suite;
+  unsigned char master_secret[48];
+} br_ssl_session_parameters;
+
 struct br_aes_ct_cbcenc_keys {};
 struct br_aes_ct_cbcdec_keys {};
 
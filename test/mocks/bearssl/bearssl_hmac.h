@@ -2,11 +2,57 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
-struct br_hmac_key_context {};
-struct br_hmac_context {};
+#include "bearssl_hash.h"
 
-inline void br_hmac_key_init(br_hmac_key_context*, const void*, const void*, size_t) {}
-inline void br_hmac_init(br_hmac_context*, const br_hmac_key_context*, size_t) {}
-inline void br_hmac_update(br_hmac_context*, const void*, size_t) {}
-inline void br_hmac_out(br_hmac_context*, void*) {}
+// HMAC-SHA256 (RFC 2104) over the mock SHA-256; the digest vtable argument is ignored.
+struct br_hmac_key_context {
+    uint8_t ipad[64];
+    uint8_t opad[64];
+};
+struct br_hmac_context {
+    br_sha256_context inner;
+    uint8_t opad[64];
+};
+
+// Key schedules computed so far, for tests that check a key is not re-derived per message.
+inline size_t br_mock_hmac_key_inits = 0;
+
+inline void br_hmac_key_init(br_hmac_key_context* kc, const void*, const void* key, size_t key_len) {
+    uint8_t k[64] = {0};
+    if (key_len > sizeof(k)) {
+        br_sha256_context h;
+        br_sha256_init(&h);
+        br_sha256_update(&h, key, key_len);
+        br_sha256_out(&h, k);
+    } else if (key_len > 0) {
+        memcpy(k, key, key_len);
+    }
+    for (size_t i = 0; i < sizeof(k); ++i) {
+        kc->ipad[i] = static_cast<uint8_t>(k[i] ^ 0x36);
+        kc->opad[i] = static_cast<uint8_t>(k[i] ^ 0x5c);
+    }
+    br_mock_hmac_key_inits++;
+}
+
+inline void br_hmac_init(br_hmac_context* ctx, const br_hmac_key_context* kc, size_t) {
+    br_sha256_init(&ctx->inner);
+    br_sha256_update(&ctx->inner, kc->ipad, sizeof(kc->ipad));
+    memcpy(ctx->opad, kc->opad, sizeof(ctx->opad));
+}
+
+inline void br_hmac_update(br_hmac_context* ctx, const void* data, size_t len) {
+    br_sha256_update(&ctx->inner, data, len);
+}
+
+inline size_t br_hmac_out(const br_hmac_context* ctx, void* out) {
+    uint8_t inner[32];
+    br_sha256_out(&ctx->inner, inner);
+    br_sha256_context outer;
+    br_sha256_init(&outer);
+    br_sha256_update(&outer, ctx->opad, sizeof(ctx->opad));
+    br_sha256_update(&outer, inner, sizeof(inner));
+    br_sha256_out(&outer, out);
+    return sizeof(inner);
+}
@@ -1,6 +1,69 @@
 #pragma once
+#include <cstdint>
+#include <cstring>
+
+// Mock RTC memory: 192 blocks of 4 bytes, with counters for write-traffic tests.
+namespace MockRtcMem {
+    inline uint8_t mem[192 * 4] = {};
+    inline uint32_t readCalls = 0;
+    inline uint32_t writeCalls = 0;
+    inline uint32_t bytesWritten = 0;
+
+    inline void resetCounters() {
+        readCalls = 0;
+        writeCalls = 0;
+        bytesWritten = 0;
+    }
+}
+
+// Mock reset reasons, settable per simulated boot.
+enum rst_reason {
+    REASON_DEFAULT_RST = 0,
+    REASON_WDT_RST = 1,
+    REASON_EXCEPTION_RST = 2,
+    REASON_SOFT_WDT_RST = 3,
+    REASON_SOFT_RESTART = 4,
+    REASON_DEEP_SLEEP_AWAKE = 5,
+    REASON_EXT_SYS_RST = 6
+};
+
+struct rst_info {
+    uint32_t reason;
+    uint32_t exccause;
+    uint32_t epc1;
+    uint32_t epc2;
+    uint32_t epc3;
+    uint32_t excvaddr;
+    uint32_t depc;
+};
+
+namespace MockRtcMem {
+    inline rst_info resetInfo = {};
+}
+
 // Mock SDK function
 // system_get_free_heap_size
 extern "C" {
     inline uint32_t system_get_free_heap_size() { return 40000; }
+
+    inline rst_info* system_get_rst_info() { return &MockRtcMem::resetInfo; }
+
+    inline bool system_rtc_mem_read(uint8_t src_addr, void* des_addr, uint16_t load_size) {
+        if (!des_addr || static_cast<size_t>(src_addr) * 4 + load_size > sizeof(MockRtcMem::mem)) {
+            return false;
+        }
+        memcpy(des_addr, MockRtcMem::mem + static_cast<size_t>(src_addr) * 4, load_size);
+        MockRtcMem::readCalls++;
+        return true;
+    }
+
+    inline bool system_rtc_mem_write(uint8_t des_addr, const void* src_addr, uint16_t save_size) {
+        if (!src_addr || des_addr < 64 || static_cast<size_t>(des_addr) * 4 + save_size > sizeof(MockRtcMem::mem)) {
+            return false;
+        }
+        memcpy(MockRtcMem::mem + static_cast<size_t>(des_addr) * 4, src_addr, save_size);
+        MockRtcMem::writeCalls++;
+        MockRtcMem::bytesWritten += save_size;
+        return true;
+    }
 }
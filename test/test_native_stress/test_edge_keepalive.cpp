@@ -0,0 +1,220 @@
+#include <unity.h>
+#include <string>
+
+#include "test_fixtures.h"
+
+#include "net/HttpKeepAlive.h"
+
+// ============================================================================
+// EDGE GATEWAY KEEP-ALIVE
+// ============================================================================
+// A local mock gateway socket: parses each POST, answers 200 with a framed body and keeps the
+// connection unless told otherwise. It closes sockets idle longer than its own timeout and can
+// be told to drop the connection when the next request arrives, as a server racing its idle
+// close would.
+struct MockGatewaySocket {
+    uint32_t connects = 0;
+    uint32_t requests = 0;
+    uint32_t keepAliveRequests = 0;
+    bool open = false;
+    unsigned long lastActivity = 0;
+    unsigned long serverIdleMs = 5000;
+    uint8_t dropNextRequests = 0;
+    bool closeAfterResponse = false;
+    bool chunked = false;
+    std::string rx;
+    size_t rxPos = 0;
+    std::string tx;
+
+    bool connect(const char*, uint16_t) {
+        connects++;
+        open = true;
+        rx.clear();
+        rxPos = 0;
+        tx.clear();
+        lastActivity = millis();
+        return true;
+    }
+    void expire() {
+        if (open && millis() - lastActivity > serverIdleMs) {
+            open = false;
+        }
+    }
+    bool connected() {
+        expire();
+        return open || rxPos < rx.size();
+    }
+    int available() {
+        return static_cast<int>(rx.size() - rxPos);
+    }
+    int read() {
+        return rxPos < rx.size() ? static_cast<unsigned char>(rx[rxPos++]) : -1;
+    }
+    void stop() {
+        open = false;
+        rx.clear();
+        rxPos = 0;
+    }
+    size_t write(const uint8_t* data, size_t len) {
+        expire();
+        if (!open) {
+            return 0;
+        }
+        tx.append(reinterpret_cast<const char*>(data), len);
+        serve();
+        return len;
+    }
+    size_t print(const char* s) {
+        return write(reinterpret_cast<const uint8_t*>(s), strlen(s));
+    }
+
+    void serve() {
+        const size_t headerEnd = tx.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) {
+            return;
+        }
+        const size_t lenAt = tx.find("Content-Length: ");
+        const size_t bodyLen = (lenAt == std::string::npos) ? 0 : std::stoul(tx.substr(lenAt + 16));
+        if (tx.size() < headerEnd + 4 + bodyLen) {
+            return;
+        }
+        const bool wantsKeepAlive = tx.find("Connection: keep-alive") < headerEnd;
+        tx.erase(0, headerEnd + 4 + bodyLen);
+        if (dropNextRequests > 0) {
+            dropNextRequests--;
+            open = false;
+            return;
+        }
+        requests++;
+        keepAliveRequests += wantsKeepAlive ? 1 : 0;
+        lastActivity = millis();
+        const bool closing = closeAfterResponse || !wantsKeepAlive;
+        const char* body = "{\"status\":\"ok\"}";
+        rx.append("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n");
+        rx.append(closing ? "Connection: close\r\n" : "Connection: keep-alive\r\n");
+        if (chunked) {
+            rx.append("Transfer-Encoding: chunked\r\n\r\n");
+            rx.append("6\r\n{\"stat\r\n9\r\nus\":\"ok\"}\r\n0\r\n\r\n");
+        } else {
+            rx.append("Content-Length: " + std::to_string(strlen(body)) + "\r\n\r\n");
+            rx.append(body);
+        }
+        if (closing) {
+            open = false;
+        }
+    }
+};
+
+// Drives one upload through HttpKeepAlive the way the transport state machine does: reuse or
+// connect, send, retry once if a kept socket turns out dead, then read the framed response.
+static bool edge_keepalive_upload(HttpKeepAlive::Connection& conn, MockGatewaySocket& gw, const char* payload) {
+    HttpKeepAlive::begin_request(conn);
+    for (;;) {
+        if (!HttpKeepAlive::reuse(conn, gw, "gateway.local", 80, millis())) {
+            HttpKeepAlive::close(conn, gw);
+            if (!gw.connect("gateway.local", 80)) {
+                return false;
+            }
+            HttpKeepAlive::opened(conn, "gateway.local", 80, millis());
+        }
+        if (!gw.connected()) {
+            if (HttpKeepAlive::retry_after_drop(conn, gw)) {
+                continue;
+            }
+            return false;
+        }
+        const std::string request = "POST /api/data HTTP/1.1\r\nHost: gateway.local\r\nConnection: keep-alive\r\n"
+                                    "Content-Length: " + std::to_string(strlen(payload)) + "\r\n\r\n" + payload;
+        gw.print(request.c_str());
+        if (gw.available() == 0) {
+            if (!gw.connected() && HttpKeepAlive::retry_after_drop(conn, gw)) {
+                continue;
+            }
+            HttpKeepAlive::close(conn, gw);
+            return false;
+        }
+        break;
+    }
+
+    HttpKeepAlive::Framing framing;
+    char line[128];
+    HttpKeepAlive::read_line(gw, line, sizeof(line), millis(), 1000);
+    HttpKeepAlive::note_status_line(framing, line);
+    const bool ok = strncmp(line, "HTTP/1.1 200", 12) == 0;
+    while (HttpKeepAlive::read_line(gw, line, sizeof(line), millis(), 1000) && line[0] != '\0') {
+        HttpKeepAlive::note_header(framing, line);
+    }
+    char body[64];
+    bool complete = false;
+    HttpKeepAlive::read_body(gw, framing, body, sizeof(body), 1000, complete);
+    HttpKeepAlive::finish(conn, gw, framing, complete, millis());
+    return ok && strcmp(body, "{\"status\":\"ok\"}") == 0;
+}
+
+void test_edge_keepalive(void) {
+    printf("\n=== EDGE GATEWAY KEEP-ALIVE ===\n");
+    HttpKeepAlive::Connection conn;
+    MockGatewaySocket gw;
+    current_millis = 10000;
+
+    // A drain: 20 records one second apart share one TCP connection.
+    for (int i = 0; i < 20; ++i) {
+        TEST_ASSERT_TRUE(edge_keepalive_upload(conn, gw, "{\"t\":215}"));
+        current_millis += 1000;
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, gw.connects);
+    TEST_ASSERT_EQUAL_UINT32(20, gw.keepAliveRequests);
+    TEST_ASSERT_EQUAL_UINT32(19, conn.reuses);
+    TEST_ASSERT_TRUE(conn.open);
+
+    // Idle past the node's timeout (still inside the gateway's): closed and reopened, no retry.
+    current_millis += EDGE_KEEPALIVE_IDLE_MS;
+    TEST_ASSERT_TRUE(edge_keepalive_upload(conn, gw, "{\"t\":216}"));
+    TEST_ASSERT_EQUAL_UINT32(2, gw.connects);
+    TEST_ASSERT_EQUAL_UINT32(0, conn.retries);
+
+    // The gateway closes the kept socket as the request arrives: one transparent reconnect.
+    current_millis += 500;
+    gw.dropNextRequests = 1;
+    TEST_ASSERT_TRUE(edge_keepalive_upload(conn, gw, "{\"t\":217}"));
+    TEST_ASSERT_EQUAL_UINT32(3, gw.connects);
+    TEST_ASSERT_EQUAL_UINT32(1, conn.retries);
+    TEST_ASSERT_EQUAL_UINT32(22, gw.requests);
+
+    // A gateway that timed out first is noticed before sending.
+    gw.serverIdleMs = 1000;
+    current_millis += 1500;
+    TEST_ASSERT_TRUE(edge_keepalive_upload(conn, gw, "{\"t\":218}"));
+    TEST_ASSERT_EQUAL_UINT32(4, gw.connects);
+    TEST_ASSERT_EQUAL_UINT32(1, conn.retries);
+    gw.serverIdleMs = 5000;
+
+    // Chunked responses keep the socket too.
+    gw.chunked = true;
+    current_millis += 500;
+    TEST_ASSERT_TRUE(edge_keepalive_upload(conn, gw, "{\"t\":219}"));
+    current_millis += 500;
+    TEST_ASSERT_TRUE(edge_keepalive_upload(conn, gw, "{\"t\":220}"));
+    TEST_ASSERT_EQUAL_UINT32(4, gw.connects);
+    gw.chunked = false;
+
+    // "Connection: close" from the gateway ends the socket; the next upload reconnects.
+    gw.closeAfterResponse = true;
+    current_millis += 500;
+    TEST_ASSERT_TRUE(edge_keepalive_upload(conn, gw, "{\"t\":221}"));
+    TEST_ASSERT_FALSE(conn.open);
+    gw.closeAfterResponse = false;
+    current_millis += 500;
+    TEST_ASSERT_TRUE(edge_keepalive_upload(conn, gw, "{\"t\":222}"));
+    TEST_ASSERT_EQUAL_UINT32(5, gw.connects);
+
+    // Only one reconnect per request: a second drop fails the upload instead of looping.
+    current_millis += 500;
+    gw.dropNextRequests = 2;
+    TEST_ASSERT_FALSE(edge_keepalive_upload(conn, gw, "{\"t\":223}"));
+    TEST_ASSERT_FALSE(conn.open);
+    TEST_ASSERT_EQUAL_UINT32(2, conn.retries);
+
+    printf("[KEEPALIVE] %u requests over %u connects (%u reused, %u reconnects)\n",
+           (unsigned)gw.requests, (unsigned)gw.connects, (unsigned)conn.reuses, (unsigned)conn.retries);
+}
@@ -0,0 +1,82 @@
+#include <unity.h>
+#include <string>
+
+#include "test_fixtures.h"
+
+#include "net/EdgeWireCodec.h"
+
+// ============================================================================
+// CBOR EDGE RECORD
+// ============================================================================
+// The typed record goes to the gateway as a CBOR map instead of the patched JSON record. The
+// golden bytes below are also the self-test vector of scripts/decode_edge_payload.py.
+static std::string to_hex(const uint8_t* data, size_t len) {
+    static const char* digits = "0123456789abcdef";
+    std::string out;
+    for (size_t i = 0; i < len; ++i) {
+        out += digits[data[i] >> 4];
+        out += digits[data[i] & 0x0F];
+    }
+    return out;
+}
+
+void test_edge_wire_cbor(void) {
+    printf("\n=== CBOR EDGE RECORD ===\n");
+    RtcSensorRecord sample{1767225600u, -52, 615, 1234, -67};
+    EdgeWireCodec::Envelope env;
+    env.ghId = 2;
+    env.nodeId = 9;
+    env.rssiNonActive = -81;
+    env.sendTime = sample.timestamp;
+
+    uint8_t wire[EdgeWireCodec::kMaxEncodedLen];
+    const size_t len = EdgeWireCodec::encode(wire, sizeof(wire), SensorAggregateCodec::from_sample(sample), env);
+    TEST_ASSERT_EQUAL_STRING("a80002010902383303190267041904d205384206385007c11a6955b900", to_hex(wire, len).c_str());
+
+    SensorAggregateCodec::SensorAggregate back{};
+    EdgeWireCodec::Envelope backEnv;
+    TEST_ASSERT_TRUE(EdgeWireCodec::decode(wire, len, back, backEnv));
+    TEST_ASSERT_EQUAL_INT16(-52, back.tempMean10);
+    TEST_ASSERT_EQUAL_INT16(615, back.humMean10);
+    TEST_ASSERT_EQUAL_UINT16(1234, back.luxMean);
+    TEST_ASSERT_EQUAL_INT16(-67, back.rssiMean);
+    TEST_ASSERT_EQUAL_INT32(-81, backEnv.rssiNonActive);
+    TEST_ASSERT_EQUAL_UINT32(sample.timestamp, backEnv.sendTime);
+    TEST_ASSERT_EQUAL_UINT32(9, backEnv.nodeId);
+
+    // The JSON record the gateway gets today, for the same reading. Its send_time is the node's local
+    // time (UTC+7), which the decoder rebuilds from the UTC epoch tag.
+    const char* json = "{\"gh_id\":2,\"node_id\":9,\"temperature\":-5.2,\"humidity\":61.5,\"light_intensity\":1234,"
+                       "\"rssi\":-67,\"rssi_nonactive\":-81,\"send_time\":\"2026-01-01 07:00:00\"}";
+    TEST_ASSERT_TRUE(len * 3 < strlen(json));
+
+    // Unsynced clock: send_time is null. Out-of-range readings are clamped like the JSON record.
+    env.sendTime = 0;
+    sample.temp10 = 1500;
+    TEST_ASSERT_GREATER_THAN(0, EdgeWireCodec::encode(wire, sizeof(wire), SensorAggregateCodec::from_sample(sample), env));
+    TEST_ASSERT_TRUE(EdgeWireCodec::decode(wire, EdgeWireCodec::encode(wire, sizeof(wire),
+                                                                       SensorAggregateCodec::from_sample(sample), env),
+                                           back, backEnv));
+    TEST_ASSERT_EQUAL_UINT32(0, backEnv.sendTime);
+    TEST_ASSERT_EQUAL_INT16(1000, back.tempMean10);
+
+    // Aggregates carry the window summary; every field at its widest still fits the bound.
+    SensorAggregateCodec::SensorAggregate agg{4000000000u, 3600, 60, -400, 215, 1000, 0, 555, 1000, 65535, -128};
+    env.ghId = 0xFFFFFFFFu;
+    env.nodeId = 0xFFFFFFFFu;
+    env.rssiNonActive = -2147483647;
+    env.sendTime = agg.start;
+    const size_t aggLen = EdgeWireCodec::encode(wire, sizeof(wire), agg, env);
+    TEST_ASSERT_GREATER_THAN(0, aggLen);
+    TEST_ASSERT_TRUE(EdgeWireCodec::decode(wire, aggLen, back, backEnv));
+    TEST_ASSERT_EQUAL_UINT16(60, back.count);
+    TEST_ASSERT_EQUAL_UINT16(3600, back.window);
+    TEST_ASSERT_EQUAL_INT16(-400, back.tempMin10);
+    TEST_ASSERT_EQUAL_INT16(1000, back.humMax10);
+    TEST_ASSERT_EQUAL_INT32(-2147483647, backEnv.rssiNonActive);
+    TEST_ASSERT_EQUAL_UINT32(0, EdgeWireCodec::encode(wire, aggLen - 1, agg, env));
+    TEST_ASSERT_FALSE(EdgeWireCodec::decode(wire, aggLen - 1, back, backEnv));
+
+    printf("[CBOR] sample %u B vs %u B JSON; widest aggregate %u B\n", (unsigned)len, (unsigned)strlen(json),
+           (unsigned)aggLen);
+}
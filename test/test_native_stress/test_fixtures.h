@@ -0,0 +1,32 @@
+#pragma once
+
+// Helpers shared by the topic test files of this suite. The module implementations are
+// #included by test_simulation.cpp only; the other files see them through their headers.
+
+#include <unity.h>
+#include <stdio.h>
+
+#define NATIVE_TEST 1
+
+#include "NativeTestHelper.h"
+#include "storage/RtcManager.h"
+
+// A sample that differs from its neighbours in every field, at one-minute spacing.
+inline RtcSensorRecord make_sample(uint32_t i) {
+    RtcSensorRecord rec{};
+    rec.timestamp = 1710000000u + i * 60u;
+    rec.temp10 = static_cast<int16_t>(250 + static_cast<int32_t>(i % 7) - 3);
+    rec.hum10 = static_cast<int16_t>(600 - static_cast<int32_t>(i % 5));
+    rec.lux = static_cast<uint16_t>(1000 + (i % 11) * 3);
+    rec.rssi = static_cast<int16_t>(-60 - static_cast<int32_t>(i % 4));
+    return rec;
+}
+
+// One record as a short CSV line; stands in for the JSON renderers of the upload path.
+inline bool render_sample(char* out, size_t outLen, const RtcSensorRecord& rec, size_t& len) {
+    const int n = snprintf(out, outLen, "%lu,%d,%d,%u,%d", (unsigned long)rec.timestamp, rec.temp10, rec.hum10,
+                           (unsigned)rec.lux, rec.rssi);
+    if (n <= 0 || static_cast<size_t>(n) >= outLen) return false;
+    len = static_cast<size_t>(n);
+    return true;
+}
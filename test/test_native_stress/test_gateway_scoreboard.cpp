@@ -0,0 +1,97 @@
+#include <unity.h>
+
+#include "test_fixtures.h"
+
+#include "net/GatewayScoreboard.h"
+
+// ============================================================================
+// EDGE GATEWAY SCOREBOARD
+// ============================================================================
+// A dead primary mDNS name used to cost a connect timeout on every upload. Simulates uploads
+// against four candidates where the first never answers and checks that, after the first
+// failure, every upload connects on its first attempt until the probe brings the name back.
+void test_gateway_scoreboard(void) {
+    printf("\n=== EDGE GATEWAY SCOREBOARD ===\n");
+    GatewayScoreboard::Board board;
+    const char* hosts[] = {"gw1.local", "192.168.1.10", "gw2.local", "192.168.1.10"};
+    const uint32_t timeoutMs = 5000;
+    bool alive[] = {false, true, true, true};
+    const uint32_t rtt[] = {0, 30, 12, 30};
+
+    auto upload = [&](uint32_t& attempts) {
+        uint8_t order[4];
+        const size_t n = GatewayScoreboard::order(board, hosts, 4, order, sizeof(order), timeoutMs);
+        TEST_ASSERT_EQUAL_UINT32(3, n);  // the repeated IP is tried once
+        for (size_t k = 0; k < n; ++k) {
+            const size_t i = order[k];
+            attempts++;
+            GatewayScoreboard::record(board, hosts[i], alive[i], alive[i] ? rtt[i] : 0, millis());
+            if (alive[i]) {
+                return i;
+            }
+        }
+        return static_cast<size_t>(99);
+    };
+
+    current_millis = 1000;
+    uint32_t attempts = 0;
+    TEST_ASSERT_EQUAL_UINT32(1, upload(attempts));  // configured order: dead mDNS first
+    TEST_ASSERT_EQUAL_UINT32(2, attempts);
+    for (int i = 0; i < 20; ++i) {
+        current_millis += 1000;
+        attempts = 0;
+        upload(attempts);
+        TEST_ASSERT_EQUAL_UINT32(1, attempts);
+    }
+
+    // The secondary answers faster; once measured it takes over.
+    uint8_t order[4];
+    TEST_ASSERT_EQUAL_UINT32(3, GatewayScoreboard::order(board, hosts, 4, order, sizeof(order), timeoutMs));
+    TEST_ASSERT_EQUAL_UINT8(1, order[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, order[2]);  // demoted behind both healthy ones
+    GatewayScoreboard::record(board, hosts[2], true, rtt[2], millis());
+    TEST_ASSERT_EQUAL_UINT32(3, GatewayScoreboard::order(board, hosts, 4, order, sizeof(order), timeoutMs));
+    TEST_ASSERT_EQUAL_UINT8(2, order[0]);
+
+    // A failure on the leader hands the next upload to the runner-up at once.
+    alive[2] = false;
+    attempts = 0;
+    TEST_ASSERT_EQUAL_UINT32(1, upload(attempts));
+    TEST_ASSERT_EQUAL_UINT32(2, attempts);
+    alive[2] = true;
+
+    // Probes: the dead name is due a minute after its last try, one probe per interval.
+    current_millis = 1000 + EDGE_GATEWAY_REPROBE_MS - 1;
+    TEST_ASSERT_FALSE(GatewayScoreboard::probe_pending(board, millis()));
+    current_millis = 1000 + EDGE_GATEWAY_REPROBE_MS;
+    TEST_ASSERT_TRUE(GatewayScoreboard::probe_pending(board, millis()));
+    TEST_ASSERT_EQUAL_STRING("gw1.local", GatewayScoreboard::probe_due(board, hosts, 4, millis()));
+    GatewayScoreboard::probe_started(board, millis());
+    GatewayScoreboard::record(board, hosts[0], false, 0, millis());
+    current_millis += EDGE_GATEWAY_REPROBE_MS / 2;
+    TEST_ASSERT_FALSE(GatewayScoreboard::probe_pending(board, millis()));
+
+    // The secondary, demoted longer ago, goes first; it answers and is promoted.
+    current_millis += EDGE_GATEWAY_REPROBE_MS;
+    TEST_ASSERT_EQUAL_STRING("gw2.local", GatewayScoreboard::probe_due(board, hosts, 4, millis()));
+    GatewayScoreboard::probe_started(board, millis());
+    GatewayScoreboard::record(board, hosts[2], true, rtt[2], millis());
+
+    // The name comes back: the probe promotes it into the healthy group, still behind the two
+    // that failed less often until its success rate recovers.
+    current_millis += EDGE_GATEWAY_REPROBE_MS;
+    TEST_ASSERT_EQUAL_STRING("gw1.local", GatewayScoreboard::probe_due(board, hosts, 4, millis()));
+    GatewayScoreboard::probe_started(board, millis());
+    GatewayScoreboard::record(board, hosts[0], true, 8, millis());
+    TEST_ASSERT_FALSE(GatewayScoreboard::demoted(GatewayScoreboard::find(board, hosts[0])));
+    TEST_ASSERT_EQUAL_UINT32(3, GatewayScoreboard::order(board, hosts, 4, order, sizeof(order), timeoutMs));
+    TEST_ASSERT_EQUAL_UINT8(1, order[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, order[1]);
+    TEST_ASSERT_EQUAL_UINT8(0, order[2]);
+    TEST_ASSERT_FALSE(GatewayScoreboard::probe_pending(board, millis() + EDGE_GATEWAY_REPROBE_MS));
+    TEST_ASSERT_EQUAL_UINT32(2, board.promotions);
+    TEST_ASSERT_EQUAL_UINT32(3, board.probes);
+
+    printf("[SCORE] demotions=%u promotions=%u probes=%u\n",
+           (unsigned)board.demotions, (unsigned)board.promotions, (unsigned)board.probes);
+}
@@ -0,0 +1,62 @@
+#include <unity.h>
+
+#include "test_fixtures.h"
+
+#include "support/HmacSigner.h"
+
+// ============================================================================
+// CACHED HMAC SIGNER
+// ============================================================================
+void test_hmac_signer_cache(void) {
+    printf("\n=== CACHED HMAC SIGNER ===\n");
+    HmacSigner::Key key;
+    TEST_ASSERT_FALSE(key.ready);
+
+    // RFC 4231 test case 2.
+    const char secret[] = "Jefe";
+    const char message[] = "what do ya want for nothing?";
+    const size_t initsBefore = br_mock_hmac_key_inits;
+    HmacSigner::set_key(key, secret, sizeof(secret) - 1);
+    TEST_ASSERT_TRUE(key.ready);
+    char signature[HmacSigner::kHexLen + 1];
+    HmacSigner::sign_hex(key, message, sizeof(message) - 1, signature);
+    TEST_ASSERT_EQUAL_STRING("5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843", signature);
+
+    // Signing again reuses the schedule: no further key derivation, same result.
+    for (int i = 0; i < 10; ++i) {
+        char again[HmacSigner::kHexLen + 1];
+        HmacSigner::sign_hex(key, message, sizeof(message) - 1, again);
+        TEST_ASSERT_EQUAL_STRING(signature, again);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, br_mock_hmac_key_inits - initsBefore);
+
+    // Pieces fed in order sign like the joined message.
+    HmacSigner::Incremental stream(key);
+    stream.update(message, 4);
+    stream.update(nullptr, 0);
+    stream.update(message + 4, 13);
+    stream.update(message + 17, sizeof(message) - 1 - 17);
+    char streamed[HmacSigner::kHexLen + 1];
+    stream.finish_hex(streamed);
+    TEST_ASSERT_EQUAL_STRING(signature, streamed);
+
+    // RFC 4231 test case 6: a key longer than the block is hashed first.
+    uint8_t longKey[131];
+    memset(longKey, 0xaa, sizeof(longKey));
+    const char longMessage[] = "Test Using Larger Than Block-Size Key - Hash Key First";
+    HmacSigner::set_key(key, longKey, sizeof(longKey));
+    HmacSigner::sign_hex(key, longMessage, sizeof(longMessage) - 1, signature);
+    TEST_ASSERT_EQUAL_STRING("60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54", signature);
+
+    // A config save drops the schedule and wipes it.
+    HmacSigner::invalidate(key);
+    TEST_ASSERT_FALSE(key.ready);
+    const uint8_t* raw = reinterpret_cast<const uint8_t*>(&key.context);
+    bool wiped = true;
+    for (size_t i = 0; i < sizeof(key.context); ++i) {
+        wiped = wiped && raw[i] == 0;
+    }
+    TEST_ASSERT_TRUE(wiped);
+
+    printf("[HMAC] 11 signatures from 1 key schedule; streamed == one-shot\n");
+}
@@ -11,6 +11,36 @@ void test_json_escaping();
 void test_apiclient_payload_fragmentation();
 void test_simulated_system_load();
 void test_peak_load_simulation();
+void test_compact_sensor_record_capacity();
+void test_delta_block_codec_roundtrip();
+void test_delta_block_cache_consumption();
+void test_cache_capacity_benchmark();
+void test_cache_batched_drain_benchmark();
+void test_segmented_cache_roundtrip();
+void test_cache_engine_benchmark();
+void test_cache_write_amplification();
+void test_checkpoint_recovery_scan();
+void test_cache_read_page_benchmark();
+void test_cache_priority_lane();
+void test_cache_downsampling_retention();
+void test_cache_downsampling_unsynced();
+void test_rtc_partial_writes();
+void test_rtc_v3_packing_and_v2_migration();
+void test_rtc_bulk_flush();
+void test_rtc_stale_batch_watermark();
+void test_deep_sleep_duty_cycle();
+void test_tls_session_cache();
+void test_edge_keepalive();
+void test_queue_read_ahead();
+void test_upload_batch_stream();
+void test_encrypted_body_stream();
+void test_edge_wire_cbor();
+void test_gateway_scoreboard();
+void test_upload_latency();
+void test_qos_throughput_probe();
+void test_hmac_signer_cache();
+void test_sensor_payload_template();
+void test_timestamp_cache();
 
 void setUp(void) {
     mock_networks.clear();
@@ -28,5 +58,35 @@ int main(int argc, char **argv) {
     RUN_TEST(test_apiclient_payload_fragmentation);
     RUN_TEST(test_simulated_system_load);
     RUN_TEST(test_peak_load_simulation);
+    RUN_TEST(test_compact_sensor_record_capacity);
+    RUN_TEST(test_delta_block_codec_roundtrip);
+    RUN_TEST(test_delta_block_cache_consumption);
+    RUN_TEST(test_cache_capacity_benchmark);
+    RUN_TEST(test_cache_batched_drain_benchmark);
+    RUN_TEST(test_segmented_cache_roundtrip);
+    RUN_TEST(test_cache_engine_benchmark);
+    RUN_TEST(test_cache_write_amplification);
+    RUN_TEST(test_checkpoint_recovery_scan);
+    RUN_TEST(test_cache_read_page_benchmark);
+    RUN_TEST(test_cache_priority_lane);
+    RUN_TEST(test_cache_downsampling_retention);
+    RUN_TEST(test_cache_downsampling_unsynced);
+    RUN_TEST(test_rtc_partial_writes);
+    RUN_TEST(test_rtc_v3_packing_and_v2_migration);
+    RUN_TEST(test_rtc_bulk_flush);
+    RUN_TEST(test_rtc_stale_batch_watermark);
+    RUN_TEST(test_deep_sleep_duty_cycle);
+    RUN_TEST(test_tls_session_cache);
+    RUN_TEST(test_edge_keepalive);
+    RUN_TEST(test_queue_read_ahead);
+    RUN_TEST(test_upload_batch_stream);
+    RUN_TEST(test_encrypted_body_stream);
+    RUN_TEST(test_edge_wire_cbor);
+    RUN_TEST(test_gateway_scoreboard);
+    RUN_TEST(test_upload_latency);
+    RUN_TEST(test_qos_throughput_probe);
+    RUN_TEST(test_hmac_signer_cache);
+    RUN_TEST(test_sensor_payload_template);
+    RUN_TEST(test_timestamp_cache);
     return UNITY_END();
 }
@@ -0,0 +1,119 @@
+#include <unity.h>
+
+#include "test_fixtures.h"
+
+#include "storage/CacheManager.h"
+#include "storage/QueueReadAhead.h"
+
+// ============================================================================
+// UPLOAD READ-AHEAD
+// ============================================================================
+// Drains priority, RTC and routine records the way the pipelined upload does: the record after
+// the in-flight one is read while "waiting", the in-flight one is popped, and the read-ahead must
+// match what a fresh load returns. Anything that reorders the queue meanwhile voids the ticket.
+static QueueReadAhead::Ticket read_upload_record(CacheManager& cache,
+                                                 const QueueReadAhead::InFlight& inFlight,
+                                                 char* out,
+                                                 size_t outLen) {
+    auto renderRtc = [](char* buf, size_t bufLen, const RtcSensorRecord& rec, size_t& len) {
+        return render_sample(buf, bufLen, rec, len);
+    };
+    auto renderCached = [](char* buf, size_t bufLen, size_t& len) {
+        RtcSensorRecord rec{};
+        return CacheManager::decode_sensor_record(buf, len, rec) && render_sample(buf, bufLen, rec, len);
+    };
+    return QueueReadAhead::read(cache, inFlight, out, outLen, renderRtc, renderCached);
+}
+
+static bool pop_upload_record(CacheManager& cache, QueueReadAhead::Source source) {
+    RtcSensorRecord rec{};
+    switch (source) {
+        case QueueReadAhead::Source::PRIORITY: return cache.pop_one(CacheLane::PRIORITY);
+        case QueueReadAhead::Source::RTC: return RtcManager::popEx(rec) == RtcReadStatus::NONE;
+        case QueueReadAhead::Source::ROUTINE: return cache.pop_one(CacheLane::ROUTINE);
+        default: return false;
+    }
+}
+
+void test_queue_read_ahead(void) {
+    printf("\n=== UPLOAD READ-AHEAD ===\n");
+    LittleFS.format();
+    CacheManager cache;
+    cache.init();
+    memset(MockRtcMem::mem, 0, sizeof(MockRtcMem::mem));
+    TEST_ASSERT_TRUE(RtcManager::clear());
+
+    uint32_t i = 0;
+    for (uint32_t k = 0; k < 5; ++k) TEST_ASSERT_TRUE(cache.write_sensor_record(make_sample(i++)));
+    for (uint32_t k = 0; k < 3; ++k) {
+        const RtcSensorRecord s = make_sample(i++);
+        TEST_ASSERT_TRUE(RtcManager::append(s.timestamp, s.temp10, s.hum10, s.lux, s.rssi));
+    }
+    RtcSensorRecord alert = make_sample(i++);
+    alert.temp10 = 452;
+    TEST_ASSERT_TRUE(cache.write_sensor_record(alert, CacheLane::PRIORITY));
+
+    char current[MAX_PAYLOAD_SIZE + 1];
+    char ahead[MAX_PAYLOAD_SIZE + 1];
+    const QueueReadAhead::Source expectedOrder[] = {QueueReadAhead::Source::PRIORITY, QueueReadAhead::Source::RTC,
+                                                    QueueReadAhead::Source::RTC, QueueReadAhead::Source::RTC,
+                                                    QueueReadAhead::Source::ROUTINE, QueueReadAhead::Source::ROUTINE,
+                                                    QueueReadAhead::Source::ROUTINE, QueueReadAhead::Source::ROUTINE,
+                                                    QueueReadAhead::Source::ROUTINE};
+    QueueReadAhead::Ticket loaded = read_upload_record(cache, QueueReadAhead::InFlight{}, current, sizeof(current));
+    uint32_t hits = 0;
+    for (const QueueReadAhead::Source expected : expectedOrder) {
+        TEST_ASSERT_EQUAL(expected, loaded.source);
+        QueueReadAhead::InFlight inFlight;
+        if (loaded.source == QueueReadAhead::Source::PRIORITY) inFlight.priority = 1;
+        if (loaded.source == QueueReadAhead::Source::RTC) inFlight.rtc = 1;
+        if (loaded.source == QueueReadAhead::Source::ROUTINE) inFlight.routine = 1;
+        const QueueReadAhead::Ticket next = read_upload_record(cache, inFlight, ahead, sizeof(ahead));
+
+        TEST_ASSERT_TRUE(pop_upload_record(cache, loaded.source));
+        loaded = read_upload_record(cache, QueueReadAhead::InFlight{}, current, sizeof(current));
+        TEST_ASSERT_EQUAL(loaded.source, next.source);
+        if (next.source == QueueReadAhead::Source::NONE) break;
+        TEST_ASSERT_TRUE(QueueReadAhead::valid(cache, next));
+        TEST_ASSERT_EQUAL_UINT32(loaded.length, next.length);
+        TEST_ASSERT_EQUAL_STRING(current, ahead);
+        hits++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(8, hits);
+    TEST_ASSERT_EQUAL(QueueReadAhead::Source::NONE, loaded.source);
+
+    // A fresh RTC sample lands ahead of the routine lane while a routine upload is in flight.
+    for (uint32_t k = 0; k < 3; ++k) TEST_ASSERT_TRUE(cache.write_sensor_record(make_sample(i++)));
+    loaded = read_upload_record(cache, QueueReadAhead::InFlight{}, current, sizeof(current));
+    QueueReadAhead::InFlight routineInFlight;
+    routineInFlight.routine = 1;
+    QueueReadAhead::Ticket next = read_upload_record(cache, routineInFlight, ahead, sizeof(ahead));
+    TEST_ASSERT_EQUAL(QueueReadAhead::Source::ROUTINE, next.source);
+    const RtcSensorRecord late = make_sample(i++);
+    TEST_ASSERT_TRUE(RtcManager::append(late.timestamp, late.temp10, late.hum10, late.lux, late.rssi));
+    TEST_ASSERT_TRUE(pop_upload_record(cache, loaded.source));
+    TEST_ASSERT_FALSE(QueueReadAhead::valid(cache, next));
+    RtcSensorRecord popped{};
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::popEx(popped));
+
+    // An alert jumps the queue.
+    loaded = read_upload_record(cache, QueueReadAhead::InFlight{}, current, sizeof(current));
+    next = read_upload_record(cache, routineInFlight, ahead, sizeof(ahead));
+    TEST_ASSERT_EQUAL(QueueReadAhead::Source::ROUTINE, next.source);
+    TEST_ASSERT_TRUE(cache.write_sensor_record(alert, CacheLane::PRIORITY));
+    TEST_ASSERT_TRUE(pop_upload_record(cache, loaded.source));
+    TEST_ASSERT_FALSE(QueueReadAhead::valid(cache, next));
+    TEST_ASSERT_TRUE(pop_upload_record(cache, QueueReadAhead::Source::PRIORITY));
+
+    // The cache is wiped underneath the read-ahead, even though the lane is refilled.
+    loaded = read_upload_record(cache, QueueReadAhead::InFlight{}, current, sizeof(current));
+    TEST_ASSERT_EQUAL(QueueReadAhead::Source::ROUTINE, loaded.source);
+    TEST_ASSERT_TRUE(QueueReadAhead::valid(cache, loaded));
+    cache.reset();
+    TEST_ASSERT_TRUE(cache.write_sensor_record(make_sample(i++)));
+    TEST_ASSERT_FALSE(QueueReadAhead::valid(cache, loaded));
+
+    printf("[READ-AHEAD] %u of 8 follow-up records served from the read-ahead; RTC sample, alert and "
+           "reset each voided a ticket\n",
+           (unsigned)hits);
+}
@@ -1,4 +1,5 @@
 #include <unity.h>
+#include <chrono>
 #include <iostream>
 #include <random>
 #include <vector>
@@ -6,13 +7,21 @@
 // Define Testing Mode
 #define NATIVE_TEST 1
 
-#include "NativeTestHelper.h"
+#include "test_fixtures.h"
 
 // Include Application Logic
 // IMPORTANT: We include .cpp files to link logic without complex build systems
 // In a real repo this would be done via proper linking
 #include "support/Crc32.cpp"
+#include "support/TimestampCache.cpp"
+#include "storage/RtcManager.cpp"
+#include "system/DutyCycle.cpp"
+#include "net/TlsSessionCache.cpp"
+#include "net/QosProbe.h"
+#include "support/SensorPayloadTemplate.h"
+#include "support/TextBufferUtils.h"
 #include "storage/CacheManager.cpp"
+#include "storage/SegmentedCacheManager.cpp"
 // We map required externs here
 
 // ============================================================================
@@ -128,3 +137,1477 @@ void test_peak_load_simulation(void) {
     printf("=== SIMULATION PASS ===\n");
 }
 
+
+// ============================================================================
+// TEST: COMPACT SENSOR RECORDS (CACHE FORMAT V5)
+// ============================================================================
+void test_compact_sensor_record_capacity(void) {
+    printf("\n=== COMPACT RECORD CAPACITY ===\n");
+
+    LittleFS.format();
+    CacheManager cache;
+    cache.init();
+
+    RtcSensorRecord rec{};
+    rec.timestamp = 1700000000;
+    rec.temp10 = 253;
+    rec.hum10 = -1;
+    rec.lux = 1200;
+    rec.rssi = -67;
+
+    const uint32_t slot = CacheManager::SENSOR_RECORD_LEN + CacheManager::RECORD_OVERHEAD_BYTES;
+    uint32_t compactCount = 0;
+    while (cache.get_size() + slot <= MAX_CACHE_DATA_SIZE) {
+        rec.timestamp += 60;
+        TEST_ASSERT_TRUE(cache.write_sensor_record(rec));
+        compactCount++;
+    }
+
+    char buf[MAX_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+    TEST_ASSERT_EQUAL(CacheReadError::NONE, cache.read_one(buf, sizeof(buf), len));
+    RtcSensorRecord out{};
+    TEST_ASSERT_TRUE(CacheManager::decode_sensor_record(buf, len, out));
+    TEST_ASSERT_EQUAL_UINT32(1700000060u, out.timestamp);
+    TEST_ASSERT_EQUAL_INT16(253, out.temp10);
+    TEST_ASSERT_EQUAL_INT16(-1, out.hum10);
+    TEST_ASSERT_EQUAL_UINT16(1200, out.lux);
+    TEST_ASSERT_EQUAL_INT16(-67, out.rssi);
+
+    // Legacy JSON records must never be mistaken for compact ones.
+    const char json[] = "{\"gh_id\":1,\"node_id\":1,\"temperature\":\"25.3\",\"humidity\":\"60.2\","
+                        "\"light_intensity\":1200,\"rssi\":-67,\"recorded_at\":\"2023-11-14 22:14:20\"}";
+    TEST_ASSERT_FALSE(CacheManager::decode_sensor_record(json, sizeof(json) - 1, out));
+
+    const uint32_t jsonCount = MAX_CACHE_DATA_SIZE / ((sizeof(json) - 1) + CacheManager::RECORD_OVERHEAD_BYTES);
+    printf("[SIM] Records per %u B: compact=%u json=%u (%.1fx)\n",
+           (unsigned)MAX_CACHE_DATA_SIZE, (unsigned)compactCount, (unsigned)jsonCount,
+           (double)compactCount / (double)jsonCount);
+    TEST_ASSERT_GREATER_THAN_UINT32(5 * jsonCount, compactCount);
+}
+
+// ============================================================================
+// TEST: DELTA BLOCK CODEC (CACHE FORMAT V6)
+// ============================================================================
+void test_delta_block_codec_roundtrip(void) {
+    // Zig-zag/varint edges.
+    const int32_t edges[] = {0, 1, -1, 63, -64, 64, 8191, -8192, INT32_MAX, INT32_MIN};
+    for (int32_t v : edges) {
+        uint8_t buf[5];
+        const size_t n = SensorBlockCodec::put_varint(buf, SensorBlockCodec::zigzag(v));
+        size_t pos = 0;
+        uint32_t raw = 0;
+        TEST_ASSERT_TRUE(SensorBlockCodec::get_varint(buf, n, pos, raw));
+        TEST_ASSERT_EQUAL_UINT32(n, pos);
+        TEST_ASSERT_EQUAL_INT32(v, SensorBlockCodec::unzigzag(raw));
+    }
+
+    // Includes a timestamp step backwards and a full-range jump.
+    RtcSensorRecord samples[40];
+    for (uint32_t i = 0; i < 40; ++i) samples[i] = make_sample(i);
+    samples[5].timestamp = 0;
+    samples[9].lux = 65535;
+    samples[10].lux = 0;
+
+    uint8_t block[CacheManager::SENSOR_BLOCK_MAX_BYTES];
+    size_t encoded = 0;
+    const size_t len = SensorBlockCodec::encode(samples, 40, block, sizeof(block), encoded);
+    TEST_ASSERT_TRUE(len > 0 && len <= sizeof(block));
+    TEST_ASSERT_TRUE(encoded >= 20);
+    TEST_ASSERT_EQUAL_UINT8(encoded, SensorBlockCodec::sample_count(block, len));
+    for (size_t i = 0; i < encoded; ++i) {
+        RtcSensorRecord out{};
+        TEST_ASSERT_TRUE(SensorBlockCodec::decode_at(block, len, static_cast<uint8_t>(i), out));
+        TEST_ASSERT_EQUAL_MEMORY(&samples[i], &out, sizeof(out));
+    }
+    RtcSensorRecord out{};
+    TEST_ASSERT_FALSE(SensorBlockCodec::decode_at(block, len, static_cast<uint8_t>(encoded), out));
+    TEST_ASSERT_FALSE(SensorBlockCodec::decode_at(block, len - 1, static_cast<uint8_t>(encoded - 1), out));
+}
+
+void test_delta_block_cache_consumption(void) {
+    LittleFS.format();
+    CacheManager cache;
+    cache.init();
+
+    RtcSensorRecord samples[17];
+    for (uint32_t i = 0; i < 17; ++i) samples[i] = make_sample(i);
+    TEST_ASSERT_EQUAL_UINT32(17, cache.write_sensor_block(samples, 17));
+    TEST_ASSERT_TRUE(cache.write_sensor_record(make_sample(17)));
+
+    // Read-ahead sees every sample without moving the tail.
+    CacheManager::PeekCursor cursor = cache.peek_begin();
+    char buf[MAX_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+    for (uint32_t i = 0; i < 18; ++i) {
+        TEST_ASSERT_EQUAL(CacheReadError::NONE, cache.peek_next(cursor, buf, sizeof(buf), len));
+        RtcSensorRecord out{};
+        TEST_ASSERT_TRUE(CacheManager::decode_sensor_record(buf, len, out));
+        TEST_ASSERT_EQUAL_UINT32(1710000000u + i * 60u, out.timestamp);
+    }
+    TEST_ASSERT_EQUAL(CacheReadError::CACHE_EMPTY, cache.peek_next(cursor, buf, sizeof(buf), len));
+
+    // read_one/pop_one walk the block sample by sample, then move to the next record.
+    for (uint32_t i = 0; i < 18; ++i) {
+        TEST_ASSERT_EQUAL(CacheReadError::NONE, cache.read_one(buf, sizeof(buf), len));
+        RtcSensorRecord out{};
+        TEST_ASSERT_TRUE(CacheManager::decode_sensor_record(buf, len, out));
+        const RtcSensorRecord expected = make_sample(i);
+        TEST_ASSERT_EQUAL_MEMORY(&expected, &out, sizeof(out));
+        TEST_ASSERT_TRUE(cache.pop_one());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, cache.get_size());
+}
+
+// Records per MAX_CACHE_DATA_SIZE for each on-disk format, filled through the real write path.
+void test_cache_capacity_benchmark(void) {
+    printf("\n=== CACHE CAPACITY BENCHMARK (per %u B) ===\n", (unsigned)MAX_CACHE_DATA_SIZE);
+    const uint32_t slot = CacheManager::SENSOR_RECORD_LEN + CacheManager::RECORD_OVERHEAD_BYTES;
+
+    LittleFS.format();
+    CacheManager cache;
+    cache.init();
+    char json[MAX_PAYLOAD_SIZE + 1];
+    uint32_t jsonCount = 0;
+    for (;;) {
+        const RtcSensorRecord rec = make_sample(jsonCount);
+        const int n = snprintf(json, sizeof(json),
+                               "{\"gh_id\":1,\"node_id\":1,\"temperature\":\"%d.%d\",\"humidity\":\"%d.%d\","
+                               "\"light_intensity\":%u,\"rssi\":%d,\"recorded_at\":\"2023-11-14 22:14:20\"}",
+                               rec.temp10 / 10, rec.temp10 % 10, rec.hum10 / 10, rec.hum10 % 10,
+                               (unsigned)rec.lux, rec.rssi);
+        if (cache.get_size() + (uint32_t)n + CacheManager::RECORD_OVERHEAD_BYTES > MAX_CACHE_DATA_SIZE) break;
+        TEST_ASSERT_TRUE(cache.write(json, (uint16_t)n));
+        jsonCount++;
+    }
+
+    cache.reset();
+    uint32_t compactCount = 0;
+    while (cache.get_size() + slot <= MAX_CACHE_DATA_SIZE) {
+        TEST_ASSERT_TRUE(cache.write_sensor_record(make_sample(compactCount)));
+        compactCount++;
+    }
+
+    cache.reset();
+    uint32_t blockCount = 0;
+    RtcSensorRecord run[17];
+    while (cache.get_size() + CacheManager::LITTLEFS_PAGE_BYTES <= MAX_CACHE_DATA_SIZE) {
+        for (uint32_t i = 0; i < 17; ++i) run[i] = make_sample(blockCount + i);
+        const size_t stored = cache.write_sensor_block(run, 17);
+        TEST_ASSERT_TRUE(stored > 0);
+        blockCount += stored;
+    }
+
+    printf("[BENCH] json=%u compact=%u block=%u (block/json %.1fx)\n",
+           (unsigned)jsonCount, (unsigned)compactCount, (unsigned)blockCount,
+           (double)blockCount / (double)jsonCount);
+    TEST_ASSERT_GREATER_THAN_UINT32(compactCount, blockCount);
+    TEST_ASSERT_GREATER_THAN_UINT32(jsonCount, compactCount);
+}
+
+// ============================================================================
+// TEST: BATCHED DRAIN (read_many / pop_many)
+// ============================================================================
+static void fill_wrapped_cache(CacheManager& cache) {
+    cache.reset();
+    // Push the tail past the midpoint so the drained region wraps around the file end.
+    uint32_t i = 0;
+    while (cache.get_size() + 64 <= MAX_CACHE_DATA_SIZE / 2) {
+        TEST_ASSERT_TRUE(cache.write_sensor_record(make_sample(i++)));
+    }
+    while (cache.get_size() > 0) {
+        TEST_ASSERT_TRUE(cache.pop_one());
+    }
+    RtcSensorRecord run[17];
+    i = 0;
+    while (cache.get_size() + CacheManager::LITTLEFS_PAGE_BYTES <= MAX_CACHE_DATA_SIZE - 512) {
+        if ((i / 17) % 3 == 2) {
+            TEST_ASSERT_TRUE(cache.write_sensor_record(make_sample(i++)));
+            continue;
+        }
+        for (uint32_t k = 0; k < 17; ++k) run[k] = make_sample(i + k);
+        i += cache.write_sensor_block(run, 17);
+    }
+}
+
+void test_cache_batched_drain_benchmark(void) {
+    printf("\n=== BATCHED DRAIN BENCHMARK ===\n");
+    LittleFS.format();
+    CacheManager cache;
+    cache.init();
+    constexpr size_t kBatch = 16;
+
+    fill_wrapped_cache(cache);
+    std::vector<std::string> single;
+    g_mockFsStats.reset();
+    char buf[MAX_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+    while (cache.read_one(buf, sizeof(buf), len) == CacheReadError::NONE) {
+        single.emplace_back(buf, len);
+        TEST_ASSERT_TRUE(cache.pop_one());
+    }
+    const MockFsStats singleStats = g_mockFsStats;
+    TEST_ASSERT_EQUAL_UINT32(0, cache.get_size());
+
+    fill_wrapped_cache(cache);
+    std::vector<std::string> batched;
+    g_mockFsStats.reset();
+    char out[kBatch * (CacheManager::SENSOR_RECORD_LEN + 1)];
+    uint16_t lengths[kBatch];
+    size_t got = 0;
+    while (cache.read_many(std::span<char>(out), std::span<uint16_t>(lengths), kBatch, got) ==
+           CacheReadError::NONE) {
+        size_t pos = 0;
+        for (size_t r = 0; r < got; ++r) {
+            batched.emplace_back(out + pos, lengths[r]);
+            pos += lengths[r];
+        }
+        TEST_ASSERT_EQUAL_UINT32(got, cache.pop_many(got));
+    }
+    const MockFsStats batchStats = g_mockFsStats;
+    TEST_ASSERT_EQUAL_UINT32(0, cache.get_size());
+
+    TEST_ASSERT_EQUAL_UINT32(single.size(), batched.size());
+    for (size_t r = 0; r < single.size(); ++r) {
+        TEST_ASSERT_TRUE(single[r] == batched[r]);
+    }
+
+    printf("[BENCH] %u records: single reads=%u seeks=%u writes=%u | batch reads=%u seeks=%u writes=%u\n",
+           (unsigned)single.size(),
+           (unsigned)singleStats.reads, (unsigned)singleStats.seeks, (unsigned)singleStats.writes,
+           (unsigned)batchStats.reads, (unsigned)batchStats.seeks, (unsigned)batchStats.writes);
+    TEST_ASSERT_LESS_THAN_UINT32(singleStats.reads, batchStats.reads);
+    TEST_ASSERT_LESS_THAN_UINT32(singleStats.seeks, batchStats.seeks);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(singleStats.writes, batchStats.writes);
+}
+
+// ============================================================================
+// TEST: SEGMENTED APPEND-ONLY ENGINE
+// ============================================================================
+static size_t count_segment_files() {
+    size_t files = 0;
+    char path[16];
+    for (uint8_t slot = 0; slot < SegmentedCacheManager::SEGMENT_COUNT; ++slot) {
+        segmentPath(path, sizeof(path), slot);
+        if (LittleFS.exists(path)) files++;
+    }
+    return files;
+}
+
+void test_segmented_cache_roundtrip(void) {
+    static_assert(SegmentedCacheManager::SENSOR_RECORD_LEN == CacheManager::SENSOR_RECORD_LEN, "record format");
+    static_assert(SegmentedCacheManager::SENSOR_BLOCK_MAX_BYTES == CacheManager::SENSOR_BLOCK_MAX_BYTES, "block format");
+    LittleFS.format();
+
+    const char json[] = "{\"gh_id\":1,\"node_id\":1,\"temperature\":\"25.3\"}";
+    uint32_t written = 0;
+    {
+        SegmentedCacheManager cache;
+        cache.init();
+        // Mixed payloads spanning several segments.
+        RtcSensorRecord run[17];
+        while (written < 1500) {
+            if (written % 50 == 7) {
+                TEST_ASSERT_TRUE(cache.write(json, sizeof(json) - 1));
+                written++;
+                continue;
+            }
+            for (uint32_t k = 0; k < 17; ++k) run[k] = make_sample(written + k);
+            written += cache.write_sensor_block(run, 17);
+            TEST_ASSERT_TRUE(cache.write_sensor_record(make_sample(written)));
+            written++;
+        }
+        TEST_ASSERT_GREATER_THAN_UINT32(1, count_segment_files());
+
+        // Consume part of it, persist, and resume from a fresh instance.
+        char buf[MAX_PAYLOAD_SIZE + 1];
+        size_t len = 0;
+        for (uint32_t i = 0; i < 150; ++i) {
+            TEST_ASSERT_EQUAL(CacheReadError::NONE, cache.read_one(buf, sizeof(buf), len));
+            TEST_ASSERT_TRUE(cache.pop_one());
+        }
+        cache.flush();
+    }
+
+    SegmentedCacheManager cache;
+    cache.init();
+    SegmentedCacheManager::PeekCursor peek = cache.peek_begin();
+    char buf[MAX_PAYLOAD_SIZE + 1];
+    char peeked[MAX_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+    size_t peekLen = 0;
+    uint32_t remaining = 0;
+    while (cache.read_one(buf, sizeof(buf), len) == CacheReadError::NONE) {
+        TEST_ASSERT_EQUAL(CacheReadError::NONE, cache.peek_next(peek, peeked, sizeof(peeked), peekLen));
+        TEST_ASSERT_EQUAL_UINT32(len, peekLen);
+        TEST_ASSERT_EQUAL_MEMORY(buf, peeked, len);
+        TEST_ASSERT_TRUE(cache.pop_one());
+        remaining++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(written - 150, remaining);
+    TEST_ASSERT_EQUAL_UINT32(0, cache.get_size());
+    // Consumed segments are gone; only the open head remains.
+    TEST_ASSERT_EQUAL_UINT32(1, count_segment_files());
+
+    // Overflow evicts the oldest segment whole and keeps appending.
+    for (uint32_t i = 0; i < 20000; ++i) {
+        TEST_ASSERT_TRUE(cache.write_sensor_record(make_sample(i)));
+    }
+    TEST_ASSERT_EQUAL_UINT32(SegmentedCacheManager::SEGMENT_COUNT, count_segment_files());
+    TEST_ASSERT_TRUE(cache.get_size() <= SegmentedCacheManager::SEGMENT_BYTES * SegmentedCacheManager::SEGMENT_COUNT);
+    TEST_ASSERT_EQUAL(CacheReadError::NONE, cache.read_one(buf, sizeof(buf), len));
+    RtcSensorRecord first{};
+    TEST_ASSERT_TRUE(SegmentedCacheManager::decode_sensor_record(buf, len, first));
+    TEST_ASSERT_TRUE(first.timestamp > make_sample(0).timestamp);
+}
+
+// Same store-and-forward workload on both engines; in-place overwrites are what LittleFS
+// turns into copy-on-write of whole blocks.
+template <typename Cache>
+static MockFsStats run_engine_workload(Cache& cache) {
+    current_millis = 1000;  // non-zero clock so both engines batch their lazy header/cursor flushes
+    cache.reset();
+    g_mockFsStats.reset();
+    char buf[MAX_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+    for (uint32_t i = 0; i < 6000; ++i) {
+        TEST_ASSERT_TRUE(cache.write_sensor_record(make_sample(i)));
+        if (i % 20 == 19) {
+            for (int k = 0; k < 15 && cache.read_one(buf, sizeof(buf), len) == CacheReadError::NONE; ++k) {
+                TEST_ASSERT_TRUE(cache.pop_one());
+            }
+        }
+    }
+    cache.flush();
+    return g_mockFsStats;
+}
+
+void test_cache_engine_benchmark(void) {
+    printf("\n=== CACHE ENGINE BENCHMARK (ring vs segmented) ===\n");
+    LittleFS.format();
+    CacheManager ring;
+    ring.init();
+    const MockFsStats ringStats = run_engine_workload(ring);
+    SegmentedCacheManager segmented;
+    segmented.init();
+    const MockFsStats segStats = run_engine_workload(segmented);
+
+    printf("[BENCH] ring:      writes=%u overwrites=%u seeks=%u bytesWritten=%u\n",
+           (unsigned)ringStats.writes, (unsigned)ringStats.overwrites, (unsigned)ringStats.seeks,
+           (unsigned)ringStats.bytesWritten);
+    printf("[BENCH] segmented: writes=%u overwrites=%u seeks=%u bytesWritten=%u\n",
+           (unsigned)segStats.writes, (unsigned)segStats.overwrites, (unsigned)segStats.seeks,
+           (unsigned)segStats.bytesWritten);
+    TEST_ASSERT_LESS_THAN_UINT32(ringStats.overwrites, segStats.overwrites);
+    TEST_ASSERT_LESS_THAN_UINT32(ringStats.writes, segStats.writes);
+}
+
+// ============================================================================
+// TEST: WRITE AMPLIFICATION
+// ============================================================================
+// Runs the engine workload and checks the engine's own I/O counters against it; returns the
+// physical bytes the LittleFS copy-on-write model charged for it.
+template <typename Cache>
+static size_t measure_write_amplification(const char* name, Cache& cache) {
+    cache.init();
+    const CacheIoStats before = cache.io_stats();
+    const MockFsStats fs = run_engine_workload(cache);
+    const CacheIoStats& after = cache.io_stats();
+    const uint32_t logical = after.logicalBytes - before.logicalBytes;
+    const uint32_t framed = after.framedBytes - before.framedBytes;
+
+    printf("[WEAR] %-9s logical=%u framed=%u physical=%u (x%.1f) headerWrites=%u flushes=%u\n",
+           name, (unsigned)logical, (unsigned)framed, (unsigned)fs.physicalBytes,
+           logical ? (double)fs.physicalBytes / logical : 0.0,
+           (unsigned)(after.headerWrites - before.headerWrites), (unsigned)(after.flushes - before.flushes));
+    TEST_ASSERT_EQUAL_UINT32(6000, after.appends - before.appends);
+    TEST_ASSERT_EQUAL_UINT32(6000 * CacheManager::SENSOR_RECORD_LEN, logical);
+    TEST_ASSERT_EQUAL_UINT32(6000 * (CacheManager::SENSOR_RECORD_LEN + CacheManager::RECORD_OVERHEAD_BYTES), framed);
+    TEST_ASSERT_EQUAL_UINT32(0, after.writeRetries - before.writeRetries);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, after.flushes - before.flushes);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(framed, fs.physicalBytes);
+    return fs.physicalBytes;
+}
+
+void test_cache_write_amplification(void) {
+    printf("\n=== CACHE WRITE AMPLIFICATION (ring vs segmented) ===\n");
+    LittleFS.format();
+    CacheManager ring;
+    const size_t ringPhysical = measure_write_amplification("ring", ring);
+    SegmentedCacheManager segmented;
+    const size_t segPhysical = measure_write_amplification("segmented", segmented);
+    TEST_ASSERT_LESS_THAN_UINT32(ringPhysical, segPhysical);
+}
+
+// ============================================================================
+// TEST: CHECKPOINTED RECOVERY (FAULT INJECTION)
+// ============================================================================
+// Persists a populated cache, destroys the 4 KB after its tail as a torn trim would, then
+// counts the bytes performSyncScan walks before the first record reads back after restart.
+static uint32_t measure_tail_recovery_scan(bool keepIndex, MockFsStats* io = nullptr) {
+    LittleFS.format();
+    {
+        CacheManager cache;
+        cache.init();
+        for (int i = 0; i < 400; i++) {
+            auto data = generate_valid_payload(i);
+            TEST_ASSERT_TRUE(cache.write((const char*)data.data(), data.size()));
+        }
+        cache.flush();
+    }
+
+    File f = LittleFS.open(Paths::CACHE_FILE, "r");
+    CacheHeader h;
+    f.read((uint8_t*)&h, sizeof(h));
+    f.close();
+    for (uint32_t k = 0; k < 4096; k++) {
+        LittleFS.corruptByte(Paths::CACHE_FILE, h.tail + k);
+    }
+    if (!keepIndex) {
+        LittleFS.remove(Paths::CACHE_INDEX);
+    }
+
+    syncScanBytes = 0;
+    g_mockFsStats.reset();
+    CacheManager cache;
+    cache.init();
+    char buf[512];
+    size_t len = 0;
+    CacheReadError err = CacheReadError::CACHE_EMPTY;
+    for (int attempt = 0; attempt < 64; attempt++) {
+        err = cache.read_one(buf, sizeof(buf), len);
+        if (err == CacheReadError::NONE) break;
+    }
+    TEST_ASSERT_EQUAL(CacheReadError::NONE, err);
+    TEST_ASSERT_EQUAL('{', buf[0]);
+    if (io) *io = g_mockFsStats;
+    return syncScanBytes;
+}
+
+void test_checkpoint_recovery_scan(void) {
+    printf("\n=== CHECKPOINT RECOVERY (4 KB damaged tail) ===\n");
+    const uint32_t scanOnly = measure_tail_recovery_scan(false);
+    const uint32_t withIndex = measure_tail_recovery_scan(true);
+    printf("[FAULT] bytes scanned: magic scan=%u checkpoint index=%u\n", (unsigned)scanOnly, (unsigned)withIndex);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(4000, scanOnly);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(MAX_PAYLOAD_SIZE + CacheManager::RECORD_OVERHEAD_BYTES, withIndex);
+}
+
+// ============================================================================
+// TEST: RING READ PAGE
+// ============================================================================
+// File calls per record for a one-at-a-time drain and for a sync scan, with the 256 B read
+// page and with the direct seek+read per field it replaces.
+static MockFsStats drain_one_by_one(CacheManager& cache, std::vector<std::string>& out) {
+    fill_wrapped_cache(cache);
+    g_mockFsStats.reset();
+    char buf[MAX_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+    while (cache.read_one(buf, sizeof(buf), len) == CacheReadError::NONE) {
+        out.emplace_back(buf, len);
+        TEST_ASSERT_TRUE(cache.pop_one());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, cache.get_size());
+    return g_mockFsStats;
+}
+
+void test_cache_read_page_benchmark(void) {
+    printf("\n=== RING READ PAGE BENCHMARK ===\n");
+    LittleFS.format();
+    CacheManager cache;
+    cache.init();
+
+    std::vector<std::string> direct;
+    std::vector<std::string> paged;
+    readPageEnabled = false;
+    const MockFsStats directStats = drain_one_by_one(cache, direct);
+    readPageEnabled = true;
+    const MockFsStats pagedStats = drain_one_by_one(cache, paged);
+    TEST_ASSERT_EQUAL_UINT32(direct.size(), paged.size());
+    for (size_t r = 0; r < direct.size(); ++r) {
+        TEST_ASSERT_TRUE(direct[r] == paged[r]);
+    }
+    const double n = static_cast<double>(direct.size());
+    printf("[BENCH] drain %u records: direct seeks/rec=%.2f reads/rec=%.2f | page seeks/rec=%.2f reads/rec=%.2f\n",
+           (unsigned)direct.size(), directStats.seeks / n, directStats.reads / n, pagedStats.seeks / n,
+           pagedStats.reads / n);
+    TEST_ASSERT_LESS_THAN_UINT32(directStats.seeks / 4, pagedStats.seeks);
+    TEST_ASSERT_LESS_THAN_UINT32(directStats.reads / 4, pagedStats.reads);
+
+    MockFsStats directScan;
+    MockFsStats pagedScan;
+    readPageEnabled = false;
+    const uint32_t directBytes = measure_tail_recovery_scan(false, &directScan);
+    readPageEnabled = true;
+    const uint32_t pagedBytes = measure_tail_recovery_scan(false, &pagedScan);
+    printf("[BENCH] sync scan %u B: direct seeks=%u reads=%u | page seeks=%u reads=%u\n",
+           (unsigned)pagedBytes, (unsigned)directScan.seeks, (unsigned)directScan.reads,
+           (unsigned)pagedScan.seeks, (unsigned)pagedScan.reads);
+    TEST_ASSERT_EQUAL_UINT32(directBytes, pagedBytes);
+    TEST_ASSERT_LESS_THAN_UINT32(directScan.reads, pagedScan.reads);
+    TEST_ASSERT_LESS_THAN_UINT32(directScan.seeks, pagedScan.seeks);
+}
+
+// ============================================================================
+// Alerts written behind a full, still-growing routine backlog stay first in their own lane,
+// survive routine trims and a restart, and overflow into the routine lane instead of
+// evicting older alerts.
+void test_cache_priority_lane(void) {
+    LittleFS.format();
+    CacheManager cache;
+    cache.init();
+
+    RtcSensorRecord run[17];
+    uint32_t i = 0;
+    auto writeRoutineBlock = [&]() {
+        for (uint32_t k = 0; k < 17; ++k) run[k] = make_sample(i + k);
+        const size_t stored = cache.write_sensor_block(run, 17);
+        TEST_ASSERT_GREATER_THAN(0, stored);
+        i += stored;
+    };
+    while (cache.io_stats().trims == 0) writeRoutineBlock();  // routine lane full from here on
+
+    RtcSensorRecord alert = make_sample(i++);
+    alert.temp10 = 452;
+    TEST_ASSERT_TRUE(cache.write_sensor_record(alert, CacheLane::PRIORITY));
+    const uint32_t alertBytes = CacheManager::SENSOR_RECORD_LEN + CacheManager::RECORD_OVERHEAD_BYTES;
+    TEST_ASSERT_EQUAL_UINT32(alertBytes, cache.get_lane_size(CacheLane::PRIORITY));
+
+    // Keep writing until every routine byte present at alert time has been evicted.
+    const uint32_t trimmedBefore = cache.io_stats().trimmedBytes;
+    while (cache.io_stats().trimmedBytes - trimmedBefore < MAX_CACHE_DATA_SIZE) writeRoutineBlock();
+    TEST_ASSERT_EQUAL_UINT32(alertBytes, cache.get_lane_size(CacheLane::PRIORITY));
+
+    // Restart: both lanes come back from their headers.
+    cache.flush();
+    CacheManager reopened;
+    reopened.init();
+    TEST_ASSERT_EQUAL_UINT32(alertBytes, reopened.get_lane_size(CacheLane::PRIORITY));
+
+    char buf[MAX_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+    RtcSensorRecord out{};
+    CacheManager::PeekCursor cursor = reopened.peek_begin(CacheLane::PRIORITY);
+    TEST_ASSERT_EQUAL(CacheReadError::NONE, reopened.peek_next(cursor, buf, sizeof(buf), len));
+    TEST_ASSERT_TRUE(CacheManager::decode_sensor_record(buf, len, out));
+    TEST_ASSERT_EQUAL_INT16(452, out.temp10);
+    TEST_ASSERT_EQUAL(CacheReadError::CACHE_EMPTY, reopened.peek_next(cursor, buf, sizeof(buf), len));
+
+    TEST_ASSERT_EQUAL(CacheReadError::NONE, reopened.read_one(buf, sizeof(buf), len, CacheLane::PRIORITY));
+    TEST_ASSERT_TRUE(CacheManager::decode_sensor_record(buf, len, out));
+    TEST_ASSERT_EQUAL_UINT32(alert.timestamp, out.timestamp);
+    TEST_ASSERT_EQUAL(CacheReadError::NONE, reopened.read_one(buf, sizeof(buf), len));
+    TEST_ASSERT_TRUE(CacheManager::decode_sensor_record(buf, len, out));
+    TEST_ASSERT_TRUE(out.temp10 < 260);  // routine sample from the other lane
+    TEST_ASSERT_TRUE(reopened.pop_one(CacheLane::PRIORITY));
+    TEST_ASSERT_EQUAL_UINT32(0, reopened.get_lane_size(CacheLane::PRIORITY));
+    TEST_ASSERT_EQUAL(CacheReadError::CACHE_EMPTY, reopened.read_one(buf, sizeof(buf), len, CacheLane::PRIORITY));
+
+    // Overflow: a full priority lane keeps its alerts and the next one displaces routine data.
+    uint32_t alerts = 0;
+    while (reopened.get_lane_size(CacheLane::PRIORITY) + alertBytes <= CACHE_PRIORITY_LANE_BYTES) {
+        alert.timestamp += 60;
+        TEST_ASSERT_TRUE(reopened.write_sensor_record(alert, CacheLane::PRIORITY));
+        alerts++;
+    }
+    const uint32_t laneFull = reopened.get_lane_size(CacheLane::PRIORITY);
+    alert.timestamp += 60;
+    alert.temp10 = 999;
+    TEST_ASSERT_TRUE(reopened.write_sensor_record(alert, CacheLane::PRIORITY));
+    TEST_ASSERT_EQUAL_UINT32(laneFull, reopened.get_lane_size(CacheLane::PRIORITY));
+    TEST_ASSERT_EQUAL_UINT32(alerts, reopened.pop_many(alerts + 1, CacheLane::PRIORITY));
+    TEST_ASSERT_EQUAL_UINT32(0, reopened.get_lane_size(CacheLane::PRIORITY));
+    printf("[LANES] %u alerts fit the %u B priority lane; overflow spilled to routine lane\n",
+           (unsigned)alerts, (unsigned)CACHE_PRIORITY_LANE_BYTES);
+}
+
+// ============================================================================
+// Thirty days offline at one sample a minute: with downsampling the oldest history survives as
+// ever coarser aggregates instead of being trimmed away whole.
+struct RetainedHistory {
+    uint32_t oldest = 0xFFFFFFFFu;
+    uint32_t samples = 0;
+    uint32_t aggregates = 0;
+};
+
+static RetainedHistory offline_history(bool downsample) {
+    LittleFS.format();
+    CacheManager cache;
+    cache.init();
+    RtcSensorRecord run[15];
+    const uint32_t total = 30u * 24u * 60u;
+    for (uint32_t i = 0; i < total;) {
+        for (uint32_t k = 0; k < 15; ++k) run[k] = make_sample(i + k);
+        const size_t stored = cache.write_sensor_block(run, 15);
+        TEST_ASSERT_GREATER_THAN(0, stored);
+        i += stored;
+        for (int pass = 0; downsample && pass < 4; ++pass) {
+            (void)cache.downsample_step();
+        }
+    }
+
+    RetainedHistory seen;
+    char buf[MAX_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+    CacheManager::PeekCursor cursor = cache.peek_begin();
+    while (cache.peek_next(cursor, buf, sizeof(buf), len) == CacheReadError::NONE) {
+        RtcSensorRecord sample;
+        SensorAggregateCodec::SensorAggregate agg;
+        if (CacheManager::decode_sensor_record(buf, len, sample)) {
+            seen.oldest = std::min(seen.oldest, sample.timestamp);
+            seen.samples++;
+        } else {
+            TEST_ASSERT_TRUE(SensorAggregateCodec::decode(buf, len, agg));
+            TEST_ASSERT_TRUE(agg.tempMin10 <= agg.tempMean10 && agg.tempMean10 <= agg.tempMax10);
+            TEST_ASSERT_TRUE(agg.humMin10 <= agg.humMean10 && agg.humMean10 <= agg.humMax10);
+            TEST_ASSERT_TRUE(agg.window >= CacheDownsampler::kWindowSeconds && agg.window <= CacheDownsampler::kMaxWindowSeconds);
+            TEST_ASSERT_GREATER_THAN(0, agg.count);
+            seen.oldest = std::min(seen.oldest, agg.start);
+            seen.aggregates++;
+        }
+    }
+    if (downsample) {
+        TEST_ASSERT_GREATER_THAN(0, cache.io_stats().downsampledEntries);
+    }
+    return seen;
+}
+
+void test_cache_downsampling_retention(void) {
+    printf("\n=== CACHE DOWNSAMPLING (30 days offline, 1 sample/min) ===\n");
+    const uint32_t end = make_sample(30u * 24u * 60u).timestamp;
+    const RetainedHistory plain = offline_history(false);
+    const RetainedHistory merged = offline_history(true);
+    TEST_ASSERT_EQUAL_UINT32(0, plain.aggregates);
+    TEST_ASSERT_GREATER_THAN(0, merged.aggregates);
+    TEST_ASSERT_GREATER_THAN(0, merged.samples);  // recent history stays at full resolution
+
+    const uint32_t plainHours = (end - plain.oldest) / 3600u;
+    const uint32_t mergedHours = (end - merged.oldest) / 3600u;
+    printf("[HISTORY] trim only: %u h (%u samples) | downsampled: %u h (%u samples + %u aggregates)\n",
+           (unsigned)plainHours, (unsigned)plain.samples, (unsigned)mergedHours,
+           (unsigned)merged.samples, (unsigned)merged.aggregates);
+    TEST_ASSERT_GREATER_THAN(plainHours * 3 / 2, mergedHours);
+}
+
+// Samples taken before NTP carry timestamp 0 and would all fall into bucket 0. They stop a pass
+// like legacy records instead of collapsing into one 1970 aggregate; synced history ahead of
+// them is still merged.
+void test_cache_downsampling_unsynced(void) {
+    printf("\n=== CACHE DOWNSAMPLING (pre-NTP samples) ===\n");
+    LittleFS.format();
+    CacheManager cache;
+    cache.init();
+    RtcSensorRecord run[15];
+    uint32_t i = 0;
+    for (; i < 150; i += 15) {
+        for (uint32_t k = 0; k < 15; ++k) run[k] = make_sample(i + k);
+        TEST_ASSERT_EQUAL_UINT32(15, cache.write_sensor_block(run, 15));
+    }
+    const uint32_t kUnsynced = 200;
+    for (uint32_t k = 0; k < kUnsynced; ++k) {
+        RtcSensorRecord rec = make_sample(i + k);
+        rec.timestamp = 0;
+        TEST_ASSERT_TRUE(cache.write_sensor_record(rec));
+    }
+    while (cache.get_lane_size(CacheLane::ROUTINE) < MAX_CACHE_DATA_SIZE / 100U * (CACHE_DOWNSAMPLE_START_PCT + 5)) {
+        for (uint32_t k = 0; k < 15; ++k) run[k] = make_sample(i + k);
+        i += cache.write_sensor_block(run, 15);
+    }
+    for (int pass = 0; pass < 64; ++pass) {
+        (void)cache.downsample_step();
+    }
+
+    uint32_t unsynced = 0;
+    uint32_t aggregates = 0;
+    char buf[MAX_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+    CacheManager::PeekCursor cursor = cache.peek_begin();
+    while (cache.peek_next(cursor, buf, sizeof(buf), len) == CacheReadError::NONE) {
+        RtcSensorRecord sample;
+        SensorAggregateCodec::SensorAggregate agg;
+        if (CacheManager::decode_sensor_record(buf, len, sample)) {
+            unsynced += (sample.timestamp == 0) ? 1 : 0;
+        } else {
+            TEST_ASSERT_TRUE(SensorAggregateCodec::decode(buf, len, agg));
+            TEST_ASSERT_TRUE(agg.start > NTP_VALID_TIMESTAMP_THRESHOLD);
+            aggregates++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(kUnsynced, unsynced);
+    TEST_ASSERT_GREATER_THAN(0, aggregates);
+    printf("[HISTORY] %u pre-NTP samples kept as is, %u synced aggregates\n", (unsigned)unsynced,
+           (unsigned)aggregates);
+}
+
+// ============================================================================
+// RTC writes cover only the touched slot and the header instead of the whole 364-byte block,
+// and the image left in RTC memory still loads back intact.
+void test_rtc_partial_writes(void) {
+    printf("\n=== RTC PARTIAL WRITES ===\n");
+    memset(MockRtcMem::mem, 0, sizeof(MockRtcMem::mem));
+    TEST_ASSERT_TRUE(RtcManager::clear());
+    RtcManager::init();
+
+    // A 9-byte slot is widened to the RTC blocks it touches.
+    const uint32_t slotAndHeader = 16 + sizeof(RtcHeaderV3);
+    uint32_t appendBytes = 0;
+    for (uint32_t i = 0; i < RTC_MAX_RECORDS; ++i) {
+        const RtcSensorRecord s = make_sample(i);
+        MockRtcMem::resetCounters();
+        TEST_ASSERT_TRUE(RtcManager::append(s.timestamp, s.temp10, s.hum10, s.lux, s.rssi));
+        TEST_ASSERT_TRUE(MockRtcMem::bytesWritten <= slotAndHeader);
+        TEST_ASSERT_EQUAL_UINT32(2, MockRtcMem::writeCalls);
+        appendBytes = std::max(appendBytes, MockRtcMem::bytesWritten);
+    }
+    TEST_ASSERT_TRUE(RtcManager::isFull());
+
+    // Overwriting the oldest slot when full is still one slot plus the header.
+    const RtcSensorRecord extra = make_sample(RTC_MAX_RECORDS);
+    MockRtcMem::resetCounters();
+    TEST_ASSERT_TRUE(RtcManager::append(extra.timestamp, extra.temp10, extra.hum10, extra.lux, extra.rssi));
+    TEST_ASSERT_TRUE(MockRtcMem::bytesWritten <= slotAndHeader);
+
+    // Pops only move the header.
+    RtcSensorRecord out{};
+    MockRtcMem::resetCounters();
+    TEST_ASSERT_TRUE(RtcManager::pop(out));
+    TEST_ASSERT_EQUAL_UINT32(make_sample(1).timestamp, out.timestamp);
+    const uint32_t popBytes = MockRtcMem::bytesWritten;
+    TEST_ASSERT_EQUAL_UINT32(sizeof(RtcHeaderV3), popBytes);
+
+    RtcSensorRecord front{};
+    uint16_t seq = 0;
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::peekAtEx(3, front, seq));
+    MockRtcMem::resetCounters();
+    uint16_t popped = 0;
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::popThroughSeq(seq, 4, popped));
+    TEST_ASSERT_EQUAL_UINT16(4, popped);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(RtcHeaderV3), MockRtcMem::bytesWritten);
+    TEST_ASSERT_EQUAL_UINT32(1, MockRtcMem::writeCalls);
+
+    // Reload from RTC memory: header and untouched slots are consistent.
+    RtcManager::init();
+    TEST_ASSERT_EQUAL_UINT16(RTC_MAX_RECORDS - 5, RtcManager::getCount());
+    for (uint16_t i = 0; i < RTC_MAX_RECORDS - 5; ++i) {
+        const RtcSensorRecord expected = make_sample(6 + i);
+        TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::peekAtEx(i, front, seq));
+        TEST_ASSERT_EQUAL_MEMORY(&expected, &front, sizeof(front));
+    }
+
+    printf("[RTC] bytes written: append <=%u | pop %u (full block %u)\n",
+           (unsigned)appendBytes, (unsigned)popBytes, (unsigned)sizeof(RtcSensorData));
+}
+
+// Layout V3 holds at least twice the V2 records, keeps samples without valid time and samples
+// that move the timestamp base, and turns a V2 image left by older firmware into V3 in place.
+void test_rtc_v3_packing_and_v2_migration(void) {
+    printf("\n=== RTC V3 PACKING / V2 MIGRATION ===\n");
+    TEST_ASSERT_TRUE(RTC_MAX_RECORDS >= 35);
+
+    memset(MockRtcMem::mem, 0, sizeof(MockRtcMem::mem));
+    TEST_ASSERT_TRUE(RtcManager::clear());
+    RtcSensorRecord edge = make_sample(100);
+    edge.temp10 = -400;
+    edge.hum10 = 1000;
+    edge.lux = 65535;
+    edge.rssi = -128;
+    TEST_ASSERT_TRUE(RtcManager::append(edge.timestamp, edge.temp10, edge.hum10, edge.lux, edge.rssi));
+    TEST_ASSERT_TRUE(RtcManager::append(0, 215, 400, 12, -70));
+    // Earlier than the base: the stored slots are rebased.
+    TEST_ASSERT_TRUE(RtcManager::append(edge.timestamp - 3600, 1, 2, 3, -4));
+    // Out of slot range or too far from the stored samples: left to the LittleFS fallback.
+    TEST_ASSERT_FALSE(RtcManager::append(edge.timestamp, 3000, 500, 1, -60));
+    TEST_ASSERT_FALSE(RtcManager::append(edge.timestamp + 86400, 200, 500, 1, -60));
+    TEST_ASSERT_EQUAL_UINT16(3, RtcManager::getCount());
+
+    RtcSensorRecord out{};
+    uint16_t seq = 0;
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::peekAtEx(0, out, seq));
+    TEST_ASSERT_EQUAL_MEMORY(&edge, &out, sizeof(out));
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::peekAtEx(1, out, seq));
+    TEST_ASSERT_EQUAL_UINT32(0, out.timestamp);
+    TEST_ASSERT_EQUAL_INT16(215, out.temp10);
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::peekAtEx(2, out, seq));
+    TEST_ASSERT_EQUAL_UINT32(edge.timestamp - 3600, out.timestamp);
+    TEST_ASSERT_EQUAL_INT16(-4, out.rssi);
+
+    // V2 image with a wrapped ring: 15 records starting at slot 12.
+    LegacyRtcSensorDataV2 v2{};
+    v2.header.blockMagic = RTC_SENSOR_MAGIC;
+    v2.header.version = 2;
+    v2.header.maxRecords = kLegacyV2Records;
+    v2.header.tail = 12;
+    v2.header.count = 15;
+    v2.header.head = (12 + 15) % kLegacyV2Records;
+    for (uint16_t i = 0; i < 15; ++i) {
+        const RtcSensorRecord rec = make_sample(i);
+        LegacyRtcRecordV2& slot = v2.records[(12 + i) % kLegacyV2Records];
+        slot.magic = RTC_RECORD_MAGIC;
+        slot.seq = static_cast<uint16_t>(500 + i);
+        slot.timestamp = rec.timestamp;
+        slot.temp10 = rec.temp10;
+        slot.hum10 = rec.hum10;
+        slot.lux = rec.lux;
+        slot.rssi = rec.rssi;
+        slot.crc = Crc32::compute(&slot, offsetof(LegacyRtcRecordV2, crc));
+    }
+    v2.header.nextSeq = 515;
+    v2.header.headerCrc = Crc32::compute(&v2.header, offsetof(LegacyRtcHeaderV2, headerCrc));
+    memcpy(MockRtcMem::mem + RTC_SENSOR_BLOCK_OFFSET * 4, &v2, sizeof(v2));
+
+    RtcManager::init();
+    TEST_ASSERT_EQUAL_UINT16(15, RtcManager::getCount());
+    TEST_ASSERT_EQUAL_UINT16(RTC_LAYOUT_VERSION, RtcManager::getRawData().header.version);
+    for (uint16_t i = 0; i < 15; ++i) {
+        const RtcSensorRecord expected = make_sample(i);
+        TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::peekAtEx(i, out, seq));
+        TEST_ASSERT_EQUAL_MEMORY(&expected, &out, sizeof(out));
+    }
+
+    // Migrated records keep appending and fill the larger ring.
+    for (uint32_t i = 15; i < RTC_MAX_RECORDS; ++i) {
+        const RtcSensorRecord s = make_sample(i);
+        TEST_ASSERT_TRUE(RtcManager::append(s.timestamp, s.temp10, s.hum10, s.lux, s.rssi));
+    }
+    TEST_ASSERT_TRUE(RtcManager::isFull());
+    TEST_ASSERT_TRUE(RtcManager::peek(out));
+    TEST_ASSERT_EQUAL_UINT32(make_sample(0).timestamp, out.timestamp);
+
+    printf("[RTC] V3 records per %u B: %u (V2: %u)\n",
+           (unsigned)sizeof(RtcSensorData), (unsigned)RTC_MAX_RECORDS, (unsigned)kLegacyV2Records);
+}
+
+// ============================================================================
+// The forced RTC flush takes every valid record from one RTC read into one cache append and
+// clears RTC with one header write; a record appended before the pop survives it.
+void test_rtc_bulk_flush(void) {
+    printf("\n=== RTC BULK FLUSH ===\n");
+    LittleFS.format();
+    CacheManager cache;
+    cache.init();
+    memset(MockRtcMem::mem, 0, sizeof(MockRtcMem::mem));
+    TEST_ASSERT_TRUE(RtcManager::clear());
+    for (uint32_t i = 0; i < RTC_MAX_RECORDS; ++i) {
+        const RtcSensorRecord s = make_sample(i);
+        TEST_ASSERT_TRUE(RtcManager::append(s.timestamp, s.temp10, s.hum10, s.lux, s.rssi));
+    }
+    // A corrupt slot inside the run is skipped, not flushed.
+    MockRtcMem::mem[RTC_SENSOR_BLOCK_OFFSET * 4 + offsetof(RtcSensorData, records) + 5 * sizeof(RtcRecordV3)] ^= 0x5A;
+
+    RtcSensorRecord run[RTC_MAX_RECORDS];
+    uint16_t runSeq[RTC_MAX_RECORDS];
+    uint16_t runLen = 0;
+    MockRtcMem::resetCounters();
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::peekRun(run, runSeq, RTC_MAX_RECORDS, runLen));
+    TEST_ASSERT_EQUAL_UINT32(1, MockRtcMem::readCalls);
+    TEST_ASSERT_EQUAL_UINT32(0, MockRtcMem::writeCalls);
+    TEST_ASSERT_EQUAL_UINT16(RTC_MAX_RECORDS - 1, runLen);
+
+    const uint32_t writesBefore = cache.io_stats().appends;
+    TEST_ASSERT_EQUAL_UINT32(runLen, cache.write_sensor_block(run, runLen));
+    TEST_ASSERT_EQUAL_UINT32(1, cache.io_stats().appends - writesBefore);
+    // As flushRtcToLittleFs does: the header goes out before RTC lets go of the run.
+    cache.flush();
+
+    const RtcSensorRecord late = make_sample(RTC_MAX_RECORDS);
+    TEST_ASSERT_TRUE(RtcManager::append(late.timestamp, late.temp10, late.hum10, late.lux, late.rssi));
+
+    MockRtcMem::resetCounters();
+    uint16_t popped = 0;
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::popThroughSeq(runSeq[runLen - 1], RTC_MAX_RECORDS, popped));
+    TEST_ASSERT_EQUAL_UINT32(1, MockRtcMem::writeCalls);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(RtcHeaderV3), MockRtcMem::bytesWritten);
+    TEST_ASSERT_EQUAL_UINT16(1, RtcManager::getCount());
+    RtcSensorRecord out{};
+    TEST_ASSERT_TRUE(RtcManager::peek(out));
+    TEST_ASSERT_EQUAL_MEMORY(&late, &out, sizeof(out));
+
+    // A reset right after the pop: the cache reopens from what reached flash, without a
+    // shutdown flush, and the run RTC no longer holds is there.
+    CacheManager rebooted;
+    rebooted.init();
+    CacheManager::PeekCursor cursor = rebooted.peek_begin();
+    char buf[MAX_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+    for (uint32_t i = 0; i < RTC_MAX_RECORDS; ++i) {
+        if (i == 5) continue;
+        TEST_ASSERT_EQUAL(CacheReadError::NONE, rebooted.peek_next(cursor, buf, sizeof(buf), len));
+        TEST_ASSERT_TRUE(CacheManager::decode_sensor_record(buf, len, out));
+        const RtcSensorRecord expected = make_sample(i);
+        TEST_ASSERT_EQUAL_MEMORY(&expected, &out, sizeof(out));
+    }
+    TEST_ASSERT_EQUAL(CacheReadError::CACHE_EMPTY, rebooted.peek_next(cursor, buf, sizeof(buf), len));
+
+    printf("[FLUSH] %u records: 1 RTC read, 1 cache append, 1 RTC header write (%u B)\n",
+           (unsigned)runLen, (unsigned)sizeof(RtcHeaderV3));
+}
+
+// ============================================================================
+// An upload batch pops its RTC part by the sequence number of its last record once the server has
+// it. If RTC was reset or its header healed in the meantime, that watermark names records that are
+// gone, and the pop must leave the fresh ones alone.
+void test_rtc_stale_batch_watermark(void) {
+    printf("\n=== RTC STALE BATCH WATERMARK ===\n");
+    memset(MockRtcMem::mem, 0, sizeof(MockRtcMem::mem));
+    TEST_ASSERT_TRUE(RtcManager::clear());
+    for (uint32_t i = 0; i < 4; ++i) {
+        const RtcSensorRecord s = make_sample(i);
+        TEST_ASSERT_TRUE(RtcManager::append(s.timestamp, s.temp10, s.hum10, s.lux, s.rssi));
+    }
+    RtcSensorRecord run[3];
+    uint16_t runSeq[3];
+    uint16_t runLen = 0;
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::peekRun(run, runSeq, 3, runLen, true));
+    TEST_ASSERT_EQUAL_UINT16(3, runLen);
+    const uint16_t lastSeq = runSeq[runLen - 1];
+
+    // RTC reset while the batch is in flight; new samples arrive before the server answers.
+    TEST_ASSERT_TRUE(RtcManager::clear());
+    for (uint32_t i = 10; i < 15; ++i) {
+        const RtcSensorRecord s = make_sample(i);
+        TEST_ASSERT_TRUE(RtcManager::append(s.timestamp, s.temp10, s.hum10, s.lux, s.rssi));
+    }
+    uint16_t popped = 0;
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::popThroughSeq(lastSeq, runLen, popped));
+    TEST_ASSERT_EQUAL_UINT16(0, popped);
+    TEST_ASSERT_EQUAL_UINT16(5, RtcManager::getCount());
+
+    // Same with a header that fails its check and is rebuilt empty.
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::peekRun(run, runSeq, 3, runLen, true));
+    const uint16_t healedSeq = runSeq[runLen - 1];
+    MockRtcMem::mem[RTC_SENSOR_BLOCK_OFFSET * 4 + offsetof(RtcHeaderV3, nextSeq)] ^= 0x5A;
+    RtcManager::init();
+    TEST_ASSERT_EQUAL_UINT16(0, RtcManager::getCount());
+    for (uint32_t i = 20; i < 24; ++i) {
+        const RtcSensorRecord s = make_sample(i);
+        TEST_ASSERT_TRUE(RtcManager::append(s.timestamp, s.temp10, s.hum10, s.lux, s.rssi));
+    }
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::popThroughSeq(healedSeq, runLen, popped));
+    TEST_ASSERT_EQUAL_UINT16(0, popped);
+    TEST_ASSERT_EQUAL_UINT16(4, RtcManager::getCount());
+
+    // A watermark reaching past more records than the batch read is refused as well; the right
+    // count pops exactly the batch and keeps what was appended after it.
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::peekRun(run, runSeq, 3, runLen, true));
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::popThroughSeq(runSeq[runLen - 1], runLen - 1, popped));
+    TEST_ASSERT_EQUAL_UINT16(0, popped);
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::popThroughSeq(runSeq[runLen - 1], runLen, popped));
+    TEST_ASSERT_EQUAL_UINT16(3, popped);
+    RtcSensorRecord out{};
+    const RtcSensorRecord newest = make_sample(23);
+    TEST_ASSERT_TRUE(RtcManager::peek(out));
+    TEST_ASSERT_EQUAL_MEMORY(&newest, &out, sizeof(out));
+
+    // Popping the same batch again is a no-op.
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::popThroughSeq(runSeq[runLen - 1], runLen, popped));
+    TEST_ASSERT_EQUAL_UINT16(0, popped);
+    TEST_ASSERT_EQUAL_UINT16(1, RtcManager::getCount());
+    printf("[RTC] stale batch watermark after reset and header heal: nothing popped\n");
+}
+
+// ============================================================================
+// DEEP-SLEEP DUTY CYCLE
+// ============================================================================
+// Simulated wall clock for the duty-cycle run; millis() restarts at 0 on every wake.
+struct DutyCycleSim {
+    uint64_t trueMs = 0;
+    uint32_t epoch0 = 1735689600;  // 2025-01-01
+    uint32_t wakes = 0;
+    uint32_t uploads = 0;
+    uint32_t fillUploads = 0;
+    uint32_t maxTimestampError = 0;
+    uint16_t maxRtcCount = 0;
+    uint32_t radioOnWakes = 0;   // woke with the radio on and uploaded
+    uint32_t radioWasted = 0;    // woke with the radio on and slept again
+    uint32_t radioMisses = 0;    // woke with the radio off and had to wake again to upload
+    std::vector<uint32_t> delivered;
+    std::vector<uint32_t> sampled;
+
+    uint32_t trueEpoch() const { return epoch0 + static_cast<uint32_t>((trueMs + current_millis) / 1000U); }
+
+    void sleep() {
+        const uint32_t callsBefore = MockDeepSleep::calls;
+        const uint32_t awake = millis();
+        DutyCycle::sleep();
+        TEST_ASSERT_EQUAL_UINT32(callsBefore + 1, MockDeepSleep::calls);
+        TEST_ASSERT_TRUE(MockDeepSleep::lastUs ==
+                         static_cast<uint64_t>(DutyCycle::settings().sampleIntervalMs - awake) * 1000ULL);
+        trueMs += awake + MockDeepSleep::lastUs / 1000U;
+        MockRtcMem::resetInfo.reason = REASON_DEEP_SLEEP_AWAKE;
+        current_millis = 0;
+    }
+
+    // Upload window: drain RTC, resync the clock from "NTP" and sleep.
+    void upload(uint32_t windowMs) {
+        RtcSensorRecord run[RTC_MAX_RECORDS];
+        uint16_t runSeq[RTC_MAX_RECORDS];
+        uint16_t runLen = 0;
+        const RtcReadStatus status = RtcManager::peekRun(run, runSeq, RTC_MAX_RECORDS, runLen);
+        TEST_ASSERT_TRUE(status == RtcReadStatus::NONE || status == RtcReadStatus::CACHE_EMPTY);
+        for (uint16_t i = 0; i < runLen; ++i) {
+            delivered.push_back(run[i].timestamp);
+        }
+        if (runLen > 0) {
+            uint16_t popped = 0;
+            TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::popThroughSeq(runSeq[runLen - 1], runLen, popped));
+        }
+        current_millis += windowMs;
+        DutyCycle::syncClock(trueEpoch());
+        DutyCycle::markUploaded();
+        uploads++;
+        sleep();
+    }
+
+    void coldBoot(const DutyCycle::Settings& settings) {
+        MockRtcMem::resetInfo.reason = REASON_DEFAULT_RST;
+        current_millis = 0;
+        TEST_ASSERT_FALSE(DutyCycle::isTimerWake());
+        memset(MockRtcMem::mem, 0, sizeof(MockRtcMem::mem));
+        RtcManager::init();
+        DutyCycle::begin();
+        DutyCycle::configure(settings);
+        upload(20000);
+    }
+
+    // Mirrors runSampleWake(): a failed reading stores nothing, and an upload wake that began with
+    // the radio off wakes again with it on before the window opens.
+    void sampleWake(uint32_t sampleMs, uint32_t windowMs, bool sensorOk = true) {
+        TEST_ASSERT_TRUE(DutyCycle::isTimerWake());
+        RtcManager::init();
+        DutyCycle::begin();
+        TEST_ASSERT_FALSE(DutyCycle::uploadPending());
+        TEST_ASSERT_EQUAL(DutyCycle::radioOff() ? RF_DISABLED : RF_DEFAULT, MockDeepSleep::lastMode);
+        wakes++;
+        current_millis = sampleMs;
+        const uint32_t ts = DutyCycle::now();
+        const uint32_t truth = trueEpoch();
+        maxTimestampError = std::max(maxTimestampError, (ts > truth) ? ts - truth : truth - ts);
+        if (sensorOk) {
+            TEST_ASSERT_TRUE(RtcManager::append(ts, 215, 550, 300, 0));
+            sampled.push_back(ts);
+        }
+        const uint16_t count = RtcManager::getCount();
+        maxRtcCount = std::max(maxRtcCount, count);
+        if (DutyCycle::decide(count) == DutyCycle::WakeAction::SLEEP) {
+            radioWasted += DutyCycle::radioOff() ? 0 : 1;
+            sleep();
+            return;
+        }
+        if (static_cast<uint32_t>(count) * 100U >= RTC_MAX_RECORDS * DEEP_SLEEP_UPLOAD_FILL_PCT) {
+            fillUploads++;
+        }
+        if (DutyCycle::radioOff()) {
+            radioMisses++;
+            const uint32_t callsBefore = MockDeepSleep::calls;
+            DutyCycle::wakeRadio();
+            TEST_ASSERT_EQUAL_UINT32(callsBefore + 1, MockDeepSleep::calls);
+            TEST_ASSERT_TRUE(MockDeepSleep::lastUs == 1000ULL);
+            TEST_ASSERT_EQUAL(RF_DEFAULT, MockDeepSleep::lastMode);
+            trueMs += current_millis + 1U;
+            current_millis = 0;
+            DutyCycle::begin();
+            TEST_ASSERT_TRUE(DutyCycle::uploadPending());
+            TEST_ASSERT_FALSE(DutyCycle::radioOff());
+        } else {
+            radioOnWakes++;
+        }
+        upload(windowMs);
+    }
+};
+
+// A day of timer wakes: every wake lands one sample in RTC and sleeps for the rest of the
+// interval, WiFi windows open on the upload interval (or early when RTC fills), timestamps
+// carried across sleeps stay on true time and every sample reaches the uploader in order.
+void test_deep_sleep_duty_cycle(void) {
+    printf("\n=== DEEP-SLEEP DUTY CYCLE ===\n");
+    MockDeepSleep::calls = 0;
+
+    DutyCycleSim day;
+    day.coldBoot({60000, 600000, 0.0f, 0.0f, 1.0f});
+    TEST_ASSERT_EQUAL_UINT32(0, DutyCycle::wakeCount());
+    for (uint32_t i = 0; i < 1440; ++i) {
+        day.sampleWake(150, 6000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1440, DutyCycle::wakeCount());
+    TEST_ASSERT_TRUE(day.uploads >= 24 * 6 && day.uploads <= 24 * 6 + 1);
+    // The radio comes up exactly on the wakes that upload.
+    TEST_ASSERT_EQUAL_UINT32(day.uploads - 1, day.radioOnWakes);
+    TEST_ASSERT_EQUAL_UINT32(0, day.radioWasted);
+    TEST_ASSERT_EQUAL_UINT32(0, day.radioMisses);
+    TEST_ASSERT_EQUAL_UINT32(0, day.fillUploads);
+    TEST_ASSERT_TRUE(day.maxTimestampError <= 1);
+    TEST_ASSERT_EQUAL_UINT32(day.sampled.size(), day.delivered.size() + RtcManager::getCount());
+    for (size_t i = 0; i < day.delivered.size(); ++i) {
+        TEST_ASSERT_EQUAL_UINT32(day.sampled[i], day.delivered[i]);
+    }
+
+    // With a long upload interval the RTC fill level brings WiFi up instead.
+    DutyCycleSim sparse;
+    sparse.coldBoot({60000, 3600000, 0.0f, 0.0f, 1.0f});
+    for (uint32_t i = 0; i < 300; ++i) {
+        sparse.sampleWake(150, 6000);
+    }
+    TEST_ASSERT_TRUE(sparse.fillUploads > 0);
+    TEST_ASSERT_TRUE(sparse.maxRtcCount * 100U >= RTC_MAX_RECORDS * DEEP_SLEEP_UPLOAD_FILL_PCT);
+    TEST_ASSERT_TRUE(sparse.maxRtcCount < RTC_MAX_RECORDS);
+    TEST_ASSERT_TRUE(sparse.maxTimestampError <= 1);
+    TEST_ASSERT_EQUAL_UINT32(sparse.sampled.size(), sparse.delivered.size() + RtcManager::getCount());
+
+    // Hourly samples run out of RTC timestamp span (a 16-bit delta, ~18 h) long before RTC fills;
+    // the wake uploads while the next sample still fits instead of failing its append.
+    DutyCycleSim hourly;
+    hourly.coldBoot({3600000, 7 * 86400000U, 0.0f, 0.0f, 1.0f});
+    for (uint32_t i = 0; i < 72; ++i) {
+        hourly.sampleWake(150, 6000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, hourly.fillUploads);
+    TEST_ASSERT_TRUE(hourly.uploads >= 1 + 72 / 19);
+    TEST_ASSERT_TRUE(hourly.maxRtcCount * 3600U < 65535U + 3600U);
+    TEST_ASSERT_EQUAL_UINT32(hourly.sampled.size(), hourly.delivered.size() + RtcManager::getCount());
+    for (size_t i = 0; i < hourly.delivered.size(); ++i) {
+        TEST_ASSERT_EQUAL_UINT32(hourly.sampled[i], hourly.delivered[i]);
+    }
+
+    // Wakes that run long push the upload past the prediction made while sleeping; those wake again
+    // with the radio on. Failed readings store nothing. Every stored sample still arrives in order.
+    DutyCycleSim uneven;
+    uneven.coldBoot({60000, 602000, 0.0f, 0.0f, 1.0f});
+    for (uint32_t i = 0; i < 240; ++i) {
+        uneven.sampleWake((i % 7 == 3) ? 4000 : 150, 6000, i % 11 != 5);
+    }
+    TEST_ASSERT_TRUE(uneven.radioMisses > 0);
+    TEST_ASSERT_EQUAL_UINT32(uneven.uploads - 1, uneven.radioOnWakes + uneven.radioMisses);
+    TEST_ASSERT_TRUE(uneven.sampled.size() < 240);
+    TEST_ASSERT_EQUAL_UINT32(uneven.sampled.size(), uneven.delivered.size() + RtcManager::getCount());
+    for (size_t i = 0; i < uneven.delivered.size(); ++i) {
+        TEST_ASSERT_EQUAL_UINT32(uneven.sampled[i], uneven.delivered[i]);
+    }
+
+    // A reset that is not a timer wake starts the cycle over.
+    MockRtcMem::resetInfo.reason = REASON_EXT_SYS_RST;
+    TEST_ASSERT_FALSE(DutyCycle::isTimerWake());
+
+    printf("[SLEEP] 1440 wakes at 60 s: %u upload windows/day, radio on for %u wakes | 1 h upload interval:"
+           " fill trigger at %u/%u | 1 h samples: span trigger at %u | uneven wakes: %u radio re-wakes\n",
+           (unsigned)day.uploads, (unsigned)day.radioOnWakes, (unsigned)sparse.maxRtcCount,
+           (unsigned)RTC_MAX_RECORDS, (unsigned)hourly.maxRtcCount, (unsigned)uneven.radioMisses);
+}
+
+// ============================================================================
+// TLS SESSION CACHE
+// ============================================================================
+// Sessions are kept per host across connects, offered again on the next connect to the same
+// host (whatever the URL around it), survive other hosts up to the slot count, and are dropped
+// after a failed connect. Handshake timings are split by resumed/full.
+void test_tls_session_cache(void) {
+    printf("\n=== TLS SESSION CACHE ===\n");
+    TlsSessionCache::clear();
+    BearSSL::WiFiClientSecure client;
+    current_millis = 1000;
+
+    // Plays the server: it echoes an offered session ID it accepts and hands out a new one on a
+    // full handshake, the way BearSSL then leaves the parameters in the client's session.
+    uint8_t nextId = 1;
+    auto connect = [&](const char* url, uint32_t handshakeMs, bool ok = true, bool accept = true) {
+        const TlsSessionCache::Ticket t = TlsSessionCache::attachUrl(client, url);
+        if (client.session && ok) {
+            auto* params = reinterpret_cast<br_ssl_session_parameters*>(client.session);
+            if (params->session_id_len == 0 || !accept) {
+                memset(params->session_id, nextId++, sizeof(params->session_id));
+                params->session_id_len = sizeof(params->session_id);
+            }
+        }
+        current_millis += handshakeMs;
+        TlsSessionCache::finish(t, ok);
+        return t;
+    };
+
+    TEST_ASSERT_FALSE(connect("api.example.com", 2400).offered);
+    BearSSL::Session* apiSession = client.session;
+    TEST_ASSERT_NOT_NULL(apiSession);
+    TlsSessionCache::Ticket t = connect("https://API.example.com:443/api/sensor", 300);
+    TEST_ASSERT_TRUE(t.offered);
+    TEST_ASSERT_TRUE(TlsSessionCache::stats().lastResumed);
+    TEST_ASSERT_EQUAL_PTR(apiSession, client.session);
+    TEST_ASSERT_EQUAL_UINT8(1, reinterpret_cast<br_ssl_session_parameters*>(apiSession)->session_id[0]);
+
+    TEST_ASSERT_FALSE(connect("https://ota.example.com/fw/check", 2600).offered);
+    TEST_ASSERT_TRUE(client.session != apiSession);
+    TEST_ASSERT_TRUE(connect("api.example.com", 320).offered);
+
+    // A third host evicts the least recently used one.
+    TEST_ASSERT_FALSE(connect("https://relay.example.net/data", 2500).offered);
+    TEST_ASSERT_TRUE(connect("api.example.com", 310).offered);
+    TEST_ASSERT_FALSE(connect("https://ota.example.com/fw/check", 2550).offered);
+
+    // A failed connect forgets the session.
+    connect("api.example.com", 5000, false);
+    TEST_ASSERT_FALSE(connect("api.example.com", 2450).offered);
+
+    // An offered session the server turns down is a full handshake, not a resume.
+    TEST_ASSERT_TRUE(connect("api.example.com", 2550, true, false).offered);
+    TEST_ASSERT_FALSE(TlsSessionCache::stats().lastResumed);
+    TEST_ASSERT_TRUE(connect("api.example.com", 310).offered);
+    TEST_ASSERT_TRUE(TlsSessionCache::stats().lastResumed);
+
+    // Hosts that do not fit a slot connect without a session.
+    t = TlsSessionCache::attach(client, "a-very-long-host-name-that-does-not-fit.example.com");
+    TEST_ASSERT_EQUAL_INT8(-1, t.slot);
+    TEST_ASSERT_NULL(client.session);
+
+    const TlsSessionCache::Stats& stats = TlsSessionCache::stats();
+    TEST_ASSERT_EQUAL_UINT32(4, stats.resumedHandshakes);
+    TEST_ASSERT_EQUAL_UINT32(6, stats.fullHandshakes);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.declinedResumes);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.failures);
+    TEST_ASSERT_EQUAL_UINT32(310, stats.averageResumedMs());
+    TEST_ASSERT_EQUAL_UINT32(2508, stats.averageFullMs());
+
+    printf("[TLS] resumed %u x avg %u ms | full %u x avg %u ms\n",
+           (unsigned)stats.resumedHandshakes, (unsigned)stats.averageResumedMs(),
+           (unsigned)stats.fullHandshakes, (unsigned)stats.averageFullMs());
+}
+
+void test_qos_throughput_probe(void) {
+    printf("\n=== QOS THROUGHPUT PROBE ===\n");
+
+    // The body is valid JSON of exactly the requested length, whatever the read sizes.
+    const size_t total = 1029;
+    std::vector<uint8_t> whole(total);
+    TEST_ASSERT_EQUAL_UINT32(total, QosProbe::body_read(whole.data(), total + 50, 0, total));
+    std::vector<uint8_t> pieces;
+    for (size_t offset = 0; offset < total;) {
+        uint8_t chunk[37];
+        const size_t n = QosProbe::body_read(chunk, sizeof(chunk), offset, total);
+        TEST_ASSERT_TRUE(n > 0);
+        pieces.insert(pieces.end(), chunk, chunk + n);
+        offset += n;
+    }
+    TEST_ASSERT_TRUE(pieces == whole);
+    const std::string body(whole.begin(), whole.end());
+    TEST_ASSERT_TRUE(body.compare(0, 21, "{\"qos_test\":1,\"pad\":\"") == 0);
+    TEST_ASSERT_EQUAL_STRING("\"}", body.c_str() + total - 2);
+    TEST_ASSERT_TRUE(body.find('"', 21) == total - 2);
+    uint8_t byte = 0;
+    TEST_ASSERT_EQUAL_UINT32(0, QosProbe::body_read(&byte, 1, total, total));
+    TEST_ASSERT_EQUAL_UINT32(0, QosProbe::body_read(&byte, 1, 0, QosProbe::kMinBodyLen - 1));
+    TEST_ASSERT_EQUAL_UINT32(QosProbe::kMinBodyLen, QosProbe::body_read(whole.data(), total, 0, QosProbe::kMinBodyLen));
+
+    // 20 round trips: 17 fast ones, two slower, one outlier.
+    QosProbe::Window window;
+    for (int i = 0; i < 17; ++i) {
+        window.add(100 + i, total);
+    }
+    window.add(400, total);
+    window.add(450, total);
+    window.add(2000, total);
+    window.finish();
+    TEST_ASSERT_EQUAL_UINT32(20, window.count);
+    TEST_ASSERT_EQUAL_UINT32(109, window.percentile(50));  // 10th of 20
+    TEST_ASSERT_EQUAL_UINT32(400, window.percentile(90));  // 18th
+    TEST_ASSERT_EQUAL_UINT32(2000, window.percentile(99)); // 20th
+    TEST_ASSERT_EQUAL_UINT32(100, window.percentile(1));
+    const uint32_t busy = 17 * 100 + (16 * 17) / 2 + 400 + 450 + 2000;
+    TEST_ASSERT_EQUAL_UINT32(busy, window.busyMs);
+    TEST_ASSERT_EQUAL_UINT32(20 * total * 1000ULL / busy, window.bytesPerSec());
+
+    // A full window keeps its samples; an empty one reports zeros.
+    QosProbe::Window full;
+    for (int i = 0; i < QosProbe::kMaxSamples + 10; ++i) {
+        full.add(70000, 10);
+    }
+    TEST_ASSERT_EQUAL_UINT32(QosProbe::kMaxSamples, full.count);
+    TEST_ASSERT_EQUAL_UINT32(0xFFFF, full.latencyMs[0]);
+    QosProbe::Window empty;
+    TEST_ASSERT_EQUAL_UINT32(0, empty.percentile(50));
+    TEST_ASSERT_EQUAL_UINT32(0, empty.bytesPerSec());
+
+    printf("[QOS] %u B x %u: %u B/s, p50=%u p90=%u p99=%u ms\n", (unsigned)total, (unsigned)window.count,
+           (unsigned)window.bytesPerSec(), (unsigned)window.percentile(50), (unsigned)window.percentile(90),
+           (unsigned)window.percentile(99));
+}
+
+// The append sequence of ApiClientUploadShared::buildSensorPayload (that file needs the full
+// config), kept here as the reference the template must match byte for byte.
+static size_t legacy_sensor_payload(char* out, size_t out_len, uint32_t gh_id, uint32_t node_id, int32_t temp10,
+                                    int32_t hum10, uint32_t lux, int32_t rssi, const char* timeStr) {
+    using namespace TextBufferUtils;
+    temp10 = SensorNormalization::clampTemperatureTenths(temp10);
+    hum10 = SensorNormalization::clampHumidityTenths(hum10);
+    lux = SensorNormalization::clampLightUInt(lux);
+    size_t pos = 0;
+    const bool ok = append_bytes_strict_P(out, out_len, pos, PSTR("{\"gh_id\":")) &&
+                    append_u32_strict(out, out_len, pos, gh_id) &&
+                    append_bytes_strict_P(out, out_len, pos, PSTR(",\"node_id\":")) &&
+                    append_u32_strict(out, out_len, pos, node_id) &&
+                    append_bytes_strict_P(out, out_len, pos, PSTR(",\"temperature\":")) &&
+                    append_fixed1_strict(out, out_len, pos, temp10) &&
+                    append_bytes_strict_P(out, out_len, pos, PSTR(",\"humidity\":")) &&
+                    append_fixed1_strict(out, out_len, pos, hum10) &&
+                    append_bytes_strict_P(out, out_len, pos, PSTR(",\"light_intensity\":")) &&
+                    append_u32_strict(out, out_len, pos, lux) &&
+                    append_bytes_strict_P(out, out_len, pos, PSTR(",\"rssi\":")) &&
+                    append_i32_strict(out, out_len, pos, rssi) &&
+                    append_bytes_strict_P(out, out_len, pos, PSTR(",\"recorded_at\":\"")) &&
+                    append_bytes_strict(out, out_len, pos, timeStr, SensorPayloadTemplate::kTimeLen) &&
+                    append_bytes_strict_P(out, out_len, pos, PSTR("\"}"));
+    return ok ? pos : 0;
+}
+
+void test_sensor_payload_template(void) {
+    printf("\n=== SENSOR PAYLOAD TEMPLATE ===\n");
+    using Layout = SensorPayloadTemplate::Layout<2, 9>;
+    using WideLayout = SensorPayloadTemplate::Layout<4294967295U, 0>;
+    const char timeStr[] = "2026-10-16 08:05:09";
+    char expected[160];
+    char actual[160];
+
+    // Every clamp edge, sign and digit count, including values the clamps pull back in.
+    const int32_t temps[] = {-2000, -401, -400, -105, -10, -9, -1, 0, 1, 9, 10, 99, 100, 255, 999, 1000, 1001};
+    const int32_t hums[] = {-5, 0, 5, 10, 455, 999, 1000, 5000};
+    const uint32_t luxes[] = {0, 7, 10, 99, 100, 999, 1000, 9999, 10000, 65535, 65536, 4000000000U};
+    const int32_t rssis[] = {INT32_MIN, -100, -67, -10, -9, -1, 0, 1, 31, INT32_MAX};
+    size_t compared = 0;
+    for (int32_t t : temps) {
+        for (int32_t h : hums) {
+            for (uint32_t l : luxes) {
+                for (int32_t r : rssis) {
+                    const size_t want = legacy_sensor_payload(expected, sizeof(expected), 2, 9, t, h, l, r, timeStr);
+                    const size_t got = Layout::render(actual, sizeof(actual), t, h, l, r, timeStr);
+                    TEST_ASSERT_EQUAL(want, got);
+                    TEST_ASSERT_EQUAL_STRING(expected, actual);
+                    TEST_ASSERT_TRUE(got <= Layout::kMaxLen);
+                    compared++;
+                }
+            }
+        }
+    }
+
+    // Ids are baked in at compile time, at any width.
+    size_t want =
+        legacy_sensor_payload(expected, sizeof(expected), 4294967295U, 0, -400, 1000, 65535, INT32_MIN, timeStr);
+    TEST_ASSERT_EQUAL(want, WideLayout::render(actual, sizeof(actual), -400, 1000, 65535, INT32_MIN, timeStr));
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+    TEST_ASSERT_EQUAL(want, WideLayout::kMaxLen);
+
+    // A buffer one byte short of payload + NUL is refused and left alone, as before.
+    want = legacy_sensor_payload(expected, sizeof(expected), 2, 9, 215, 480, 312, -61, timeStr);
+    memset(actual, 'x', sizeof(actual));
+    TEST_ASSERT_EQUAL(0, Layout::render(actual, want, 215, 480, 312, -61, timeStr));
+    TEST_ASSERT_EQUAL('x', actual[0]);
+    TEST_ASSERT_EQUAL(want, Layout::render(actual, want + 1, 215, 480, 312, -61, timeStr));
+
+    // Records/sec over a realistic spread of readings.
+    const size_t kRecords = 200000;
+    size_t sink = 0;
+    auto run = [&](bool useTemplate) {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < kRecords; ++i) {
+            const int32_t t = 150 + static_cast<int32_t>(i % 200);
+            const int32_t h = 300 + static_cast<int32_t>(i % 500);
+            const uint32_t l = static_cast<uint32_t>((i * 37) % 40000);
+            const int32_t r = -40 - static_cast<int32_t>(i % 50);
+            sink += useTemplate ? Layout::render(actual, sizeof(actual), t, h, l, r, timeStr)
+                                : legacy_sensor_payload(actual, sizeof(actual), 2, 9, t, h, l, r, timeStr);
+        }
+        const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return secs > 0 ? kRecords / secs : 0.0;
+    };
+    const double legacyRate = run(false);
+    const double templateRate = run(true);
+    TEST_ASSERT_TRUE(sink > 0);
+    printf("[BENCH] %u payloads compared; builder %.0f rec/s, template %.0f rec/s (%.1fx)\n", (unsigned)compared,
+           legacyRate, templateRate, legacyRate > 0 ? templateRate / legacyRate : 0.0);
+}
+
+static void reference_local_time(time_t ts, char* out) {
+    tm t;
+    localtime_r(&ts, &t);
+    strftime(out, TimestampCache::kLen + 1, "%Y-%m-%d %H:%M:%S", &t);
+}
+
+void test_timestamp_cache(void) {
+    printf("\n=== TIMESTAMP CACHE ===\n");
+    const char* savedTz = getenv("TZ");
+    std::string restoreTz = savedTz ? savedTz : "";
+    setenv("TZ", "<+07>-7", 1);  // what configTime(7 * 3600, 0, ...) sets up
+    tzset();
+    TimestampCache::invalidate();
+
+    char expected[TimestampCache::kLen + 1];
+    char actual[TimestampCache::kLen + 1];
+    auto check = [&](time_t ts) {
+        reference_local_time(ts, expected);
+        TEST_ASSERT_TRUE(TimestampCache::format(ts, actual));
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+    };
+
+    // A backlog within one local day converts once.
+    const time_t dayStart = 1760547600;  // 2025-10-16 00:00:00 +07
+    uint32_t before = TimestampCache::conversions();
+    for (time_t ts = dayStart; ts < dayStart + 86400; ts += 97) {
+        check(ts);
+    }
+    check(dayStart + 86399);
+    TEST_ASSERT_EQUAL_UINT32(1, TimestampCache::conversions() - before);
+
+    // Crossing midnight either way, and across a month and year end, converts again.
+    before = TimestampCache::conversions();
+    check(dayStart + 86400);
+    check(dayStart - 1);
+    check(dayStart);
+    TEST_ASSERT_EQUAL_UINT32(3, TimestampCache::conversions() - before);
+    const time_t newYear = 1767200400;  // 2026-01-01 00:00:00 +07
+    for (time_t ts = newYear - 5; ts < newYear + 5; ++ts) {
+        check(ts);
+    }
+    check(1709139600 + 86399);  // 2024-02-29 23:59:59 +07
+
+    // Random walk over a few weeks, steps of up to a day in both directions.
+    std::mt19937 rng(25);
+    time_t ts = dayStart;
+    for (int i = 0; i < 5000; ++i) {
+        ts += static_cast<time_t>(rng() % 172800) - 86400;
+        check(ts);
+    }
+
+    // A zone change drops the cached day; the same instant reads differently afterwards.
+    check(dayStart + 3600);
+    TEST_ASSERT_EQUAL_STRING("2025-10-16 01:00:00", actual);
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    TimestampCache::invalidate();
+    check(dayStart + 3600);
+    TEST_ASSERT_EQUAL_STRING("2025-10-15 18:00:00", actual);
+    for (time_t t = dayStart; t < dayStart + 86400 * 2; t += 601) {
+        check(t);
+    }
+
+    // Without a buffer there is nothing to write.
+    TEST_ASSERT_FALSE(TimestampCache::format(0, nullptr));
+
+    before = TimestampCache::conversions();
+    const size_t kRecords = 100000;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kRecords; ++i) {
+        reference_local_time(dayStart + static_cast<time_t>(i % 86400), expected);
+    }
+    const auto mid = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kRecords; ++i) {
+        TimestampCache::format(dayStart + static_cast<time_t>(i % 86400), actual);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double direct = std::chrono::duration<double>(mid - start).count();
+    const double cached = std::chrono::duration<double>(end - mid).count();
+    printf("[BENCH] %u timestamps: localtime_r %.0f/s, cached %.0f/s, %u conversions\n", (unsigned)kRecords,
+           direct > 0 ? kRecords / direct : 0.0, cached > 0 ? kRecords / cached : 0.0,
+           (unsigned)(TimestampCache::conversions() - before));
+
+    if (savedTz) {
+        setenv("TZ", restoreTz.c_str(), 1);
+    } else {
+        unsetenv("TZ");
+    }
+    tzset();
+    TimestampCache::invalidate();
+}
@@ -0,0 +1,305 @@
+#include <unity.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "test_fixtures.h"
+
+#include "net/EncryptedBody.h"
+#include "net/HttpStreamWriter.h"
+#include "storage/CacheManager.h"
+#include "storage/UploadBatchStream.h"
+#include "support/HmacSigner.h"
+
+// ============================================================================
+// STREAMED UPLOAD BODY
+// ============================================================================
+// A queued body is counted without a payload buffer, then rendered again from storage straight
+// into the writer's chunk; the bytes on the wire must be what a buffered assembly would have sent,
+// under the Content-Length counted up front.
+struct CaptureSink {
+    std::string data;
+    size_t limit = SIZE_MAX;
+    size_t operator()(const uint8_t* bytes, size_t len) {
+        const size_t n = std::min(len, limit - std::min(limit, data.size()));
+        data.append(reinterpret_cast<const char*>(bytes), n);
+        return n;
+    }
+};
+
+static const size_t kTestBodySlot = MAX_PAYLOAD_SIZE + 2;
+
+// Renders each record in place in the writer's chunk, one byte in for its separator, the way the
+// transport sends a cloud body.
+struct ChunkBodyOut {
+    HttpStreamWriter::Writer<CaptureSink>& writer;
+
+    char* slot(size_t& len) {
+        char* room = writer.reserve(kTestBodySlot + 1);
+        len = room ? kTestBodySlot : 0;
+        return room ? room + 1 : nullptr;
+    }
+    bool record(char* rec, size_t len, char sep) {
+        if (sep == '\0') {
+            memmove(rec - 1, rec, len);
+            return writer.commit(len);
+        }
+        rec[-1] = sep;
+        return writer.commit(len + 1);
+    }
+    bool put(const char* data, size_t len) { return writer.put(data, len); }
+};
+
+static bool render_test_cached(char* out, size_t outLen, size_t& len) {
+    RtcSensorRecord rec{};
+    return CacheManager::decode_sensor_record(out, len, rec) && render_sample(out, outLen, rec, len);
+}
+
+static UploadBatchStream::Plan plan_test_batch(CacheManager& cache, bool fromRtc, CacheLane lane, uint16_t maxRecords,
+                                               uint32_t maxBytes = UINT32_MAX) {
+    char slot[kTestBodySlot];
+    return UploadBatchStream::plan(cache, fromRtc, lane, maxRecords, maxBytes, slot, sizeof(slot), render_sample,
+                                   render_test_cached);
+}
+
+static bool write_test_batch(CacheManager& cache, const UploadBatchStream::Plan& plan,
+                             HttpStreamWriter::Writer<CaptureSink>& out) {
+    ChunkBodyOut body{out};
+    return UploadBatchStream::write(cache, plan, render_sample, render_test_cached, body);
+}
+
+static std::string rendered_sample(uint32_t i) {
+    char buf[64];
+    size_t len = 0;
+    TEST_ASSERT_TRUE(render_sample(buf, sizeof(buf), make_sample(i), len));
+    return std::string(buf, len);
+}
+
+void test_upload_batch_stream(void) {
+    printf("\n=== STREAMED UPLOAD BODY ===\n");
+    LittleFS.format();
+    CacheManager cache;
+    cache.init();
+    memset(MockRtcMem::mem, 0, sizeof(MockRtcMem::mem));
+    TEST_ASSERT_TRUE(RtcManager::clear());
+
+    // Routine lane holds samples 0..3, RTC holds the newer 4..6.
+    for (uint32_t i = 0; i < 4; ++i) TEST_ASSERT_TRUE(cache.write_sensor_record(make_sample(i)));
+    for (uint32_t i = 4; i < 7; ++i) {
+        const RtcSensorRecord s = make_sample(i);
+        TEST_ASSERT_TRUE(RtcManager::append(s.timestamp, s.temp10, s.hum10, s.lux, s.rssi));
+    }
+
+    MockRtcMem::resetCounters();
+    UploadBatchStream::Plan plan = plan_test_batch(cache, true, CacheLane::ROUTINE, 32);
+    TEST_ASSERT_TRUE(plan.active);
+    TEST_ASSERT_EQUAL_UINT32(1, MockRtcMem::readCalls);  // one RTC read for the run, not one per record
+    TEST_ASSERT_EQUAL_UINT16(3, plan.rtcRecords);
+    TEST_ASSERT_EQUAL_UINT16(4, plan.laneRecords);
+
+    // The loaded record is rendered from RTC like the rest, not copied from a payload buffer.
+    std::string expected = "[" + rendered_sample(4);
+    for (uint32_t i : {5u, 6u, 0u, 1u, 2u, 3u}) expected += "," + rendered_sample(i);
+    expected += "]";
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), plan.bodyLen);
+
+    CaptureSink sink;
+    HttpStreamWriter::Writer<CaptureSink> out(sink);
+    out.put(F("POST /api/data HTTP/1.1\r\nHost: "));
+    out.put("cloud.example");
+    out.put(F("\r\nContent-Length: "));
+    out.put_u32(plan.bodyLen);
+    out.put(F("\r\n\r\n"));
+    TEST_ASSERT_EQUAL_UINT32(0, sink.data.size());  // head still gathered in the chunk
+    MockRtcMem::resetCounters();
+    TEST_ASSERT_TRUE(UploadBatchStream::valid(cache, plan));
+    TEST_ASSERT_TRUE(write_test_batch(cache, plan, out));
+    TEST_ASSERT_EQUAL_UINT32(2, MockRtcMem::readCalls);
+    TEST_ASSERT_TRUE(out.flush());
+    const std::string head = "POST /api/data HTTP/1.1\r\nHost: cloud.example\r\nContent-Length: " +
+                             std::to_string(expected.size()) + "\r\n\r\n";
+    TEST_ASSERT_EQUAL_STRING((head + expected).c_str(), sink.data.c_str());
+    // Each record needs a whole slot free in the chunk, so a chunk carries less than it holds.
+    TEST_ASSERT_TRUE(out.sinkWrites() <= sink.data.size() / (HTTP_STREAM_CHUNK_BYTES - kTestBodySlot - 1) + 1);
+
+    // The record cap holds across the RTC/cache boundary, and so does the byte cap.
+    UploadBatchStream::Plan capped = plan_test_batch(cache, true, CacheLane::ROUTINE, 4);
+    TEST_ASSERT_EQUAL_UINT16(3, capped.rtcRecords);
+    TEST_ASSERT_EQUAL_UINT16(1, capped.laneRecords);
+    const uint32_t threeLen = static_cast<uint32_t>(
+        2 + rendered_sample(4).size() + 1 + rendered_sample(5).size() + 1 + rendered_sample(6).size());
+    capped = plan_test_batch(cache, true, CacheLane::ROUTINE, 32, threeLen);
+    TEST_ASSERT_EQUAL_UINT16(3, capped.rtcRecords);
+    TEST_ASSERT_EQUAL_UINT16(0, capped.laneRecords);
+    TEST_ASSERT_EQUAL_UINT32(threeLen, capped.bodyLen);
+
+    // One record goes as the bare object.
+    UploadBatchStream::Plan single = plan_test_batch(cache, true, CacheLane::ROUTINE, 1);
+    TEST_ASSERT_TRUE(single.active);
+    TEST_ASSERT_EQUAL_UINT16(1, single.records());
+    TEST_ASSERT_EQUAL_UINT32(rendered_sample(4).size(), single.bodyLen);
+    CaptureSink singleSink;
+    HttpStreamWriter::Writer<CaptureSink> singleOut(singleSink);
+    TEST_ASSERT_TRUE(write_test_batch(cache, single, singleOut));
+    TEST_ASSERT_TRUE(singleOut.flush());
+    TEST_ASSERT_EQUAL_STRING(rendered_sample(4).c_str(), singleSink.data.c_str());
+
+    // A corrupt slot ends the RTC part and keeps the batch from running on into the lane.
+    const size_t slot1 = RTC_SENSOR_BLOCK_OFFSET * 4 + offsetof(RtcSensorData, records) +
+                         ((RtcManager::getRawData().header.tail + 2) % RTC_MAX_RECORDS) * sizeof(RtcRecordV3);
+    MockRtcMem::mem[slot1] ^= 0x5A;
+    UploadBatchStream::Plan cut = plan_test_batch(cache, true, CacheLane::ROUTINE, 32);
+    TEST_ASSERT_TRUE(cut.active);
+    TEST_ASSERT_EQUAL_UINT16(2, cut.rtcRecords);
+    TEST_ASSERT_EQUAL_UINT16(0, cut.laneRecords);
+    MockRtcMem::mem[slot1] ^= 0x5A;
+
+    // RTC moved on between counting and sending: the plan is refused before any byte goes out.
+    RtcSensorRecord popped{};
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::popEx(popped));
+    TEST_ASSERT_FALSE(UploadBatchStream::valid(cache, plan));
+    TEST_ASSERT_FALSE(UploadBatchStream::valid(cache, single));
+    uint16_t drained = 0;
+    TEST_ASSERT_EQUAL(RtcReadStatus::NONE, RtcManager::popThroughSeq(plan.lastRtcSeq, plan.rtcRecords, drained));
+    TEST_ASSERT_EQUAL_UINT16(0, RtcManager::getCount());
+
+    // A routine-lane batch walks the lane from the tail entry.
+    plan = plan_test_batch(cache, false, CacheLane::ROUTINE, 32);
+    TEST_ASSERT_TRUE(plan.active);
+    TEST_ASSERT_EQUAL_UINT16(0, plan.rtcRecords);
+    TEST_ASSERT_EQUAL_UINT16(4, plan.laneRecords);
+
+    // Entries gone mid-stream: the walk stops short of the promised body.
+    TEST_ASSERT_EQUAL_UINT32(2, cache.pop_many(2));
+    CaptureSink shortSink;
+    HttpStreamWriter::Writer<CaptureSink> shortOut(shortSink);
+    TEST_ASSERT_FALSE(write_test_batch(cache, plan, shortOut));
+
+    // A socket taking fewer bytes than handed fails the writer for good.
+    CaptureSink stalled;
+    stalled.limit = 10;
+    HttpStreamWriter::Writer<CaptureSink> stalledOut(stalled);
+    std::string big(HTTP_STREAM_CHUNK_BYTES + 20, 'x');
+    TEST_ASSERT_FALSE(stalledOut.put(big.data(), big.size()));
+    TEST_ASSERT_FALSE(stalledOut.ok());
+    TEST_ASSERT_FALSE(stalledOut.put("y", 1));
+    TEST_ASSERT_EQUAL_UINT32(10, stalledOut.written());
+    TEST_ASSERT_TRUE(stalledOut.reserve(1) == nullptr);
+
+    printf("[STREAM] 7-record body, %u B + head in %u socket write(s), no payload buffer\n",
+           (unsigned)expected.size(), (unsigned)out.sinkWrites());
+}
+
+// ============================================================================
+// STREAMED GATEWAY BODY ENCRYPTION
+// ============================================================================
+// The gateway body is encrypted a record at a time as it is written; it must come out the same as
+// encrypting the whole plaintext in one buffer, under a length known before the first byte.
+// A toy block "cipher" stands in for AES: CBC chaining is what the runs have to get right.
+struct ToyCbc {
+    bool operator()(uint8_t* iv, uint8_t* data, size_t len) {
+        if (len == 0 || len % 16 != 0) return false;
+        for (size_t block = 0; block < len; block += 16) {
+            for (size_t i = 0; i < 16; ++i) data[block + i] = static_cast<uint8_t>((data[block + i] ^ iv[i]) * 7 + 0x3B);
+            memcpy(iv, data + block, 16);
+        }
+        return true;
+    }
+};
+
+struct StringEmit {
+    std::string data;
+    bool operator()(const char* bytes, size_t len) {
+        data.append(bytes, len);
+        return true;
+    }
+};
+
+static std::string one_shot_encrypted_body(const uint8_t* iv, uint32_t ts, const std::string& plain) {
+    std::vector<uint8_t> buf = {static_cast<uint8_t>(ts >> 24), static_cast<uint8_t>(ts >> 16),
+                                static_cast<uint8_t>(ts >> 8), static_cast<uint8_t>(ts)};
+    buf.insert(buf.end(), plain.begin(), plain.end());
+    const size_t pad = 16 - buf.size() % 16;
+    buf.insert(buf.end(), pad, static_cast<uint8_t>(pad));
+    uint8_t chain[16];
+    memcpy(chain, iv, sizeof(chain));
+    ToyCbc cipher;
+    TEST_ASSERT_TRUE(cipher(chain, buf.data(), buf.size()));
+    std::string out = "ENC:";
+    std::string digits((buf.size() + 2) / 3 * 4, '\0');
+    out.append(&digits[0], EncryptedBody::base64(iv, 16, &digits[0]));
+    out += ':';
+    out.append(&digits[0], EncryptedBody::base64(buf.data(), buf.size(), &digits[0]));
+    return out;
+}
+
+void test_encrypted_body_stream(void) {
+    printf("\n=== STREAMED GATEWAY BODY ENCRYPTION ===\n");
+    char digits[16];
+    TEST_ASSERT_EQUAL_UINT32(8, EncryptedBody::base64(reinterpret_cast<const uint8_t*>("foobar"), 6, digits));
+    TEST_ASSERT_EQUAL_STRING("Zm9vYmFy", std::string(digits, 8).c_str());
+    TEST_ASSERT_EQUAL_UINT32(4, EncryptedBody::base64(reinterpret_cast<const uint8_t*>("fo"), 2, digits));
+    TEST_ASSERT_EQUAL_STRING("Zm8=", std::string(digits, 4).c_str());
+    TEST_ASSERT_EQUAL_UINT32(4, EncryptedBody::base64(reinterpret_cast<const uint8_t*>("f"), 1, digits));
+    TEST_ASSERT_EQUAL_STRING("Zg==", std::string(digits, 4).c_str());
+
+    uint8_t iv[16];
+    for (size_t i = 0; i < sizeof(iv); ++i) iv[i] = static_cast<uint8_t>(0xA0 + i * 3);
+    const uint32_t ts = 1735689600UL;
+    HmacSigner::Key key;
+    HmacSigner::set_key(key, "gateway-key", 11);
+
+    // Lengths across block and run edges: 12 and 44 fill a block or a run exactly with the timestamp.
+    size_t checked = 0;
+    for (size_t plainLen : {0u, 1u, 11u, 12u, 13u, 43u, 44u, 45u, 92u, 140u, 255u, 700u}) {
+        std::string plain;
+        for (size_t i = 0; i < plainLen; ++i) plain += static_cast<char>('!' + (i * 13) % 90);
+        const std::string expected = one_shot_encrypted_body(iv, ts, plain);
+        TEST_ASSERT_EQUAL_UINT32(expected.size(), EncryptedBody::body_len(plainLen));
+
+        // Plaintext handed over in uneven pieces, the way records and separators arrive.
+        ToyCbc cipher;
+        StringEmit emit;
+        EncryptedBody::Encoder<ToyCbc, StringEmit> enc(cipher, emit, iv, ts, plainLen);
+        TEST_ASSERT_TRUE(enc.begin());
+        size_t pos = 0;
+        for (size_t step = 1; pos < plainLen; step = step % 37 + 5) {
+            const size_t n = std::min(step, plainLen - pos);
+            TEST_ASSERT_TRUE(enc.put(plain.data() + pos, n));
+            pos += n;
+        }
+        TEST_ASSERT_TRUE(enc.finish());
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), emit.data.c_str());
+
+        // The signing pass over the emitted pieces matches a signature over the whole body.
+        HmacSigner::Incremental hmac(key);
+        auto toHmac = [&hmac](const char* data, size_t len) {
+            hmac.update(data, len);
+            return true;
+        };
+        ToyCbc cipher2;
+        EncryptedBody::Encoder<ToyCbc, decltype(toHmac)> signer(cipher2, toHmac, iv, ts, plainLen);
+        TEST_ASSERT_TRUE(signer.begin() && signer.put(plain.data(), plainLen) && signer.finish());
+        char streamed[HmacSigner::kHexLen + 1];
+        char whole[HmacSigner::kHexLen + 1];
+        hmac.finish_hex(streamed);
+        HmacSigner::sign_hex(key, expected.data(), expected.size(), whole);
+        TEST_ASSERT_EQUAL_STRING(whole, streamed);
+        checked++;
+    }
+
+    // Plaintext that does not add up to the promised length fails either way.
+    ToyCbc cipher;
+    StringEmit emit;
+    EncryptedBody::Encoder<ToyCbc, StringEmit> longer(cipher, emit, iv, ts, 4);
+    TEST_ASSERT_TRUE(longer.begin());
+    TEST_ASSERT_FALSE(longer.put("12345", 5));
+    TEST_ASSERT_FALSE(longer.finish());
+    EncryptedBody::Encoder<ToyCbc, StringEmit> shorter(cipher, emit, iv, ts, 4);
+    TEST_ASSERT_TRUE(shorter.begin() && shorter.put("123", 3));
+    TEST_ASSERT_FALSE(shorter.finish());
+    TEST_ASSERT_FALSE(shorter.ok());
+
+    printf("[ENC] %u plaintext lengths encrypted in 48-byte runs match the one-shot body and signature\n",
+           (unsigned)checked);
+}
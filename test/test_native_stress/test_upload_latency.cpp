@@ -0,0 +1,62 @@
+#include <unity.h>
+
+#include "test_fixtures.h"
+
+#include "net/UploadLatency.cpp"
+
+// ============================================================================
+// UPLOAD LATENCY HISTOGRAMS
+// ============================================================================
+// UploadLatency keeps its state in the module, so its implementation is compiled here alone.
+void test_upload_latency(void) {
+    printf("\n=== UPLOAD LATENCY HISTOGRAMS ===\n");
+    using Phase = UploadLatency::Phase;
+    using Target = UploadLatency::Target;
+    current_millis = 1000;
+    UploadLatency::reset();
+
+    // Bucket edges: <1 ms, then [2^(i-1), 2^i), the last one open-ended.
+    TEST_ASSERT_EQUAL_UINT32(0, UploadLatency::bucketFor(0));
+    TEST_ASSERT_EQUAL_UINT32(1, UploadLatency::bucketFor(1));
+    TEST_ASSERT_EQUAL_UINT32(2, UploadLatency::bucketFor(2));
+    TEST_ASSERT_EQUAL_UINT32(2, UploadLatency::bucketFor(3));
+    TEST_ASSERT_EQUAL_UINT32(3, UploadLatency::bucketFor(4));
+    TEST_ASSERT_EQUAL_UINT32(10, UploadLatency::bucketFor(1000));
+    TEST_ASSERT_EQUAL_UINT32(UploadLatency::kBuckets - 1, UploadLatency::bucketFor(UINT32_MAX));
+
+    // 90 fast connects around 20 ms and 10 slow ones around 3 s.
+    for (int i = 0; i < 90; ++i) {
+        UploadLatency::record(Target::EDGE, Phase::CONNECT, 18 + (i % 5));
+    }
+    for (int i = 0; i < 10; ++i) {
+        UploadLatency::record(Target::EDGE, Phase::CONNECT, 3000 + i);
+    }
+    UploadLatency::recordFailure(Target::EDGE);
+    const UploadLatency::Histogram& h = UploadLatency::histogram(Target::EDGE, Phase::CONNECT);
+    TEST_ASSERT_EQUAL_UINT32(100, h.count);
+    TEST_ASSERT_EQUAL_UINT32(3009, h.maxMs);
+    TEST_ASSERT_EQUAL_UINT32(32, h.percentileMs(50));
+    TEST_ASSERT_EQUAL_UINT32(32, h.percentileMs(90));
+    TEST_ASSERT_EQUAL_UINT32(3009, h.percentileMs(95));  // capped at the largest sample seen
+    TEST_ASSERT_EQUAL_UINT32((90 * 20 + 10 * 3004.5) / 100, h.averageMs());
+    TEST_ASSERT_EQUAL_UINT32(1, UploadLatency::failures().count[static_cast<size_t>(Target::EDGE)]);
+    TEST_ASSERT_EQUAL_UINT32(0, UploadLatency::histogram(Target::CLOUD, Phase::CONNECT).count);
+    TEST_ASSERT_EQUAL_UINT32(0, UploadLatency::histogram(Target::EDGE, Phase::TOTAL).percentileMs(50));
+    printf("[LATENCY] edge connect n=%u p50=%u p95=%u avg=%u max=%u ms\n", (unsigned)h.count,
+           (unsigned)h.percentileMs(50), (unsigned)h.percentileMs(95), (unsigned)h.averageMs(), (unsigned)h.maxMs);
+
+    // A saturated bucket drops further samples instead of wrapping.
+    for (uint32_t i = 0; i < 0x10010; ++i) {
+        UploadLatency::record(Target::CLOUD, Phase::TLS, 700);
+    }
+    const UploadLatency::Histogram& tls = UploadLatency::histogram(Target::CLOUD, Phase::TLS);
+    TEST_ASSERT_EQUAL_UINT32(0xFFFF, tls.buckets[UploadLatency::bucketFor(700)]);
+    TEST_ASSERT_EQUAL_UINT32(0xFFFF, tls.count);
+
+    current_millis = 61000;
+    TEST_ASSERT_EQUAL_UINT32(60000, UploadLatency::sinceResetMs());
+    UploadLatency::reset();
+    TEST_ASSERT_EQUAL_UINT32(0, UploadLatency::histogram(Target::EDGE, Phase::CONNECT).count);
+    TEST_ASSERT_EQUAL_UINT32(0, UploadLatency::failures().count[static_cast<size_t>(Target::EDGE)]);
+    TEST_ASSERT_EQUAL_UINT32(0, UploadLatency::sinceResetMs());
+}